@@ -0,0 +1,387 @@
+/*******************************************************************************
+ * ANALYSE DES PARTIES EN COLONNES
+ * Export: lit les journaux des parties (-j du serveur), un à la fois, et
+ * écrit les parties et les coups dans un fichier en colonnes (colonnes.h);
+ * la mémoire ne dépend pas du nombre de journaux.
+ * Lecture: parcourt des exports et calcule les statistiques des questions,
+ * des réponses, des accusations et des résultats, en ne décodant que les
+ * colonnes utiles.
+ *
+ * Usage: ./analyse -o <export.sh13k> <journal>...
+ *        ./analyse [-c] <export.sh13k>...      (-c: coups en CSV)
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "partie.h"
+#include "journal.h"
+#include "colonnes.h"
+
+/*******************************************************************************
+ * SECTION 1: EXPORT DES JOURNAUX
+ ******************************************************************************/
+
+struct ecrivainColonnes export;
+long long numeroPartie = 0;                 // Parties exportées (numéro de la suivante)
+long journaux = 0, illisibles = 0, coupsExportes = 0;
+
+// Partie du journal en cours de lecture et son dernier coup (sa réponse
+// arrive avec les événements qui le suivent)
+struct partieLue
+{
+    int enCours;
+    int coupEnCours;
+    unsigned long long debut;
+    unsigned long long dernier;
+    struct lignePartie p;
+    struct ligneCoup c;
+    char noms[NB_JOUEURS][40];
+};
+
+void terminerCoup(struct partieLue *pl)
+{
+    if (!pl->coupEnCours)
+        return;
+    if (colonnesCoup(&export, &pl->c) < 0)
+    {
+        perror("export");
+        exit(1);
+    }
+    coupsExportes++;
+    pl->coupEnCours = 0;
+}
+
+void terminerPartieLue(struct partieLue *pl)
+{
+    int i;
+
+    terminerCoup(pl);
+    if (!pl->enCours)
+        return;
+    pl->p.valeurs[P_DUREE] = (pl->dernier - pl->debut) / 1000;
+    for (i=0; i<NB_JOUEURS; i++)
+        pl->p.noms[i] = pl->noms[i];
+    if (colonnesPartie(&export, &pl->p) < 0)
+    {
+        perror("export");
+        exit(1);
+    }
+    pl->enCours = 0;
+}
+
+void exporter(const char *fichier)
+{
+    struct lecteurJournal l;
+    struct enregistrement e;
+    struct action act;
+    struct evenement ev;
+    struct partieLue pl;
+    long long *v;
+    int place;
+
+    if (journalOuvrir(&l, fichier, 1) < 0)
+    {
+        fprintf(stderr, "%s: journal illisible\n", fichier);
+        illisibles++;
+        return;
+    }
+    journaux++;
+    memset(&pl, 0, sizeof(pl));
+    v = pl.p.valeurs;
+
+    while (journalSuivant(&l, &e))
+    {
+        pl.dernier = e.t;
+        switch (e.type)
+        {
+            case J_PARTIE:
+                terminerPartieLue(&pl);
+                memset(&pl, 0, sizeof(pl));
+                pl.enCours = 1;
+                pl.debut = pl.dernier = e.t;
+                v[P_PARTIE] = numeroPartie++;
+                v[P_DEBUT] = e.t;
+                v[P_GRAINE] = e.donnees[0] | (e.donnees[1] << 8) | (e.donnees[2] << 16)
+                              | ((unsigned int) e.donnees[3] << 24);
+                v[P_GAGNANT] = -1;
+                break;
+
+            case J_DONNE:
+                v[P_COUPABLE] = e.donnees[12];
+                break;
+
+            // Joueur assis (ou reconnecté: même place, même nom)
+            case J_JOUEUR:
+                place = e.donnees[0];
+                if (place >= NB_JOUEURS || e.longueur < 7)
+                    break;
+                if (e.donnees[1])
+                    v[P_ROBOTS] |= 1 << place;
+                strncpy(pl.noms[place], (char *) e.donnees + 6, sizeof(pl.noms[place]) - 1);
+                break;
+
+            case J_ACTION:
+                if (!pl.enCours)
+                    break;
+                terminerCoup(&pl);
+                journalLireAction(&e, &act);
+                memset(&pl.c, 0, sizeof(pl.c));
+                pl.c.valeurs[C_PARTIE] = v[P_PARTIE];
+                pl.c.valeurs[C_TOUR] = v[P_TOURS]++;
+                pl.c.valeurs[C_MS] = (e.t - pl.debut) / 1000;
+                pl.c.valeurs[C_JOUEUR] = act.joueur;
+                pl.c.valeurs[C_CODE] = act.code;
+                pl.c.valeurs[C_A] = act.a;
+                pl.c.valeurs[C_B] = (act.code == 'S') ? act.b : 0;
+                pl.coupEnCours = 1;
+                break;
+
+            // Réponse du coup en cours
+            case J_EVENEMENT:
+                journalLireEvenement(&e, &ev);
+                if (!pl.coupEnCours)
+                    break;
+                switch (ev.code)
+                {
+                    case 'S':
+                        pl.c.valeurs[C_REPONSE] = ev.b;
+                        break;
+                    case 'R':
+                        pl.c.valeurs[C_REPONSE] |= (long long) ev.c << ev.b;
+                        break;
+                    case 'W':
+                        if (pl.c.valeurs[C_CODE] == 'G')
+                            pl.c.valeurs[C_REPONSE] = 1;
+                        break;
+                    case 'F':
+                        v[P_PERDUS] |= 1 << ev.a;
+                        break;
+                    case 'A':
+                        v[P_PERDUS] |= 1 << ev.a;
+                        pl.c.valeurs[C_REPONSE] = 1;
+                        break;
+                }
+                break;
+
+            case J_FIN:
+                v[P_GAGNANT] = e.donnees[0];
+                terminerPartieLue(&pl);
+                break;
+        }
+    }
+
+    // Partie interrompue: exportée sans gagnant
+    terminerPartieLue(&pl);
+    journalLiberer(&l);
+}
+
+/*******************************************************************************
+ * SECTION 2: LECTURE DES EXPORTS
+ ******************************************************************************/
+
+struct statistiques
+{
+    long blocs;
+    long long octets;
+    long parties;
+    long terminees;
+    long victoires[NB_JOUEURS];             // Victoires par place
+    long victoiresRobots;
+    long toursVictoire;
+    long long dureeVictoire;                // ms
+    long coups;
+    long codes[128];
+    long reponsesS[NB_JOUEURS];             // Symboles annoncés (0 à 3)
+    long objetsS[NB_OBJETS];                // Objet demandé
+    long reponsesO[NB_JOUEURS + 1];         // Joueurs qui ont l'objet
+    long accusations[2];                    // Fausses, bonnes
+    long toursAccusation[2];
+    long forfaits;
+} stats;
+
+long long *colonne[COLONNES_MAX];
+int csv = 0;
+
+void lireParties(struct blocLu *b)
+{
+    long long *gagnant = colonne[P_GAGNANT], *tours = colonne[P_TOURS];
+    long long *duree = colonne[P_DUREE], *robots = colonne[P_ROBOTS];
+    int i;
+
+    colonnesDecoder(b, P_GAGNANT, gagnant);
+    colonnesDecoder(b, P_TOURS, tours);
+    colonnesDecoder(b, P_DUREE, duree);
+    colonnesDecoder(b, P_ROBOTS, robots);
+    stats.parties += b->lignes;
+    for (i=0; i<b->lignes; i++)
+    {
+        if (gagnant[i] < 0 || gagnant[i] >= NB_JOUEURS)
+            continue;
+        stats.terminees++;
+        stats.victoires[gagnant[i]]++;
+        stats.victoiresRobots += (robots[i] >> gagnant[i]) & 1;
+        stats.toursVictoire += tours[i];
+        stats.dureeVictoire += duree[i];
+    }
+}
+
+void lireCoups(struct blocLu *b)
+{
+    long long *code = colonne[C_CODE], *a = colonne[C_A], *bb = colonne[C_B];
+    long long *reponse = colonne[C_REPONSE], *tour = colonne[C_TOUR];
+    int i, c;
+
+    for (c=0; c<C_COLONNES; c++)
+        if (csv || c == C_CODE || c == C_A || c == C_B || c == C_REPONSE || c == C_TOUR)
+            colonnesDecoder(b, c, colonne[c]);
+    stats.coups += b->lignes;
+    for (i=0; i<b->lignes; i++)
+    {
+        stats.codes[code[i] & 127]++;
+        switch (code[i])
+        {
+            case 'S':
+                if (reponse[i] >= 0 && reponse[i] < NB_JOUEURS && bb[i] >= 0 && bb[i] < NB_OBJETS)
+                {
+                    stats.reponsesS[reponse[i]]++;
+                    stats.objetsS[bb[i]]++;
+                }
+                break;
+            case 'O':
+                stats.reponsesO[__builtin_popcountll(reponse[i] & 15)]++;
+                break;
+            case 'G':
+                stats.accusations[reponse[i] != 0]++;
+                stats.toursAccusation[reponse[i] != 0] += tour[i];
+                break;
+            case 'P':
+                stats.forfaits += reponse[i] != 0;
+                break;
+        }
+        if (csv)
+            printf("%lld,%lld,%lld,%lld,%c,%lld,%lld,%lld\n", colonne[C_PARTIE][i], tour[i],
+                   colonne[C_MS][i], colonne[C_JOUEUR][i], (char) code[i], a[i], bb[i], reponse[i]);
+    }
+}
+
+int lire(const char *fichier)
+{
+    struct lecteurColonnes l;
+    struct blocLu b;
+    int r;
+
+    if (colonnesOuvrir(&l, fichier) < 0)
+    {
+        fprintf(stderr, "%s: export illisible\n", fichier);
+        return -1;
+    }
+    while ((r = colonnesBloc(&l, &b)) > 0)
+    {
+        stats.blocs++;
+        if (b.table == TABLE_PARTIES && b.nbColonnes >= P_COLONNES)
+            lireParties(&b);
+        else if (b.table == TABLE_COUPS && b.nbColonnes >= C_COLONNES)
+            lireCoups(&b);
+    }
+    stats.octets += l.taille;
+    colonnesLiberer(&l);
+    if (r < 0)
+        fprintf(stderr, "%s: bloc invalide, fin du fichier ignorée\n", fichier);
+    return r;
+}
+
+/*******************************************************************************
+ * SECTION 3: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+void usage(const char *nom)
+{
+    fprintf(stderr, "Usage: %s -o <export%s> <journal>...\n       %s [-c] <export%s>...\n",
+            nom, COLONNES_EXTENSION, nom, COLONNES_EXTENSION);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    struct timespec t0, t1;
+    char *sortie = NULL;
+    double t;
+    int opt, i, erreurs = 0;
+
+    while ((opt = getopt(argc, argv, "co:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c': csv = 1; break;
+            case 'o': sortie = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc)
+        usage(argv[0]);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (sortie != NULL)
+    {
+        if (colonnesCreer(&export, sortie) < 0)
+        {
+            perror(sortie);
+            exit(1);
+        }
+        for (i=optind; i<argc; i++)
+            exporter(argv[i]);
+        if (colonnesFermer(&export) < 0)
+        {
+            perror(sortie);
+            exit(1);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        fprintf(stderr, "=== EXPORT DE %ld JOURNAUX ===\n", journaux);
+        fprintf(stderr, "parties: %lld, coups: %ld, journaux illisibles: %ld\n",
+                numeroPartie, coupsExportes, illisibles);
+        fprintf(stderr, "%s: %lld octets (%.1f octets par coup), %.3f s\n", sortie, export.octets,
+                coupsExportes > 0 ? (double) export.octets / coupsExportes : 0.0, t);
+        return illisibles == 0 ? 0 : 2;
+    }
+
+    for (i=0; i<COLONNES_MAX; i++)
+        if ((colonne[i] = malloc(COLONNES_LIGNES * sizeof(long long))) == NULL)
+        {
+            perror("analyse");
+            exit(1);
+        }
+    for (i=optind; i<argc; i++)
+        erreurs += lire(argv[i]) < 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (csv)
+        return erreurs == 0 ? 0 : 2;
+
+    printf("=== ANALYSE DE %d EXPORT(S) ===\n", argc - optind);
+    printf("parties: %ld dont %ld terminées, coups: %ld (G=%ld O=%ld S=%ld P=%ld)\n",
+           stats.parties, stats.terminees, stats.coups,
+           stats.codes['G'], stats.codes['O'], stats.codes['S'], stats.codes['P']);
+    printf("victoires par place: %ld %ld %ld %ld, dont robots: %ld\n",
+           stats.victoires[0], stats.victoires[1], stats.victoires[2], stats.victoires[3],
+           stats.victoiresRobots);
+    if (stats.terminees > 0)
+        printf("tours moyens pour gagner: %.1f, durée moyenne: %.2f s\n",
+               (double) stats.toursVictoire / stats.terminees, stats.dureeVictoire / 1e3 / stats.terminees);
+    printf("questions S: réponses 0=%ld 1=%ld 2=%ld 3=%ld, objets", stats.reponsesS[0],
+           stats.reponsesS[1], stats.reponsesS[2], stats.reponsesS[3]);
+    for (i=0; i<NB_OBJETS; i++)
+        printf(" %ld", stats.objetsS[i]);
+    printf("\nquestions O: joueurs qui ont l'objet 0=%ld 1=%ld 2=%ld 3=%ld 4=%ld\n", stats.reponsesO[0],
+           stats.reponsesO[1], stats.reponsesO[2], stats.reponsesO[3], stats.reponsesO[4]);
+    printf("accusations: %ld bonnes (tour moyen %.1f), %ld fausses (tour moyen %.1f), forfaits: %ld\n",
+           stats.accusations[1], stats.accusations[1] ? (double) stats.toursAccusation[1] / stats.accusations[1] : 0.0,
+           stats.accusations[0], stats.accusations[0] ? (double) stats.toursAccusation[0] / stats.accusations[0] : 0.0,
+           stats.forfaits);
+    printf("lu: %lld octets en %ld blocs, %.3f s (%.0f Mo/s, %.0f coups/s)\n", stats.octets, stats.blocs,
+           t, stats.octets / 1e6 / t, stats.coups / t);
+    return erreurs == 0 ? 0 : 2;
+}
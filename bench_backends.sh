@@ -0,0 +1,34 @@
+#!/bin/bash
+# Compare les backends réseau du serveur (poll, io_uring) sous la même charge:
+# appels système du chemin réseau par tour (métrique sh13_net_syscalls_total)
+# et percentiles de latence action -> 'M' mesurés par loadgen.
+#
+# Usage: ./bench_backends.sh [tables] [secondes] [fils du serveur]
+# ex:    ./bench_backends.sh 512 20 2
+
+TABLES=${1:-256}
+DUREE=${2:-20}
+GROUPES=${3:-1}
+PORT=27000
+METRIQUES=9460
+PORT_JOUEURS=28000
+
+printf "%-9s %8s %10s %12s %10s %8s %8s %8s\n" backend tables "tours/s" "appels" "appels/tour" p50_us p99_us p999_us
+
+for BACKEND in poll io_uring; do
+    ./server -B "$BACKEND" -n "$TABLES" -S "$GROUPES" -l avert -m "$METRIQUES" "$PORT" > /dev/null 2>&1 &
+    SERVEUR=$!
+    sleep 0.5
+
+    RAPPORT=$(./loadgen -t 2 -n "$TABLES" -d "$DUREE" -r -p "$PORT_JOUEURS" 127.0.0.1 "$PORT")
+    APPELS=$(curl -s "localhost:$METRIQUES/metrics" | awk '/^sh13_net_syscalls_total/ { print $2 }')
+    kill "$SERVEUR"
+    wait "$SERVEUR" 2>/dev/null
+
+    TOURS=$(echo "$RAPPORT" | awk '/^tours:/ { print $2 }')
+    PARSEC=$(echo "$RAPPORT" | awk '/^tours:/ { gsub(/[(\/s)]/, "", $3); print $3 }')
+    LATENCES=$(echo "$RAPPORT" | grep "latence" | sed 's/.*p50=\([0-9]*\).*p99=\([0-9]*\) p99.9=\([0-9]*\).*/\1 \2 \3/')
+    printf "%-9s %8d %10s %12s %10.1f %8s %8s %8s\n" "$BACKEND" "$TABLES" "$PARSEC" "$APPELS" \
+           "$(echo "$APPELS $TOURS" | awk '{ print ($2 > 0) ? $1 / $2 : 0 }')" $LATENCES
+    sleep 1
+done
@@ -0,0 +1,568 @@
+/*******************************************************************************
+ * BANCS D'ESSAI DES PRIMITIVES
+ * Mesure les fonctions chaudes du serveur et du client une par une: mélange
+ * et distribution (partie.c), lecture de chaque type de message avec le
+ * sscanf de server.c et de sh13.c, mise en forme des réponses (sprintf),
+ * recherche d'un joueur par son nom et envoi à toute la table (fonctions de
+ * server.c, compilé sans son main) vers des puits locaux TCP et unix.
+ *
+ * Chaque banc est calibré (itérations pour durer au moins -t ms), puis
+ * répété -n fois. Une ligne JSON par banc sur la sortie standard:
+ *   {"commit":"...","banc":"...","iterations":N,"ns_min":x,"ns_mediane":x,"ns_max":x}
+ * Avec -r, les médianes sont comparées à celles d'un fichier de résultats
+ * précédent: un banc plus lent de plus de -s % est une régression (code de
+ * retour 1).
+ *
+ * Usage: ./bench_primitives [-c commit] [-f filtre] [-n repetitions] [-t ms]
+ *                           [-r reference.jsonl] [-s seuil%]
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "partie.h"
+#include "session.h"
+#include "transport.h"
+#include "diffusion.h"
+#include "logger.h"
+
+#define REPETITIONS_MAX 100
+#define PUITS           NB_JOUEURS
+#define NB_REFERENCES   256
+
+// Fonctions de server.c (pas d'en-tête: le serveur est un seul programme)
+int findClientByName(struct session *s, char *name);
+void broadcastMessage(struct session *s, char *mess);
+
+/*******************************************************************************
+ * SECTION 1: MESURE
+ ******************************************************************************/
+
+struct banc
+{
+    const char *nom;
+    void (*fonction)(long n);
+};
+
+static volatile long puits;         // Résultats consommés (rien n'est éliminé)
+
+static const char *commit = "inconnu";
+static int repetitions = 5;
+static double dureeMin = 0.05;      // Secondes par répétition au moins
+
+static struct
+{
+    char banc[64];
+    double mediane;
+} references[NB_REFERENCES];
+static int nbReferences = 0;
+static double seuil = 10.0;
+
+static double maintenant()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int comparerDoubles(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Médianes d'un fichier produit par ce programme (champs "banc" et "ns_mediane")
+static int lireReference(const char *chemin)
+{
+    char ligne[512], *p, *q;
+    FILE *f = fopen(chemin, "r");
+
+    if (f == NULL)
+        return -1;
+    while (fgets(ligne, sizeof(ligne), f) != NULL && nbReferences < NB_REFERENCES)
+    {
+        p = strstr(ligne, "\"banc\":\"");
+        q = strstr(ligne, "\"ns_mediane\":");
+        if (p == NULL || q == NULL)
+            continue;
+        p += 8;
+        if (sscanf(p, "%63[^\"]", references[nbReferences].banc) != 1)
+            continue;
+        references[nbReferences].mediane = atof(q + 13);
+        nbReferences++;
+    }
+    fclose(f);
+    return 0;
+}
+
+static double chercherReference(const char *banc)
+{
+    int i;
+
+    for (i=0; i<nbReferences; i++)
+        if (strcmp(references[i].banc, banc) == 0)
+            return references[i].mediane;
+    return 0;
+}
+
+// Calibre, répète et écrit la ligne du banc. Retourne 1 si c'est une régression
+static int mesurer(struct banc *b)
+{
+    double ns[REPETITIONS_MAX], debut, duree, ref, ecart;
+    long n = 1;
+    int r, regression = 0;
+
+    // Itérations doublées jusqu'à durer dureeMin (cache et prédicteurs chauds)
+    for (;;)
+    {
+        debut = maintenant();
+        b->fonction(n);
+        duree = maintenant() - debut;
+        if (duree >= dureeMin)
+            break;
+        n = (duree > dureeMin / 16) ? (long) (n * 1.2 * dureeMin / duree) + 1 : n * 2;
+    }
+
+    for (r=0; r<repetitions; r++)
+    {
+        debut = maintenant();
+        b->fonction(n);
+        ns[r] = (maintenant() - debut) * 1e9 / n;
+    }
+    qsort(ns, repetitions, sizeof(double), comparerDoubles);
+
+    printf("{\"commit\":\"%s\",\"banc\":\"%s\",\"iterations\":%ld,"
+           "\"ns_min\":%.2f,\"ns_mediane\":%.2f,\"ns_max\":%.2f",
+           commit, b->nom, n, ns[0], ns[repetitions/2], ns[repetitions-1]);
+    ref = chercherReference(b->nom);
+    if (ref > 0)
+    {
+        ecart = 100.0 * (ns[repetitions/2] - ref) / ref;
+        regression = (ecart > seuil);
+        printf(",\"reference\":%.2f,\"ecart\":%.1f,\"regression\":%s",
+               ref, ecart, regression ? "true" : "false");
+    }
+    printf("}\n");
+    fflush(stdout);
+    return regression;
+}
+
+/*******************************************************************************
+ * SECTION 2: PARTIE (MÉLANGE ET DISTRIBUTION)
+ ******************************************************************************/
+
+static struct partie partie;
+
+static void bancMelangerDeck(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+    {
+        melangerDeck(&partie);
+        puits += partie.deck[12];
+    }
+}
+
+static void bancCreateTable(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+    {
+        createTable(&partie);
+        puits += partie.tableCartes[3][7];
+    }
+}
+
+/*******************************************************************************
+ * SECTION 3: LECTURE DES MESSAGES
+ * Mêmes formats que server.c (connexion 'C', actions par partieLireAction)
+ * et que sh13.c (un sscanf par type de message reçu)
+ ******************************************************************************/
+
+static char nom1[40], nom2[40], nom3[40], nom4[40];
+
+static void bancLireServeurC(long n)
+{
+    char com, ip[40], nom[40];
+    int port;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf("C 127.0.0.1 32001 Alice", "%c %s %d %s", &com, ip, &port, nom) + port;
+}
+
+static void lireAction(long n, char *mess)
+{
+    struct action act;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += partieLireAction(mess, &act) + act.a;
+}
+
+static void bancLireServeurG(long n) { lireAction(n, "G 1 5 0 #12"); }
+static void bancLireServeurO(long n) { lireAction(n, "O 2 3 0 #13"); }
+static void bancLireServeurS(long n) { lireAction(n, "S 3 0 6 0 #14"); }
+
+static void bancLireClientI(long n)
+{
+    int id, table;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf("I 2 17", "I %d %d", &id, &table) + id;
+}
+
+static void bancLireClientL(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf("L Alice Bob Charlie Diane", "L %s %s %s %s", nom1, nom2, nom3, nom4) + nom4[0];
+}
+
+// Messages de trois entiers: D (cartes), V (réponse O), R (réponse S)
+static void lireTrois(long n, const char *mess, const char *format)
+{
+    int a, b, c;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf(mess, format, &a, &b, &c) + c;
+}
+
+static void bancLireClientD(long n) { lireTrois(n, "D 4 9 11", "D %d %d %d"); }
+static void bancLireClientV(long n) { lireTrois(n, "V 1 3 2", "V %d %d %d"); }
+static void bancLireClientR(long n) { lireTrois(n, "R 6 2 1", "R %d %d %d"); }
+
+// Messages de deux entiers: S (nombre de symboles), F (accusation fausse), W (gagnant)
+static void lireDeux(long n, const char *mess, const char *format)
+{
+    int a, b;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf(mess, format, &a, &b) + b;
+}
+
+static void bancLireClientS(long n) { lireDeux(n, "S 5 3", "S %d %d"); }
+static void bancLireClientF(long n) { lireDeux(n, "F 1 3", "F %d %d"); }
+static void bancLireClientW(long n) { lireDeux(n, "W 2 7", "W %d %d"); }
+
+static void lireUn(long n, const char *mess, const char *format)
+{
+    int a;
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sscanf(mess, format, &a) + a;
+}
+
+static void bancLireClientM(long n) { lireUn(n, "M 3", "M %d"); }
+static void bancLireClientA(long n) { lireUn(n, "A 1", "A %d"); }
+
+/*******************************************************************************
+ * SECTION 4: MISE EN FORME DES RÉPONSES
+ ******************************************************************************/
+
+static char reponse[256];
+
+static void bancFormerI(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sprintf(reponse, "I %d %d", (int) (i & 3), 17);
+}
+
+static void bancFormerL(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sprintf(reponse, "L %s %s %s %s", "Alice", "Bob", "Charlie", "Diane");
+}
+
+static void formerEvenement(long n, char code, int a, int b, int c)
+{
+    struct evenement ev;
+    long i;
+
+    ev.code = code;
+    ev.dest = A_TOUS;
+    ev.b = b;
+    ev.c = c;
+    for (i=0; i<n; i++)
+    {
+        ev.a = a + (i & 1);
+        partieFormater(&ev, reponse);
+        puits += reponse[2];
+    }
+}
+
+static void bancFormerD(long n) { formerEvenement(n, 'D', 4, 9, 11); }
+static void bancFormerM(long n) { formerEvenement(n, 'M', 2, 0, 0); }
+static void bancFormerV(long n) { formerEvenement(n, 'V', 1, 3, 0); }
+static void bancFormerW(long n) { formerEvenement(n, 'W', 2, 7, 0); }
+
+// Réponse à une question S telle que server.c la forme
+static void bancFormerServeurS(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sprintf(reponse, "S %d %d %d %d", 3, (int) (i & 3), 1, 14);
+}
+
+// Action numérotée du client (sh13.c)
+static void bancFormerClientS(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sprintf(reponse, "S %d %d %d %d #%d", 1, 2, 6, 17, (int) i);
+}
+
+static void bancFormerClientC(long n)
+{
+    long i;
+
+    for (i=0; i<n; i++)
+        puits += sprintf(reponse, "C %s %d %s", "127.0.0.1", 32001, "Alice");
+}
+
+/*******************************************************************************
+ * SECTION 5: FONCTIONS DE SERVER.C
+ * Les puits acceptent et lisent les connexions comme un client sh13 (une
+ * connexion par message)
+ ******************************************************************************/
+
+static struct session table;
+static struct ecoute puitsEcoute[2][PUITS];    // [0]: TCP, [1]: unix
+
+static void *filPuits(void *arg)
+{
+    struct ecoute *e = arg;
+    char buffer[256];
+    int fd;
+
+    for (;;)
+    {
+        fd = accept(e->fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        while (read(fd, buffer, sizeof(buffer)) > 0)
+            ;
+        close(fd);
+    }
+    return NULL;
+}
+
+static int ouvrirPuitsTcp(struct ecoute *e)
+{
+    struct sockaddr_in adresse;
+    socklen_t lg = sizeof(adresse);
+
+    e->type = TRANSPORT_TCP;
+    e->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (e->fd < 0)
+        return -1;
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sin_family = AF_INET;
+    adresse.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    adresse.sin_port = 0;
+    if (bind(e->fd, (struct sockaddr *) &adresse, sizeof(adresse)) < 0
+        || listen(e->fd, 128) < 0
+        || getsockname(e->fd, (struct sockaddr *) &adresse, &lg) < 0)
+        return -1;
+    return ntohs(adresse.sin_port);
+}
+
+// Puits TCP et unix de chaque place, avec leur fil
+static int ouvrirPuits()
+{
+    pthread_t fil;
+    char adresse[108];
+    int i, t, port;
+
+    for (i=0; i<PUITS; i++)
+    {
+        port = ouvrirPuitsTcp(&puitsEcoute[0][i]);
+        snprintf(adresse, sizeof(adresse), "unix:/tmp/bench_primitives-%d-%d", (int) getpid(), i);
+        if (port < 0 || transportEcouter(&puitsEcoute[1][i], adresse, 0, 128) < 0)
+            return -1;
+        sprintf(puitsEcoute[0][i].adresse, "%d", port);
+        for (t=0; t<2; t++)
+            if (pthread_create(&fil, NULL, filPuits, &puitsEcoute[t][i]) != 0)
+                return -1;
+    }
+    return 0;
+}
+
+static void fermerPuits()
+{
+    int i;
+
+    for (i=0; i<PUITS; i++)
+        unlink(puitsEcoute[1][i].adresse + 5);
+}
+
+// Table pleine dont les joueurs écoutent sur les puits du transport t
+static void asseoir(int t)
+{
+    static const char *noms[PUITS] = { "Alice", "Bob", "Charlie", "Diane" };
+    int i;
+
+    memset(&table, 0, sizeof(table));
+    for (i=0; i<PUITS; i++)
+    {
+        if (t == 0)
+        {
+            strcpy(table.tcpClients[i].ipAddress, "127.0.0.1");
+            table.tcpClients[i].port = atoi(puitsEcoute[0][i].adresse);
+        }
+        else
+            snprintf(table.tcpClients[i].ipAddress, sizeof(table.tcpClients[i].ipAddress),
+                     "%s", puitsEcoute[1][i].adresse);
+        strcpy(table.tcpClients[i].name, noms[i]);
+    }
+    table.nbClients = PUITS;
+}
+
+static void bancTrouverDernier(long n)
+{
+    long i;
+
+    asseoir(0);
+    for (i=0; i<n; i++)
+        puits += findClientByName(&table, "Diane");
+}
+
+static void bancTrouverAbsent(long n)
+{
+    long i;
+
+    asseoir(0);
+    for (i=0; i<n; i++)
+        puits += findClientByName(&table, "Eve");
+}
+
+static void diffuser(long n, int t)
+{
+    long i;
+
+    asseoir(t);
+    for (i=0; i<n; i++)
+        broadcastMessage(&table, "V 1 3 2");
+}
+
+static void bancDiffuserTcp(long n) { diffuser(n, 0); }
+static void bancDiffuserUnix(long n) { diffuser(n, 1); }
+
+/*******************************************************************************
+ * SECTION 6: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+static struct banc bancs[] =
+{
+    { "melangerDeck", bancMelangerDeck },
+    { "createTable", bancCreateTable },
+    { "lire_serveur_C", bancLireServeurC },
+    { "lire_serveur_G", bancLireServeurG },
+    { "lire_serveur_O", bancLireServeurO },
+    { "lire_serveur_S", bancLireServeurS },
+    { "lire_client_I", bancLireClientI },
+    { "lire_client_L", bancLireClientL },
+    { "lire_client_D", bancLireClientD },
+    { "lire_client_M", bancLireClientM },
+    { "lire_client_V", bancLireClientV },
+    { "lire_client_R", bancLireClientR },
+    { "lire_client_S", bancLireClientS },
+    { "lire_client_F", bancLireClientF },
+    { "lire_client_W", bancLireClientW },
+    { "lire_client_A", bancLireClientA },
+    { "former_I", bancFormerI },
+    { "former_L", bancFormerL },
+    { "former_D", bancFormerD },
+    { "former_M", bancFormerM },
+    { "former_V", bancFormerV },
+    { "former_W", bancFormerW },
+    { "former_serveur_S", bancFormerServeurS },
+    { "former_client_C", bancFormerClientC },
+    { "former_client_S", bancFormerClientS },
+    { "findClientByName_dernier", bancTrouverDernier },
+    { "findClientByName_absent", bancTrouverAbsent },
+    { "broadcastMessage_tcp", bancDiffuserTcp },
+    { "broadcastMessage_unix", bancDiffuserUnix },
+};
+
+void usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s [-c commit] [-f filtre] [-n repetitions] [-t ms] [-r reference.jsonl] [-s seuil%%]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filtre = NULL;
+    int opt, i, regressions = 0;
+
+    while ((opt = getopt(argc, argv, "c:f:n:t:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'c':
+                commit = optarg;
+                break;
+            case 'f':
+                filtre = optarg;
+                break;
+            case 'n':
+                repetitions = atoi(optarg);
+                break;
+            case 't':
+                dureeMin = atof(optarg) / 1000;
+                break;
+            case 'r':
+                if (lireReference(optarg) < 0)
+                {
+                    perror(optarg);
+                    exit(1);
+                }
+                break;
+            case 's':
+                seuil = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc || repetitions < 1 || repetitions > REPETITIONS_MAX || dureeMin <= 0)
+        usage(argv[0]);
+
+    // Le serveur ne journalise que ses erreurs (puits injoignables)
+    logInit(stderr, LOG_NIV_ERREUR, 0);
+    if (diffusionInit(1) < 0 || ouvrirPuits() < 0)
+    {
+        perror("puits");
+        exit(1);
+    }
+    partieInit(&partie, 1);
+
+    for (i=0; i<(int) (sizeof(bancs) / sizeof(bancs[0])); i++)
+        if (filtre == NULL || strstr(bancs[i].nom, filtre) != NULL)
+            regressions += mesurer(&bancs[i]);
+
+    fermerPuits();
+    if (regressions > 0)
+        fprintf(stderr, "%d régression(s) au-delà de %.0f %%\n", regressions, seuil);
+    return regressions > 0;
+}
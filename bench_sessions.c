@@ -0,0 +1,281 @@
+/*******************************************************************************
+ * BANC D'ESSAI DES SESSIONS RÉSIDENTES
+ * Garde un grand nombre de tables en mémoire et joue des tours sur des tables
+ * tirées au hasard, avec l'état compact (compact.h) puis avec la
+ * représentation du serveur (struct partie + tcpClients). Rapporte les
+ * octets par session et les tours par seconde.
+ *
+ * Usage: ./bench_sessions [-n sessions] [-t tours] [-k joueursDistincts] [-c]
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "partie.h"
+#include "compact.h"
+#include "session.h"
+
+/*******************************************************************************
+ * SECTION 1: OUTILS
+ ******************************************************************************/
+
+// Table telle que le serveur la représente (hors robots et journal)
+struct sessionClassique
+{
+    struct _client tcpClients[NB_JOUEURS];
+    int nbClients;
+    int fsm;
+    struct partie jeu;
+};
+
+double maintenant()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Mémoire résidente du processus en octets
+long residente()
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    long taille = 0, res = 0;
+
+    if (f == NULL)
+        return 0;
+    if (fscanf(f, "%ld %ld", &taille, &res) != 2)
+        res = 0;
+    fclose(f);
+    return res * sysconf(_SC_PAGESIZE);
+}
+
+static unsigned int alea = 2463534242u;
+
+static unsigned int aleatoire()
+{
+    alea ^= alea << 13;
+    alea ^= alea >> 17;
+    alea ^= alea << 5;
+    return alea;
+}
+
+// Action au hasard pour le joueur courant: surtout des questions,
+// parfois une accusation (les parties finissent et sont redonnées)
+void genererAction(int joueur, struct action *act)
+{
+    unsigned int r = aleatoire();
+
+    act->joueur = joueur;
+    act->a = act->b = 0;
+    switch (r % 100)
+    {
+        case 0: case 1: case 2:
+            act->code = 'G';
+            act->a = (r >> 8) % NB_CARTES;
+            break;
+        case 3: case 4: case 5: case 6: case 7: case 8: case 9:
+        case 10: case 11: case 12: case 13: case 14:
+            act->code = 'O';
+            act->a = (r >> 8) % NB_OBJETS;
+            break;
+        default:
+            act->code = 'S';
+            act->a = (joueur + 1 + (r >> 8) % 3) % NB_JOUEURS;
+            act->b = (r >> 16) % NB_OBJETS;
+            break;
+    }
+}
+
+/*******************************************************************************
+ * SECTION 2: VÉRIFICATION
+ * Les deux représentations jouent les mêmes actions et doivent produire
+ * exactement les mêmes événements
+ ******************************************************************************/
+
+long verifier(long tours)
+{
+    struct partie p;
+    struct partieCompacte pc;
+    struct action act;
+    struct evenement ev1[MAX_EVENEMENTS], ev2[MAX_EVENEMENTS];
+    long differences = 0, t;
+    unsigned int graine = 1;
+    int n1, n2, i;
+
+    partieInit(&p, graine);
+    compactInit(&pc, graine);
+    n1 = partieDemarrer(&p, ev1);
+    n2 = compactDemarrer(&pc, ev2);
+    if (n1 != n2 || memcmp(ev1, ev2, n1 * sizeof(ev1[0])) != 0)
+        differences++;
+
+    for (t=0; t<tours; t++)
+    {
+        genererAction(p.joueurCourant, &act);
+        n1 = partieAppliquer(&p, &act, ev1);
+        n2 = compactAppliquer(&pc, &act, ev2);
+        if (n1 != n2)
+            differences++;
+        else
+            for (i=0; i<n1; i++)
+                if (ev1[i].code != ev2[i].code || ev1[i].dest != ev2[i].dest || ev1[i].a != ev2[i].a
+                    || ev1[i].b != ev2[i].b || ev1[i].c != ev2[i].c)
+                {
+                    differences++;
+                    break;
+                }
+        if (p.gagnant != -1)
+        {
+            graine++;
+            partieInit(&p, graine);
+            compactInit(&pc, graine);
+        }
+    }
+    return differences;
+}
+
+/*******************************************************************************
+ * SECTION 3: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    struct sessionCompacte *compactes;
+    struct sessionClassique *classiques;
+    struct tableNoms noms;
+    struct action act;
+    struct evenement ev[MAX_EVENEMENTS];
+    struct sessionCompacte *sc;
+    struct sessionClassique *cl;
+    char texte[64];
+    long nbSessions = 1000000, tours = 20000000, nbNoms = 100000, parties, t, i, k;
+    long avant, octetsCompact, octetsClassique;
+    double debut, dureeInit, duree;
+    int classique = 1, opt, j, n;
+
+    while ((opt = getopt(argc, argv, "n:t:k:c")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': nbSessions = atol(optarg); break;
+            case 't': tours = atol(optarg); break;
+            case 'k': nbNoms = atol(optarg); break;
+            case 'c': classique = 0; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n sessions] [-t tours] [-k joueursDistincts] [-c]\n", argv[0]);
+                exit(1);
+        }
+    }
+    if (nbSessions < 1 || nbNoms < 1)
+        exit(1);
+
+    printf("=== SESSIONS RÉSIDENTES: %ld tables, %ld tours, %ld joueurs distincts ===\n",
+           nbSessions, tours, nbNoms);
+    printf("vérification compact / partie.c: %ld différences sur 1000000 tours\n\n", verifier(1000000));
+
+    /* État compact */
+    avant = residente();
+    debut = maintenant();
+    if (nomsInit(&noms, nbNoms * 2) < 0)
+        exit(1);
+    compactes = aligned_alloc(64, nbSessions * sizeof(struct sessionCompacte));
+    if (compactes == NULL)
+        exit(1);
+    for (i=0; i<nbSessions; i++)
+    {
+        sc = &compactes[i];
+        compactInit(&sc->jeu, i + 1);
+        sc->graine = i + 1;
+        sc->fsm = 1;
+        sc->nbClients = NB_JOUEURS;
+        sc->robots = 0;
+        sc->libre = 0;
+        for (j=0; j<NB_JOUEURS; j++)
+        {
+            k = (i * NB_JOUEURS + j) % nbNoms;
+            sprintf(texte, "joueur%ld", k);
+            sc->noms[j] = nomsInterner(&noms, texte);
+            sprintf(texte, "10.%ld.%ld.%ld %ld", (k >> 16) & 255, (k >> 8) & 255, k & 255, 5000 + k % 1000);
+            sc->adresses[j] = nomsInterner(&noms, texte);
+        }
+    }
+    dureeInit = maintenant() - debut;
+    octetsCompact = residente() - avant;
+
+    alea = 2463534242u;
+    parties = 0;
+    debut = maintenant();
+    for (t=0; t<tours; t++)
+    {
+        sc = &compactes[aleatoire() % nbSessions];
+        genererAction(sc->jeu.joueurCourant, &act);
+        n = compactAppliquer(&sc->jeu, &act, ev);
+        if (n > 0 && sc->jeu.gagnant != -1)
+        {
+            sc->graine = sc->jeu.alea;
+            compactInit(&sc->jeu, sc->graine);
+            parties++;
+        }
+    }
+    duree = maintenant() - debut;
+
+    printf("compact:    %zu octets par table (+ %.1f octets de noms internés), résident %.1f Mo\n",
+           sizeof(struct sessionCompacte), (double) nomsOctets(&noms) / nbSessions, octetsCompact / 1e6);
+    printf("            initialisation %.2f s (%.2f us/table), %.0f tours/s, %ld parties finies\n",
+           dureeInit, dureeInit * 1e6 / nbSessions, tours / duree, parties);
+
+    /* Représentation du serveur */
+    if (classique)
+    {
+        avant = residente();
+        debut = maintenant();
+        classiques = malloc(nbSessions * sizeof(struct sessionClassique));
+        if (classiques == NULL)
+            exit(1);
+        for (i=0; i<nbSessions; i++)
+        {
+            cl = &classiques[i];
+            partieInit(&cl->jeu, i + 1);
+            cl->fsm = 1;
+            cl->nbClients = NB_JOUEURS;
+            for (j=0; j<NB_JOUEURS; j++)
+            {
+                k = (i * NB_JOUEURS + j) % nbNoms;
+                sprintf(cl->tcpClients[j].name, "joueur%ld", k);
+                sprintf(cl->tcpClients[j].ipAddress, "10.%ld.%ld.%ld", (k >> 16) & 255, (k >> 8) & 255, k & 255);
+                cl->tcpClients[j].port = 5000 + k % 1000;
+                cl->tcpClients[j].robot = 0;
+            }
+        }
+        dureeInit = maintenant() - debut;
+        octetsClassique = residente() - avant;
+
+        alea = 2463534242u;
+        parties = 0;
+        debut = maintenant();
+        for (t=0; t<tours; t++)
+        {
+            cl = &classiques[aleatoire() % nbSessions];
+            genererAction(cl->jeu.joueurCourant, &act);
+            n = partieAppliquer(&cl->jeu, &act, ev);
+            if (n > 0 && cl->jeu.gagnant != -1)
+            {
+                partieInit(&cl->jeu, cl->jeu.alea);
+                parties++;
+            }
+        }
+        duree = maintenant() - debut;
+
+        printf("classique:  %zu octets par table, résident %.1f Mo\n",
+               sizeof(struct sessionClassique), octetsClassique / 1e6);
+        printf("            initialisation %.2f s (%.2f us/table), %.0f tours/s, %ld parties finies\n",
+               dureeInit, dureeInit * 1e6 / nbSessions, tours / duree, parties);
+        free(classiques);
+    }
+
+    free(compactes);
+    nomsLiberer(&noms);
+    return 0;
+}
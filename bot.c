@@ -0,0 +1,273 @@
+/*******************************************************************************
+ * JOUEUR ROBOT
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+
+/*******************************************************************************
+ * SECTION 1: TRIPLETS DE CARTES COMPATIBLES
+ ******************************************************************************/
+
+// Nombre maximum de triplets parmi les 10 cartes que le robot ne possède pas
+#define MAX_TRIPLETS 120
+
+// Vérifie qu'un triplet de cartes (masque de bits) est compatible
+// avec tout ce que le robot sait de la main du joueur j
+static int tripletCompatible(struct bot *b, int j, int triplet)
+{
+    int o, c, somme;
+
+    for (o=0; o<NB_OBJETS; o++)
+    {
+        somme = 0;
+        for (c=0; c<NB_CARTES; c++)
+            if (triplet & (1<<c))
+                somme += symbolesCartes[c][o];
+
+        if (b->stat[j][o] != -1 && b->stat[j][o] != somme)
+            return 0;
+        if (b->presence[j][o] != -1 && b->presence[j][o] != (somme > 0))
+            return 0;
+    }
+    return 1;
+}
+
+// Liste les triplets compatibles pour le joueur j, retourne leur nombre
+static int listerTriplets(struct bot *b, int j, int reste, int *triplets)
+{
+    int c1, c2, c3, t, n = 0;
+
+    for (c1=0; c1<NB_CARTES; c1++)
+        for (c2=c1+1; c2<NB_CARTES; c2++)
+            for (c3=c2+1; c3<NB_CARTES; c3++)
+            {
+                t = (1<<c1) | (1<<c2) | (1<<c3);
+                if ((t & reste) == t && tripletCompatible(b, j, t))
+                    triplets[n++] = t;
+            }
+    return n;
+}
+
+/*******************************************************************************
+ * SECTION 2: DÉDUCTION DES COUPABLES POSSIBLES
+ ******************************************************************************/
+
+// Remplit possible[] avec les cartes pouvant encore être le coupable
+// Retourne le nombre de coupables possibles
+static int deduireCoupables(struct bot *b, int *possible)
+{
+    int autres[3], triplets[3][MAX_TRIPLETS], nb[3];
+    int reste, i, j, k, a, c, n;
+
+    // Cartes que le robot n'a pas en main
+    reste = (1<<NB_CARTES) - 1;
+    for (i=0; i<3; i++)
+        reste &= ~(1<<b->cartes[i]);
+
+    for (i=0, j=0; j<NB_JOUEURS; j++)
+        if (j != b->id)
+            autres[i++] = j;
+
+    for (i=0; i<3; i++)
+        nb[i] = listerTriplets(b, autres[i], reste, triplets[i]);
+
+    for (c=0; c<NB_CARTES; c++)
+        possible[c] = 0;
+
+    // Toute répartition disjointe des trois mains laisse une seule carte: le coupable
+    for (i=0; i<nb[0]; i++)
+        for (j=0; j<nb[1]; j++)
+        {
+            if (triplets[0][i] & triplets[1][j])
+                continue;
+            for (k=0; k<nb[2]; k++)
+            {
+                if (triplets[2][k] & (triplets[0][i] | triplets[1][j]))
+                    continue;
+                a = reste & ~(triplets[0][i] | triplets[1][j] | triplets[2][k]);
+                for (c=0; c<NB_CARTES; c++)
+                    if (a == (1<<c))
+                        possible[c] = !b->innocent[c];
+            }
+        }
+
+    n = 0;
+    for (c=0; c<NB_CARTES; c++)
+        n += possible[c];
+    return n;
+}
+
+/*******************************************************************************
+ * SECTION 3: INTERFACE DU ROBOT
+ ******************************************************************************/
+
+void botInit(struct bot *b, int id)
+{
+    int j, o, c;
+
+    b->id = id;
+    for (j=0; j<3; j++)
+        b->cartes[j] = -1;
+    for (j=0; j<NB_JOUEURS; j++)
+        for (o=0; o<NB_OBJETS; o++)
+        {
+            b->stat[j][o] = -1;
+            b->presence[j][o] = -1;
+        }
+    for (c=0; c<NB_CARTES; c++)
+        b->innocent[c] = 0;
+    b->requete = 0;
+    for (j=0; j<BOT_QUESTIONS; j++)
+        b->questions[j].requete = 0;
+}
+
+void botRecoit(struct bot *b, char *mess)
+{
+    int x, y, z, j, o, n, q;
+
+    switch (mess[0])
+    {
+        // Distribution: le robot connaît exactement sa propre ligne
+        case 'D':
+            sscanf(mess, "D %d %d %d", &b->cartes[0], &b->cartes[1], &b->cartes[2]);
+            for (o=0; o<NB_OBJETS; o++)
+            {
+                b->stat[b->id][o] = 0;
+                for (j=0; j<3; j++)
+                    b->stat[b->id][o] += symbolesCartes[b->cartes[j]][o];
+                b->presence[b->id][o] = (b->stat[b->id][o] > 0);
+            }
+            break;
+
+        // Réponse à une question O/N: "R <objet> <joueur> <0|1>"
+        case 'R':
+            if (sscanf(mess, "R %d %d %d", &x, &y, &z) == 3)
+            {
+                b->presence[y][x] = z;
+                if (z == 0)
+                    b->stat[y][x] = 0;
+            }
+            break;
+
+        // Réponse à une de nos questions statistiques: "S <objet> <valeur> [#requete]"
+        case 'S':
+            n = lireRequete(mess);
+            if (n == 0)
+                n = b->requete;
+            q = n % BOT_QUESTIONS;
+            if (sscanf(mess, "S %d %d", &x, &z) == 2 && n != 0
+                && b->questions[q].requete == n && b->questions[q].objet == x)
+            {
+                b->stat[b->questions[q].joueur][x] = z;
+                b->presence[b->questions[q].joueur][x] = (z > 0);
+                b->questions[q].requete = 0;
+            }
+            break;
+
+        // Mauvaise accusation: la carte accusée est innocente
+        case 'F':
+            if (sscanf(mess, "F %d %d", &x, &y) == 2)
+                b->innocent[y] = 1;
+            break;
+    }
+}
+
+void botJoue(struct bot *b, char *action)
+{
+    int possible[NB_CARTES];
+    int triplets[MAX_TRIPLETS];
+    int valeurs[4];
+    int n, c, j, o, t, k, v, q, reste, distincts, inconnus;
+    int meilleurJoueur = -1, meilleurObjet = -1, meilleur = 0;
+    int objetON = -1, meilleurON = 1;
+
+    b->requete++;
+
+    // Une seule possibilité: on accuse
+    n = deduireCoupables(b, possible);
+    if (n == 1)
+    {
+        for (c=0; c<NB_CARTES; c++)
+            if (possible[c])
+                break;
+        sprintf(action, "G %d %d", b->id, c);
+        return;
+    }
+
+    // Connaissances incohérentes (ne devrait pas arriver): accusation au hasard
+    if (n == 0)
+    {
+        do
+            c = rand() % NB_CARTES;
+        while (b->innocent[c] || c == b->cartes[0] || c == b->cartes[1] || c == b->cartes[2]);
+        sprintf(action, "G %d %d", b->id, c);
+        return;
+    }
+
+    reste = (1<<NB_CARTES) - 1;
+    for (k=0; k<3; k++)
+        reste &= ~(1<<b->cartes[k]);
+
+    // Question statistique la plus discriminante: celle dont la réponse
+    // prend le plus de valeurs différentes parmi les mains encore possibles
+    for (j=0; j<NB_JOUEURS; j++)
+    {
+        if (j == b->id)
+            continue;
+        n = listerTriplets(b, j, reste, triplets);
+        for (o=0; o<NB_OBJETS; o++)
+        {
+            if (b->stat[j][o] != -1)
+                continue;
+            for (v=0; v<4; v++)
+                valeurs[v] = 0;
+            for (t=0; t<n; t++)
+            {
+                v = 0;
+                for (c=0; c<NB_CARTES; c++)
+                    if (triplets[t] & (1<<c))
+                        v += symbolesCartes[c][o];
+                valeurs[v] = 1;
+            }
+            distincts = valeurs[0] + valeurs[1] + valeurs[2] + valeurs[3];
+            if (distincts > meilleur || (distincts == meilleur && rand() % 2))
+            {
+                meilleur = distincts;
+                meilleurJoueur = j;
+                meilleurObjet = o;
+            }
+        }
+    }
+
+    // Question O/N si un objet est inconnu chez plusieurs adversaires
+    // et qu'aucune question statistique n'est vraiment discriminante
+    for (o=0; o<NB_OBJETS; o++)
+    {
+        inconnus = 0;
+        for (j=0; j<NB_JOUEURS; j++)
+            if (j != b->id && b->presence[j][o] == -1)
+                inconnus++;
+        if (inconnus > meilleurON)
+        {
+            meilleurON = inconnus;
+            objetON = o;
+        }
+    }
+
+    if (meilleurJoueur == -1 || (objetON != -1 && meilleur <= 2))
+    {
+        if (objetON == -1)
+            objetON = rand() % NB_OBJETS;
+        sprintf(action, "O %d %d", b->id, objetON);
+        return;
+    }
+
+    q = b->requete % BOT_QUESTIONS;
+    b->questions[q].requete = b->requete;
+    b->questions[q].joueur = meilleurJoueur;
+    b->questions[q].objet = meilleurObjet;
+    sprintf(action, "S %d %d %d", b->id, meilleurJoueur, meilleurObjet);
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * JOUEUR ROBOT
+ * Stratégie de déduction utilisée par les robots du serveur (sans socket)
+ ******************************************************************************/
+#ifndef BOT_H
+#define BOT_H
+
+#include "regles.h"
+
+#define BOT_QUESTIONS 8     // Questions 'S' sans réponse suivies au plus (requêtes en cours)
+
+// Connaissances accumulées par un robot au cours d'une partie
+struct bot
+{
+    int id;                                 // Place du robot à la table (0 à 3)
+    int cartes[3];                          // Cartes reçues avec le message 'D'
+    int stat[NB_JOUEURS][NB_OBJETS];        // Nombre exact de symboles (-1 = inconnu)
+    int presence[NB_JOUEURS][NB_OBJETS];    // Réponse 'R' (-1 = inconnu, 0 = aucun, 1 = au moins un)
+    int innocent[NB_CARTES];                // Cartes que l'on sait innocentes
+    int requete;                            // Numéro de la dernière action choisie par botJoue
+    struct
+    {
+        int requete;                        // 0 = case libre
+        int joueur, objet;
+    } questions[BOT_QUESTIONS];             // Questions 'S' en attente de réponse, par numéro
+};
+
+// Remet à zéro les connaissances du robot pour une nouvelle partie
+void botInit(struct bot *b, int id);
+
+// Met à jour les connaissances du robot à partir d'un message du serveur
+// (mêmes formats que ceux reçus par sh13.c: 'D', 'R', 'S', 'F', ...)
+// Une réponse 'S' est attribuée à sa question par son numéro de requête
+// (sans numéro: la dernière question posée)
+void botRecoit(struct bot *b, char *mess);
+
+// Choisit l'action du robot quand c'est son tour
+// Écrit dans action un message 'G', 'O' ou 'S' au format attendu par le serveur
+// L'action reçoit le numéro b->requete, que l'appelant peut ajouter en "#<n>"
+void botJoue(struct bot *b, char *action);
+
+#endif
@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * CLASSEMENT DES JOUEURS
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "classement.h"
+#include "palmares.h"
+#include "regles.h"
+#include "hachage.h"
+#include "logger.h"
+#include "metriques.h"
+
+#define CLASSEMENT_MAGIQUE  0x31534c43u     // "CLS1"
+#define CAPACITE_INITIALE   65536           // Fiches de l'index créé (puissance de 2)
+#define LOT_MAX             1024            // Parties validées ensemble au plus
+#define JOURNAL_MAX         (4L << 20)      // Octets de journal avant synchronisation de l'index
+#define LOCALES_MASQUE      (2 * LOT_MAX * NB_JOUEURS - 1)
+
+// En-tête de l'index: une page, les fiches suivent
+struct entete
+{
+    unsigned int magique;
+    unsigned int taillefiche;
+    unsigned long capacite;
+    unsigned long nb;
+    unsigned long lot;                      // Dernier lot recopié dans l'index
+    char reserve[4096 - 32];
+};
+
+struct partieFinie
+{
+    char noms[NB_JOUEURS][CLASSEMENT_NOM];
+    int nb;
+    int gagnant;
+    int tours;
+};
+
+// Index projeté et palmarès (recherches des autres fils sous verrou de
+// lecture; seul le fil de validation les modifie, sous verrou d'écriture)
+static char chemin[1024];
+static struct entete *entete = NULL;
+static struct fiche *fiches;
+static size_t taille;
+static int fdJournal = -1;
+static unsigned long nbJoueurs = 0;         // entete->nb, lisible sans verrou (l'index peut être reprojeté)
+static long octetsJournal = 0;
+static pthread_rwlock_t verrouIndex = PTHREAD_RWLOCK_INITIALIZER;
+static struct palmares palmares;
+
+// Parties terminées en attente du prochain lot
+static struct partieFinie file[LOT_MAX];
+static int nbFile = 0;
+static pthread_mutex_t verrouFile = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t attenteLot = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t placeLot = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t lotValide = PTHREAD_COND_INITIALIZER;
+static int lotEnCours = 0;                  // Le fil de validation traite un lot
+
+// Fil de validation: fiches modifiées par le lot en cours (copies)
+static struct partieFinie lot[LOT_MAX];
+static struct fiche locales[LOT_MAX * NB_JOUEURS];
+static int indexLocales[2 * LOT_MAX * NB_JOUEURS];     // Indice + 1, 0 = case vide
+static int nbLocales;
+
+/*******************************************************************************
+ * INDEX PROJETÉ
+ ******************************************************************************/
+
+// Fiche du nom dans une table, NULL si absente (creer: ajoutée, fiche initiale)
+static struct fiche *trouver(struct entete *e, struct fiche *t, const char *nom, int creer)
+{
+    unsigned long masque = e->capacite - 1;
+    unsigned long i;
+
+    for (i = hacherNom(nom) & masque; t[i].nom[0] != '\0'; i = (i + 1) & masque)
+        if (strncmp(t[i].nom, nom, CLASSEMENT_NOM - 1) == 0)
+            return &t[i];
+    if (!creer)
+        return NULL;
+    memset(&t[i], 0, sizeof(t[i]));
+    strncpy(t[i].nom, nom, CLASSEMENT_NOM - 1);
+    t[i].elo = CLASSEMENT_ELO_INITIAL;
+    e->nb++;
+    return &t[i];
+}
+
+// Projette le fichier de l'index (créé vide avec capacite fiches s'il n'existe pas)
+static int projeter(const char *fichier, unsigned long capacite, struct entete **e, size_t *lg)
+{
+    struct stat st;
+    int fd;
+
+    fd = open(fichier, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) < 0)
+        return -1;
+    if (st.st_size == 0)
+    {
+        st.st_size = sizeof(struct entete) + capacite * sizeof(struct fiche);
+        if (ftruncate(fd, st.st_size) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    *e = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (*e == MAP_FAILED)
+        return -1;
+    *lg = st.st_size;
+
+    if ((*e)->magique == 0)
+    {
+        (*e)->magique = CLASSEMENT_MAGIQUE;
+        (*e)->taillefiche = sizeof(struct fiche);
+        (*e)->capacite = capacite;
+    }
+    if ((*e)->magique != CLASSEMENT_MAGIQUE || (*e)->taillefiche != sizeof(struct fiche)
+        || sizeof(struct entete) + (*e)->capacite * sizeof(struct fiche) != *lg)
+    {
+        munmap(*e, *lg);
+        return -1;
+    }
+    return 0;
+}
+
+// Double la capacité: nouvel index rempli puis renommé (verrou d'écriture tenu)
+static int agrandir()
+{
+    struct entete *e;
+    struct fiche *t;
+    char temporaire[1100];
+    size_t lg;
+    unsigned long i;
+
+    snprintf(temporaire, sizeof(temporaire), "%s.nouveau", chemin);
+    unlink(temporaire);
+    if (projeter(temporaire, 2 * entete->capacite, &e, &lg) < 0)
+        return -1;
+    t = (struct fiche *)(e + 1);
+    for (i=0; i<entete->capacite; i++)
+        if (fiches[i].nom[0] != '\0')
+            *trouver(e, t, fiches[i].nom, 1) = fiches[i];
+    e->lot = entete->lot;
+    if (msync(e, lg, MS_SYNC) < 0 || rename(temporaire, chemin) < 0)
+    {
+        munmap(e, lg);
+        return -1;
+    }
+    LOG_INFO("Classement: index agrandi à %lu fiches (%lu joueurs)", e->capacite, e->nb);
+    munmap(entete, taille);
+    entete = e;
+    fiches = t;
+    taille = lg;
+    return 0;
+}
+
+// Recopie une fiche validée dans l'index si elle est plus récente
+static int recopier(struct fiche *f)
+{
+    struct fiche *g;
+
+    if (4 * (entete->nb + 1) > 3 * entete->capacite && agrandir() < 0)
+        return -1;
+    g = trouver(entete, fiches, f->nom, 1);
+    __atomic_store_n(&nbJoueurs, entete->nb, __ATOMIC_RELAXED);
+    if (g->lot < f->lot)
+        *g = *f;
+    if (entete->lot < f->lot)
+        entete->lot = f->lot;
+    return 0;
+}
+
+// Index à jour sur disque: le journal peut être vidé
+static void synchroniser()
+{
+    if (msync(entete, taille, MS_SYNC) == 0 && ftruncate(fdJournal, 0) == 0)
+        octetsJournal = 0;
+}
+
+/*******************************************************************************
+ * VALIDATION GROUPÉE
+ ******************************************************************************/
+
+// Copie de travail de la fiche d'un joueur pour le lot en cours
+static struct fiche *locale(const char *nom)
+{
+    struct fiche *f;
+    unsigned int i;
+
+    for (i = hacherNom(nom) & LOCALES_MASQUE; indexLocales[i] != 0; i = (i + 1) & LOCALES_MASQUE)
+        if (strcmp(locales[indexLocales[i] - 1].nom, nom) == 0)
+            return &locales[indexLocales[i] - 1];
+
+    indexLocales[i] = ++nbLocales;
+    if ((f = trouver(entete, fiches, nom, 0)) != NULL)
+        locales[nbLocales - 1] = *f;
+    else
+    {
+        f = &locales[nbLocales - 1];
+        memset(f, 0, sizeof(*f));
+        memcpy(f->nom, nom, strnlen(nom, CLASSEMENT_NOM - 1));
+        f->nom[CLASSEMENT_NOM - 1] = '\0';
+        f->elo = CLASSEMENT_ELO_INITIAL;
+    }
+    return &locales[nbLocales - 1];
+}
+
+// Elo à plusieurs: le gagnant bat chacun des autres, K partagé entre les duels
+// (cotes d'avant la partie)
+static void noter(struct partieFinie *p)
+{
+    struct fiche *f[NB_JOUEURS] = { NULL };
+    float avant[NB_JOUEURS], attendu, delta;
+    int i;
+
+    for (i=0; i<p->nb; i++)
+    {
+        f[i] = locale(p->noms[i]);
+        avant[i] = f[i]->elo;
+        f[i]->parties++;
+    }
+    if (p->gagnant < 0 || p->gagnant >= p->nb)
+        return;
+    f[p->gagnant]->victoires++;
+    f[p->gagnant]->toursVictoires += p->tours;
+    for (i=0; i<p->nb; i++)
+    {
+        if (i == p->gagnant)
+            continue;
+        attendu = 1.0f / (1.0f + powf(10.0f, (avant[i] - avant[p->gagnant]) / 400.0f));
+        delta = CLASSEMENT_K * (1.0f - attendu) / (p->nb - 1);
+        f[p->gagnant]->elo += delta;
+        f[i]->elo -= delta;
+    }
+}
+
+static void *filValidation(void *arg)
+{
+    unsigned long numero;
+    ssize_t lg;
+    off_t fin;
+    int n, i;
+
+    (void) arg;
+    while (1)
+    {
+        pthread_mutex_lock(&verrouFile);
+        lotEnCours = 0;
+        pthread_cond_broadcast(&lotValide);
+        while (nbFile == 0)
+            pthread_cond_wait(&attenteLot, &verrouFile);
+        lotEnCours = 1;
+        n = nbFile;
+        memcpy(lot, file, n * sizeof(struct partieFinie));
+        nbFile = 0;
+        pthread_cond_broadcast(&placeLot);
+        pthread_mutex_unlock(&verrouFile);
+
+        // Nouvelles fiches calculées sur des copies: l'index ne change qu'une
+        // fois le lot écrit dans le journal
+        nbLocales = 0;
+        memset(indexLocales, 0, sizeof(indexLocales));
+        for (i=0; i<n; i++)
+            noter(&lot[i]);
+        numero = entete->lot + 1;
+        for (i=0; i<nbLocales; i++)
+            locales[i].lot = numero;
+
+        // Un lot perdu (écriture incomplète, disque plein) ne laisse aucun
+        // octet dans le journal: les lots suivants restent alignés sur les fiches
+        lg = nbLocales * sizeof(struct fiche);
+        fin = lseek(fdJournal, 0, SEEK_END);
+        if (write(fdJournal, locales, lg) != lg || fdatasync(fdJournal) < 0)
+        {
+            LOG_ERREUR("Classement: écriture du journal impossible, lot de %d partie(s) perdu", n);
+            if (fin < 0 || ftruncate(fdJournal, fin) < 0)
+                LOG_ERREUR("Classement: journal %s.journal non tronqué après l'échec", chemin);
+            continue;
+        }
+        octetsJournal += lg;
+        metriquesCompte(MET_LOTS_CLASSEMENT, 1);
+
+        pthread_rwlock_wrlock(&verrouIndex);
+        for (i=0; i<nbLocales; i++)
+            if (recopier(&locales[i]) < 0)
+                LOG_ERREUR("Classement: index plein, fiche de %s dans le journal seulement", locales[i].nom);
+            else if (palmaresCoter(&palmares, locales[i].nom, locales[i].elo) < 0)
+                LOG_ERREUR("Classement: mémoire pleine, %s absent du palmarès", locales[i].nom);
+        pthread_rwlock_unlock(&verrouIndex);
+
+        if (octetsJournal > JOURNAL_MAX)
+            synchroniser();
+        LOG_DEBUG("Classement: lot %lu, %d partie(s), %d fiche(s)", numero, n, nbLocales);
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * INTERFACE
+ ******************************************************************************/
+
+int classementOuvrir(const char *fichier)
+{
+    struct fiche f;
+    char journal[1100];
+    pthread_t fil;
+    long rejouees = 0;
+    unsigned long i;
+
+    if (strlen(fichier) >= sizeof(chemin) - 16)
+        return -1;
+    strcpy(chemin, fichier);
+    if (projeter(chemin, CAPACITE_INITIALE, &entete, &taille) < 0)
+        return -1;
+    fiches = (struct fiche *)(entete + 1);
+    nbJoueurs = entete->nb;
+
+    // Lots validés après la dernière synchronisation de l'index
+    snprintf(journal, sizeof(journal), "%s.journal", chemin);
+    fdJournal = open(journal, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fdJournal < 0)
+        return -1;
+    while (read(fdJournal, &f, sizeof(f)) == sizeof(f))
+    {
+        f.nom[CLASSEMENT_NOM - 1] = '\0';
+        if (f.nom[0] != '\0' && recopier(&f) == 0)
+            rejouees++;
+    }
+    synchroniser();
+    LOG_INFO("Classement %s: %lu joueur(s), %ld fiche(s) rejouée(s) du journal",
+             chemin, entete->nb, rejouees);
+
+    // Palmarès: seule construction complète, ensuite mis à jour fiche par fiche
+    if (palmaresInit(&palmares) < 0)
+        return -1;
+    for (i=0; i<entete->capacite; i++)
+        if (fiches[i].nom[0] != '\0' && palmaresCoter(&palmares, fiches[i].nom, fiches[i].elo) < 0)
+            return -1;
+
+    if (pthread_create(&fil, NULL, filValidation, NULL) != 0)
+        return -1;
+    pthread_detach(fil);
+    return 0;
+}
+
+int classementChercher(const char *nom, struct fiche *f)
+{
+    struct fiche *g = NULL;
+
+    if (entete != NULL)
+    {
+        pthread_rwlock_rdlock(&verrouIndex);
+        g = trouver(entete, fiches, nom, 0);
+        if (g != NULL)
+            *f = *g;
+        pthread_rwlock_unlock(&verrouIndex);
+    }
+    if (g != NULL)
+        return 1;
+    memset(f, 0, sizeof(*f));
+    strncpy(f->nom, nom, CLASSEMENT_NOM - 1);
+    f->elo = CLASSEMENT_ELO_INITIAL;
+    return 0;
+}
+
+void classementPartie(char noms[][CLASSEMENT_NOM], int nb, int gagnant, int tours)
+{
+    struct partieFinie *p;
+    int i;
+
+    if (entete == NULL || nb < 1)
+        return;
+    pthread_mutex_lock(&verrouFile);
+    while (nbFile == LOT_MAX)
+        pthread_cond_wait(&placeLot, &verrouFile);
+    p = &file[nbFile++];
+    for (i=0; i<nb && i<NB_JOUEURS; i++)
+    {
+        strncpy(p->noms[i], noms[i], CLASSEMENT_NOM - 1);
+        p->noms[i][CLASSEMENT_NOM - 1] = '\0';
+    }
+    p->nb = i;
+    p->gagnant = gagnant;
+    p->tours = tours;
+    if (nbFile == 1)
+        pthread_cond_signal(&attenteLot);
+    pthread_mutex_unlock(&verrouFile);
+}
+
+void classementVider()
+{
+    if (entete == NULL)
+        return;
+    pthread_mutex_lock(&verrouFile);
+    while (nbFile > 0 || lotEnCours)
+        pthread_cond_wait(&lotValide, &verrouFile);
+    // Verrou gardé: le fil de validation ne prend pas de lot pendant la synchronisation
+    synchroniser();
+    pthread_mutex_unlock(&verrouFile);
+}
+
+unsigned long classementRang(const char *nom, struct fiche *f)
+{
+    struct fiche *g;
+    unsigned long rang = 0;
+
+    if (entete == NULL)
+        return 0;
+    pthread_rwlock_rdlock(&verrouIndex);
+    if ((g = trouver(entete, fiches, nom, 0)) != NULL)
+    {
+        *f = *g;
+        rang = palmaresRang(&palmares, nom);
+    }
+    pthread_rwlock_unlock(&verrouIndex);
+    return rang;
+}
+
+int classementPalmares(unsigned long debut, int nb, struct fiche *f)
+{
+    struct joueurPalmares *j;
+    struct fiche *g;
+    int n = 0;
+
+    if (entete == NULL)
+        return 0;
+    pthread_rwlock_rdlock(&verrouIndex);
+    for (j = palmaresAuRang(&palmares, debut); j != NULL && n < nb; j = palmaresSuivant(j))
+    {
+        g = trouver(entete, fiches, j->nom, 0);
+        if (g != NULL)
+            f[n++] = *g;
+    }
+    pthread_rwlock_unlock(&verrouIndex);
+    return n;
+}
+
+long classementJoueurs()
+{
+    return (long) __atomic_load_n(&nbJoueurs, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * CLASSEMENT DES JOUEURS
+ * Cote Elo, parties, victoires et tours joués pour gagner, conservés sur
+ * disque d'une exécution à l'autre. L'index est une table de hachage par nom
+ * (adressage ouvert, sondage linéaire) dans un fichier projeté en mémoire:
+ * une recherche touche une ou deux pages, seules les pages utilisées sont en
+ * mémoire, quel que soit le nombre de joueurs. La table double (nouveau
+ * fichier, renommé) au-delà de 3/4 de remplissage.
+ * Les fins de partie sont mises en file par les fils des tables; un fil de
+ * validation les traite par lots: les fiches modifiées d'un lot sont écrites
+ * dans le journal <fichier>.journal avec un seul fdatasync (validation
+ * groupée), puis recopiées dans l'index. Le journal est vidé une fois l'index
+ * synchronisé; au démarrage, ses fiches plus récentes que celles de l'index
+ * y sont recopiées (rejeu idempotent: valeurs absolues, numéro de lot).
+ * Le palmarès (palmares.c) range les joueurs par cote en mémoire: construit
+ * une fois à l'ouverture, puis tenu à jour par le fil de validation à chaque
+ * fiche recopiée.
+ ******************************************************************************/
+#ifndef CLASSEMENT_H
+#define CLASSEMENT_H
+
+#define CLASSEMENT_NOM          40
+#define CLASSEMENT_ELO_INITIAL  1500.0f
+#define CLASSEMENT_K            32.0f       // Points en jeu entre le gagnant et les autres
+
+// Fiche d'un joueur (64 octets, une ligne de cache)
+struct fiche
+{
+    char nom[CLASSEMENT_NOM];
+    float elo;
+    unsigned int parties;
+    unsigned int victoires;
+    unsigned int toursVictoires;            // Somme des tours joués par le gagnant
+    unsigned long lot;                      // Dernier lot validé qui l'a modifiée
+};
+
+// Ouvre (ou crée) l'index et son journal, rejoue le journal et lance le fil
+// de validation. Retourne -1 en cas d'échec
+int classementOuvrir(const char *fichier);
+
+// Fiche du joueur (copie); fiche initiale et retour 0 s'il est inconnu, 1 sinon
+int classementChercher(const char *nom, struct fiche *f);
+
+// Fin de partie (noms des joueurs classés, indice du gagnant ou -1, tours
+// joués par le gagnant). Mise en file seulement: validée avec le lot suivant
+void classementPartie(char noms[][CLASSEMENT_NOM], int nb, int gagnant, int tours);
+
+// Attend que les parties en file soient validées, puis synchronise l'index
+// (relève par un autre processus: plus aucune partie ne doit être en route)
+void classementVider();
+
+// Rang du joueur dans le palmarès (1 = meilleure cote) et sa fiche (copie)
+// Retourne 0 s'il n'est pas classé
+unsigned long classementRang(const char *nom, struct fiche *f);
+
+// Fiches des joueurs des rangs debut à debut + nb - 1 (debut à partir de 1)
+// Retourne le nombre de fiches copiées
+int classementPalmares(unsigned long debut, int nb, struct fiche *f);
+
+// Joueurs de l'index (jauge)
+long classementJoueurs();
+
+#endif
@@ -1,3 +1,8 @@
 #! /bin/sh
-gcc -o sh13 -I/usr/include/SDL2 sh13.c -lSDL2_image -lSDL2_ttf -lSDL2 -lpthread
-gcc -o server server.c
+gcc -o sh13 -I/usr/include/SDL2 sh13.c transport.c -lSDL2_image -lSDL2_ttf -lSDL2 -lpthread
+gcc -o server server.c regles.c partie.c journal.c reprise.c bot.c session.c logger.c metriques.c histogramme.c minuterie.c lobby.c diffusion.c transport.c uring.c classement.c releve.c palmares.c limiteur.c -lpthread -lm
+gcc -o loadgen loadgen.c regles.c bot.c histogramme.c transport.c -lpthread
+gcc -o tracebench tracebench.c partie.c journal.c regles.c histogramme.c -lpthread
+gcc -o replay replay.c partie.c journal.c regles.c
+gcc -O2 -o bench_sessions bench_sessions.c compact.c partie.c regles.c
+gcc -O2 -o analyse analyse.c colonnes.c compact.c journal.c partie.c regles.c
@@ -0,0 +1,378 @@
+/*******************************************************************************
+ * EXPORT EN COLONNES DES PARTIES
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "colonnes.h"
+
+#define ENTETE_FICHIER  8
+#define ENTETE_BLOC     12
+#define ENTETE_COLONNE  24
+
+static const int codagesParties[P_COLONNES] =
+{
+    COL_DELTA, COL_DELTA, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT,
+    COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT
+};
+
+static const int codagesCoups[C_COLONNES] =
+{
+    COL_DELTA, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT, COL_BRUT
+};
+
+static void ecrireU32(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static void ecrireI64(unsigned char *p, long long v)
+{
+    ecrireU32(p, (unsigned long long) v);
+    ecrireU32(p + 4, (unsigned long long) v >> 32);
+}
+
+static unsigned int lireU32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static long long lireI64(const unsigned char *p)
+{
+    return (long long)(lireU32(p) | ((unsigned long long) lireU32(p + 4) << 32));
+}
+
+static int ecrireTout(struct ecrivainColonnes *e, const void *donnees, size_t n)
+{
+    const char *p = donnees;
+    ssize_t k;
+
+    while (n > 0)
+    {
+        k = write(e->fd, p, n);
+        if (k <= 0)
+            return -1;
+        p += k;
+        n -= k;
+        e->octets += k;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+ * ÉCRITURE
+ ******************************************************************************/
+
+static int blocInit(struct blocColonnes *b, int table, int nbColonnes, const int *codages)
+{
+    int i;
+
+    memset(b, 0, sizeof(*b));
+    b->table = table;
+    b->nbColonnes = nbColonnes;
+    b->codages = codages;
+    for (i=0; i<nbColonnes; i++)
+        if ((b->valeurs[i] = malloc(COLONNES_LIGNES * sizeof(long long))) == NULL)
+            return -1;
+    b->mots = malloc((COLONNES_LIGNES + 1) * sizeof(unsigned long long));
+    if (b->mots == NULL || (table == TABLE_PARTIES && nomsInit(&b->noms, 1024) < 0))
+        return -1;
+    return 0;
+}
+
+static void blocLiberer(struct blocColonnes *b)
+{
+    int i;
+
+    for (i=0; i<b->nbColonnes; i++)
+        free(b->valeurs[i]);
+    free(b->mots);
+    if (b->table == TABLE_PARTIES)
+        nomsLiberer(&b->noms);
+}
+
+// Valeur codée de la ligne i (différence avec la précédente pour COL_DELTA)
+static inline long long codee(struct blocColonnes *b, int c, int i)
+{
+    if (b->codages[c] == COL_DELTA)
+        return i == 0 ? 0 : b->valeurs[c][i] - b->valeurs[c][i-1];
+    return b->valeurs[c][i];
+}
+
+// Écrit le bloc entamé d'une table et le remet à zéro
+static int viderBloc(struct ecrivainColonnes *e, struct blocColonnes *b)
+{
+    unsigned char entete[ENTETE_COLONNE];
+    long long base[COLONNES_MAX], x, max;
+    unsigned long long u;
+    int bits[COLONNES_MAX], mots[COLONNES_MAX];
+    unsigned int octets = 0;
+    long pos;
+    int c, i, k, decalage;
+
+    if (b->lignes == 0)
+        return 0;
+
+    // Largeur de chaque colonne: écart entre ses valeurs extrêmes
+    for (c=0; c<b->nbColonnes; c++)
+    {
+        base[c] = max = codee(b, c, 0);
+        for (i=1; i<b->lignes; i++)
+        {
+            x = codee(b, c, i);
+            if (x < base[c])
+                base[c] = x;
+            if (x > max)
+                max = x;
+        }
+        u = (unsigned long long) max - (unsigned long long) base[c];
+        bits[c] = (u == 0) ? 0 : 64 - __builtin_clzll(u);
+        mots[c] = ((long) b->lignes * bits[c] + 63) / 64;
+        octets += ENTETE_COLONNE + 8 * mots[c];
+    }
+    if (b->table == TABLE_PARTIES)
+        octets += 4 + b->noms.utilise;
+
+    entete[0] = b->table;
+    entete[1] = b->nbColonnes;
+    entete[2] = entete[3] = 0;
+    ecrireU32(entete + 4, b->lignes);
+    ecrireU32(entete + 8, octets);
+    if (ecrireTout(e, entete, ENTETE_BLOC) < 0)
+        return -1;
+
+    // Colonnes: bits serrés, une valeur peut chevaucher deux mots
+    for (c=0; c<b->nbColonnes; c++)
+    {
+        entete[0] = b->codages[c];
+        entete[1] = bits[c];
+        entete[2] = entete[3] = 0;
+        ecrireU32(entete + 4, mots[c]);
+        ecrireI64(entete + 8, base[c]);
+        ecrireI64(entete + 16, b->valeurs[c][0]);
+        if (ecrireTout(e, entete, ENTETE_COLONNE) < 0)
+            return -1;
+        if (bits[c] == 0)
+            continue;
+        memset(b->mots, 0, (mots[c] + 1) * sizeof(unsigned long long));
+        for (i=0; i<b->lignes; i++)
+        {
+            u = (unsigned long long)(codee(b, c, i) - base[c]);
+            pos = (long) i * bits[c];
+            k = pos >> 6;
+            decalage = pos & 63;
+            b->mots[k] |= u << decalage;
+            if (decalage + bits[c] > 64)
+                b->mots[k+1] |= u >> (64 - decalage);
+        }
+        if (ecrireTout(e, b->mots, mots[c] * sizeof(unsigned long long)) < 0)
+            return -1;
+    }
+
+    // Dictionnaire des noms du bloc, remis à zéro pour le suivant
+    if (b->table == TABLE_PARTIES)
+    {
+        ecrireU32(entete, b->noms.utilise);
+        if (ecrireTout(e, entete, 4) < 0 || ecrireTout(e, b->noms.texte, b->noms.utilise) < 0)
+            return -1;
+        nomsLiberer(&b->noms);
+        if (nomsInit(&b->noms, 1024) < 0)
+            return -1;
+    }
+    b->lignes = 0;
+    return 0;
+}
+
+int colonnesCreer(struct ecrivainColonnes *e, const char *chemin)
+{
+    unsigned char entete[ENTETE_FICHIER] = { 'S', 'H', '1', 'K', COLONNES_VERSION, 0, 0, 0 };
+
+    memset(e, 0, sizeof(*e));
+    e->fd = open(chemin, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (e->fd < 0)
+        return -1;
+    if (blocInit(&e->parties, TABLE_PARTIES, P_COLONNES, codagesParties) < 0
+        || blocInit(&e->coups, TABLE_COUPS, C_COLONNES, codagesCoups) < 0
+        || ecrireTout(e, entete, sizeof(entete)) < 0)
+        return -1;
+    return 0;
+}
+
+int colonnesPartie(struct ecrivainColonnes *e, struct lignePartie *p)
+{
+    struct blocColonnes *b = &e->parties;
+    int c;
+
+    for (c=0; c<P_NOM; c++)
+        b->valeurs[c][b->lignes] = p->valeurs[c];
+    for (c=0; c<NB_JOUEURS; c++)
+        b->valeurs[P_NOM + c][b->lignes] = (p->noms[c] == NULL || p->noms[c][0] == '\0') ? 0
+                                           : nomsInterner(&b->noms, p->noms[c]);
+    if (++b->lignes == COLONNES_LIGNES)
+        return viderBloc(e, b);
+    return 0;
+}
+
+int colonnesCoup(struct ecrivainColonnes *e, struct ligneCoup *l)
+{
+    struct blocColonnes *b = &e->coups;
+    int c;
+
+    for (c=0; c<C_COLONNES; c++)
+        b->valeurs[c][b->lignes] = l->valeurs[c];
+    if (++b->lignes == COLONNES_LIGNES)
+        return viderBloc(e, b);
+    return 0;
+}
+
+int colonnesFermer(struct ecrivainColonnes *e)
+{
+    int r = 0;
+
+    if (viderBloc(e, &e->parties) < 0 || viderBloc(e, &e->coups) < 0)
+        r = -1;
+    if (close(e->fd) < 0)
+        r = -1;
+    blocLiberer(&e->parties);
+    blocLiberer(&e->coups);
+    return r;
+}
+
+/*******************************************************************************
+ * LECTURE
+ ******************************************************************************/
+
+int colonnesOuvrir(struct lecteurColonnes *l, const char *chemin)
+{
+    struct stat st;
+    int fd;
+
+    memset(l, 0, sizeof(*l));
+    fd = open(chemin, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) < 0 || st.st_size < ENTETE_FICHIER)
+    {
+        close(fd);
+        return -1;
+    }
+    l->taille = st.st_size;
+    l->donnees = mmap(NULL, l->taille, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (l->donnees == MAP_FAILED)
+        return -1;
+    madvise(l->donnees, l->taille, MADV_SEQUENTIAL);
+    if (memcmp(l->donnees, "SH1K", 4) != 0 || l->donnees[4] != COLONNES_VERSION)
+    {
+        munmap(l->donnees, l->taille);
+        return -1;
+    }
+    l->pos = ENTETE_FICHIER;
+    return 0;
+}
+
+int colonnesBloc(struct lecteurColonnes *l, struct blocLu *b)
+{
+    const unsigned char *p = l->donnees + l->pos, *fin;
+    size_t octets;
+    int c;
+
+    if (l->pos == l->taille)
+        return 0;
+    if (l->pos + ENTETE_BLOC > l->taille)
+        return -1;
+    b->table = p[0];
+    b->nbColonnes = p[1];
+    b->lignes = lireU32(p + 4);
+    octets = lireU32(p + 8);
+    if (b->nbColonnes > COLONNES_MAX || b->lignes > COLONNES_LIGNES
+        || l->pos + ENTETE_BLOC + octets > l->taille)
+        return -1;
+    p += ENTETE_BLOC;
+    fin = p + octets;
+
+    for (c=0; c<b->nbColonnes; c++)
+    {
+        if (p + ENTETE_COLONNE > fin || p + ENTETE_COLONNE + 8 * (size_t) lireU32(p + 4) > fin
+            || p[1] > 64 || 8 * (size_t) lireU32(p + 4) < ((size_t) b->lignes * p[1] + 7) / 8)
+            return -1;
+        b->colonnes[c] = p;
+        p += ENTETE_COLONNE + 8 * (size_t) lireU32(p + 4);
+    }
+
+    b->dictionnaire = NULL;
+    b->octetsDictionnaire = 0;
+    if (b->table == TABLE_PARTIES)
+    {
+        if (p + 4 > fin || p + 4 + lireU32(p) > fin)
+            return -1;
+        b->octetsDictionnaire = lireU32(p);
+        b->dictionnaire = (const char *) p + 4;
+    }
+    l->pos += ENTETE_BLOC + octets;
+    return 1;
+}
+
+void colonnesDecoder(struct blocLu *b, int colonne, long long *valeurs)
+{
+    const unsigned char *p = b->colonnes[colonne];
+    const unsigned char *mots = p + ENTETE_COLONNE;
+    int bits = p[1], i, k, decalage, delta = (p[0] == COL_DELTA);
+    long long base = lireI64(p + 8), precedente = lireI64(p + 16);
+    unsigned long long masque = (bits == 64) ? ~0ULL : (1ULL << bits) - 1;
+    unsigned long long m0, m1, u;
+    long pos;
+
+    if (bits == 0)
+    {
+        for (i=0; i<b->lignes; i++)
+            valeurs[i] = (delta && i > 0) ? valeurs[i-1] + base : (delta ? precedente : base);
+        return;
+    }
+    for (i=0; i<b->lignes; i++)
+    {
+        pos = (long) i * bits;
+        k = pos >> 6;
+        decalage = pos & 63;
+        memcpy(&m0, mots + 8 * k, 8);
+        u = m0 >> decalage;
+        if (decalage + bits > 64)
+        {
+            memcpy(&m1, mots + 8 * (k + 1), 8);
+            u |= m1 << (64 - decalage);
+        }
+        u &= masque;
+        if (delta)
+            valeurs[i] = precedente = (i == 0) ? precedente : precedente + base + (long long) u;
+        else
+            valeurs[i] = base + (long long) u;
+    }
+}
+
+int colonnesNoms(struct blocLu *b, const char **noms, int max)
+{
+    unsigned int pos = 0;
+    int n = 0;
+
+    while (pos < b->octetsDictionnaire && n < max)
+    {
+        noms[n++] = b->dictionnaire + pos;
+        pos += strnlen(b->dictionnaire + pos, b->octetsDictionnaire - pos) + 1;
+    }
+    return n;
+}
+
+void colonnesLiberer(struct lecteurColonnes *l)
+{
+    if (l->donnees != NULL)
+        munmap(l->donnees, l->taille);
+    l->donnees = NULL;
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * EXPORT EN COLONNES DES PARTIES
+ * Deux tables pour l'analyse hors ligne: une ligne par partie (joueurs,
+ * coupable, gagnant...) et une ligne par coup (question, cible, objet,
+ * réponse, accusation). Les lignes sont écrites par blocs de
+ * COLONNES_LIGNES: chaque colonne d'un bloc est un tableau d'entiers de
+ * largeur fixe, la plus petite qui couvre ses valeurs une fois la plus petite
+ * retranchée (bits serrés dans des mots de 64 bits), après différence avec
+ * la ligne précédente pour les colonnes croissantes (numéro de partie,
+ * horodatage). Les noms des joueurs sont des indices dans le dictionnaire
+ * du bloc. L'écriture ne garde qu'un bloc par table en mémoire; la lecture
+ * projette le fichier et ne décode que les colonnes demandées.
+ *
+ * Format (entiers petit-boutistes):
+ *   en-tête: "SH1K" | version u16 | réservé u16
+ *   bloc:    table u8 | colonnes u8 | réservé u16 | lignes u32 | octets u32 (suite du bloc)
+ *   colonne: codage u8 | bits u8 | réservé u16 | mots u32 | base i64 | premier i64 | mots u64
+ *            valeur = base + bits lus (COL_BRUT), ou précédente + base + bits
+ *            lus (COL_DELTA, première valeur = premier)
+ *   puis, bloc de parties: dictionnaire: octets u32 | noms terminés par '\0'
+ *            (indice 0 = "", place vide)
+ ******************************************************************************/
+#ifndef COLONNES_H
+#define COLONNES_H
+
+#include <stddef.h>
+
+#include "partie.h"
+#include "compact.h"
+
+#define COLONNES_VERSION    1
+#define COLONNES_EXTENSION  ".sh13k"
+#define COLONNES_LIGNES     65536       // Lignes d'un bloc au plus
+#define COLONNES_MAX        16
+
+#define COL_BRUT    0
+#define COL_DELTA   1
+
+// Tables et leurs colonnes
+#define TABLE_PARTIES   'P'
+#define P_PARTIE        0       // Numéro de la partie dans l'export
+#define P_DEBUT         1       // Horodatage de la donne (µs depuis l'epoch)
+#define P_DUREE         2       // Durée jusqu'au dernier enregistrement (ms)
+#define P_GRAINE        3
+#define P_COUPABLE      4       // deck[12]
+#define P_GAGNANT       5       // Place du gagnant, -1 si la partie n'est pas finie
+#define P_TOURS         6       // Actions jouées
+#define P_ROBOTS        7       // Bit j: place j tenue par un robot
+#define P_PERDUS        8       // Bit j: place j éliminée (accusation fausse ou forfait)
+#define P_NOM           9       // P_NOM + j: nom de la place j (dictionnaire du bloc)
+#define P_COLONNES      (P_NOM + NB_JOUEURS)
+
+#define TABLE_COUPS     'C'
+#define C_PARTIE        0
+#define C_TOUR          1       // Rang de l'action dans la partie (0 = première)
+#define C_MS            2       // Depuis la donne (ms)
+#define C_JOUEUR        3
+#define C_CODE          4       // 'G', 'O', 'S' ou 'P' (délai dépassé)
+#define C_A             5       // G: carte; O: objet; S: joueur interrogé; P: forfait
+#define C_B             6       // S: objet
+#define C_REPONSE       7       // G: 1 bonne accusation; O: bit j si j a l'objet;
+                                // S: symboles du joueur interrogé; P: 1 éliminé
+#define C_COLONNES      8
+
+struct lignePartie
+{
+    long long valeurs[P_COLONNES];          // P_NOM et suivantes ignorées
+    const char *noms[NB_JOUEURS];
+};
+
+struct ligneCoup
+{
+    long long valeurs[C_COLONNES];
+};
+
+// Bloc en cours d'écriture d'une table
+struct blocColonnes
+{
+    int table;
+    int nbColonnes;
+    const int *codages;
+    int lignes;
+    long long *valeurs[COLONNES_MAX];       // COLONNES_LIGNES valeurs par colonne
+    unsigned long long *mots;               // Colonne codée
+    struct tableNoms noms;                  // Dictionnaire (parties)
+};
+
+struct ecrivainColonnes
+{
+    int fd;
+    struct blocColonnes parties;
+    struct blocColonnes coups;
+    long long octets;                       // Écrits dans le fichier
+};
+
+// Bloc lu: pointeurs dans le fichier projeté
+struct blocLu
+{
+    int table;
+    int nbColonnes;
+    int lignes;
+    const unsigned char *colonnes[COLONNES_MAX];
+    const char *dictionnaire;               // NULL pour les coups
+    unsigned int octetsDictionnaire;
+};
+
+struct lecteurColonnes
+{
+    unsigned char *donnees;
+    size_t taille;
+    size_t pos;
+};
+
+/* Écriture (mémoire bornée: un bloc par table) */
+int colonnesCreer(struct ecrivainColonnes *e, const char *chemin);
+int colonnesPartie(struct ecrivainColonnes *e, struct lignePartie *p);
+int colonnesCoup(struct ecrivainColonnes *e, struct ligneCoup *c);
+int colonnesFermer(struct ecrivainColonnes *e);       // Écrit les blocs entamés
+
+/* Lecture */
+int colonnesOuvrir(struct lecteurColonnes *l, const char *chemin);
+// Bloc suivant, 0 à la fin du fichier, -1 s'il est tronqué ou invalide
+int colonnesBloc(struct lecteurColonnes *l, struct blocLu *b);
+// Décode une colonne du bloc dans valeurs (b->lignes valeurs)
+void colonnesDecoder(struct blocLu *b, int colonne, long long *valeurs);
+// Noms du dictionnaire d'un bloc de parties: noms[i] pour i < retour
+int colonnesNoms(struct blocLu *b, const char **noms, int max);
+void colonnesLiberer(struct lecteurColonnes *l);
+
+#endif
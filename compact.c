@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * ÉTAT COMPACT DES PARTIES
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "compact.h"
+#include "hachage.h"
+
+/*******************************************************************************
+ * SECTION 1: DONNE ET CONVERSIONS
+ ******************************************************************************/
+
+// Symboles d'une carte au format du champ symboles d'un joueur (16 bits)
+static unsigned long long symbolesCarte[NB_CARTES];
+static int precalcule = 0;
+
+static void precalculer()
+{
+    int c, o;
+
+    if (precalcule)
+        return;
+    for (c=0; c<NB_CARTES; c++)
+        for (o=0; o<NB_OBJETS; o++)
+            symbolesCarte[c] |= (unsigned long long) symbolesCartes[c][o] << (2 * o);
+    precalcule = 1;
+}
+
+// Les champs de 2 bits ne débordent pas: au plus 3 cartes par joueur
+static void calculerSymboles(struct partieCompacte *pc)
+{
+    int j;
+
+    precalculer();
+    pc->symboles = 0;
+    for (j=0; j<NB_JOUEURS; j++)
+        pc->symboles |= (symbolesCarte[compactCarte(pc, 3*j)]
+                         + symbolesCarte[compactCarte(pc, 3*j+1)]
+                         + symbolesCarte[compactCarte(pc, 3*j+2)]) << (2 * NB_OBJETS * j);
+}
+
+void compactInit(struct partieCompacte *pc, unsigned int graine)
+{
+    struct partie p;
+
+    partieInit(&p, graine);
+    compactDepuis(pc, &p);
+}
+
+void compactDepuis(struct partieCompacte *pc, const struct partie *p)
+{
+    int i;
+
+    pc->deck = 0;
+    for (i=0; i<NB_CARTES; i++)
+        pc->deck |= (unsigned long long) p->deck[i] << (4 * i);
+    calculerSymboles(pc);
+    pc->alea = p->alea;
+    pc->joueurCourant = p->joueurCourant;
+    pc->perdus = 0;
+    for (i=0; i<NB_JOUEURS; i++)
+        if (p->joueursPerdu[i])
+            pc->perdus |= 1 << i;
+    pc->gagnant = p->gagnant;
+}
+
+void compactVers(const struct partieCompacte *pc, struct partie *p)
+{
+    int i, o;
+
+    p->alea = pc->alea;
+    for (i=0; i<NB_CARTES; i++)
+        p->deck[i] = compactCarte(pc, i);
+    for (i=0; i<NB_JOUEURS; i++)
+    {
+        for (o=0; o<NB_OBJETS; o++)
+            p->tableCartes[i][o] = compactSymboles(pc, i, o);
+        p->joueursPerdu[i] = compactPerdu(pc, i);
+    }
+    p->joueurCourant = pc->joueurCourant;
+    p->gagnant = pc->gagnant;
+}
+
+/*******************************************************************************
+ * SECTION 2: DÉROULEMENT D'UN TOUR (règles de partie.c)
+ ******************************************************************************/
+
+static int evenement(struct evenement *ev, char code, int dest, int a, int b, int c)
+{
+    ev->code = code;
+    ev->dest = dest;
+    ev->a = a;
+    ev->b = b;
+    ev->c = c;
+    return 1;
+}
+
+static int joueurSuivant(struct partieCompacte *pc, struct evenement *ev)
+{
+    int i;
+
+    for (i=0; i<NB_JOUEURS; i++)
+    {
+        pc->joueurCourant = (pc->joueurCourant + 1) % NB_JOUEURS;
+        if (!compactPerdu(pc, pc->joueurCourant))
+            break;
+    }
+    return evenement(ev, 'M', A_TOUS, pc->joueurCourant, 0, 0);
+}
+
+int compactDemarrer(struct partieCompacte *pc, struct evenement *ev)
+{
+    int i, n = 0;
+
+    for (i=0; i<NB_JOUEURS; i++)
+        n += evenement(&ev[n], 'D', i, compactCarte(pc, 3*i), compactCarte(pc, 3*i+1), compactCarte(pc, 3*i+2));
+    n += evenement(&ev[n], 'M', A_TOUS, pc->joueurCourant, 0, 0);
+    return n;
+}
+
+int compactAppliquer(struct partieCompacte *pc, struct action *act, struct evenement *ev)
+{
+    int j, restants, n = 0;
+
+    if (pc->gagnant != -1 || act->joueur != pc->joueurCourant)
+        return -1;
+
+    switch (act->code)
+    {
+        case 'G':
+            if (act->a < 0 || act->a >= NB_CARTES)
+                return -1;
+            if (act->a == compactCarte(pc, 12))
+            {
+                pc->gagnant = act->joueur;
+                return evenement(&ev[0], 'W', A_TOUS, act->joueur, act->a, 0);
+            }
+            pc->perdus |= 1 << act->joueur;
+            n += evenement(&ev[n], 'F', A_TOUS, act->joueur, act->a, 0);
+            break;
+
+        case 'O':
+            if (act->a < 0 || act->a >= NB_OBJETS)
+                return -1;
+            for (j=0; j<NB_JOUEURS; j++)
+                n += evenement(&ev[n], 'R', A_TOUS, act->a, j, compactSymboles(pc, j, act->a) > 0);
+            break;
+
+        case 'S':
+            if (act->a < 0 || act->a >= NB_JOUEURS || act->b < 0 || act->b >= NB_OBJETS)
+                return -1;
+            n += evenement(&ev[n], 'S', act->joueur, act->b, compactSymboles(pc, act->a, act->b), 0);
+            break;
+
+        case 'P':
+            if (act->a)
+            {
+                pc->perdus |= 1 << act->joueur;
+                n += evenement(&ev[n], 'A', A_TOUS, act->joueur, 0, 0);
+                restants = 0;
+                for (j=0; j<NB_JOUEURS; j++)
+                    if (!compactPerdu(pc, j))
+                    {
+                        restants++;
+                        pc->gagnant = j;
+                    }
+                if (restants <= 1)
+                {
+                    if (restants == 0)
+                        pc->gagnant = act->joueur;
+                    n += evenement(&ev[n], 'W', A_TOUS, pc->gagnant, compactCarte(pc, 12), 0);
+                    return n;
+                }
+                pc->gagnant = -1;
+            }
+            break;
+
+        default:
+            return -1;
+    }
+
+    n += joueurSuivant(pc, &ev[n]);
+    return n;
+}
+
+/*******************************************************************************
+ * SECTION 3: INTERNEMENT DES NOMS
+ ******************************************************************************/
+
+int nomsInit(struct tableNoms *t, unsigned int capacite)
+{
+    unsigned int c = 16;
+
+    while (c < capacite * 2)
+        c *= 2;
+    t->capacite = c;
+    t->index = calloc(c, sizeof(unsigned int));
+    t->debuts = malloc(c / 2 * sizeof(unsigned int));
+    t->tailleTexte = 16 * (size_t) c;
+    t->texte = malloc(t->tailleTexte);
+    t->utilise = 1;
+    t->nb = 1;
+    if (t->index == NULL || t->debuts == NULL || t->texte == NULL)
+        return -1;
+    t->texte[0] = '\0';
+    t->debuts[0] = 0;
+    return 0;
+}
+
+static void agrandir(struct tableNoms *t)
+{
+    unsigned int *index, c = t->capacite * 2, i, k;
+
+    index = calloc(c, sizeof(unsigned int));
+    for (i=1; i<t->nb; i++)
+    {
+        k = hacherNom(t->texte + t->debuts[i]) & (c - 1);
+        while (index[k] != 0)
+            k = (k + 1) & (c - 1);
+        index[k] = i;
+    }
+    free(t->index);
+    t->index = index;
+    t->capacite = c;
+    t->debuts = realloc(t->debuts, c / 2 * sizeof(unsigned int));
+}
+
+unsigned int nomsInterner(struct tableNoms *t, const char *nom)
+{
+    unsigned int k = hacherNom(nom) & (t->capacite - 1), id;
+    size_t l = strlen(nom) + 1;
+
+    while ((id = t->index[k]) != 0)
+    {
+        if (strcmp(t->texte + t->debuts[id], nom) == 0)
+            return id;
+        k = (k + 1) & (t->capacite - 1);
+    }
+
+    // Nouveau nom
+    if (t->nb + 1 > t->capacite / 2)
+    {
+        agrandir(t);
+        return nomsInterner(t, nom);
+    }
+    while (t->utilise + l > t->tailleTexte)
+    {
+        t->tailleTexte *= 2;
+        t->texte = realloc(t->texte, t->tailleTexte);
+    }
+    memcpy(t->texte + t->utilise, nom, l);
+    id = t->nb++;
+    t->debuts[id] = t->utilise;
+    t->utilise += l;
+    t->index[k] = id;
+    return id;
+}
+
+const char *nomsTexte(struct tableNoms *t, unsigned int id)
+{
+    return id < t->nb ? t->texte + t->debuts[id] : "-";
+}
+
+size_t nomsOctets(struct tableNoms *t)
+{
+    return t->tailleTexte + t->capacite * sizeof(unsigned int)
+           + t->capacite / 2 * sizeof(unsigned int);
+}
+
+void nomsLiberer(struct tableNoms *t)
+{
+    free(t->texte);
+    free(t->debuts);
+    free(t->index);
+}
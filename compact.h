@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * ÉTAT COMPACT DES PARTIES
+ * Représentation serrée d'une table pour héberger un très grand nombre de
+ * parties simultanées: une session tient dans une ligne de cache (64 octets).
+ *   - deck: 13 cartes de 4 bits dans un entier de 64 bits;
+ *   - symboles: 2 bits par (joueur, objet), 4 × 8 × 2 = 64 bits (une carte
+ *     porte 0 ou 1 symbole de chaque objet, un joueur en a donc 0 à 3);
+ *   - joueurs éliminés: un bit par place;
+ *   - noms et adresses des joueurs: identifiants dans une table d'internement.
+ * Mêmes règles et mêmes événements que partie.c (vérifié par bench_sessions).
+ ******************************************************************************/
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stddef.h>
+
+#include "partie.h"
+
+struct partieCompacte
+{
+    unsigned long long deck;            // Carte i dans les bits 4i..4i+3, deck[12] = coupable
+    unsigned long long symboles;        // Objet o du joueur j dans les bits 2(8j+o)..2(8j+o)+1
+    unsigned int alea;                  // État du générateur pseudo-aléatoire
+    unsigned char joueurCourant;
+    unsigned char perdus;               // Bit j: le joueur j a fait une mauvaise accusation
+    signed char gagnant;                // -1 tant que la partie continue
+};
+
+// Une table complète: partie chaude puis joueurs (identifiants internés)
+struct sessionCompacte
+{
+    struct partieCompacte jeu;          // 24 octets
+    unsigned int graine;                // Graine de la donne (journal)
+    unsigned char fsm;                  // 0 = attente des joueurs, 1 = partie en cours
+    unsigned char nbClients;
+    unsigned char robots;               // Bit j: place j tenue par un robot
+    unsigned char libre;
+    unsigned int noms[NB_JOUEURS];
+    unsigned int adresses[NB_JOUEURS];  // "ip port" interné
+};
+
+_Static_assert(sizeof(struct sessionCompacte) == 64, "une session compacte doit tenir dans 64 octets");
+
+static inline int compactCarte(const struct partieCompacte *pc, int i)
+{
+    return (pc->deck >> (4 * i)) & 15;
+}
+
+static inline int compactSymboles(const struct partieCompacte *pc, int joueur, int objet)
+{
+    return (pc->symboles >> (2 * (NB_OBJETS * joueur + objet))) & 3;
+}
+
+static inline int compactPerdu(const struct partieCompacte *pc, int joueur)
+{
+    return (pc->perdus >> joueur) & 1;
+}
+
+// Nouvelle donne: même mélange que partieInit pour la même graine
+void compactInit(struct partieCompacte *pc, unsigned int graine);
+
+// Conversions avec la représentation du serveur (la graine n'est pas copiée)
+void compactDepuis(struct partieCompacte *pc, const struct partie *p);
+void compactVers(const struct partieCompacte *pc, struct partie *p);
+
+// Mêmes contrats que partieDemarrer et partieAppliquer
+int compactDemarrer(struct partieCompacte *pc, struct evenement *ev);
+int compactAppliquer(struct partieCompacte *pc, struct action *act, struct evenement *ev);
+
+/*******************************************************************************
+ * INTERNEMENT DES NOMS
+ * Chaque chaîne distincte est stockée une seule fois et désignée par un
+ * identifiant de 32 bits (0 = aucune). Adressage ouvert, taille doublée
+ * quand la table est à moitié pleine: pas d'allocation pour un nom connu.
+ ******************************************************************************/
+
+struct tableNoms
+{
+    char *texte;                        // Chaînes bout à bout, terminées par '\0'
+    size_t tailleTexte;
+    size_t utilise;
+    unsigned int *debuts;               // debuts[id] = position de la chaîne dans texte
+    unsigned int nb;                    // Identifiants attribués (id 0 réservé)
+    unsigned int *index;                // Alvéoles: identifiant ou 0
+    unsigned int capacite;              // Puissance de 2
+};
+
+int nomsInit(struct tableNoms *t, unsigned int capacite);
+unsigned int nomsInterner(struct tableNoms *t, const char *nom);
+const char *nomsTexte(struct tableNoms *t, unsigned int id);
+size_t nomsOctets(struct tableNoms *t);
+void nomsLiberer(struct tableNoms *t);
+
+#endif
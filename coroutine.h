@@ -0,0 +1,38 @@
+/*******************************************************************************
+ * COROUTINES SANS PILE
+ * Une fonction écrite comme une suite d'étapes (attendre l'action du joueur,
+ * jouer, recommencer) qui rend la main quand il faut attendre et reprend au
+ * même endroit à l'appel suivant. Le point de reprise est un entier (numéro
+ * de ligne) gardé par l'appelant: une coroutine suspendue ne coûte ni fil
+ * ni pile, seulement ce champ et les données qu'elle garde elle-même.
+ * Contraintes: les variables locales ne survivent pas à CO_ATTENDRE (l'état
+ * vit dans la structure de l'appelant), pas de switch dans le corps, et une
+ * seule CO_ATTENDRE par ligne.
+ ******************************************************************************/
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+typedef unsigned short coroutine;           // Point de reprise, 0 = début
+
+#define CO_SUSPENDUE    0
+#define CO_TERMINEE     1
+
+// Début du corps de la coroutine (reprise au dernier point d'attente)
+#define CO_DEBUT(co)    switch (*(co)) { case 0:
+
+// Rend la main, puis reprend ici à la première reprise où cond est vraie
+// (cond porte sur ce qui a causé la reprise: elle n'est pas évaluée avant
+// d'avoir rendu la main)
+#define CO_ATTENDRE(co, cond)                                   \
+    do {                                                        \
+        *(co) = __LINE__;                                       \
+        return CO_SUSPENDUE;                                    \
+        case __LINE__:                                          \
+        if (!(cond))                                            \
+            return CO_SUSPENDUE;                                \
+    } while (0)
+
+// Fin du corps: la prochaine reprise recommence au début
+#define CO_FIN(co)      } *(co) = 0
+
+#endif
@@ -0,0 +1,448 @@
+/*******************************************************************************
+ * DIFFUSION AUX SPECTATEURS
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#include "diffusion.h"
+#include "logger.h"
+#include "metriques.h"
+#include "minuterie.h"
+
+#define DIFF_MASQUE     (DIFF_OCTETS - 1)
+#define DIFF_RETARD_MAX (DIFF_OCTETS / 2)       // Octets de retard au-delà desquels: instantané
+#define DIFF_ABONNEMENTS 1024                   // Abonnements en attente du fil
+
+// Connexion d'un spectateur (fil de diffusion seulement)
+struct spectateur
+{
+    int fd;
+    unsigned long position;                     // Prochain octet de l'anneau à envoyer
+    char instantane[DIFF_TAILLE + 16];          // 'L' et 'M' en cours d'envoi
+    int lgInstantane, envoyeInstantane;
+    long bloqueDepuis;                          // ms sans rien pouvoir envoyer, 0 s'il suit
+    struct spectateur *suivant;
+};
+
+struct canal
+{
+    unsigned long tete;                         // Octets publiés (fil de la table)
+    char anneau[DIFF_OCTETS];                   // Messages à la suite, un par ligne
+    int abonnes;                                // Lu par le fil de la table: rien à copier si 0
+    unsigned int version;                       // Instantané: impair pendant l'écriture
+    char liste[DIFF_TAILLE];                    // Dernier 'L'
+    char courant[16];                           // Dernier 'M'
+    struct spectateur *spectateurs;
+};
+
+struct abonnement
+{
+    char ip[40];
+    int port;
+    int fd;                                     // Connexion héritée (relève), -1 sinon
+    int table;
+};
+
+static struct canal *canaux = NULL;
+static int nbCanaux;
+static long nbSpectateurs = 0;
+
+static pthread_mutex_t verrouAbonnements = PTHREAD_MUTEX_INITIALIZER;
+static struct abonnement abonnements[DIFF_ABONNEMENTS];
+static int nbAbonnements = 0;
+static int reveil[2];
+static pthread_mutex_t verrouDiffusion = PTHREAD_MUTEX_INITIALIZER;    // Un tour du fil de diffusion
+static int suspendue = 0;                       // Connexions cédées à un autre processus
+
+static long horlogeMs()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000L + t.tv_nsec / 1000000L;
+}
+
+/*******************************************************************************
+ * PUBLICATION (FIL DE LA TABLE)
+ ******************************************************************************/
+
+void diffusionPublier(int table, const char *texte)
+{
+    struct canal *c;
+    unsigned int v;
+    int n, debut, avant;
+
+    if (canaux == NULL || table < 0 || table >= nbCanaux)
+        return;
+    c = &canaux[table];
+    n = strlen(texte);
+    if (n > DIFF_TAILLE - 1)
+        n = DIFF_TAILLE - 1;
+
+    // Instantané pour les nouveaux spectateurs et ceux qui ont décroché
+    if (texte[0] == 'L' || texte[0] == 'M')
+    {
+        v = c->version;
+        __atomic_store_n(&c->version, v + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        if (texte[0] == 'L')
+            snprintf(c->liste, sizeof(c->liste), "%.*s", n, texte);
+        else
+            snprintf(c->courant, sizeof(c->courant), "%.*s", n, texte);
+        __atomic_store_n(&c->version, v + 2, __ATOMIC_RELEASE);
+    }
+
+    // Encodé une fois, partagé par tous les spectateurs de la table
+    if (__atomic_load_n(&c->abonnes, __ATOMIC_RELAXED) == 0)
+        return;
+    debut = c->tete & DIFF_MASQUE;
+    avant = (n < DIFF_OCTETS - debut) ? n : DIFF_OCTETS - debut;
+    memcpy(c->anneau + debut, texte, avant);
+    memcpy(c->anneau, texte + avant, n - avant);
+    c->anneau[(c->tete + n) & DIFF_MASQUE] = '\n';
+    __atomic_store_n(&c->tete, c->tete + n + 1, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * ENVOI AUX SPECTATEURS (FIL DE DIFFUSION)
+ ******************************************************************************/
+
+// Copie cohérente de 'L' et 'M' (relue si le fil de la table l'a modifiée entre-temps)
+static void prendreInstantane(struct canal *c, struct spectateur *sp)
+{
+    unsigned int v;
+
+    do
+    {
+        v = __atomic_load_n(&c->version, __ATOMIC_ACQUIRE);
+        sp->lgInstantane = 0;
+        if (c->liste[0] != '\0')
+            sp->lgInstantane = snprintf(sp->instantane, sizeof(sp->instantane), "%s\n%s%s",
+                                        c->liste, c->courant, c->courant[0] ? "\n" : "");
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((v & 1) || __atomic_load_n(&c->version, __ATOMIC_RELAXED) != v);
+    if (sp->lgInstantane >= (int) sizeof(sp->instantane))
+        sp->lgInstantane = sizeof(sp->instantane) - 1;
+    sp->envoyeInstantane = 0;
+}
+
+// Envoie au spectateur ce qui lui manque jusqu'à tete, sans jamais attendre
+// Retourne -1 si le spectateur est à lâcher
+static int envoyer(struct canal *c, struct spectateur *sp, unsigned long tete, long maintenant)
+{
+    struct iovec iov[3];
+    struct msghdr msg;
+    unsigned long debut = sp->position;
+    int nb = 0, reste, d;
+    ssize_t n;
+
+    // Trop en retard: l'instantané remplace les messages manqués
+    if (sp->lgInstantane == 0 && tete - sp->position > DIFF_RETARD_MAX)
+    {
+        prendreInstantane(c, sp);
+        sp->position = debut = tete;
+        metriquesCompte(MET_INSTANTANES, 1);
+    }
+
+    if (sp->envoyeInstantane < sp->lgInstantane)
+    {
+        iov[nb].iov_base = sp->instantane + sp->envoyeInstantane;
+        iov[nb++].iov_len = sp->lgInstantane - sp->envoyeInstantane;
+    }
+    // Anneau: au plus deux morceaux (fin puis début du tableau)
+    if (tete != debut)
+    {
+        d = debut & DIFF_MASQUE;
+        reste = (tete - debut < (unsigned long)(DIFF_OCTETS - d)) ? (int)(tete - debut) : DIFF_OCTETS - d;
+        iov[nb].iov_base = c->anneau + d;
+        iov[nb++].iov_len = reste;
+        if (tete - debut > (unsigned long) reste)
+        {
+            iov[nb].iov_base = c->anneau;
+            iov[nb++].iov_len = tete - debut - reste;
+        }
+    }
+    if (nb == 0)
+    {
+        sp->bloqueDepuis = 0;
+        return 0;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = nb;
+    n = sendmsg(sp->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOTCONN)
+        return -1;
+
+    // Octets réécrits pendant l'envoi: le flux n'est plus fiable
+    if (__atomic_load_n(&c->tete, __ATOMIC_ACQUIRE) - debut > DIFF_OCTETS)
+        return -1;
+
+    if (n <= 0)
+    {
+        if (sp->bloqueDepuis == 0)
+            sp->bloqueDepuis = maintenant;
+        return (maintenant - sp->bloqueDepuis > DIFF_PATIENCE_MS) ? -1 : 0;
+    }
+    sp->bloqueDepuis = 0;
+    metriquesCompte(MET_OCTETS_DIFFUSES, n);
+
+    // Avance dans l'instantané puis dans l'anneau
+    reste = sp->lgInstantane - sp->envoyeInstantane;
+    if (reste > 0)
+    {
+        if (n < reste)
+        {
+            sp->envoyeInstantane += n;
+            return 0;
+        }
+        n -= reste;
+        sp->lgInstantane = sp->envoyeInstantane = 0;
+    }
+    sp->position += n;
+    return 0;
+}
+
+static void lacher(struct canal *c, struct spectateur *sp)
+{
+    close(sp->fd);
+    free(sp);
+    __atomic_store_n(&c->abonnes, c->abonnes - 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&nbSpectateurs, nbSpectateurs - 1, __ATOMIC_RELAXED);
+}
+
+static void diffuserTable(struct canal *c, long maintenant)
+{
+    struct spectateur **pp, *sp;
+    unsigned long tete = __atomic_load_n(&c->tete, __ATOMIC_ACQUIRE);
+
+    for (pp = &c->spectateurs; (sp = *pp) != NULL; )
+    {
+        if (envoyer(c, sp, tete, maintenant) < 0)
+        {
+            *pp = sp->suivant;
+            lacher(c, sp);
+            metriquesCompte(MET_SPECTATEURS_LACHES, 1);
+            continue;
+        }
+        pp = &sp->suivant;
+    }
+}
+
+// Connexion non bloquante au spectateur, -1 s'il est injoignable
+static int connecter(struct abonnement *a)
+{
+    struct sockaddr_in adresse;
+    struct addrinfo indices, *resultat;
+    int fd;
+
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sin_family = AF_INET;
+    adresse.sin_port = htons(a->port);
+    if (inet_pton(AF_INET, a->ip, &adresse.sin_addr) != 1)
+    {
+        memset(&indices, 0, sizeof(indices));
+        indices.ai_family = AF_INET;
+        if (getaddrinfo(a->ip, NULL, &indices, &resultat) != 0)
+        {
+            metriquesCompte(MET_ECHECS_CONNEXION, 1);
+            return -1;
+        }
+        adresse.sin_addr = ((struct sockaddr_in *) resultat->ai_addr)->sin_addr;
+        freeaddrinfo(resultat);
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    if (connect(fd, (struct sockaddr *) &adresse, sizeof(adresse)) < 0 && errno != EINPROGRESS)
+    {
+        LOG_AVERT("Spectateur %s:%d injoignable", a->ip, a->port);
+        metriquesCompte(MET_ECHECS_CONNEXION, 1);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Nouveau spectateur (connecté, ou connexion héritée): il reçoit d'abord l'instantané
+static void accueillir(struct abonnement *a)
+{
+    struct spectateur *sp;
+    struct canal *c = &canaux[a->table];
+    int fd = a->fd;
+
+    if (fd >= 0)
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    else if ((fd = connecter(a)) < 0)
+        return;
+
+    sp = calloc(1, sizeof(struct spectateur));
+    if (sp == NULL)
+    {
+        close(fd);
+        return;
+    }
+    sp->fd = fd;
+    sp->position = __atomic_load_n(&c->tete, __ATOMIC_ACQUIRE);
+    prendreInstantane(c, sp);
+    sp->suivant = c->spectateurs;
+    c->spectateurs = sp;
+    __atomic_store_n(&c->abonnes, c->abonnes + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&nbSpectateurs, nbSpectateurs + 1, __ATOMIC_RELAXED);
+    if (a->fd >= 0)
+        LOG_INFO("Spectateur repris à la table %d", a->table);
+    else
+        LOG_INFO("Spectateur %s:%d à la table %d", a->ip, a->port, a->table);
+}
+
+// Fil de diffusion: nouveaux abonnements, puis les nouveaux messages de chaque
+// table à chaque tick (aucun réveil demandé au fil des tables)
+static void *filDiffusion(void *arg)
+{
+    static struct abonnement lot[DIFF_ABONNEMENTS];
+    struct pollfd attente;
+    char vidange[64];
+    long maintenant;
+    int i, n;
+
+    attente.fd = reveil[0];
+    attente.events = POLLIN;
+    while (1)
+    {
+        if (poll(&attente, 1, nbSpectateurs > 0 ? MINUTERIE_TICK_MS : -1) < 0)
+            continue;
+        if (attente.revents & POLLIN)
+            while (read(reveil[0], vidange, sizeof(vidange)) == sizeof(vidange))
+                ;
+
+        pthread_mutex_lock(&verrouDiffusion);
+        if (suspendue)
+        {
+            pthread_mutex_unlock(&verrouDiffusion);
+            continue;
+        }
+        pthread_mutex_lock(&verrouAbonnements);
+        n = nbAbonnements;
+        memcpy(lot, abonnements, n * sizeof(struct abonnement));
+        nbAbonnements = 0;
+        pthread_mutex_unlock(&verrouAbonnements);
+        for (i=0; i<n; i++)
+            accueillir(&lot[i]);
+
+        maintenant = horlogeMs();
+        for (i=0; i<nbCanaux; i++)
+            if (canaux[i].spectateurs != NULL)
+                diffuserTable(&canaux[i], maintenant);
+        pthread_mutex_unlock(&verrouDiffusion);
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * INITIALISATION ET ABONNEMENTS
+ ******************************************************************************/
+
+int diffusionInit(int nbTables)
+{
+    pthread_t fil;
+
+    canaux = calloc(nbTables, sizeof(struct canal));
+    if (canaux == NULL || pipe(reveil) < 0)
+        return -1;
+    nbCanaux = nbTables;
+    fcntl(reveil[0], F_SETFL, O_NONBLOCK);
+    fcntl(reveil[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&fil, NULL, filDiffusion, NULL) != 0)
+        return -1;
+    pthread_detach(fil);
+    return 0;
+}
+
+static int abonner(const char *ip, int port, int fd, int table)
+{
+    int ok;
+
+    if (canaux == NULL || table < 0 || table >= nbCanaux)
+        return -1;
+    pthread_mutex_lock(&verrouAbonnements);
+    ok = (nbAbonnements < DIFF_ABONNEMENTS);
+    if (ok)
+    {
+        snprintf(abonnements[nbAbonnements].ip, sizeof(abonnements[0].ip), "%s", ip);
+        abonnements[nbAbonnements].port = port;
+        abonnements[nbAbonnements].fd = fd;
+        abonnements[nbAbonnements].table = table;
+        nbAbonnements++;
+    }
+    pthread_mutex_unlock(&verrouAbonnements);
+    if (!ok)
+        return -1;
+    if (write(reveil[1], "a", 1) < 0)
+        LOG_DEBUG("Diffusion déjà réveillée");
+    return 0;
+}
+
+int diffusionAbonner(const char *ip, int port, int table)
+{
+    return abonner(ip, port, -1, table);
+}
+
+int diffusionAdopter(int fd, int table)
+{
+    return abonner("-", 0, fd, table);
+}
+
+/*******************************************************************************
+ * RELÈVE PAR UN AUTRE PROCESSUS
+ ******************************************************************************/
+
+int diffusionCeder(int *fds, int *tables, int max)
+{
+    struct spectateur *sp;
+    long maintenant = horlogeMs();
+    int i, n = 0;
+
+    pthread_mutex_lock(&verrouDiffusion);
+    // Ce qui est déjà publié part avant que les connexions changent de main
+    for (i=0; i<nbCanaux; i++)
+        if (canaux[i].spectateurs != NULL)
+            diffuserTable(&canaux[i], maintenant);
+    for (i=0; i<nbCanaux; i++)
+        for (sp = canaux[i].spectateurs; sp != NULL && n < max; sp = sp->suivant)
+        {
+            fds[n] = sp->fd;
+            tables[n++] = i;
+        }
+    suspendue = 1;
+    pthread_mutex_unlock(&verrouDiffusion);
+    return n;
+}
+
+void diffusionReprendre()
+{
+    pthread_mutex_lock(&verrouDiffusion);
+    suspendue = 0;
+    pthread_mutex_unlock(&verrouDiffusion);
+    if (write(reveil[1], "r", 1) < 0)
+        LOG_DEBUG("Diffusion déjà réveillée");
+}
+
+long diffusionSpectateurs()
+{
+    return __atomic_load_n(&nbSpectateurs, __ATOMIC_RELAXED);
+}
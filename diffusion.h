@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * DIFFUSION AUX SPECTATEURS
+ * Un spectateur suit une table en lecture seule: il reçoit les messages
+ * publics ('L', 'M', 'R', 'F', 'A', 'W', et les réponses aux questions 'S' si
+ * la table les rend publiques), jamais les cartes 'D' ni les réponses privées.
+ * Le fil de la table écrit chaque message une fois dans l'anneau d'octets de
+ * sa table (un seul écrivain, aucun verrou); le fil de diffusion le recopie
+ * sur la connexion de chaque spectateur par sendmsg depuis l'anneau partagé. Un
+ * spectateur trop lent est remis à jour par un instantané ('L' et 'M'), puis
+ * lâché s'il n'avance plus: il ne ralentit jamais les joueurs.
+ ******************************************************************************/
+#ifndef DIFFUSION_H
+#define DIFFUSION_H
+
+#define DIFF_OCTETS         8192    // Anneau d'une table (puissance de 2), ~500 messages
+#define DIFF_TAILLE         176     // Message le plus long: 'L' avec quatre noms
+#define DIFF_PATIENCE_MS    5000    // Spectateur bloqué plus longtemps: lâché
+
+// Alloue les anneaux de nbTables tables et lance le fil de diffusion
+// Retourne -1 si la mémoire manque
+int diffusionInit(int nbTables);
+
+// Publie un message de la table (fil de la table seulement)
+void diffusionPublier(int table, const char *texte);
+
+// Abonne le spectateur ip:port à la table (le serveur s'y connecte une fois
+// et y écrit les messages, un par ligne). Retourne -1 si la table n'existe pas
+int diffusionAbonner(const char *ip, int port, int table);
+
+// Relève par un autre processus: envoie ce qui est publié, suspend la
+// diffusion et donne les connexions des spectateurs (au plus max) et leurs
+// tables. diffusionReprendre relance la diffusion si la relève échoue
+int diffusionCeder(int *fds, int *tables, int max);
+void diffusionReprendre();
+
+// Connexion d'un spectateur héritée d'un autre processus: il reçoit d'abord
+// l'instantané de sa table, puis la suite. Retourne -1 si la table n'existe pas
+int diffusionAdopter(int fd, int table);
+
+// Spectateurs connectés (jauge)
+long diffusionSpectateurs();
+
+#endif
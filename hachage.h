@@ -0,0 +1,19 @@
+/*******************************************************************************
+ * HACHAGE DES NOMS
+ * FNV-1a 32 bits, partagé par les tables à adressage ouvert du serveur
+ * (lobby, classement, palmarès, destinations locales) et l'internement des
+ * noms de compact.c. Les tables prennent les bits de poids faible.
+ ******************************************************************************/
+#ifndef HACHAGE_H
+#define HACHAGE_H
+
+static inline unsigned int hacherNom(const char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s)
+        h = (h ^ (unsigned char) *s++) * 16777619u;
+    return h;
+}
+
+#endif
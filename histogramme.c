@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * HISTOGRAMME DE LATENCES
+ ******************************************************************************/
+#include "histogramme.h"
+
+int histoCase(double us)
+{
+    long v = (long) us;
+    int e;
+
+    if (v < 16)
+        return v < 0 ? 0 : v;
+    e = 63 - __builtin_clzl(v) - 4;
+    // v >> e est dans [16, 32[: 16 cases par puissance de 2
+    return (e + 1) * 16 + (int)((v >> e) - 16);
+}
+
+double histoValeur(int c)
+{
+    int e = c / 16 - 1;
+
+    if (c < 16)
+        return c;
+    return (double)((16L + c % 16) << e);
+}
+
+void histoAjoute(struct histogramme *h, double us)
+{
+    int c = histoCase(us);
+
+    if (c >= HISTO_CASES)
+        c = HISTO_CASES - 1;
+    h->cases[c]++;
+    h->nb++;
+    if (us > h->max)
+        h->max = us;
+}
+
+void histoFusionne(struct histogramme *dest, struct histogramme *h)
+{
+    int c;
+
+    for (c=0; c<HISTO_CASES; c++)
+        dest->cases[c] += h->cases[c];
+    dest->nb += h->nb;
+    if (h->max > dest->max)
+        dest->max = h->max;
+}
+
+double histoPercentile(struct histogramme *h, double p)
+{
+    long seuil = (long)(h->nb * p / 100.0);
+    long cumul = 0;
+    int c;
+
+    for (c=0; c<HISTO_CASES; c++)
+    {
+        cumul += h->cases[c];
+        if (cumul > seuil)
+            return histoValeur(c);
+    }
+    return h->max;
+}
@@ -0,0 +1,25 @@
+/*******************************************************************************
+ * HISTOGRAMME DE LATENCES
+ * Échelle log-linéaire (16 cases par puissance de 2, précision ~6%),
+ * valeurs en microsecondes. Utilisé par les outils de mesure.
+ ******************************************************************************/
+#ifndef HISTOGRAMME_H
+#define HISTOGRAMME_H
+
+#define HISTO_CASES (64*16)
+
+struct histogramme
+{
+    long cases[HISTO_CASES];
+    long nb;
+    double max;
+};
+
+void histoAjoute(struct histogramme *h, double us);
+void histoFusionne(struct histogramme *dest, struct histogramme *h);
+double histoPercentile(struct histogramme *h, double p);
+// Case d'une valeur et plus petite valeur d'une case (case + 1: borne supérieure)
+int histoCase(double us);
+double histoValeur(int c);
+
+#endif
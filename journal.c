@@ -0,0 +1,333 @@
+/*******************************************************************************
+ * JOURNAL BINAIRE DES PARTIES
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "journal.h"
+
+/*******************************************************************************
+ * SECTION 1: ÉCRITURE
+ ******************************************************************************/
+
+static unsigned long long horloge()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (unsigned long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void ecrireU32(unsigned char *p, unsigned int v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static unsigned int lireU32(unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+// Réserve la place d'un enregistrement dans le tampon et écrit son en-tête
+// Retourne l'adresse des données à remplir
+static unsigned char *enregistrer(struct journal *j, int type, int longueur)
+{
+    unsigned long long t = horloge();
+    unsigned long long dt = t > j->dernier ? t - j->dernier : 0;
+    unsigned char *p;
+
+    if (j->taille + 6 + longueur > JOURNAL_TAMPON)
+        journalVider(j);
+
+    if (dt > 0xFFFFFFFFULL)
+        dt = 0xFFFFFFFFULL;
+    j->dernier += dt;
+
+    p = j->tampon + j->taille;
+    p[0] = type;
+    p[1] = longueur;
+    ecrireU32(p + 2, (unsigned int) dt);
+    j->taille += 6 + longueur;
+    j->position += 6 + longueur;
+    return p + 6;
+}
+
+// Ouvre un nouveau journal dans une structure fournie par l'appelant
+int journalInit(struct journal *j, const char *chemin)
+{
+    unsigned char *p;
+
+    j->fd = open(chemin, O_WRONLY | O_CREAT | O_APPEND | O_EXCL, 0644);
+    if (j->fd < 0)
+        return -1;
+
+    // En-tête du fichier
+    j->dernier = horloge();
+    p = j->tampon;
+    memcpy(p, "SH13", 4);
+    p[4] = JOURNAL_VERSION; p[5] = 0;
+    p[6] = 0; p[7] = 0;
+    ecrireU32(p + 8, (unsigned int) j->dernier);
+    ecrireU32(p + 12, (unsigned int)(j->dernier >> 32));
+    j->taille = 16;
+    j->position = 16;
+    return 0;
+}
+
+struct journal *journalCreer(const char *chemin)
+{
+    struct journal *j;
+
+    j = malloc(sizeof(struct journal));
+    if (j == NULL)
+        return NULL;
+    if (journalInit(j, chemin) < 0)
+    {
+        free(j);
+        return NULL;
+    }
+    return j;
+}
+
+// Rouvre un journal existant pour continuer la partie après un redémarrage
+// taille: fin du dernier enregistrement complet (le reste est tronqué)
+// dernier: horodatage de ce dernier enregistrement
+int journalRouvrir(struct journal *j, const char *chemin, long long taille, unsigned long long dernier)
+{
+    j->fd = open(chemin, O_WRONLY | O_APPEND);
+    if (j->fd < 0)
+        return -1;
+    if (ftruncate(j->fd, taille) < 0)
+    {
+        close(j->fd);
+        return -1;
+    }
+    j->dernier = dernier;
+    j->taille = 0;
+    j->position = taille;
+    return 0;
+}
+
+struct journal *journalReprendre(const char *chemin, long long taille, unsigned long long dernier)
+{
+    struct journal *j;
+
+    j = malloc(sizeof(struct journal));
+    if (j == NULL)
+        return NULL;
+    if (journalRouvrir(j, chemin, taille, dernier) < 0)
+    {
+        free(j);
+        return NULL;
+    }
+    return j;
+}
+
+void journalPartie(struct journal *j, struct partie *p)
+{
+    unsigned char *d;
+    int i;
+
+    d = enregistrer(j, J_PARTIE, 4);
+    ecrireU32(d, p->graine);
+
+    d = enregistrer(j, J_DONNE, NB_CARTES);
+    for (i=0; i<NB_CARTES; i++)
+        d[i] = p->deck[i];
+}
+
+void journalJoueur(struct journal *j, int place, int robot, int port, char *nom, char *ip)
+{
+    int ln = strlen(nom) + 1, li = strlen(ip) + 1;
+    unsigned char *d;
+
+    if (6 + ln + li > 255)
+        return;
+    d = enregistrer(j, J_JOUEUR, 6 + ln + li);
+    d[0] = place;
+    d[1] = robot;
+    ecrireU32(d + 2, (unsigned int) port);
+    memcpy(d + 6, nom, ln);
+    memcpy(d + 6 + ln, ip, li);
+}
+
+void journalAction(struct journal *j, struct action *act)
+{
+    unsigned char *d = enregistrer(j, J_ACTION, 4);
+
+    d[0] = act->code;
+    d[1] = act->joueur;
+    d[2] = act->a;
+    d[3] = act->b;
+}
+
+void journalEvenement(struct journal *j, struct evenement *ev)
+{
+    unsigned char *d = enregistrer(j, J_EVENEMENT, 5);
+
+    d[0] = ev->code;
+    d[1] = ev->dest;            // A_TOUS (-1) devient 255
+    d[2] = ev->a;
+    d[3] = ev->b;
+    d[4] = ev->c;
+}
+
+void journalFin(struct journal *j, int gagnant)
+{
+    unsigned char *d = enregistrer(j, J_FIN, 1);
+
+    d[0] = gagnant;
+}
+
+// Écrit le tampon dans le fichier en un seul appel système
+void journalVider(struct journal *j)
+{
+    int n, ecrit = 0;
+
+    while (ecrit < j->taille)
+    {
+        n = write(j->fd, j->tampon + ecrit, j->taille - ecrit);
+        if (n <= 0)
+        {
+            perror("journal");
+            break;
+        }
+        ecrit += n;
+    }
+    j->taille = 0;
+}
+
+// Vide et ferme le journal sans libérer la structure
+void journalTerminer(struct journal *j)
+{
+    journalVider(j);
+    close(j->fd);
+}
+
+void journalFermer(struct journal *j)
+{
+    journalTerminer(j);
+    free(j);
+}
+
+/*******************************************************************************
+ * SECTION 2: LECTURE
+ ******************************************************************************/
+
+int journalOuvrir(struct lecteurJournal *l, const char *chemin, int avecMmap)
+{
+    struct stat st;
+    size_t lu = 0;
+    ssize_t n;
+    int fd;
+
+    fd = open(chemin, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) < 0 || st.st_size < 16)
+    {
+        close(fd);
+        return -1;
+    }
+    l->taille = st.st_size;
+    l->mmap = avecMmap;
+
+    if (avecMmap)
+    {
+        l->donnees = mmap(NULL, l->taille, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (l->donnees == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        madvise(l->donnees, l->taille, MADV_SEQUENTIAL);
+    }
+    else
+    {
+        l->donnees = malloc(l->taille);
+        while (l->donnees != NULL && lu < l->taille
+               && (n = read(fd, l->donnees + lu, l->taille - lu)) > 0)
+            lu += n;
+        if (l->donnees == NULL || lu < l->taille)
+        {
+            free(l->donnees);
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+
+    if (memcmp(l->donnees, "SH13", 4) != 0 || l->donnees[4] != JOURNAL_VERSION)
+    {
+        journalLiberer(l);
+        return -1;
+    }
+    l->t = lireU32(l->donnees + 8) | ((unsigned long long) lireU32(l->donnees + 12) << 32);
+    l->pos = 16;
+    return 0;
+}
+
+// Lit l'enregistrement suivant, retourne 0 à la fin du journal
+// Un enregistrement tronqué (arrêt brutal pendant l'écriture) termine la lecture
+int journalSuivant(struct lecteurJournal *l, struct enregistrement *e)
+{
+    unsigned char *p;
+
+    if (l->pos + 6 > l->taille)
+        return 0;
+    p = l->donnees + l->pos;
+    if (l->pos + 6 + p[1] > l->taille)
+        return 0;
+
+    l->t += lireU32(p + 2);
+    e->type = p[0];
+    e->longueur = p[1];
+    e->t = l->t;
+    e->donnees = p + 6;
+    l->pos += 6 + p[1];
+    return 1;
+}
+
+// Reprend la lecture à une position connue (fin d'un enregistrement)
+// t: horodatage de l'enregistrement qui se termine à cette position
+int journalAller(struct lecteurJournal *l, long long position, unsigned long long t)
+{
+    if (position < 16 || position > (long long) l->taille)
+        return -1;
+    l->pos = position;
+    l->t = t;
+    return 0;
+}
+
+void journalLiberer(struct lecteurJournal *l)
+{
+    if (l->mmap)
+        munmap(l->donnees, l->taille);
+    else
+        free(l->donnees);
+    l->donnees = NULL;
+}
+
+void journalLireAction(struct enregistrement *e, struct action *act)
+{
+    act->code = e->donnees[0];
+    act->joueur = e->donnees[1];
+    act->a = e->donnees[2];
+    act->b = e->donnees[3];
+    act->requete = 0;
+}
+
+void journalLireEvenement(struct enregistrement *e, struct evenement *ev)
+{
+    ev->code = e->donnees[0];
+    ev->dest = e->donnees[1] == 255 ? A_TOUS : e->donnees[1];
+    ev->a = e->donnees[2];
+    ev->b = e->donnees[3];
+    ev->c = e->donnees[4];
+}
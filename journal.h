@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * JOURNAL BINAIRE DES PARTIES
+ * Fichier en ajout seul: graine, donne, joueurs, actions acceptées et
+ * événements émis, horodatés. Écritures groupées dans un tampon mémoire.
+ *
+ * Format (entiers petit-boutistes):
+ *   en-tête:        "SH13" | version u16 | réservé u16 | t0 u64 (µs depuis l'epoch)
+ *   enregistrement: type u8 | longueur u8 | dt u32 (µs depuis le précédent) | données
+ ******************************************************************************/
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "partie.h"
+
+#define JOURNAL_VERSION     1
+#define JOURNAL_TAMPON      65536
+#define JOURNAL_EXTENSION   ".sh13j"
+
+// Types d'enregistrement
+#define J_PARTIE    'P'     // graine u32 (nouvelle partie)
+#define J_DONNE     'D'     // deck mélangé, 13 octets
+#define J_JOUEUR    'C'     // place u8 | robot u8 | port i32 | nom\0 | ip\0
+#define J_ACTION    'A'     // code u8 | joueur u8 | a u8 | b u8
+#define J_EVENEMENT 'E'     // code u8 | dest u8 (255 = à tous) | a u8 | b u8 | c u8
+#define J_FIN       'F'     // gagnant u8
+
+// Journal ouvert en écriture
+struct journal
+{
+    int fd;
+    long long position;                     // Taille du fichier une fois le tampon vidé
+    unsigned long long dernier;             // Horodatage du dernier enregistrement (µs)
+    int taille;                             // Octets en attente dans le tampon
+    unsigned char tampon[JOURNAL_TAMPON];
+};
+
+// Enregistrement lu
+struct enregistrement
+{
+    int type;
+    unsigned long long t;                   // Horodatage absolu (µs depuis l'epoch)
+    int longueur;
+    unsigned char *donnees;
+};
+
+// Lecture d'un journal complet (mmap ou lecture en mémoire)
+struct lecteurJournal
+{
+    unsigned char *donnees;
+    size_t taille;
+    size_t pos;
+    int mmap;
+    unsigned long long t;
+};
+
+/* Écriture */
+struct journal *journalCreer(const char *chemin);
+struct journal *journalReprendre(const char *chemin, long long taille, unsigned long long dernier);
+// Variantes sans allocation: la structure appartient à l'appelant (sessions recyclées)
+int journalInit(struct journal *j, const char *chemin);
+int journalRouvrir(struct journal *j, const char *chemin, long long taille, unsigned long long dernier);
+void journalTerminer(struct journal *j);
+void journalPartie(struct journal *j, struct partie *p);
+void journalJoueur(struct journal *j, int place, int robot, int port, char *nom, char *ip);
+void journalAction(struct journal *j, struct action *act);
+void journalEvenement(struct journal *j, struct evenement *ev);
+void journalFin(struct journal *j, int gagnant);
+void journalVider(struct journal *j);
+void journalFermer(struct journal *j);
+
+/* Lecture */
+int journalOuvrir(struct lecteurJournal *l, const char *chemin, int avecMmap);
+int journalSuivant(struct lecteurJournal *l, struct enregistrement *e);
+int journalAller(struct lecteurJournal *l, long long position, unsigned long long t);
+void journalLiberer(struct lecteurJournal *l);
+
+/* Décodage des enregistrements */
+void journalLireAction(struct enregistrement *e, struct action *act);
+void journalLireEvenement(struct enregistrement *e, struct evenement *ev);
+
+#endif
@@ -1,5 +1,8 @@
 #!/bin/bash
 
+# Quatre joueurs dans un seul client (une case par place, images chargées une fois)
+# ./launch.sh separes : un processus sh13 par joueur
+
 PIDS=()
 
 cleanup() {
@@ -14,13 +17,22 @@ trap cleanup SIGINT
 
 BASE_PORT=32001
 
-for i in {1..4}; do
-    PLAYER="player$i"
-    PORT=$((BASE_PORT + i - 1))
+if [ "$1" = "separes" ]; then
+    for i in {1..4}; do
+        PLAYER="player$i"
+        PORT=$((BASE_PORT + i - 1))
 
-    ./sh13 localhost 32000 localhost "$PORT" "$PLAYER" &
+        ./sh13 localhost 32000 localhost "$PORT" "$PLAYER" &
+        PIDS+=($!)
+    done
+else
+    SIEGES=()
+    for i in {1..4}; do
+        SIEGES+=("$((BASE_PORT + i - 1))" "player$i")
+    done
+
+    ./sh13 localhost 32000 localhost "${SIEGES[@]}" &
     PIDS+=($!)
-done
+fi
 
 wait
-
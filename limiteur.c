@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * LIMITEURS DE DÉBIT: SEAUX À JETONS
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "limiteur.h"
+
+#define JETON 1000000ULL
+
+int limiteurLire(struct limiteur *l, const char *texte)
+{
+    int n = sscanf(texte, "%u:%u", &l->debit, &l->rafale);
+
+    if (n < 1)
+        return -1;
+    if (n == 1)
+        l->rafale = l->debit;
+    if (l->debit > 0 && l->rafale == 0)
+        return -1;
+    return 0;
+}
+
+int seauPrendre(struct seau *s, const struct limiteur *l, unsigned long long maintenant)
+{
+    unsigned long long plein = l->rafale * JETON;
+
+    if (l->debit == 0)
+        return 1;
+
+    // Seau neuf: plein; sinon debit millionièmes de jeton par µs écoulée
+    if (s->dernier == 0 || maintenant - s->dernier >= plein / l->debit)
+        s->jetons = plein;
+    else if (maintenant > s->dernier)
+    {
+        s->jetons += (maintenant - s->dernier) * l->debit;
+        if (s->jetons > plein)
+            s->jetons = plein;
+    }
+    s->dernier = maintenant;
+
+    if (s->jetons < JETON)
+        return 0;
+    s->jetons -= JETON;
+    return 1;
+}
+
+int tableSeauxInit(struct tableSeaux *t, unsigned int taille)
+{
+    unsigned int n = 16;
+
+    while (n < taille)
+        n *= 2;
+    t->cases = calloc(n, sizeof(struct seauAdresse));
+    if (t->cases == NULL)
+        return -1;
+    t->masque = n - 1;
+    return 0;
+}
+
+struct seau *tableSeauxChercher(struct tableSeaux *t, unsigned int adresse)
+{
+    struct seauAdresse *c, *remplacee = NULL;
+    unsigned int h = (adresse * 2654435761u) & t->masque;
+    int i;
+
+    for (i=0; i<LIMITEUR_SONDES; i++)
+    {
+        c = &t->cases[(h + i) & t->masque];
+        if (c->adresse == adresse)
+            return &c->seau;
+        if (c->adresse == 0)
+        {
+            remplacee = c;
+            break;
+        }
+        if (remplacee == NULL || c->seau.dernier < remplacee->seau.dernier)
+            remplacee = c;
+    }
+
+    remplacee->adresse = adresse;
+    memset(&remplacee->seau, 0, sizeof(remplacee->seau));
+    return &remplacee->seau;
+}
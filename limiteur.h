@@ -0,0 +1,54 @@
+/*******************************************************************************
+ * LIMITEURS DE DÉBIT: SEAUX À JETONS
+ * Un seau se remplit de debit jetons par seconde jusqu'à rafale jetons; un
+ * message en prend un, ou est refusé si le seau est vide. Les jetons sont
+ * comptés en millionièmes (entiers) et le remplissage est calculé à la
+ * demande depuis le dernier passage: aucune minuterie, 16 octets par seau.
+ * La table des adresses garde un seau par adresse IPv4 (adressage ouvert,
+ * sondage linéaire borné); quand les cases sondées sont prises, l'adresse
+ * restée muette le plus longtemps cède la sienne (son seau était plein).
+ * Pas de verrou: le fil principal seul s'en sert.
+ ******************************************************************************/
+#ifndef LIMITEUR_H
+#define LIMITEUR_H
+
+#define LIMITEUR_SONDES     8       // Cases sondées par adresse
+
+struct limiteur
+{
+    unsigned int debit;             // Jetons par seconde (0 = sans limite)
+    unsigned int rafale;            // Jetons au plus
+};
+
+struct seau
+{
+    unsigned long long jetons;      // Millionièmes de jeton
+    unsigned long long dernier;     // Dernier passage (µs)
+};
+
+struct seauAdresse
+{
+    unsigned int adresse;           // IPv4 (ordre réseau), 0 = case vide
+    struct seau seau;
+};
+
+struct tableSeaux
+{
+    struct seauAdresse *cases;
+    unsigned int masque;            // Taille - 1 (puissance de 2)
+};
+
+// Lit "<debit>[:<rafale>]" (rafale par défaut: debit), retourne -1 si invalide
+int limiteurLire(struct limiteur *l, const char *texte);
+
+// Prend un jeton du seau à l'instant maintenant (µs), retourne 0 s'il est vide
+// Un seau neuf (mis à zéro) est plein
+int seauPrendre(struct seau *s, const struct limiteur *l, unsigned long long maintenant);
+
+// Table d'au moins taille adresses, retourne -1 si la mémoire manque
+int tableSeauxInit(struct tableSeaux *t, unsigned int taille);
+
+// Seau de l'adresse (créé plein si elle est inconnue)
+struct seau *tableSeauxChercher(struct tableSeaux *t, unsigned int adresse);
+
+#endif
@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * GÉNÉRATEUR DE CHARGE SHERLOCK 13
+ * Joueurs virtuels sans interface graphique parlant le protocole de sh13.c
+ *
+ * Usage: ./loadgen [options] <IP serveur> <port serveur>
+ ******************************************************************************/
+
+/*******************************************************************************
+ * SECTION 1: INCLUSION DES BIBLIOTHÈQUES
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#include "regles.h"
+#include "bot.h"
+#include "histogramme.h"
+#include "transport.h"
+
+/*******************************************************************************
+ * SECTION 2: STRUCTURES ET VARIABLES GLOBALES
+ ******************************************************************************/
+
+// Un joueur virtuel: une place à une table, avec son port d'écoute
+struct joueurVirtuel
+{
+    char nom[40];           // Nom envoyé dans le message 'C'
+    char adresse[40];       // Adresse envoyée dans 'C': 127.0.0.1, unix:<chemin> ou shm:<chemin>
+    int port;               // Port d'écoute (le serveur s'y connecte pour chaque message)
+    int fd;                 // Socket d'écoute (ou tube de réveil de l'anneau)
+    struct ecoute ecoute;
+    int serveurPort;        // Port du serveur qui héberge la table du joueur
+    int id;                 // Place reçue avec 'I' (-1 tant que non connue)
+    int table;              // Table reçue avec 'I', ajoutée à chaque action
+    int perdu;              // 1 après une mauvaise accusation
+    int comptePartie;       // Premier joueur virtuel de sa table ('L'): compte ses fins de partie
+    struct bot b;           // Stratégie de jeu (la même que les robots du serveur)
+    double echeance;        // Instant où jouer (think time), 0 si rien à jouer
+    double envoi;           // Instant d'envoi de la dernière action, 0 si aucune en cours
+};
+
+// Un fil d'exécution gère un sous-ensemble de joueurs
+struct fil
+{
+    pthread_t tid;
+    struct joueurVirtuel *joueurs;
+    int nbJoueurs;
+    struct histogramme histo;
+    long tours;             // Actions envoyées et acquittées par un 'M'
+    long parties;           // Parties terminées (un 'W' par table, quel que soit le gagnant)
+    long victoires;         // Parties gagnées par un joueur virtuel
+    long messages;          // Messages reçus du serveur
+    long erreurs;           // Échecs de connexion / envoi
+};
+
+char gServerIpAddress[256];
+int gServerPort;
+struct sockaddr_in gServerAddr;
+
+int nbFils = 2;             // -t: nombre de fils d'exécution
+int nbTables = 1;           // -n: nombre de tables
+int joueursParTable = 4;    // -j: joueurs virtuels par table (4 - robots du serveur)
+int portBase = 33000;       // -p: premier port d'écoute des joueurs virtuels
+int nbPortsServeur = 1;     // -P: tables réparties sur ce nombre de ports serveur consécutifs
+int reflexion = 0;          // -w: think time en millisecondes
+int duree = 30;             // -d: durée du test en secondes
+int rejouer = 0;            // -r: renvoie 'C' après chaque partie terminée
+int nbSpectateurs = 0;      // -v: spectateurs répartis sur les tables du serveur
+int portSpectateurs = 0;    // Port d'écoute commun des spectateurs (après ceux des joueurs)
+
+// Spectateurs: une connexion gardée ouverte par le serveur, un message par ligne
+struct
+{
+    pthread_t tid;
+    long connectes;
+    long messages;
+    long octets;
+} spect;
+
+volatile int arret = 0;
+
+/*******************************************************************************
+ * SECTION 3: HORLOGE
+ ******************************************************************************/
+
+double maintenant()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*******************************************************************************
+ * SECTION 4: ENVOI DE MESSAGES AU SERVEUR
+ ******************************************************************************/
+
+// Même protocole que sh13.c: une connexion TCP par message, ou le transport
+// local désigné par l'adresse du serveur (unix:, shm:)
+int sendMessageToServer(int portno, char *mess)
+{
+    struct sockaddr_in addr = gServerAddr;
+    char sendbuffer[256];
+    int sockfd, n, len;
+
+    if (transportType(gServerIpAddress) != TRANSPORT_TCP)
+        return transportEnvoyer(gServerIpAddress, mess) < 0 ? -1 : 0;
+    addr.sin_port = htons(portno);
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0)
+        return -1;
+    if (connect(sockfd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        close(sockfd);
+        return -1;
+    }
+
+    len = sprintf(sendbuffer, "%s\n", mess);
+    n = write(sockfd, sendbuffer, len);
+    close(sockfd);
+    return n == len ? 0 : -1;
+}
+
+void envoyerConnexion(struct fil *f, struct joueurVirtuel *jv)
+{
+    char mess[256];
+
+    jv->id = -1;
+    jv->perdu = 0;
+    jv->echeance = 0;
+    jv->envoi = 0;
+    sprintf(mess, "C %s %d %s", jv->adresse, jv->port, jv->nom);
+    if (sendMessageToServer(jv->serveurPort, mess) < 0)
+        f->erreurs++;
+}
+
+/*******************************************************************************
+ * SECTION 5: TRAITEMENT DES MESSAGES REÇUS
+ ******************************************************************************/
+
+// Place du premier joueur virtuel d'un message 'L' (noms "lg<table>_<n>"), -1 sinon
+int premierVirtuel(char *mess)
+{
+    char noms[NB_JOUEURS][40];
+    int i, n;
+
+    n = sscanf(mess, "L %39s %39s %39s %39s", noms[0], noms[1], noms[2], noms[3]);
+    for (i=0; i<n; i++)
+        if (strncmp(noms[i], "lg", 2) == 0)
+            return i;
+    return -1;
+}
+
+void recevoir(struct fil *f, struct joueurVirtuel *jv, char *mess)
+{
+    int x, y;
+    double t;
+
+    f->messages++;
+    switch (mess[0])
+    {
+        // 'I': place à la table
+        case 'I':
+            jv->table = 0;
+            sscanf(mess, "I %d %d", &jv->id, &jv->table);
+            botInit(&jv->b, jv->id);
+            break;
+
+        // 'L': liste des joueurs; le premier joueur virtuel de la liste (les
+        // robots du serveur et les autres clients n'en sont pas) comptera la
+        // fin de chaque partie de la table
+        case 'L':
+            jv->comptePartie = premierVirtuel(mess) == jv->id;
+            break;
+
+        // 'D': nouvelle distribution (début de partie)
+        case 'D':
+            botInit(&jv->b, jv->id);
+            botRecoit(&jv->b, mess);
+            jv->perdu = 0;
+            break;
+
+        // 'M': joueur courant; acquitte notre dernière action s'il en porte
+        // le numéro (ou s'il n'est pas numéroté: serveur sans numéros de requête)
+        case 'M':
+            sscanf(mess, "M %d", &x);
+            t = maintenant();
+            y = lireRequete(mess);
+            if (jv->envoi != 0 && (y == 0 || y == jv->b.requete))
+            {
+                histoAjoute(&f->histo, (t - jv->envoi) * 1e6);
+                f->tours++;
+                jv->envoi = 0;
+            }
+            if (x == jv->id && !jv->perdu)
+                jv->echeance = t + reflexion / 1000.0;
+            break;
+
+        // 'F': mauvaise accusation
+        case 'F':
+            sscanf(mess, "F %d %d", &x, &y);
+            if (x == jv->id)
+                jv->perdu = 1;
+            botRecoit(&jv->b, mess);
+            break;
+
+        // 'W': fin de partie
+        case 'W':
+            sscanf(mess, "W %d %d", &x, &y);
+            if (jv->comptePartie)
+                f->parties++;
+            if (x == jv->id)
+                f->victoires++;
+            jv->echeance = 0;
+            jv->envoi = 0;
+            if (rejouer)
+                envoyerConnexion(f, jv);
+            break;
+
+        // 'R', 'S': réponses aux questions
+        default:
+            botRecoit(&jv->b, mess);
+            break;
+    }
+}
+
+// Accepte toutes les connexions en attente sur le port d'un joueur (ou vide
+// son anneau, et le déclare endormi avant de rendre la main à epoll)
+void accepterMessages(struct fil *f, struct joueurVirtuel *jv)
+{
+    char buffer[256];
+    int n;
+
+    do
+    {
+        while ((n = transportRecevoir(&jv->ecoute, buffer, sizeof(buffer), NULL, 0)) >= 0)
+            if (n > 0)
+                recevoir(f, jv, buffer);
+            else if (jv->ecoute.type == TRANSPORT_SHM)
+                break;
+    } while (transportPret(&jv->ecoute));
+}
+
+/*******************************************************************************
+ * SECTION 6: BOUCLE D'UN FIL D'EXÉCUTION
+ ******************************************************************************/
+
+void *fn_fil(void *arg)
+{
+    struct fil *f = arg;
+    struct epoll_event ev, evs[256];
+    struct joueurVirtuel *jv;
+    char action[256];
+    double t, prochaine;
+    int ep, i, n, attente;
+
+    ep = epoll_create1(0);
+    for (i=0; i<f->nbJoueurs; i++)
+    {
+        ev.events = EPOLLIN;
+        ev.data.ptr = &f->joueurs[i];
+        epoll_ctl(ep, EPOLL_CTL_ADD, f->joueurs[i].fd, &ev);
+    }
+
+    for (i=0; i<f->nbJoueurs; i++)
+        envoyerConnexion(f, &f->joueurs[i]);
+
+    while (!arret)
+    {
+        // Attend au plus jusqu'à la prochaine action à jouer
+        t = maintenant();
+        prochaine = t + 0.1;
+        for (i=0; i<f->nbJoueurs; i++)
+            if (f->joueurs[i].echeance != 0 && f->joueurs[i].echeance < prochaine)
+                prochaine = f->joueurs[i].echeance;
+        attente = (int)((prochaine - t) * 1000);
+        if (attente < 0)
+            attente = 0;
+
+        n = epoll_wait(ep, evs, 256, attente);
+        for (i=0; i<n; i++)
+            accepterMessages(f, evs[i].data.ptr);
+
+        // Joue les actions dont le think time est écoulé
+        t = maintenant();
+        for (i=0; i<f->nbJoueurs; i++)
+        {
+            jv = &f->joueurs[i];
+            if (jv->echeance == 0 || jv->echeance > t)
+                continue;
+            jv->echeance = 0;
+            botJoue(&jv->b, action);
+            sprintf(action + strlen(action), " %d #%d", jv->table, jv->b.requete);
+            jv->envoi = maintenant();
+            if (sendMessageToServer(jv->serveurPort, action) < 0)
+            {
+                f->erreurs++;
+                jv->envoi = 0;
+            }
+        }
+    }
+
+    close(ep);
+    return NULL;
+}
+
+// Fil des spectateurs: s'abonne aux tables 0, 1, ... puis lit les flux
+void *fn_spectateurs(void *arg)
+{
+    struct epoll_event ev, evs[256];
+    struct sockaddr_in addr;
+    char mess[256], buffer[4096];
+    int ecoute = (int)(long) arg;
+    int ep, i, k, n, fd;
+
+    ep = epoll_create1(0);
+    ev.events = EPOLLIN;
+    ev.data.fd = ecoute;
+    epoll_ctl(ep, EPOLL_CTL_ADD, ecoute, &ev);
+    for (k=0; k<nbSpectateurs; k++)
+    {
+        sprintf(mess, "E 127.0.0.1 %d %d", portSpectateurs, k % nbTables);
+        sendMessageToServer(gServerPort + k % nbPortsServeur, mess);
+    }
+
+    while (!arret)
+    {
+        n = epoll_wait(ep, evs, 256, 100);
+        for (i=0; i<n; i++)
+        {
+            if (evs[i].data.fd == ecoute)
+            {
+                socklen_t lg = sizeof(addr);
+
+                while ((fd = accept(ecoute, (struct sockaddr *) &addr, &lg)) >= 0)
+                {
+                    fcntl(fd, F_SETFL, O_NONBLOCK);
+                    ev.events = EPOLLIN;
+                    ev.data.fd = fd;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+                    spect.connectes++;
+                }
+                continue;
+            }
+            while ((k = read(evs[i].data.fd, buffer, sizeof(buffer))) > 0)
+            {
+                spect.octets += k;
+                while (k-- > 0)
+                    spect.messages += (buffer[k] == '\n');
+            }
+            if (k == 0)
+            {
+                close(evs[i].data.fd);
+                spect.connectes--;
+            }
+        }
+    }
+    close(ep);
+    return NULL;
+}
+
+/*******************************************************************************
+ * SECTION 7: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+void usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t fils] [-n tables] [-j joueursParTable] [-p portBase]\n"
+                    "          [-P nbPortsServeur] [-w thinkMs] [-d secondes] [-r] [-v spectateurs]\n"
+                    "          <IP serveur> <port serveur>\n", prog);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    struct joueurVirtuel *joueurs;
+    struct fil *fils;
+    struct sockaddr_in addr;
+    struct hostent *server;
+    struct histogramme total;
+    long tours, parties, victoires, messages, erreurs, toursAvant = 0, partiesAvant = 0;
+    double debut, t;
+    int nbJoueurs, opt, i, k, un = 1;
+
+    while ((opt = getopt(argc, argv, "t:n:j:p:P:w:d:rv:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': nbFils = atoi(optarg); break;
+            case 'n': nbTables = atoi(optarg); break;
+            case 'j': joueursParTable = atoi(optarg); break;
+            case 'p': portBase = atoi(optarg); break;
+            case 'P': nbPortsServeur = atoi(optarg); break;
+            case 'w': reflexion = atoi(optarg); break;
+            case 'd': duree = atoi(optarg); break;
+            case 'r': rejouer = 1; break;
+            case 'v': nbSpectateurs = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind + 2 > argc || nbFils < 1 || nbTables < 1 || nbPortsServeur < 1
+        || joueursParTable < 1 || joueursParTable > 4)
+        usage(argv[0]);
+
+    strcpy(gServerIpAddress, argv[optind]);
+    gServerPort = atoi(argv[optind+1]);
+
+    // Serveur local (unix:, shm:): les joueurs reçoivent par le même transport
+    if (transportType(gServerIpAddress) == TRANSPORT_TCP)
+    {
+        server = gethostbyname(gServerIpAddress);
+        if (server == NULL) {
+            fprintf(stderr, "ERROR, no such host\n");
+            exit(1);
+        }
+        bzero((char *) &gServerAddr, sizeof(gServerAddr));
+        gServerAddr.sin_family = AF_INET;
+        bcopy((char *)server->h_addr, (char *)&gServerAddr.sin_addr.s_addr, server->h_length);
+    }
+
+    // Crée les joueurs virtuels et leur socket d'écoute non bloquante
+    nbJoueurs = nbTables * joueursParTable;
+    joueurs = calloc(nbJoueurs, sizeof(struct joueurVirtuel));
+    for (i=0; i<nbJoueurs; i++)
+    {
+        struct joueurVirtuel *jv = &joueurs[i];
+
+        sprintf(jv->nom, "lg%d_%d", i / joueursParTable, i % joueursParTable);
+        jv->port = portBase + i;
+        jv->serveurPort = gServerPort + (i / joueursParTable) % nbPortsServeur;
+        jv->id = -1;
+
+        if (transportType(gServerIpAddress) == TRANSPORT_UNIX)
+            sprintf(jv->adresse, "unix:/tmp/lg%d.sock", jv->port);
+        else if (transportType(gServerIpAddress) == TRANSPORT_SHM)
+            sprintf(jv->adresse, "shm:/dev/shm/lg%d", jv->port);
+        else
+            strcpy(jv->adresse, "127.0.0.1");
+
+        if (transportEcouter(&jv->ecoute, jv->adresse, jv->port, 64) < 0)
+        {
+            fprintf(stderr, "ERROR on binding %s %d\n", jv->adresse, jv->port);
+            exit(1);
+        }
+        jv->fd = jv->ecoute.fd;
+        fcntl(jv->fd, F_SETFL, O_NONBLOCK);
+        transportPret(&jv->ecoute);
+    }
+
+    // Répartit les tables entières entre les fils
+    fils = calloc(nbFils, sizeof(struct fil));
+    for (k=0; k<nbFils; k++)
+    {
+        int t0 = nbTables * k / nbFils, t1 = nbTables * (k+1) / nbFils;
+
+        fils[k].joueurs = joueurs + t0 * joueursParTable;
+        fils[k].nbJoueurs = (t1 - t0) * joueursParTable;
+    }
+
+    // Spectateurs: un seul port d'écoute, une connexion par abonnement
+    if (nbSpectateurs > 0)
+    {
+        int ecoute = socket(AF_INET, SOCK_STREAM, 0);
+
+        portSpectateurs = portBase + nbJoueurs;
+        setsockopt(ecoute, SOL_SOCKET, SO_REUSEADDR, &un, sizeof(un));
+        bzero((char *) &addr, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(portSpectateurs);
+        if (bind(ecoute, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+        {
+            fprintf(stderr, "ERROR on binding port %d\n", portSpectateurs);
+            exit(1);
+        }
+        listen(ecoute, SOMAXCONN);
+        fcntl(ecoute, F_SETFL, O_NONBLOCK);
+        pthread_create(&spect.tid, NULL, fn_spectateurs, (void *)(long) ecoute);
+    }
+
+    printf("=== GÉNÉRATEUR DE CHARGE SH13 ===\n");
+    printf("%d tables, %d joueurs virtuels, %d fils, think time %d ms, serveur %s:%d (%d ports)\n\n",
+           nbTables, nbJoueurs, nbFils, reflexion, gServerIpAddress, gServerPort, nbPortsServeur);
+
+    debut = maintenant();
+    for (k=0; k<nbFils; k++)
+        pthread_create(&fils[k].tid, NULL, fn_fil, &fils[k]);
+
+    // Rapport chaque seconde (compteurs lus sans verrou: valeurs indicatives)
+    for (i=1; i<=duree; i++)
+    {
+        sleep(1);
+        tours = parties = 0;
+        for (k=0; k<nbFils; k++)
+        {
+            tours += fils[k].tours;
+            parties += fils[k].parties;
+        }
+        printf("[%3ds] tours/s=%ld parties/s=%ld (total tours=%ld parties=%ld)\n",
+               i, tours - toursAvant, parties - partiesAvant, tours, parties);
+        fflush(stdout);
+        toursAvant = tours;
+        partiesAvant = parties;
+    }
+
+    arret = 1;
+    for (k=0; k<nbFils; k++)
+        pthread_join(fils[k].tid, NULL);
+    if (nbSpectateurs > 0)
+        pthread_join(spect.tid, NULL);
+    t = maintenant() - debut;
+
+    // Agrège les résultats de tous les fils
+    memset(&total, 0, sizeof(total));
+    tours = parties = victoires = messages = erreurs = 0;
+    for (k=0; k<nbFils; k++)
+    {
+        histoFusionne(&total, &fils[k].histo);
+        tours += fils[k].tours;
+        parties += fils[k].parties;
+        victoires += fils[k].victoires;
+        messages += fils[k].messages;
+        erreurs += fils[k].erreurs;
+    }
+
+    printf("\n=== RÉSULTATS (%.1f s) ===\n", t);
+    printf("tours: %ld (%.1f/s)\n", tours, tours / t);
+    printf("parties: %ld (%.2f/s), %ld gagnées par les joueurs virtuels\n", parties, parties / t, victoires);
+    printf("messages reçus: %ld (%.1f/s)\n", messages, messages / t);
+    printf("erreurs: %ld\n", erreurs);
+    if (nbSpectateurs > 0)
+        printf("spectateurs: %ld connectés sur %d, %ld messages (%.1f/s), %ld octets\n",
+               spect.connectes, nbSpectateurs, spect.messages, spect.messages / t, spect.octets);
+    printf("latence action -> 'M' (us): p50=%.0f p90=%.0f p99=%.0f p99.9=%.0f max=%.0f\n",
+           histoPercentile(&total, 50), histoPercentile(&total, 90),
+           histoPercentile(&total, 99), histoPercentile(&total, 99.9), total.max);
+
+    for (i=0; i<nbJoueurs; i++)
+        transportFermer(&joueurs[i].ecoute);
+    free(joueurs);
+    free(fils);
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*******************************************************************************
+ * LOBBY: FILES D'ATTENTE DES JOUEURS
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "lobby.h"
+#include "hachage.h"
+
+#define MASQUE_TAGS (2 * LOBBY_MAX_TAGS - 1)
+
+int lobbyInit(struct lobby *l, int capacite, int taille, void (*expiration)(struct minuterie *m))
+{
+    unsigned int n = 16;
+    int i;
+
+    memset(l, 0, sizeof(*l));
+    while (n < 2u * capacite)
+        n *= 2;
+    l->joueurs = calloc(capacite, sizeof(struct joueurLobby));
+    l->index = calloc(n, sizeof(struct joueurLobby *));
+    if (l->joueurs == NULL || l->index == NULL)
+        return -1;
+    l->masque = n - 1;
+    l->capacite = capacite;
+    l->taille = taille;
+
+    for (i=capacite-1; i>=0; i--)
+    {
+        minuterieInit(&l->joueurs[i].inactivite, expiration, &l->joueurs[i], 0);
+        l->joueurs[i].suivant = l->libres;
+        l->libres = &l->joueurs[i];
+    }
+    return 0;
+}
+
+struct joueurLobby *lobbyChercher(struct lobby *l, const char *nom)
+{
+    unsigned int i = hacherNom(nom) & l->masque;
+
+    while (l->index[i] != NULL)
+    {
+        if (strcmp(l->index[i]->nom, nom) == 0)
+            return l->index[i];
+        i = (i + 1) & l->masque;
+    }
+    return NULL;
+}
+
+// Suppression par décalage: les suivants de la même grappe reculent si besoin
+static void oublierTag(struct lobby *l, int f)
+{
+    unsigned int i, k, ideal;
+
+    for (i = hacherNom(l->files[f].tag) & MASQUE_TAGS; l->indexTags[i] != f + 1; i = (i + 1) & MASQUE_TAGS)
+        ;
+    l->indexTags[i] = 0;
+    for (k = (i + 1) & MASQUE_TAGS; l->indexTags[k] != 0; k = (k + 1) & MASQUE_TAGS)
+    {
+        ideal = hacherNom(l->files[l->indexTags[k] - 1].tag) & MASQUE_TAGS;
+        // Déplaçable en i si sa case idéale n'est pas dans ]i, k]
+        if (((k - ideal) & MASQUE_TAGS) >= ((k - i) & MASQUE_TAGS))
+        {
+            l->indexTags[i] = l->indexTags[k];
+            l->indexTags[k] = 0;
+            i = k;
+        }
+    }
+}
+
+// File du tag, créée au premier joueur (ou reprise à un tag dont la file est vide)
+static int fileDuTag(struct lobby *l, const char *tag)
+{
+    unsigned int i;
+    int f;
+
+    for (i = hacherNom(tag) & MASQUE_TAGS; l->indexTags[i] != 0; i = (i + 1) & MASQUE_TAGS)
+        if (strcmp(l->files[l->indexTags[i] - 1].tag, tag) == 0)
+            return l->indexTags[i] - 1;
+
+    if (l->nbFiles < LOBBY_MAX_TAGS)
+        f = l->nbFiles++;
+    else
+    {
+        // Toutes les files ont servi: parcours rare, seulement à la saturation
+        for (f=0; f<LOBBY_MAX_TAGS && l->files[f].nb > 0; f++)
+            ;
+        if (f == LOBBY_MAX_TAGS)
+            return -1;
+        oublierTag(l, f);
+        for (i = hacherNom(tag) & MASQUE_TAGS; l->indexTags[i] != 0; i = (i + 1) & MASQUE_TAGS)
+            ;
+    }
+    memset(l->files[f].tag, 0, LOBBY_TAG);
+    strncpy(l->files[f].tag, tag, LOBBY_TAG - 1);
+    l->indexTags[i] = f + 1;
+    return f;
+}
+
+// Chaîne ou retire la file des files prêtes après un changement de taille
+static void majPrete(struct lobby *l, struct fileLobby *file)
+{
+    int prete = file->nb >= l->taille;
+
+    if (prete == file->prete)
+        return;
+    file->prete = prete;
+    if (prete)
+    {
+        file->suivante = NULL;
+        file->precedente = l->dernierePrete;
+        if (l->dernierePrete != NULL)
+            l->dernierePrete->suivante = file;
+        else
+            l->pretes = file;
+        l->dernierePrete = file;
+    }
+    else
+    {
+        if (file->precedente != NULL)
+            file->precedente->suivante = file->suivante;
+        else
+            l->pretes = file->suivante;
+        if (file->suivante != NULL)
+            file->suivante->precedente = file->precedente;
+        else
+            l->dernierePrete = file->precedente;
+        file->suivante = file->precedente = NULL;
+    }
+}
+
+struct joueurLobby *lobbyAjouter(struct lobby *l, const char *nom, const char *ip, int port, const char *tag)
+{
+    struct joueurLobby *j = l->libres;
+    struct fileLobby *file;
+    unsigned int i;
+    int f;
+
+    if (j == NULL || (f = fileDuTag(l, tag)) < 0)
+        return NULL;
+    l->libres = j->suivant;
+
+    strncpy(j->nom, nom, LOBBY_NOM - 1);
+    j->nom[LOBBY_NOM - 1] = '\0';
+    strncpy(j->ip, ip, sizeof(j->ip) - 1);
+    j->ip[sizeof(j->ip) - 1] = '\0';
+    j->port = port;
+    j->file = f;
+    j->table = LOBBY_EN_ATTENTE;
+    j->elo = 0;
+
+    for (i = hacherNom(j->nom) & l->masque; l->index[i] != NULL; i = (i + 1) & l->masque)
+        ;
+    l->index[i] = j;
+    l->nb++;
+
+    // En queue de sa file
+    file = &l->files[f];
+    j->suivant = NULL;
+    j->precedent = file->queue;
+    if (file->queue != NULL)
+        file->queue->suivant = j;
+    else
+        file->tete = j;
+    file->queue = j;
+    file->nb++;
+    l->enAttente++;
+    majPrete(l, file);
+    return j;
+}
+
+static void sortirDeFile(struct lobby *l, struct joueurLobby *j)
+{
+    struct fileLobby *file = &l->files[j->file];
+
+    if (j->precedent != NULL)
+        j->precedent->suivant = j->suivant;
+    else
+        file->tete = j->suivant;
+    if (j->suivant != NULL)
+        j->suivant->precedent = j->precedent;
+    else
+        file->queue = j->precedent;
+    j->suivant = j->precedent = NULL;
+    file->nb--;
+    l->enAttente--;
+    majPrete(l, file);
+}
+
+void lobbyRetirer(struct lobby *l, struct joueurLobby *j)
+{
+    unsigned int i, k, ideal;
+
+    if (j->table == LOBBY_EN_ATTENTE)
+        sortirDeFile(l, j);
+
+    // Suppression par décalage, comme pour les tags
+    for (i = hacherNom(j->nom) & l->masque; l->index[i] != j; i = (i + 1) & l->masque)
+        ;
+    l->index[i] = NULL;
+    for (k = (i + 1) & l->masque; l->index[k] != NULL; k = (k + 1) & l->masque)
+    {
+        ideal = hacherNom(l->index[k]->nom) & l->masque;
+        if (((k - ideal) & l->masque) >= ((k - i) & l->masque))
+        {
+            l->index[i] = l->index[k];
+            l->index[k] = NULL;
+            i = k;
+        }
+    }
+    l->nb--;
+
+    j->suivant = l->libres;
+    l->libres = j;
+}
+
+static float ecartElo(struct joueurLobby *a, struct joueurLobby *b)
+{
+    return a->elo > b->elo ? a->elo - b->elo : b->elo - a->elo;
+}
+
+// Le premier arrivé est toujours servi; ses adversaires sont, parmi les
+// LOBBY_FENETRE premiers de la file, ceux dont la cote est la plus proche
+// de la sienne (à écart égal, les premiers arrivés)
+int lobbyFormer(struct lobby *l, int numero, struct joueurLobby **table)
+{
+    struct fileLobby *file = l->pretes;
+    struct joueurLobby *candidats[LOBBY_FENETRE], *j;
+    int i, k, m, n = 0;
+
+    if (file == NULL)
+        return 0;
+    for (j = file->tete; j != NULL && n < LOBBY_FENETRE; j = j->suivant)
+        candidats[n++] = j;
+
+    // Sélection ordonnée: le plus proche remonte, les autres gardent leur ordre
+    for (i=1; i<l->taille; i++)
+    {
+        k = i;
+        for (m=i+1; m<n; m++)
+            if (ecartElo(candidats[m], candidats[0]) < ecartElo(candidats[k], candidats[0]))
+                k = m;
+        j = candidats[k];
+        memmove(&candidats[i + 1], &candidats[i], (k - i) * sizeof(candidats[0]));
+        candidats[i] = j;
+    }
+    for (i=0; i<l->taille; i++)
+    {
+        table[i] = candidats[i];
+        lobbyAsseoir(l, table[i], numero);
+    }
+    return 1;
+}
+
+void lobbyAsseoir(struct lobby *l, struct joueurLobby *j, int numero)
+{
+    if (j->table == LOBBY_EN_ATTENTE)
+        sortirDeFile(l, j);
+    j->table = numero;
+}
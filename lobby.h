@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * LOBBY: FILES D'ATTENTE DES JOUEURS
+ * Les joueurs qui envoient 'C' attendent ici qu'une table se forme. Une file
+ * par tag (région, niveau...: dernier champ optionnel de 'C'); dès qu'une
+ * file contient assez de joueurs, ils sont assis ensemble à une table (le
+ * premier arrivé avec ceux de cote proche, voir lobbyFormer).
+ * Les noms et les tags sont indexés par des tables de hachage (adressage
+ * ouvert, sondage linéaire, suppression par décalage) et les files prêtes
+ * sont chaînées: ajout, recherche, retrait et formation d'une table en O(1),
+ * sans parcours des joueurs ni des files. Tout est alloué une fois.
+ ******************************************************************************/
+#ifndef LOBBY_H
+#define LOBBY_H
+
+#include "minuterie.h"
+
+#define LOBBY_NOM       40
+#define LOBBY_TAG       16
+#define LOBBY_MAX_TAGS  1024       // Files simultanées (une file vide est réutilisée)
+#define LOBBY_EN_ATTENTE -1         // joueurLobby.table d'un joueur dans une file
+#define LOBBY_FENETRE   16          // Premiers de la file entre lesquels les cotes sont rapprochées
+
+// Joueur connu du lobby: en attente d'une table, ou assis à une table
+struct joueurLobby
+{
+    char nom[LOBBY_NOM];
+    char ip[40];
+    int port;
+    int file;                       // File d'attente (indice du tag)
+    int table;                      // Numéro de la session, LOBBY_EN_ATTENTE dans une file
+    float elo;                      // Cote du classement à l'arrivée (0 sans classement), voir lobbyFormer
+    struct joueurLobby *suivant;    // File d'attente (ou liste des enregistrements libres)
+    struct joueurLobby *precedent;
+    struct minuterie inactivite;    // Sans nouvelles en attente: retiré du lobby
+};
+
+struct fileLobby
+{
+    char tag[LOBBY_TAG];
+    struct joueurLobby *tete;
+    struct joueurLobby *queue;
+    int nb;
+    int prete;                      // nb >= taille: chaînée dans les files prêtes
+    struct fileLobby *suivante;     // Files prêtes, dans l'ordre où elles le sont devenues
+    struct fileLobby *precedente;
+};
+
+struct lobby
+{
+    struct joueurLobby *joueurs;    // capacite enregistrements
+    struct joueurLobby *libres;
+    int capacite;
+    int taille;                     // Joueurs par table
+    int nb;                         // Joueurs connus (en attente ou assis)
+    int enAttente;
+    struct joueurLobby **index;     // Noms -> joueurs (NULL = case vide)
+    unsigned int masque;            // Taille de l'index - 1 (puissance de 2, > 2 * capacite)
+    struct fileLobby files[LOBBY_MAX_TAGS];
+    int nbFiles;
+    short indexTags[2 * LOBBY_MAX_TAGS];    // Tags -> indice de file + 1 (0 = case vide)
+    struct fileLobby *pretes;       // Files d'au moins taille joueurs
+    struct fileLobby *dernierePrete;
+};
+
+// Alloue le lobby pour capacite joueurs et des tables de taille joueurs,
+// retourne -1 si la mémoire manque
+// La minuterie d'inactivité de chaque joueur appelle expiration (donnees = joueur)
+int lobbyInit(struct lobby *l, int capacite, int taille, void (*expiration)(struct minuterie *m));
+
+// Joueur de ce nom, NULL s'il est inconnu
+struct joueurLobby *lobbyChercher(struct lobby *l, const char *nom);
+
+// Met un nouveau joueur en file d'attente (tag "" = file commune)
+// Retourne NULL si le lobby est plein ou si LOBBY_MAX_TAGS files sont occupées
+struct joueurLobby *lobbyAjouter(struct lobby *l, const char *nom, const char *ip, int port, const char *tag);
+
+// Oublie un joueur (en attente ou assis); sa minuterie doit être annulée
+void lobbyRetirer(struct lobby *l, struct joueurLobby *j);
+
+// Retourne 1 si une file contient de quoi former une table
+static inline int lobbyPrete(struct lobby *l)
+{
+    return l->pretes != NULL;
+}
+
+// Sort de la plus ancienne file prête son premier joueur arrivé et, parmi les
+// LOBBY_FENETRE suivants, les taille - 1 de cote la plus proche de la sienne,
+// et les assoit à la table numero. Retourne 0 si aucune file n'est prête
+int lobbyFormer(struct lobby *l, int numero, struct joueurLobby **table);
+
+// Assoit un joueur (en attente ou non) à la table numero
+void lobbyAsseoir(struct lobby *l, struct joueurLobby *j, int numero);
+
+#endif
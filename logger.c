@@ -0,0 +1,454 @@
+/*******************************************************************************
+ * JOURNALISATION ASYNCHRONE
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "logger.h"
+
+#define LOG_BOURRAGE    0xFF            // Niveau d'un bloc de remplissage en fin d'anneau
+#define LOG_MASQUE      (LOG_ANNEAU - 1)
+
+int logNiveau = LOG_NIV_INFO;
+unsigned int logLimite = 0;
+
+// En-tête d'un enregistrement, suivi des arguments puis des chaînes copiées
+struct logEntete
+{
+    unsigned int taille;                // Octets de l'enregistrement (multiple de 8)
+    unsigned char niveau;
+    unsigned char nbArgs;
+    unsigned short reserve;
+    unsigned int supprimes;             // Appels supprimés par la limite de débit avant celui-ci
+    unsigned int reserve2;
+    unsigned long long t;               // µs depuis l'epoch
+    const char *format;
+};
+
+struct logValeur
+{
+    long long v;                        // Entier, bits du réel ou position de la chaîne
+    char type;
+    char reserve[7];
+};
+
+// Anneau d'un fil producteur: un seul écrivain (le fil), un seul lecteur
+// (le fil d'écriture). tete et queue comptent les octets depuis le début.
+struct logAnneau
+{
+    unsigned char donnees[LOG_ANNEAU];
+    unsigned long tete __attribute__((aligned(64)));
+    unsigned long perdus;
+    unsigned long queue __attribute__((aligned(64)));
+    unsigned long perdusSignales;
+    int libre;                          // Fil terminé: l'anneau sera repris par un nouveau fil
+};
+
+static struct logAnneau *anneaux[LOG_MAX_FILS];
+static int nbAnneaux = 0;
+static pthread_mutex_t verrouAnneaux = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct logAnneau *monAnneau = NULL;
+static pthread_key_t cleAnneau;
+static pthread_once_t cleCreee = PTHREAD_ONCE_INIT;
+static unsigned long perdusSansAnneau = 0;  // Enregistrements des fils au-delà de LOG_MAX_FILS
+
+static FILE *sortie = NULL;
+static pthread_t filEcriture;
+static volatile int demarre = 0;
+static volatile int arret = 0;
+
+static const char *nomsNiveaux[] = { "DEBUG", "INFO", "AVERT", "ERREUR" };
+
+/*******************************************************************************
+ * SECTION 1: PRODUCTEURS
+ ******************************************************************************/
+
+static unsigned long long horlogeUs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Fin d'un fil: son anneau (encore vidé par le lecteur) attend un nouveau fil
+static void libererAnneau(void *a)
+{
+    __atomic_store_n(&((struct logAnneau *) a)->libre, 1, __ATOMIC_RELEASE);
+}
+
+static void creerCle()
+{
+    pthread_key_create(&cleAnneau, libererAnneau);
+}
+
+// Premier enregistrement d'un fil: il reprend l'anneau d'un fil terminé, ou
+// en crée un qu'il déclare au lecteur. Au-delà de LOG_MAX_FILS anneaux, ses
+// enregistrements sont perdus (et comptés) tant qu'aucun ne se libère.
+static struct logAnneau *anneauDuFil()
+{
+    struct logAnneau *a = NULL;
+    int i;
+
+    if (monAnneau != NULL)
+        return monAnneau;
+    pthread_once(&cleCreee, creerCle);
+    pthread_mutex_lock(&verrouAnneaux);
+    for (i=0; i<nbAnneaux && a == NULL; i++)
+        if (__atomic_load_n(&anneaux[i]->libre, __ATOMIC_ACQUIRE))
+        {
+            a = anneaux[i];
+            a->libre = 0;
+        }
+    if (a == NULL && nbAnneaux < LOG_MAX_FILS && (a = calloc(1, sizeof(struct logAnneau))) != NULL)
+    {
+        anneaux[nbAnneaux] = a;
+        __atomic_store_n(&nbAnneaux, nbAnneaux + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&verrouAnneaux);
+    if (a == NULL)
+        return NULL;
+    pthread_setspecific(cleAnneau, a);
+    monAnneau = a;
+    return a;
+}
+
+void logEcrire(struct logSite *site, int niveau, const char *format, struct logArg *args)
+{
+    struct logAnneau *a;
+    struct logEntete *e;
+    struct logValeur *val;
+    unsigned long long t = horlogeUs();
+    unsigned long tete, libre;
+    unsigned int supprimes = 0, taille, pos, bourrage, texte;
+    unsigned int longueurs[16];
+    int n, i;
+
+    // Limite de débit par appel (compteurs approximatifs entre fils)
+    if (logLimite != 0)
+    {
+        if (site->seconde != t / 1000000)
+        {
+            site->seconde = t / 1000000;
+            site->compte = 0;
+        }
+        if (++site->compte > logLimite)
+        {
+            site->supprimes++;
+            return;
+        }
+        supprimes = site->supprimes;
+        site->supprimes = 0;
+    }
+
+    // Taille de l'enregistrement
+    taille = sizeof(struct logEntete);
+    for (n=0; args[n].type != 0 && n < 16; n++)
+    {
+        taille += sizeof(struct logValeur);
+        if (args[n].type == 's')
+        {
+            longueurs[n] = args[n].v.s == NULL ? 0 : strnlen(args[n].v.s, LOG_MAX_TEXTE);
+            taille += longueurs[n] + 1;
+        }
+    }
+    taille = (taille + 7) & ~7u;
+
+    a = anneauDuFil();
+    if (a == NULL)
+    {
+        __atomic_add_fetch(&perdusSansAnneau, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // Place libre; un enregistrement ne fait jamais le tour de l'anneau
+    tete = a->tete;
+    libre = LOG_ANNEAU - (tete - __atomic_load_n(&a->queue, __ATOMIC_ACQUIRE));
+    pos = tete & LOG_MASQUE;
+    bourrage = (pos + taille > LOG_ANNEAU) ? LOG_ANNEAU - pos : 0;
+    if (taille + bourrage > libre)
+    {
+        a->perdus++;
+        return;
+    }
+    if (bourrage)
+    {
+        e = (struct logEntete *)(a->donnees + pos);
+        e->taille = bourrage;
+        e->niveau = LOG_BOURRAGE;
+        tete += bourrage;
+        pos = 0;
+    }
+
+    e = (struct logEntete *)(a->donnees + pos);
+    e->taille = taille;
+    e->niveau = niveau;
+    e->nbArgs = n;
+    e->supprimes = supprimes;
+    e->t = t;
+    e->format = format;
+    val = (struct logValeur *)(e + 1);
+    texte = sizeof(struct logEntete) + n * sizeof(struct logValeur);
+    for (i=0; i<n; i++)
+    {
+        val[i].type = args[i].type;
+        switch (args[i].type)
+        {
+            case 'i':
+                val[i].v = args[i].v.i;
+                break;
+            case 'r':
+                memcpy(&val[i].v, &args[i].v.r, sizeof(double));
+                break;
+            case 's':
+                val[i].v = texte;
+                if (longueurs[i] > 0)
+                    memcpy((char *) e + texte, args[i].v.s, longueurs[i]);
+                ((char *) e)[texte + longueurs[i]] = '\0';
+                texte += longueurs[i] + 1;
+                break;
+        }
+    }
+    __atomic_store_n(&a->tete, tete + taille, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * SECTION 2: FORMATAGE
+ * Les conversions printf sont appliquées une à une aux arguments copiés
+ ******************************************************************************/
+
+static int formater(char *sortie, int taille, struct logEntete *e)
+{
+    struct logValeur *val = (struct logValeur *)(e + 1);
+    const char *f = e->format;
+    char spec[40];
+    int n = 0, k, arg = 0, l, long64;
+    double r;
+
+    while (*f && n < taille - 1)
+    {
+        if (*f != '%')
+        {
+            sortie[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%')
+        {
+            sortie[n++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Spécification: %[drapeaux][largeur][.précision][longueur]conversion
+        // Les entiers sont copiés sur 64 bits: un modificateur l, z, j ou t devient ll
+        k = 0;
+        spec[k++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && k < 20)
+            spec[k++] = *f++;
+        long64 = 0;
+        while (*f && strchr("hlzjt", *f))
+            long64 |= (*f++ != 'h');
+        if (*f == '\0')
+            break;
+        if (long64 && strchr("diuxXo", *f))
+        {
+            spec[k++] = 'l';
+            spec[k++] = 'l';
+        }
+        spec[k++] = *f;
+        spec[k] = '\0';
+
+        if (arg >= e->nbArgs)
+            l = snprintf(sortie + n, taille - n, "(?)");
+        else
+            switch (*f)
+            {
+                case 'd': case 'i':
+                    if (long64)
+                        l = snprintf(sortie + n, taille - n, spec, val[arg].v);
+                    else
+                        l = snprintf(sortie + n, taille - n, spec, (int) val[arg].v);
+                    break;
+                case 'u': case 'x': case 'X': case 'o':
+                    if (long64)
+                        l = snprintf(sortie + n, taille - n, spec, (unsigned long long) val[arg].v);
+                    else
+                        l = snprintf(sortie + n, taille - n, spec, (unsigned int) val[arg].v);
+                    break;
+                case 'c':
+                    l = snprintf(sortie + n, taille - n, spec, (int) val[arg].v);
+                    break;
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+                    if (val[arg].type == 'r')
+                        memcpy(&r, &val[arg].v, sizeof(double));
+                    else
+                        r = (double) val[arg].v;
+                    l = snprintf(sortie + n, taille - n, spec, r);
+                    break;
+                case 's':
+                    l = snprintf(sortie + n, taille - n, spec,
+                                 val[arg].type == 's' ? (char *) e + val[arg].v : "(?)");
+                    break;
+                default:
+                    l = snprintf(sortie + n, taille - n, "%s", spec);
+                    break;
+            }
+        arg++;
+        f++;
+        if (l > 0)
+            n += l < taille - n ? l : taille - n - 1;
+    }
+    sortie[n] = '\0';
+    return n;
+}
+
+/*******************************************************************************
+ * SECTION 3: FIL D'ÉCRITURE
+ ******************************************************************************/
+
+// Prochain enregistrement d'un anneau (les blocs de remplissage sont sautés)
+static struct logEntete *prochain(struct logAnneau *a)
+{
+    struct logEntete *e;
+    unsigned long tete = __atomic_load_n(&a->tete, __ATOMIC_ACQUIRE);
+
+    while (a->queue != tete)
+    {
+        e = (struct logEntete *)(a->donnees + (a->queue & LOG_MASQUE));
+        if (e->niveau != LOG_BOURRAGE)
+            return e;
+        __atomic_store_n(&a->queue, a->queue + e->taille, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static unsigned long perdusSansAnneauSignales = 0;
+
+// Écrit tout ce qui est en attente, dans l'ordre des horodatages
+// Retourne le nombre d'enregistrements écrits
+static int vider()
+{
+    struct logEntete *e, *plusAncien;
+    struct logAnneau *choisi;
+    char ligne[4096];
+    unsigned long perdus;
+    int i, n, ecrits = 0, nb = __atomic_load_n(&nbAnneaux, __ATOMIC_ACQUIRE);
+
+    while (1)
+    {
+        plusAncien = NULL;
+        choisi = NULL;
+        for (i=0; i<nb; i++)
+            if ((e = prochain(anneaux[i])) != NULL && (plusAncien == NULL || e->t < plusAncien->t))
+            {
+                plusAncien = e;
+                choisi = anneaux[i];
+            }
+        if (plusAncien == NULL)
+            break;
+
+        n = formater(ligne, sizeof(ligne), plusAncien);
+        fprintf(sortie, "%llu.%06llu %-6s %.*s", plusAncien->t / 1000000, plusAncien->t % 1000000,
+                nomsNiveaux[plusAncien->niveau & 3], n, ligne);
+        if (plusAncien->supprimes)
+            fprintf(sortie, " [%u messages supprimés par la limite de débit]", plusAncien->supprimes);
+        fputc('\n', sortie);
+        __atomic_store_n(&choisi->queue, choisi->queue + plusAncien->taille, __ATOMIC_RELEASE);
+        ecrits++;
+    }
+
+    for (i=0; i<nb; i++)
+    {
+        perdus = __atomic_load_n(&anneaux[i]->perdus, __ATOMIC_RELAXED);
+        if (perdus != anneaux[i]->perdusSignales)
+        {
+            fprintf(sortie, "%llu.%06llu %-6s %lu enregistrements perdus (anneau %d plein)\n",
+                    horlogeUs() / 1000000, horlogeUs() % 1000000, nomsNiveaux[LOG_NIV_AVERT],
+                    perdus - anneaux[i]->perdusSignales, i);
+            anneaux[i]->perdusSignales = perdus;
+        }
+    }
+    perdus = __atomic_load_n(&perdusSansAnneau, __ATOMIC_RELAXED);
+    if (perdus != perdusSansAnneauSignales)
+    {
+        fprintf(sortie, "%llu.%06llu %-6s %lu enregistrements perdus (plus de %d fils)\n",
+                horlogeUs() / 1000000, horlogeUs() % 1000000, nomsNiveaux[LOG_NIV_AVERT],
+                perdus - perdusSansAnneauSignales, LOG_MAX_FILS);
+        perdusSansAnneauSignales = perdus;
+    }
+    if (ecrits > 0)
+        fflush(sortie);
+    return ecrits;
+}
+
+static void *fn_ecriture(void *arg)
+{
+    while (!arret)
+        if (vider() == 0)
+            usleep(1000);
+    vider();
+    return NULL;
+}
+
+void logInit(FILE *f, int niveau, unsigned int limite)
+{
+    sortie = f;
+    logNiveau = niveau;
+    logLimite = limite;
+    if (demarre)
+        return;
+    if (pthread_create(&filEcriture, NULL, fn_ecriture, NULL) != 0)
+    {
+        perror("logger");
+        return;
+    }
+    demarre = 1;
+    atexit(logFermer);
+}
+
+void logFermer()
+{
+    if (!demarre)
+        return;
+    demarre = 0;
+    arret = 1;
+    pthread_join(filEcriture, NULL);
+}
+
+unsigned long logEnAttente()
+{
+    unsigned long total = 0;
+    int i, nb = __atomic_load_n(&nbAnneaux, __ATOMIC_ACQUIRE);
+
+    for (i=0; i<nb; i++)
+        total += __atomic_load_n(&anneaux[i]->tete, __ATOMIC_RELAXED)
+               - __atomic_load_n(&anneaux[i]->queue, __ATOMIC_RELAXED);
+    return total;
+}
+
+unsigned long logPerdus()
+{
+    unsigned long total = __atomic_load_n(&perdusSansAnneau, __ATOMIC_RELAXED);
+    int i, nb = __atomic_load_n(&nbAnneaux, __ATOMIC_ACQUIRE);
+
+    for (i=0; i<nb; i++)
+        total += __atomic_load_n(&anneaux[i]->perdus, __ATOMIC_RELAXED);
+    return total;
+}
+
+int logNiveauDepuis(const char *nom)
+{
+    int i;
+
+    for (i=0; i<4; i++)
+        if (strcasecmp(nom, nomsNiveaux[i]) == 0)
+            return i;
+    if (nom[0] >= '0' && nom[0] <= '3' && nom[1] == '\0')
+        return nom[0] - '0';
+    return -1;
+}
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * JOURNALISATION ASYNCHRONE
+ * Les appels LOG_xxx n'écrivent pas sur la sortie: ils copient un
+ * enregistrement binaire (horodatage, niveau, format, arguments) dans un
+ * anneau propre au fil d'exécution appelant, sans verrou. Un fil en
+ * arrière-plan formate les enregistrements de tous les anneaux dans l'ordre
+ * chronologique et les écrit. Un terminal lent ne ralentit plus la partie:
+ * si un anneau est plein, l'enregistrement est perdu (et compté).
+ *
+ *   LOG_DEBUG / LOG_INFO / LOG_AVERT / LOG_ERREUR (format printf)
+ *
+ * Arguments acceptés: entiers, réels, chaînes (copiées, 255 octets au plus),
+ * 10 au plus par appel. Chaque appel est limité à logLimite enregistrements
+ * par seconde; les suivants sont comptés et signalés avec le prochain.
+ * Compiler avec -DLOG_NIVEAU_COMPILE=1 retire complètement LOG_DEBUG.
+ ******************************************************************************/
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+
+// Niveaux
+#define LOG_NIV_DEBUG   0
+#define LOG_NIV_INFO    1
+#define LOG_NIV_AVERT   2
+#define LOG_NIV_ERREUR  3
+
+#ifndef LOG_NIVEAU_COMPILE
+#define LOG_NIVEAU_COMPILE LOG_NIV_DEBUG
+#endif
+
+#define LOG_ANNEAU      (256 * 1024)    // Octets par fil d'exécution (puissance de 2)
+#define LOG_MAX_FILS    64              // Fils vivants qui journalisent (anneau repris à la fin d'un fil)
+#define LOG_MAX_TEXTE   255             // Longueur maximale d'une chaîne copiée
+
+extern int logNiveau;                   // Niveau minimum à l'exécution
+extern unsigned int logLimite;          // Enregistrements par seconde et par appel (0 = sans limite)
+
+// Argument typé (rempli par LOG_ARG selon le type de l'expression)
+struct logArg
+{
+    char type;                          // 'i' entier, 'r' réel, 's' chaîne, 0 = fin de liste
+    union
+    {
+        long long i;
+        double r;
+        const char *s;
+    } v;
+};
+
+// Limitation de débit: une instance par appel LOG_xxx
+struct logSite
+{
+    unsigned long long seconde;
+    unsigned int compte;
+    unsigned int supprimes;
+};
+
+static inline struct logArg logArgEntier(long long v) { struct logArg a; a.type = 'i'; a.v.i = v; return a; }
+static inline struct logArg logArgReel(double v) { struct logArg a; a.type = 'r'; a.v.r = v; return a; }
+static inline struct logArg logArgTexte(const char *v) { struct logArg a; a.type = 's'; a.v.s = v; return a; }
+static inline struct logArg logArgFin() { struct logArg a; a.type = 0; a.v.i = 0; return a; }
+
+#define LOG_ARG(x) _Generic((x),                            \
+        char *: logArgTexte, const char *: logArgTexte,     \
+        float: logArgReel, double: logArgReel,              \
+        default: logArgEntier)(x)
+
+// LOG_MAP(a, b, c) -> LOG_ARG(a), LOG_ARG(b), LOG_ARG(c),
+#define LOG_A0()
+#define LOG_A1(a) LOG_ARG(a),
+#define LOG_A2(a, ...) LOG_ARG(a), LOG_A1(__VA_ARGS__)
+#define LOG_A3(a, ...) LOG_ARG(a), LOG_A2(__VA_ARGS__)
+#define LOG_A4(a, ...) LOG_ARG(a), LOG_A3(__VA_ARGS__)
+#define LOG_A5(a, ...) LOG_ARG(a), LOG_A4(__VA_ARGS__)
+#define LOG_A6(a, ...) LOG_ARG(a), LOG_A5(__VA_ARGS__)
+#define LOG_A7(a, ...) LOG_ARG(a), LOG_A6(__VA_ARGS__)
+#define LOG_A8(a, ...) LOG_ARG(a), LOG_A7(__VA_ARGS__)
+#define LOG_A9(a, ...) LOG_ARG(a), LOG_A8(__VA_ARGS__)
+#define LOG_A10(a, ...) LOG_ARG(a), LOG_A9(__VA_ARGS__)
+#define LOG_CHOIX(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+#define LOG_MAP(...) LOG_CHOIX(_0, ##__VA_ARGS__, LOG_A10, LOG_A9, LOG_A8, LOG_A7, LOG_A6, \
+                               LOG_A5, LOG_A4, LOG_A3, LOG_A2, LOG_A1, LOG_A0)(__VA_ARGS__)
+
+#define LOG_ECRIRE(niveau, format, ...) do {                                        \
+        static struct logSite logSite_;                                             \
+        if ((niveau) >= logNiveau)                                                  \
+            logEcrire(&logSite_, (niveau), (format),                                \
+                      (struct logArg[]){ LOG_MAP(__VA_ARGS__) logArgFin() });       \
+    } while (0)
+
+#if LOG_NIVEAU_COMPILE > LOG_NIV_DEBUG
+#define LOG_DEBUG(format, ...) do { } while (0)
+#else
+#define LOG_DEBUG(format, ...) LOG_ECRIRE(LOG_NIV_DEBUG, format, ##__VA_ARGS__)
+#endif
+#define LOG_INFO(format, ...) LOG_ECRIRE(LOG_NIV_INFO, format, ##__VA_ARGS__)
+#define LOG_AVERT(format, ...) LOG_ECRIRE(LOG_NIV_AVERT, format, ##__VA_ARGS__)
+#define LOG_ERREUR(format, ...) LOG_ECRIRE(LOG_NIV_ERREUR, format, ##__VA_ARGS__)
+
+// Démarre le fil d'écriture vers sortie; les enregistrements restants sont
+// écrits à la sortie du programme (exit)
+void logInit(FILE *sortie, int niveau, unsigned int limite);
+
+// Écrit tous les enregistrements en attente et arrête le fil d'écriture
+void logFermer();
+
+// Octets en attente d'écriture et enregistrements perdus, tous fils confondus
+unsigned long logEnAttente();
+unsigned long logPerdus();
+
+// Niveau à partir de son nom ("debug", "info", "avert", "erreur") ou de son numéro
+int logNiveauDepuis(const char *nom);
+
+// Appelée par les macros: le format doit être une chaîne constante
+void logEcrire(struct logSite *site, int niveau, const char *format, struct logArg *args);
+
+#endif
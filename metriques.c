@@ -0,0 +1,292 @@
+/*******************************************************************************
+ * MÉTRIQUES DU SERVEUR
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "metriques.h"
+
+__thread struct metriquesFil *metFil = NULL;
+
+static struct metriquesFil *tranches[MET_MAX_FILS];
+static int nbTranches = 0;
+static int libres[MET_MAX_FILS];            // Tranche d'un fil terminé, à reprendre
+static long tranchesRefusees = 0;           // Fils sans tranche (plus de MET_MAX_FILS vivants)
+static pthread_mutex_t verrouTranches = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t cleTranche;
+static pthread_once_t cleCreee = PTHREAD_ONCE_INIT;
+
+struct jauge
+{
+    const char *nom;
+    const char *type;
+    const char *aide;
+    long (*lire)();
+};
+
+static struct jauge jauges[MET_MAX_JAUGES];
+static int nbJauges = 0;
+
+static const char *nomsCompteurs[MET_NB_COMPTEURS][2] =
+{
+    { "sh13_messages_received_total", "Messages reçus des joueurs" },
+    { "sh13_bytes_received_total", "Octets reçus des joueurs" },
+    { "sh13_messages_sent_total", "Messages envoyés aux joueurs" },
+    { "sh13_bytes_sent_total", "Octets envoyés aux joueurs" },
+    { "sh13_connect_failures_total", "Clients injoignables (message perdu)" },
+    { "sh13_rejected_actions_total", "Messages illisibles ou hors tour" },
+    { "sh13_games_total", "Parties terminées" },
+    { "sh13_spectator_bytes_sent_total", "Octets envoyés aux spectateurs" },
+    { "sh13_spectator_snapshots_total", "Instantanés envoyés aux spectateurs en retard" },
+    { "sh13_spectators_dropped_total", "Spectateurs lâchés (bloqués ou déconnectés)" },
+    { "sh13_net_syscalls_total", "Appels système du chemin réseau (réception et envoi des messages)" },
+    { "sh13_ratings_commits_total", "Lots de fins de partie validés dans le journal du classement" },
+    { "sh13_rate_limited_total", "Messages refusés par un limiteur de débit (adresse ou place)" },
+    { "sh13_admission_refused_total", "Nouveaux joueurs refusés, file d'un groupe au-delà du seuil d'admission" },
+};
+
+static const char *nomsCommandes = "CGOS?";
+
+// Bornes exportées: puissances de 2 en ns, de 1 µs à 8,6 s
+#define MET_BORNE_MIN   10
+#define MET_BORNE_MAX   33
+
+// Un client muet (ou qui ne lit pas la page) ne retient le fil d'exposition
+// que ce temps; sa connexion est ensuite fermée
+#define MET_DELAI_MS    1000
+
+/*******************************************************************************
+ * ENREGISTREMENT
+ ******************************************************************************/
+
+// Fin d'un fil: sa tranche garde ses compteurs et passe au prochain fil créé;
+// celle d'un fil refusé n'est pas exposée et disparaît avec lui
+static void libererTranche(void *t)
+{
+    int i;
+
+    pthread_mutex_lock(&verrouTranches);
+    for (i=0; i<nbTranches && tranches[i] != t; i++)
+        ;
+    if (i < nbTranches)
+        libres[i] = 1;
+    else
+        free(t);
+    pthread_mutex_unlock(&verrouTranches);
+}
+
+static void creerCle()
+{
+    pthread_key_create(&cleTranche, libererTranche);
+}
+
+// Une tranche par fil vivant: reprise d'un fil terminé, ou nouvelle
+struct metriquesFil *metriquesFilCreer()
+{
+    struct metriquesFil *f = NULL;
+    int i;
+
+    pthread_once(&cleCreee, creerCle);
+    pthread_mutex_lock(&verrouTranches);
+    for (i=0; i<nbTranches && f == NULL; i++)
+        if (libres[i])
+        {
+            libres[i] = 0;
+            f = tranches[i];
+        }
+    if (f == NULL)
+    {
+        f = calloc(1, sizeof(struct metriquesFil));
+        if (f == NULL)
+        {
+            perror("metriques");
+            exit(1);
+        }
+        if (nbTranches < MET_MAX_FILS)
+            __atomic_store_n(&tranches[nbTranches++], f, __ATOMIC_RELEASE);
+        else
+            __atomic_add_fetch(&tranchesRefusees, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&verrouTranches);
+    pthread_setspecific(cleTranche, f);
+    return f;
+}
+
+void metriquesDuree(int commande, long ns)
+{
+    struct metriquesFil *f = metriquesDuFil();
+    struct histogramme *h = &f->durees[commande];
+    int c = histoCase(ns);
+
+    if (c >= HISTO_CASES)
+        c = HISTO_CASES - 1;
+    metriquesAjoute(&h->cases[c], 1);
+    metriquesAjoute(&h->nb, 1);
+    metriquesAjoute(&f->sommes[commande], ns);
+}
+
+void metriquesJauge(const char *nom, const char *type, const char *aide, long (*lire)())
+{
+    if (nbJauges >= MET_MAX_JAUGES)
+        return;
+    jauges[nbJauges].nom = nom;
+    jauges[nbJauges].type = type;
+    jauges[nbJauges].aide = aide;
+    jauges[nbJauges].lire = lire;
+    nbJauges++;
+}
+
+/*******************************************************************************
+ * EXPOSITION
+ ******************************************************************************/
+
+void metriquesTexte(FILE *f)
+{
+    struct histogramme h;
+    long cumul, somme;
+    int i, j, c, p, nb = __atomic_load_n(&nbTranches, __ATOMIC_ACQUIRE);
+
+    for (i=0; i<MET_NB_COMPTEURS; i++)
+    {
+        cumul = 0;
+        for (j=0; j<nb; j++)
+            cumul += __atomic_load_n(&tranches[j]->compteurs[i], __ATOMIC_RELAXED);
+        fprintf(f, "# HELP %s %s\n# TYPE %s counter\n%s %ld\n",
+                nomsCompteurs[i][0], nomsCompteurs[i][1], nomsCompteurs[i][0], nomsCompteurs[i][0], cumul);
+    }
+
+    fprintf(f, "# HELP sh13_command_duration_seconds Traitement d'un message (règles, envois, journal)\n");
+    fprintf(f, "# TYPE sh13_command_duration_seconds histogram\n");
+    for (i=0; i<MET_NB_COMMANDES; i++)
+    {
+        memset(&h, 0, sizeof(h));
+        somme = 0;
+        for (j=0; j<nb; j++)
+        {
+            for (c=0; c<HISTO_CASES; c++)
+                h.cases[c] += __atomic_load_n(&tranches[j]->durees[i].cases[c], __ATOMIC_RELAXED);
+            somme += __atomic_load_n(&tranches[j]->sommes[i], __ATOMIC_RELAXED);
+        }
+
+        // Cumul des cases situées sous chaque borne (les bornes tombent sur des débuts de case)
+        cumul = 0;
+        c = 0;
+        for (p=MET_BORNE_MIN; p<=MET_BORNE_MAX; p++)
+        {
+            for (; c<histoCase((double)(1L << p)); c++)
+                cumul += h.cases[c];
+            fprintf(f, "sh13_command_duration_seconds_bucket{command=\"%c\",le=\"%.9g\"} %ld\n",
+                    nomsCommandes[i], (double)(1L << p) / 1e9, cumul);
+        }
+        for (; c<HISTO_CASES; c++)
+            cumul += h.cases[c];
+        fprintf(f, "sh13_command_duration_seconds_bucket{command=\"%c\",le=\"+Inf\"} %ld\n",
+                nomsCommandes[i], cumul);
+        fprintf(f, "sh13_command_duration_seconds_sum{command=\"%c\"} %.9f\n", nomsCommandes[i], somme / 1e9);
+        fprintf(f, "sh13_command_duration_seconds_count{command=\"%c\"} %ld\n", nomsCommandes[i], cumul);
+    }
+
+    for (i=0; i<nbJauges; i++)
+        fprintf(f, "# HELP %s %s\n# TYPE %s %s\n%s %ld\n",
+                jauges[i].nom, jauges[i].aide, jauges[i].nom, jauges[i].type, jauges[i].nom, jauges[i].lire());
+
+    fprintf(f, "# HELP sh13_metrics_threads_refused_total Fils dont les métriques sont perdues (plus de %d fils)\n"
+            "# TYPE sh13_metrics_threads_refused_total counter\nsh13_metrics_threads_refused_total %ld\n",
+            MET_MAX_FILS, __atomic_load_n(&tranchesRefusees, __ATOMIC_RELAXED));
+}
+
+// Répond à chaque connexion par la page de métriques (toute requête HTTP)
+static void *fn_exposition(void *arg)
+{
+    int ecoute = (int)(long) arg;
+    int fd;
+    struct timeval delai = { MET_DELAI_MS / 1000, (MET_DELAI_MS % 1000) * 1000 };
+    char requete[1024], entete[128];
+    char *page;
+    size_t taille;
+    FILE *f;
+
+    while (1)
+    {
+        fd = accept(ecoute, NULL, NULL);
+        if (fd < 0)
+            continue;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &delai, sizeof(delai));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &delai, sizeof(delai));
+        if (read(fd, requete, sizeof(requete)) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        page = NULL;
+        taille = 0;
+        f = open_memstream(&page, &taille);
+        if (f != NULL)
+        {
+            metriquesTexte(f);
+            fclose(f);
+            sprintf(entete, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                    "Content-Length: %zu\r\n\r\n", taille);
+            if (write(fd, entete, strlen(entete)) > 0 && write(fd, page, taille) < 0)
+                perror("metriques");
+            free(page);
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+int metriquesServir(const char *adresse)
+{
+    struct sockaddr_in in;
+    struct sockaddr_un un;
+    int fd, oui = 1;
+
+    if (strncmp(adresse, "unix:", 5) == 0)
+    {
+        if (strlen(adresse + 5) >= sizeof(un.sun_path))
+            return -1;
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        strcpy(un.sun_path, adresse + 5);
+        unlink(un.sun_path);
+        if (fd < 0 || bind(fd, (struct sockaddr *) &un, sizeof(un)) < 0)
+            return -1;
+    }
+    else
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &oui, sizeof(oui));
+        memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        in.sin_port = htons(atoi(adresse));
+        if (bind(fd, (struct sockaddr *) &in, sizeof(in)) < 0)
+            return -1;
+    }
+    if (listen(fd, 8) < 0)
+        return -1;
+    return metriquesReprendre(fd);
+}
+
+int metriquesReprendre(int fd)
+{
+    pthread_t fil;
+
+    if (pthread_create(&fil, NULL, fn_exposition, (void *)(long) fd) != 0)
+        return -1;
+    pthread_detach(fil);
+    return fd;
+}
@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * MÉTRIQUES DU SERVEUR
+ * Compteurs et histogrammes de durée par commande ('C', 'G', 'O', 'S'),
+ * exposés au format texte de Prometheus sur un port HTTP local ou une socket
+ * Unix. Chaque fil écrit dans sa propre tranche (allouée au premier
+ * enregistrement): pas de verrou ni d'instruction atomique coûteuse sur le
+ * chemin critique, les tranches sont additionnées à la lecture.
+ * Les durées sont en nanosecondes (échelle log-linéaire de histogramme.h).
+ ******************************************************************************/
+#ifndef METRIQUES_H
+#define METRIQUES_H
+
+#include <stdio.h>
+#include "histogramme.h"
+
+#define MET_MAX_FILS    64      // Fils vivants (tranche reprise à la fin d'un fil)
+#define MET_MAX_JAUGES  16
+
+// Compteurs
+enum
+{
+    MET_MESSAGES_RECUS,
+    MET_OCTETS_RECUS,
+    MET_MESSAGES_ENVOYES,
+    MET_OCTETS_ENVOYES,
+    MET_ECHECS_CONNEXION,       // Client injoignable (message perdu)
+    MET_ACTIONS_REFUSEES,       // Message illisible ou hors tour
+    MET_PARTIES,                // Parties terminées
+    MET_OCTETS_DIFFUSES,        // Octets envoyés aux spectateurs
+    MET_INSTANTANES,            // Spectateurs en retard remis à jour par un instantané
+    MET_SPECTATEURS_LACHES,     // Spectateurs bloqués ou déconnectés
+    MET_APPELS_RESEAU,          // Appels système du chemin réseau (poll/accept/..., io_uring_enter)
+    MET_LOTS_CLASSEMENT,        // Lots de fins de partie validés (un fdatasync chacun)
+    MET_LIMITES_DEBIT,          // Messages refusés par un limiteur de débit (adresse ou place)
+    MET_ADMISSIONS_REFUSEES,    // Nouveaux joueurs refusés (groupes surchargés)
+    MET_NB_COMPTEURS
+};
+
+// Commandes mesurées
+enum
+{
+    MET_CMD_C,
+    MET_CMD_G,
+    MET_CMD_O,
+    MET_CMD_S,
+    MET_CMD_AUTRE,
+    MET_NB_COMMANDES
+};
+
+// Tranche d'un fil: écrite par ce fil seulement
+struct metriquesFil
+{
+    long compteurs[MET_NB_COMPTEURS];
+    long sommes[MET_NB_COMMANDES];                  // Somme des durées (ns)
+    struct histogramme durees[MET_NB_COMMANDES];
+};
+
+extern __thread struct metriquesFil *metFil;
+struct metriquesFil *metriquesFilCreer();
+
+static inline struct metriquesFil *metriquesDuFil()
+{
+    if (metFil == NULL)
+        metFil = metriquesFilCreer();
+    return metFil;
+}
+
+// Écriture par le seul propriétaire, lecture concurrente par le fil d'exposition:
+// accès atomiques "relaxed" (simples mov sur x86)
+static inline void metriquesAjoute(long *compteur, long n)
+{
+    __atomic_store_n(compteur, __atomic_load_n(compteur, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline void metriquesCompte(int compteur, long n)
+{
+    metriquesAjoute(&metriquesDuFil()->compteurs[compteur], n);
+}
+
+static inline int metriquesCommande(char c)
+{
+    switch (c)
+    {
+        case 'C': return MET_CMD_C;
+        case 'G': return MET_CMD_G;
+        case 'O': return MET_CMD_O;
+        case 'S': return MET_CMD_S;
+    }
+    return MET_CMD_AUTRE;
+}
+
+void metriquesDuree(int commande, long ns);
+
+// Valeur lue à chaque exposition; type "gauge" ou "counter"
+void metriquesJauge(const char *nom, const char *type, const char *aide, long (*lire)());
+
+// Écrit toutes les métriques au format texte de Prometheus
+void metriquesTexte(FILE *f);
+
+// Lance le fil d'exposition: "<port>" (127.0.0.1) ou "unix:<chemin>"
+// Retourne sa socket d'écoute, -1 en cas d'échec
+int metriquesServir(const char *adresse);
+
+// Lance le fil d'exposition sur une socket d'écoute héritée (relève)
+int metriquesReprendre(int fd);
+
+#endif
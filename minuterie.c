@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * MINUTERIES: ROUE HIÉRARCHIQUE
+ ******************************************************************************/
+#include <stddef.h>
+
+#include "minuterie.h"
+
+#define ROUE_MASQUE (ROUE_CASES - 1)
+
+void roueInit(struct roue *r, unsigned long maintenant)
+{
+    int n, c;
+
+    r->maintenant = maintenant;
+    r->nb = 0;
+    for (n=0; n<ROUE_NIVEAUX; n++)
+        for (c=0; c<ROUE_CASES; c++)
+        {
+            r->cases[n][c].suivante = &r->cases[n][c];
+            r->cases[n][c].precedente = &r->cases[n][c];
+        }
+}
+
+void minuterieInit(struct minuterie *m, void (*rappel)(struct minuterie *m), void *donnees, int valeur)
+{
+    m->suivante = m->precedente = NULL;
+    m->echeance = 0;
+    m->rappel = rappel;
+    m->donnees = donnees;
+    m->valeur = valeur;
+}
+
+// Range m dans la case de son échéance, au niveau le plus fin qui la couvre
+static void ranger(struct roue *r, struct minuterie *m)
+{
+    unsigned long ecart = m->echeance - r->maintenant;
+    struct minuterie *tete;
+    int n = 0;
+
+    while (n < ROUE_NIVEAUX - 1 && ecart >= (1UL << (ROUE_BITS * (n + 1))))
+        n++;
+    // Au-delà de la roue: rangée au dernier niveau, elle redescendra plus tard
+    if (ecart >= (1UL << (ROUE_BITS * ROUE_NIVEAUX)) - 1)
+        m->echeance = r->maintenant + (1UL << (ROUE_BITS * ROUE_NIVEAUX)) - 1;
+    tete = &r->cases[n][(m->echeance >> (ROUE_BITS * n)) & ROUE_MASQUE];
+
+    m->suivante = tete;
+    m->precedente = tete->precedente;
+    tete->precedente->suivante = m;
+    tete->precedente = m;
+}
+
+static void detacher(struct minuterie *m)
+{
+    m->precedente->suivante = m->suivante;
+    m->suivante->precedente = m->precedente;
+    m->suivante = m->precedente = NULL;
+}
+
+void rouePlanifier(struct roue *r, struct minuterie *m, unsigned long echeance)
+{
+    if (minuterieActive(m))
+        detacher(m);
+    else
+        r->nb++;
+    m->echeance = (echeance > r->maintenant) ? echeance : r->maintenant + 1;
+    ranger(r, m);
+}
+
+void roueAnnuler(struct roue *r, struct minuterie *m)
+{
+    if (!minuterieActive(m))
+        return;
+    detacher(m);
+    r->nb--;
+}
+
+// Redescend les minuteries d'une case du niveau n (la roue du dessous a fait un tour)
+static void cascade(struct roue *r, int n)
+{
+    struct minuterie *tete = &r->cases[n][(r->maintenant >> (ROUE_BITS * n)) & ROUE_MASQUE];
+    struct minuterie *m;
+
+    while ((m = tete->suivante) != tete)
+    {
+        detacher(m);
+        ranger(r, m);
+    }
+}
+
+int roueAvancer(struct roue *r, unsigned long maintenant)
+{
+    struct minuterie *tete, *m;
+    int n, appels = 0;
+
+    while (r->maintenant < maintenant)
+    {
+        // Roue vide: rien à parcourir
+        if (r->nb == 0)
+        {
+            r->maintenant = maintenant;
+            break;
+        }
+        r->maintenant++;
+
+        for (n=1; n<ROUE_NIVEAUX
+                  && ((r->maintenant >> (ROUE_BITS * (n - 1))) & ROUE_MASQUE) == 0; n++)
+            cascade(r, n);
+
+        tete = &r->cases[0][r->maintenant & ROUE_MASQUE];
+        while ((m = tete->suivante) != tete)
+        {
+            detacher(m);
+            r->nb--;
+            m->rappel(m);
+            appels++;
+        }
+    }
+    return appels;
+}
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * MINUTERIES: ROUE HIÉRARCHIQUE
+ * Échéances des tables (délai de tour, inactivité des joueurs). Le temps est
+ * compté en ticks; la roue a 4 niveaux de 256 cases: une minuterie est rangée
+ * dans la case de son échéance au niveau le plus fin qui la couvre, et
+ * redescend d'un niveau quand la roue du dessous a fait un tour. Planifier,
+ * annuler et avancer d'un tick coûtent O(1), quel que soit le nombre de
+ * minuteries en attente. Les minuteries sont intrusives (aucune allocation).
+ ******************************************************************************/
+#ifndef MINUTERIE_H
+#define MINUTERIE_H
+
+#define ROUE_NIVEAUX    4
+#define ROUE_BITS       8
+#define ROUE_CASES      (1 << ROUE_BITS)
+
+#define MINUTERIE_TICK_MS   10      // Durée d'un tick pour le serveur
+
+struct minuterie
+{
+    struct minuterie *suivante;         // Liste circulaire de la case (NULL si inactive)
+    struct minuterie *precedente;
+    unsigned long echeance;             // Tick d'expiration
+    void (*rappel)(struct minuterie *m);
+    void *donnees;                      // Libres pour le rappel
+    int valeur;
+};
+
+struct roue
+{
+    unsigned long maintenant;           // Dernier tick traité
+    long nb;                            // Minuteries en attente
+    struct minuterie cases[ROUE_NIVEAUX][ROUE_CASES];   // Sentinelles
+};
+
+void roueInit(struct roue *r, unsigned long maintenant);
+
+// Prépare une minuterie inactive
+void minuterieInit(struct minuterie *m, void (*rappel)(struct minuterie *m), void *donnees, int valeur);
+
+// (Re)planifie m pour le tick echeance (au plus tôt le prochain tick)
+void rouePlanifier(struct roue *r, struct minuterie *m, unsigned long echeance);
+
+// Retire m de la roue si elle y est
+void roueAnnuler(struct roue *r, struct minuterie *m);
+
+static inline int minuterieActive(struct minuterie *m)
+{
+    return m->suivante != NULL;
+}
+
+// Avance jusqu'au tick maintenant et appelle le rappel des minuteries échues
+// (un rappel peut replanifier ou annuler n'importe quelle minuterie)
+// Retourne le nombre de rappels
+int roueAvancer(struct roue *r, unsigned long maintenant);
+
+#endif
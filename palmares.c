@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * PALMARÈS: JOUEURS RANGÉS PAR COTE
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "palmares.h"
+#include "hachage.h"
+
+// a est classé avant b: meilleure cote, ou même cote et nom plus petit
+static int avant(struct joueurPalmares *a, struct joueurPalmares *b)
+{
+    return a->elo > b->elo || (a->elo == b->elo && strcmp(a->nom, b->nom) < 0);
+}
+
+// Niveaux d'un nouveau joueur: 1, puis un de plus avec une chance sur 4 (xorshift)
+static int tirerNiveaux(struct palmares *p)
+{
+    int n = 1;
+
+    while (n < PALMARES_NIVEAUX)
+    {
+        p->alea ^= p->alea << 13;
+        p->alea ^= p->alea >> 17;
+        p->alea ^= p->alea << 5;
+        if ((p->alea & 3) != 0)
+            break;
+        n++;
+    }
+    return n;
+}
+
+static struct joueurPalmares *chercher(struct palmares *p, const char *nom)
+{
+    struct joueurPalmares *j;
+
+    for (j = p->noms[hacherNom(nom) & p->masque]; j != NULL; j = j->suivantNom)
+        if (strcmp(j->nom, nom) == 0)
+            return j;
+    return NULL;
+}
+
+// Double l'index des noms (au-delà d'un joueur par case)
+static int agrandirNoms(struct palmares *p)
+{
+    struct joueurPalmares **noms, *j, *suivant;
+    unsigned long i, masque = 2 * p->masque + 1;
+
+    noms = calloc(masque + 1, sizeof(struct joueurPalmares *));
+    if (noms == NULL)
+        return -1;
+    for (i=0; i<=p->masque; i++)
+        for (j = p->noms[i]; j != NULL; j = suivant)
+        {
+            suivant = j->suivantNom;
+            j->suivantNom = noms[hacherNom(j->nom) & masque];
+            noms[hacherNom(j->nom) & masque] = j;
+        }
+    free(p->noms);
+    p->noms = noms;
+    p->masque = masque;
+    return 0;
+}
+
+// Accroche j à sa place (sa cote)
+static void accrocher(struct palmares *p, struct joueurPalmares *j)
+{
+    struct joueurPalmares *prec[PALMARES_NIVEAUX], *x = p->tete;
+    unsigned long rang[PALMARES_NIVEAUX];
+    int i;
+
+    // Dernier joueur avant j à chaque niveau, et son rang
+    for (i=p->niveaux-1; i>=0; i--)
+    {
+        rang[i] = (i == p->niveaux - 1) ? 0 : rang[i+1];
+        while (x->liens[i].suivant != NULL && avant(x->liens[i].suivant, j))
+        {
+            rang[i] += x->liens[i].enjambe;
+            x = x->liens[i].suivant;
+        }
+        prec[i] = x;
+    }
+
+    // Niveaux neufs: la tête enjambe tout le palmarès
+    for (i=p->niveaux; i<j->niveaux; i++)
+    {
+        rang[i] = 0;
+        prec[i] = p->tete;
+        p->tete->liens[i].enjambe = p->nb;
+    }
+    if (j->niveaux > p->niveaux)
+        p->niveaux = j->niveaux;
+
+    for (i=0; i<j->niveaux; i++)
+    {
+        j->liens[i].suivant = prec[i]->liens[i].suivant;
+        prec[i]->liens[i].suivant = j;
+        j->liens[i].enjambe = prec[i]->liens[i].enjambe - (rang[0] - rang[i]);
+        prec[i]->liens[i].enjambe = (rang[0] - rang[i]) + 1;
+    }
+    for (; i<p->niveaux; i++)
+        prec[i]->liens[i].enjambe++;
+    p->nb++;
+}
+
+// Décroche j (sa cote est encore celle de sa place)
+static void decrocher(struct palmares *p, struct joueurPalmares *j)
+{
+    struct joueurPalmares *x = p->tete;
+    int i;
+
+    for (i=p->niveaux-1; i>=0; i--)
+    {
+        while (x->liens[i].suivant != NULL && avant(x->liens[i].suivant, j))
+            x = x->liens[i].suivant;
+        if (x->liens[i].suivant == j)
+        {
+            x->liens[i].enjambe += j->liens[i].enjambe - 1;
+            x->liens[i].suivant = j->liens[i].suivant;
+        }
+        else
+            x->liens[i].enjambe--;
+    }
+    while (p->niveaux > 1 && p->tete->liens[p->niveaux-1].suivant == NULL)
+        p->niveaux--;
+    p->nb--;
+}
+
+int palmaresInit(struct palmares *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->tete = calloc(1, sizeof(struct joueurPalmares) + PALMARES_NIVEAUX * sizeof(p->tete->liens[0]));
+    p->noms = calloc(1024, sizeof(struct joueurPalmares *));
+    if (p->tete == NULL || p->noms == NULL)
+        return -1;
+    p->tete->niveaux = PALMARES_NIVEAUX;
+    p->niveaux = 1;
+    p->masque = 1023;
+    p->alea = 2463534242u;
+    return 0;
+}
+
+int palmaresCoter(struct palmares *p, const char *nom, float elo)
+{
+    struct joueurPalmares *j = chercher(p, nom);
+    unsigned int h;
+    int n;
+
+    if (j != NULL)
+    {
+        if (j->elo == elo)
+            return 0;
+        decrocher(p, j);
+        j->elo = elo;
+        accrocher(p, j);
+        return 0;
+    }
+
+    if (p->nb > p->masque && agrandirNoms(p) < 0)
+        return -1;
+    n = tirerNiveaux(p);
+    j = calloc(1, sizeof(struct joueurPalmares) + n * sizeof(j->liens[0]));
+    if (j == NULL)
+        return -1;
+    strncpy(j->nom, nom, PALMARES_NOM - 1);
+    j->elo = elo;
+    j->niveaux = n;
+    h = hacherNom(j->nom) & p->masque;
+    j->suivantNom = p->noms[h];
+    p->noms[h] = j;
+    accrocher(p, j);
+    return 0;
+}
+
+unsigned long palmaresRang(struct palmares *p, const char *nom)
+{
+    struct joueurPalmares *j = chercher(p, nom), *x = p->tete;
+    unsigned long rang = 0;
+    int i;
+
+    if (j == NULL)
+        return 0;
+    for (i=p->niveaux-1; i>=0; i--)
+        while (x->liens[i].suivant != NULL && !avant(j, x->liens[i].suivant))
+        {
+            rang += x->liens[i].enjambe;
+            x = x->liens[i].suivant;
+        }
+    return rang;
+}
+
+struct joueurPalmares *palmaresAuRang(struct palmares *p, unsigned long rang)
+{
+    struct joueurPalmares *x = p->tete;
+    unsigned long parcouru = 0;
+    int i;
+
+    if (rang == 0 || rang > p->nb)
+        return NULL;
+    for (i=p->niveaux-1; i>=0; i--)
+        while (x->liens[i].suivant != NULL && parcouru + x->liens[i].enjambe <= rang)
+        {
+            parcouru += x->liens[i].enjambe;
+            x = x->liens[i].suivant;
+        }
+    return x;
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * PALMARÈS: JOUEURS RANGÉS PAR COTE
+ * Liste à enjambements (skip list) indexée: joueurs triés par cote
+ * décroissante (à cote égale, par nom), chaque lien connaît le nombre de
+ * joueurs qu'il enjambe. Le rang d'un joueur est la somme des enjambements
+ * du chemin qui mène à lui: mise à jour d'une cote, rang d'un joueur et accès
+ * au k-ième en O(log n), les suivants en O(1) chacun. Une table de hachage
+ * (chaînage) retrouve le joueur par son nom. Un joueur dont la cote change
+ * est décroché puis raccroché à sa nouvelle place: rien n'est jamais trié.
+ * Pas de verrou: l'appelant protège le palmarès.
+ ******************************************************************************/
+#ifndef PALMARES_H
+#define PALMARES_H
+
+#define PALMARES_NOM        40
+#define PALMARES_NIVEAUX    32      // Niveaux au plus (p = 1/4: 4^32 joueurs)
+
+struct joueurPalmares
+{
+    char nom[PALMARES_NOM];
+    float elo;
+    struct joueurPalmares *suivantNom;      // Chaînage de l'index des noms
+    int niveaux;
+    struct
+    {
+        struct joueurPalmares *suivant;
+        unsigned long enjambe;              // Rangs entre ce joueur et le suivant de ce niveau
+    } liens[];
+};
+
+struct palmares
+{
+    struct joueurPalmares *tete;            // Sentinelle, PALMARES_NIVEAUX niveaux
+    int niveaux;                            // Niveaux utilisés par les joueurs
+    unsigned long nb;
+    struct joueurPalmares **noms;           // Index des noms (NULL = case vide)
+    unsigned long masque;                   // Taille de l'index - 1 (double au-delà de nb)
+    unsigned int alea;                      // Tirage des niveaux
+};
+
+// Palmarès vide, retourne -1 si la mémoire manque
+int palmaresInit(struct palmares *p);
+
+// Nouvelle cote du joueur (ajouté s'il est inconnu)
+// Retourne -1 si la mémoire manque
+int palmaresCoter(struct palmares *p, const char *nom, float elo);
+
+// Rang du joueur (1 = meilleure cote), 0 s'il est inconnu
+unsigned long palmaresRang(struct palmares *p, const char *nom);
+
+// Joueur du rang donné (à partir de 1), NULL au-delà du dernier
+struct joueurPalmares *palmaresAuRang(struct palmares *p, unsigned long rang);
+
+// Joueur suivant dans le palmarès, NULL après le dernier
+static inline struct joueurPalmares *palmaresSuivant(struct joueurPalmares *j)
+{
+    return j->liens[0].suivant;
+}
+
+#endif
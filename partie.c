@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * MOTEUR DE PARTIE SHERLOCK 13
+ ******************************************************************************/
+#include <stdio.h>
+
+#include "partie.h"
+
+/*******************************************************************************
+ * SECTION 1: MÉLANGE DU DECK
+ ******************************************************************************/
+
+// Générateur xorshift32: la même graine redonne toujours le même deck,
+// quelle que soit la libc (nécessaire pour rejouer les journaux)
+static unsigned int partieAleatoire(struct partie *p)
+{
+    unsigned int x = p->alea;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    p->alea = x;
+    return x;
+}
+
+// Mélange aléatoirement le deck de cartes
+void melangerDeck(struct partie *p)
+{
+    int i;                  // Compteur de boucle
+    int index1, index2;     // Indices des deux cartes à échanger
+    int tmp;                // Variable temporaire pour l'échange
+
+    // Effectue 1000 échanges aléatoires pour bien mélanger le deck
+    for (i=0; i<1000; i++)
+    {
+        index1 = partieAleatoire(p) % NB_CARTES;
+        index2 = partieAleatoire(p) % NB_CARTES;
+
+        tmp = p->deck[index1];
+        p->deck[index1] = p->deck[index2];
+        p->deck[index2] = tmp;
+    }
+}
+
+/*******************************************************************************
+ * SECTION 2: CRÉATION DU TABLEAU DE STATISTIQUES
+ ******************************************************************************/
+
+// Crée le tableau de statistiques basé sur les cartes distribuées
+// Joueur i: cartes d'indices i*3, i*3+1, i*3+2 du deck mélangé
+// Coupable: carte d'indice 12 (la carte à deviner)
+void createTable(struct partie *p)
+{
+    int i, j, o, c;
+
+    for (i=0; i<NB_JOUEURS; i++)
+        for (o=0; o<NB_OBJETS; o++)
+            p->tableCartes[i][o] = 0;
+
+    for (i=0; i<NB_JOUEURS; i++)
+        for (j=0; j<3; j++)
+        {
+            c = p->deck[i*3+j];
+            for (o=0; o<NB_OBJETS; o++)
+                p->tableCartes[i][o] += symbolesCartes[c][o];
+        }
+}
+
+void partieInit(struct partie *p, unsigned int graine)
+{
+    int i;
+
+    p->graine = graine;
+    p->alea = graine ? graine : 0x9E3779B9;
+    for (i=0; i<NB_CARTES; i++)
+        p->deck[i] = i;
+    melangerDeck(p);
+    createTable(p);
+
+    p->joueurCourant = 0;
+    for (i=0; i<NB_JOUEURS; i++)
+        p->joueursPerdu[i] = 0;
+    p->gagnant = -1;
+}
+
+/*******************************************************************************
+ * SECTION 3: DÉROULEMENT D'UN TOUR
+ ******************************************************************************/
+
+static int evenement(struct evenement *ev, char code, int dest, int a, int b, int c)
+{
+    ev->code = code;
+    ev->dest = dest;
+    ev->a = a;
+    ev->b = b;
+    ev->c = c;
+    return 1;
+}
+
+// Passe la main au prochain joueur encore en jeu et produit le 'M'
+static int joueurSuivant(struct partie *p, struct evenement *ev)
+{
+    int i;
+
+    // Saute les joueurs éliminés par une mauvaise accusation
+    for (i=0; i<NB_JOUEURS; i++)
+    {
+        p->joueurCourant = (p->joueurCourant + 1) % NB_JOUEURS;
+        if (!p->joueursPerdu[p->joueurCourant])
+            break;
+    }
+    return evenement(ev, 'M', A_TOUS, p->joueurCourant, 0, 0);
+}
+
+int partieDemarrer(struct partie *p, struct evenement *ev)
+{
+    int i, n = 0;
+
+    for (i=0; i<NB_JOUEURS; i++)
+        n += evenement(&ev[n], 'D', i, p->deck[i*3], p->deck[i*3+1], p->deck[i*3+2]);
+    n += evenement(&ev[n], 'M', A_TOUS, p->joueurCourant, 0, 0);
+    return n;
+}
+
+int partieAppliquer(struct partie *p, struct action *act, struct evenement *ev)
+{
+    int j, restants, n = 0;
+
+    // Seul le joueur courant peut agir, tant que personne n'a gagné
+    if (p->gagnant != -1 || act->joueur != p->joueurCourant)
+        return -1;
+
+    switch (act->code)
+    {
+        // Accusation: "G <idJoueur> <numCarte>"
+        case 'G':
+            if (act->a < 0 || act->a >= NB_CARTES)
+                return -1;
+            if (act->a == p->deck[12])
+            {
+                p->gagnant = act->joueur;
+                return evenement(&ev[0], 'W', A_TOUS, act->joueur, act->a, 0);
+            }
+            // Mauvaise accusation: le joueur est éliminé
+            p->joueursPerdu[act->joueur] = 1;
+            n += evenement(&ev[n], 'F', A_TOUS, act->joueur, act->a, 0);
+            break;
+
+        // Question oui/non à toute la table: "O <idJoueur> <objet>"
+        case 'O':
+            if (act->a < 0 || act->a >= NB_OBJETS)
+                return -1;
+            for (j=0; j<NB_JOUEURS; j++)
+                n += evenement(&ev[n], 'R', A_TOUS, act->a, j, p->tableCartes[j][act->a] > 0);
+            break;
+
+        // Question statistique: "S <idJoueur> <joueur> <objet>"
+        // Réponse uniquement au joueur demandeur
+        case 'S':
+            if (act->a < 0 || act->a >= NB_JOUEURS || act->b < 0 || act->b >= NB_OBJETS)
+                return -1;
+            n += evenement(&ev[n], 'S', act->joueur, act->b, p->tableCartes[act->a][act->b], 0);
+            break;
+
+        // Délai de tour dépassé (action du serveur, jamais reçue du réseau):
+        // "P <idJoueur> 0" passe le tour, "P <idJoueur> 1" élimine le joueur
+        case 'P':
+            if (act->a)
+            {
+                p->joueursPerdu[act->joueur] = 1;
+                n += evenement(&ev[n], 'A', A_TOUS, act->joueur, 0, 0);
+                // Plus personne en face: le dernier joueur en jeu l'emporte
+                restants = 0;
+                for (j=0; j<NB_JOUEURS; j++)
+                    if (!p->joueursPerdu[j])
+                    {
+                        restants++;
+                        p->gagnant = j;
+                    }
+                if (restants <= 1)
+                {
+                    if (restants == 0)
+                        p->gagnant = act->joueur;
+                    n += evenement(&ev[n], 'W', A_TOUS, p->gagnant, p->deck[12], 0);
+                    return n;
+                }
+                p->gagnant = -1;
+            }
+            break;
+
+        default:
+            return -1;
+    }
+
+    n += joueurSuivant(p, &ev[n]);
+    return n;
+}
+
+/*******************************************************************************
+ * SECTION 4: FORMAT TEXTE DU PROTOCOLE
+ ******************************************************************************/
+
+int partieLireAction(char *mess, struct action *act)
+{
+    char com;
+
+    act->a = act->b = 0;
+    act->requete = lireRequete(mess);
+    switch (mess[0])
+    {
+        case 'G':
+        case 'O':
+            if (sscanf(mess, "%c %d %d", &com, &act->joueur, &act->a) != 3)
+                return 0;
+            break;
+        case 'S':
+            if (sscanf(mess, "%c %d %d %d", &com, &act->joueur, &act->a, &act->b) != 4)
+                return 0;
+            break;
+        default:
+            return 0;
+    }
+    act->code = com;
+    return 1;
+}
+
+void partieFormaterAction(struct action *act, char *mess)
+{
+    if (act->code == 'S')
+        sprintf(mess, "S %d %d %d", act->joueur, act->a, act->b);
+    else
+        sprintf(mess, "%c %d %d", act->code, act->joueur, act->a);
+}
+
+void partieFormater(struct evenement *ev, char *mess)
+{
+    switch (ev->code)
+    {
+        case 'D':
+        case 'R':
+            sprintf(mess, "%c %d %d %d", ev->code, ev->a, ev->b, ev->c);
+            break;
+        case 'M':
+            sprintf(mess, "M %d", ev->a);
+            break;
+        default:
+            sprintf(mess, "%c %d %d", ev->code, ev->a, ev->b);
+            break;
+    }
+}
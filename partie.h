@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * MOTEUR DE PARTIE SHERLOCK 13
+ * Règles du jeu sans entrées/sorties: utilisé par le serveur et par les outils
+ * (rejeu des journaux). Une action acceptée produit une liste d'événements
+ * que l'appelant envoie aux joueurs.
+ ******************************************************************************/
+#ifndef PARTIE_H
+#define PARTIE_H
+
+#include "regles.h"
+
+// Nombre maximum d'événements produits par une action (question O/N: 4 'R' + 'M')
+#define MAX_EVENEMENTS 8
+
+// Destinataire d'un événement envoyé à toute la table
+#define A_TOUS -1
+
+// État d'une partie
+struct partie
+{
+    unsigned int graine;                    // Graine du mélange (rejouable)
+    unsigned int alea;                      // État du générateur pseudo-aléatoire
+    int deck[NB_CARTES];                    // Deck mélangé, deck[12] = coupable
+    int tableCartes[NB_JOUEURS][NB_OBJETS]; // Symboles de chaque joueur
+    int joueurCourant;                      // Indice du joueur dont c'est le tour (0 à 3)
+    int joueursPerdu[NB_JOUEURS];           // 1 si le joueur a fait une mauvaise accusation
+    int gagnant;                            // Joueur gagnant, -1 tant que la partie continue
+};
+
+// Action d'un joueur ('G', 'O' ou 'S') ou du serveur ('P', délai de tour dépassé)
+// G: a = carte accusée; O: a = objet; S: a = joueur interrogé, b = objet
+// P: a = 0 tour passé, 1 joueur éliminé (forfait)
+struct action
+{
+    char code;
+    int joueur;
+    int a, b;
+    int requete;                            // "#<n>" du client, 0 si absent (non journalisé)
+};
+
+// Message produit par le moteur ('D', 'M', 'R', 'S', 'F', 'W', 'A' forfait)
+// dest = place du destinataire ou A_TOUS
+struct evenement
+{
+    char code;
+    int dest;
+    int a, b, c;
+};
+
+// Remet la partie à zéro: deck mélangé avec la graine, tableau des symboles
+void partieInit(struct partie *p, unsigned int graine);
+
+// Mélange le deck (générateur interne, reproductible à partir de la graine)
+void melangerDeck(struct partie *p);
+
+// Calcule tableCartes à partir des cartes distribuées
+void createTable(struct partie *p);
+
+// Événements du début de partie: 'D' à chaque joueur puis 'M'
+int partieDemarrer(struct partie *p, struct evenement *ev);
+
+// Applique l'action d'un joueur
+// Retourne le nombre d'événements produits, -1 si l'action est refusée
+int partieAppliquer(struct partie *p, struct action *act, struct evenement *ev);
+
+// Analyse un message 'G', 'O' ou 'S' reçu d'un joueur, retourne 0 si invalide
+int partieLireAction(char *mess, struct action *act);
+
+// Écrit le message texte correspondant à une action ou un événement
+void partieFormaterAction(struct action *act, char *mess);
+void partieFormater(struct evenement *ev, char *mess);
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * REGLES DU JEU SHERLOCK 13
+ ******************************************************************************/
+#include "regles.h"
+
+// Noms des 13 cartes/personnages du jeu Sherlock 13
+char *nomcartes[NB_CARTES]=
+{
+    "Sebastian Moran",          // Carte 0
+    "irene Adler",              // Carte 1
+    "inspector Lestrade",       // Carte 2
+    "inspector Gregson",        // Carte 3
+    "inspector Baynes",         // Carte 4
+    "inspector Bradstreet",     // Carte 5
+    "inspector Hopkins",        // Carte 6
+    "Sherlock Holmes",          // Carte 7
+    "John Watson",              // Carte 8
+    "Mycroft Holmes",           // Carte 9
+    "Mrs. Hudson",              // Carte 10
+    "Mary Morstan",             // Carte 11
+    "James Moriarty"            // Carte 12
+};
+
+// Symboles portés par chaque carte
+//                                   pipe amp poing cour carn coll oeil crane
+const int symbolesCartes[NB_CARTES][NB_OBJETS]=
+{
+    /* 0  Sebastian Moran      */ {  0,   0,   1,   0,   0,   0,   0,   1 },
+    /* 1  Irene Adler          */ {  0,   1,   0,   0,   0,   1,   0,   1 },
+    /* 2  Inspector Lestrade   */ {  0,   0,   0,   1,   1,   0,   1,   0 },
+    /* 3  Inspector Gregson    */ {  0,   0,   1,   1,   1,   0,   0,   0 },
+    /* 4  Inspector Baynes     */ {  0,   1,   0,   1,   0,   0,   0,   0 },
+    /* 5  Inspector Bradstreet */ {  0,   0,   1,   1,   0,   0,   0,   0 },
+    /* 6  Inspector Hopkins    */ {  1,   0,   0,   1,   0,   0,   1,   0 },
+    /* 7  Sherlock Holmes      */ {  1,   1,   1,   0,   0,   0,   0,   0 },
+    /* 8  John Watson          */ {  1,   0,   1,   0,   0,   0,   1,   0 },
+    /* 9  Mycroft Holmes       */ {  1,   1,   0,   0,   1,   0,   0,   0 },
+    /* 10 Mrs. Hudson          */ {  1,   0,   0,   0,   0,   1,   0,   0 },
+    /* 11 Mary Morstan         */ {  0,   0,   0,   0,   1,   1,   0,   0 },
+    /* 12 James Moriarty       */ {  0,   1,   0,   0,   0,   0,   0,   1 }
+};
@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * REGLES DU JEU SHERLOCK 13
+ * Données partagées par le serveur, les joueurs robots et les outils
+ ******************************************************************************/
+#ifndef REGLES_H
+#define REGLES_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NB_CARTES   13      // Nombre de personnages
+#define NB_JOUEURS  4       // Nombre de joueurs autour d'une table
+#define NB_OBJETS   8       // Nombre de symboles (colonnes de tableCartes)
+
+// Noms des 13 cartes/personnages du jeu Sherlock 13
+extern char *nomcartes[NB_CARTES];
+
+// symbolesCartes[c][o] = nombre de symboles o portés par la carte c
+// Colonnes: 0=pipe 1=ampoule 2=poing 3=couronne 4=carnet 5=collier 6=oeil 7=crâne
+extern const int symbolesCartes[NB_CARTES][NB_OBJETS];
+
+// Numéro de requête d'un message: dernier champ "#<n>", 0 si absent
+// Un client l'ajoute à ses actions 'G', 'O', 'S' (après la table); le serveur
+// le recopie dans les réponses à cette action qu'il envoie à ce client
+static inline int lireRequete(const char *mess)
+{
+    const char *p = strrchr(mess, '#');
+
+    return p != NULL ? atoi(p + 1) : 0;
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * RELÈVE D'UN PROCESSUS PAR UN AUTRE
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "releve.h"
+
+struct enteteReleve
+{
+    int type;
+    int taille;
+};
+
+static int adresse(struct sockaddr_un *un, const char *chemin)
+{
+    if (strlen(chemin) >= sizeof(un->sun_path))
+        return -1;
+    memset(un, 0, sizeof(*un));
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, chemin);
+    return 0;
+}
+
+int releveEcouter(const char *chemin)
+{
+    struct sockaddr_un un;
+    int fd;
+
+    if (adresse(&un, chemin) < 0 || (fd = socket(AF_UNIX, SOCK_SEQPACKET, 0)) < 0)
+        return -1;
+    unlink(chemin);
+    if (bind(fd, (struct sockaddr *) &un, sizeof(un)) < 0 || listen(fd, 1) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int releveConnecter(const char *chemin)
+{
+    struct sockaddr_un un;
+    int fd;
+
+    if (adresse(&un, chemin) < 0 || (fd = socket(AF_UNIX, SOCK_SEQPACKET, 0)) < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *) &un, sizeof(un)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int releveEnvoyer(int fd, int type, const void *donnees, int taille, const int *fds, int nbFds)
+{
+    struct enteteReleve e;
+    struct iovec iov[2];
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    union
+    {
+        char octets[CMSG_SPACE(RELEVE_FDS * sizeof(int))];
+        struct cmsghdr aligne;
+    } controle;
+
+    if (taille > RELEVE_MESSAGE || nbFds > RELEVE_FDS)
+        return -1;
+    e.type = type;
+    e.taille = taille;
+    iov[0].iov_base = &e;
+    iov[0].iov_len = sizeof(e);
+    iov[1].iov_base = (void *) donnees;
+    iov[1].iov_len = taille;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    if (nbFds > 0)
+    {
+        memset(&controle, 0, sizeof(controle));
+        msg.msg_control = controle.octets;
+        msg.msg_controllen = CMSG_SPACE(nbFds * sizeof(int));
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(nbFds * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, nbFds * sizeof(int));
+    }
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)(sizeof(e) + taille) ? 0 : -1;
+}
+
+int releveRecevoir(int fd, int *type, void *donnees, int taille, int *fds, int *nbFds, int delaiMs)
+{
+    struct enteteReleve e;
+    struct iovec iov[2];
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    struct pollfd attente;
+    union
+    {
+        char octets[CMSG_SPACE(RELEVE_FDS * sizeof(int))];
+        struct cmsghdr aligne;
+    } controle;
+    ssize_t n;
+
+    *nbFds = 0;
+    attente.fd = fd;
+    attente.events = POLLIN;
+    if (poll(&attente, 1, delaiMs) <= 0)
+        return -1;
+
+    iov[0].iov_base = &e;
+    iov[0].iov_len = sizeof(e);
+    iov[1].iov_base = donnees;
+    iov[1].iov_len = taille;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    msg.msg_control = controle.octets;
+    msg.msg_controllen = sizeof(controle.octets);
+    n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < (ssize_t) sizeof(e))
+        return -1;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            *nbFds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg), *nbFds * sizeof(int));
+        }
+
+    // Message tronqué: données plus grandes que prévu (versions différentes)
+    if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || n - (ssize_t) sizeof(e) != e.taille)
+    {
+        while (*nbFds > 0)
+            close(fds[--(*nbFds)]);
+        return -1;
+    }
+    *type = e.type;
+    return e.taille;
+}
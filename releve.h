@@ -0,0 +1,33 @@
+/*******************************************************************************
+ * RELÈVE D'UN PROCESSUS PAR UN AUTRE (MISE À JOUR SANS INTERRUPTION)
+ * Le serveur en place écoute sur une socket Unix; le nouveau processus s'y
+ * connecte et reçoit, message par message, l'état à reprendre et les
+ * descripteurs ouverts (SCM_RIGHTS): sockets d'écoute avec leurs connexions
+ * en attente, connexions des spectateurs... Les messages gardent leurs
+ * limites (SOCK_SEQPACKET): un type, des données de taille fixe et au plus
+ * RELEVE_FDS descripteurs chacun.
+ ******************************************************************************/
+#ifndef RELEVE_H
+#define RELEVE_H
+
+#define RELEVE_FDS      16          // Descripteurs par message au plus
+#define RELEVE_MESSAGE  8192        // Données d'un message au plus
+
+// Écoute les successeurs sur chemin (remplace une socket existante)
+// Retourne la socket d'écoute, -1 en cas d'échec
+int releveEcouter(const char *chemin);
+
+// Se connecte au processus en place, -1 s'il n'y en a pas
+int releveConnecter(const char *chemin);
+
+// Envoie un message: type, taille octets de donnees et nbFds descripteurs
+// (dupliqués dans le processus qui les reçoit). Retourne -1 en cas d'échec
+int releveEnvoyer(int fd, int type, const void *donnees, int taille, const int *fds, int nbFds);
+
+// Reçoit le message suivant (attend au plus delaiMs, -1: sans limite):
+// données copiées dans donnees (taille octets au plus), descripteurs reçus
+// dans fds (RELEVE_FDS places) et leur nombre dans *nbFds
+// Retourne la taille des données, -1 en cas d'échec, de délai ou de fin
+int releveRecevoir(int fd, int *type, void *donnees, int taille, int *fds, int *nbFds, int delaiMs);
+
+#endif
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * REJEU DES JOURNAUX DE PARTIES
+ * Rejoue chaque journal à travers le moteur de partie (sans attente),
+ * vérifie que la donne et tous les événements sont identiques à ceux
+ * enregistrés, et recalcule les statistiques des parties.
+ *
+ * Usage: ./replay [-m] [-r repetitions] [-v] <journal>...
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "partie.h"
+#include "journal.h"
+
+/*******************************************************************************
+ * SECTION 1: STATISTIQUES
+ ******************************************************************************/
+
+struct statistiques
+{
+    long journaux;
+    long enregistrements;
+    long parties;
+    long terminees;
+    long actions[128];                      // Actions par code ('G', 'O', 'S')
+    long mauvaisesAccusations;
+    long victoires[NB_JOUEURS];             // Victoires par place
+    long toursVictoire;                     // Somme des tours des parties terminées
+    double dureeVictoire;                   // Somme des durées des parties terminées (s)
+    long divergences;
+} stats;
+
+int verbeux = 0;
+
+void divergence(const char *fichier, struct enregistrement *e, const char *message)
+{
+    stats.divergences++;
+    if (verbeux || stats.divergences <= 20)
+        fprintf(stderr, "%s: enregistrement '%c' à t=%llu: %s\n",
+                fichier, e->type, e->t, message);
+}
+
+/*******************************************************************************
+ * SECTION 2: REJEU D'UN JOURNAL
+ ******************************************************************************/
+
+void rejouer(const char *fichier, int avecMmap)
+{
+    struct lecteurJournal l;
+    struct enregistrement e;
+    struct partie p;
+    struct action act;
+    struct evenement attendus[MAX_EVENEMENTS], ev;
+    int nbAttendus = 0, prochain = 0;
+    int joueurs = 0, enCours = 0, tours = 0, i;
+    unsigned long long debut = 0;
+    unsigned int graine;
+
+    if (journalOuvrir(&l, fichier, avecMmap) < 0)
+    {
+        fprintf(stderr, "%s: journal illisible\n", fichier);
+        stats.divergences++;
+        return;
+    }
+    stats.journaux++;
+
+    while (journalSuivant(&l, &e))
+    {
+        stats.enregistrements++;
+        switch (e.type)
+        {
+            // Nouvelle partie: le moteur redistribue à partir de la graine
+            case J_PARTIE:
+                graine = e.donnees[0] | (e.donnees[1] << 8) | (e.donnees[2] << 16)
+                         | ((unsigned int) e.donnees[3] << 24);
+                partieInit(&p, graine);
+                stats.parties++;
+                enCours = 1;
+                joueurs = 0;
+                tours = 0;
+                nbAttendus = prochain = 0;
+                debut = e.t;
+                break;
+
+            case J_DONNE:
+                for (i=0; i<NB_CARTES; i++)
+                    if (e.donnees[i] != p.deck[i])
+                        break;
+                if (i < NB_CARTES)
+                    divergence(fichier, &e, "donne différente du mélange de la graine");
+                break;
+
+            // Quatrième joueur assis: la partie démarre ('D' puis 'M')
+            case J_JOUEUR:
+                if (++joueurs == NB_JOUEURS)
+                {
+                    nbAttendus = partieDemarrer(&p, attendus);
+                    prochain = 0;
+                }
+                break;
+
+            case J_ACTION:
+                if (!enCours)
+                {
+                    divergence(fichier, &e, "action hors partie");
+                    break;
+                }
+                if (prochain < nbAttendus)
+                    divergence(fichier, &e, "événements manquants avant l'action");
+                journalLireAction(&e, &act);
+                stats.actions[act.code & 127]++;
+                tours++;
+                nbAttendus = partieAppliquer(&p, &act, attendus);
+                prochain = 0;
+                if (nbAttendus < 0)
+                {
+                    divergence(fichier, &e, "action refusée par les règles");
+                    nbAttendus = 0;
+                }
+                if (act.code == 'G' && p.gagnant == -1)
+                    stats.mauvaisesAccusations++;
+                break;
+
+            case J_EVENEMENT:
+                journalLireEvenement(&e, &ev);
+                if (prochain >= nbAttendus)
+                    divergence(fichier, &e, "événement inattendu");
+                else if (ev.code != attendus[prochain].code || ev.dest != attendus[prochain].dest
+                         || ev.a != attendus[prochain].a || ev.b != attendus[prochain].b
+                         || ev.c != attendus[prochain].c)
+                    divergence(fichier, &e, "événement différent");
+                prochain++;
+                break;
+
+            case J_FIN:
+                if (e.donnees[0] != p.gagnant)
+                    divergence(fichier, &e, "gagnant différent");
+                else
+                {
+                    stats.terminees++;
+                    stats.victoires[p.gagnant]++;
+                    stats.toursVictoire += tours;
+                    stats.dureeVictoire += (e.t - debut) / 1e6;
+                }
+                enCours = 0;
+                break;
+
+            default:
+                divergence(fichier, &e, "type d'enregistrement inconnu");
+                break;
+        }
+    }
+
+    journalLiberer(&l);
+}
+
+/*******************************************************************************
+ * SECTION 3: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    struct timespec t0, t1;
+    double t;
+    int avecMmap = 0, repetitions = 1, opt, r, i;
+
+    while ((opt = getopt(argc, argv, "mr:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': avecMmap = 1; break;
+            case 'r': repetitions = atoi(optarg); break;
+            case 'v': verbeux = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-m] [-r repetitions] [-v] <journal>...\n", argv[0]);
+                exit(1);
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "Usage: %s [-m] [-r repetitions] [-v] <journal>...\n", argv[0]);
+        exit(1);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r=0; r<repetitions; r++)
+        for (i=optind; i<argc; i++)
+            rejouer(argv[i], avecMmap);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    printf("=== REJEU DE %ld JOURNAUX (%s) ===\n", stats.journaux, avecMmap ? "mmap" : "read");
+    printf("enregistrements: %ld (%.0f/s)\n", stats.enregistrements, stats.enregistrements / t);
+    printf("parties: %ld dont %ld terminées (%.0f parties/s)\n",
+           stats.parties, stats.terminees, stats.parties / t);
+    printf("actions: G=%ld O=%ld S=%ld, mauvaises accusations=%ld\n",
+           stats.actions['G'], stats.actions['O'], stats.actions['S'], stats.mauvaisesAccusations);
+    printf("victoires par place: %ld %ld %ld %ld\n",
+           stats.victoires[0], stats.victoires[1], stats.victoires[2], stats.victoires[3]);
+    if (stats.terminees > 0)
+        printf("tours moyens pour gagner: %.1f, durée moyenne: %.2f s\n",
+               (double) stats.toursVictoire / stats.terminees, stats.dureeVictoire / stats.terminees);
+    printf("divergences: %ld\n", stats.divergences);
+    printf("temps: %.3f s\n", t);
+
+    return stats.divergences == 0 ? 0 : 2;
+}
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * REPRISE DES PARTIES APRÈS UN REDÉMARRAGE DU SERVEUR
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "journal.h"
+#include "reprise.h"
+
+// En-tête du fichier de point de reprise
+#define REPRISE_MAGIE   0x53483133      // "SH13"
+#define REPRISE_VERSION 1
+
+struct fichierReprise
+{
+    unsigned int magie;
+    unsigned int version;
+    unsigned int taille;                // sizeof(struct etatReprise) de l'écrivain
+    struct etatReprise etat;
+};
+
+/*******************************************************************************
+ * SECTION 1: POINT DE REPRISE
+ ******************************************************************************/
+
+int repriseSauver(const char *cheminJournal, struct etatReprise *e)
+{
+    struct fichierReprise f;
+    char chemin[1100], temporaire[1120];
+    int fd, n;
+
+    sprintf(chemin, "%s" REPRISE_EXTENSION, cheminJournal);
+    sprintf(temporaire, "%s.tmp", chemin);
+
+    f.magie = REPRISE_MAGIE;
+    f.version = REPRISE_VERSION;
+    f.taille = sizeof(struct etatReprise);
+    f.etat = *e;
+
+    fd = open(temporaire, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    n = write(fd, &f, sizeof(f));
+    close(fd);
+    if (n != sizeof(f))
+    {
+        unlink(temporaire);
+        return -1;
+    }
+    return rename(temporaire, chemin);
+}
+
+// Charge le point de reprise s'il existe et correspond à ce binaire
+static int chargerPointReprise(const char *cheminJournal, struct etatReprise *e)
+{
+    struct fichierReprise f;
+    char chemin[1100];
+    int fd, n;
+
+    sprintf(chemin, "%s" REPRISE_EXTENSION, cheminJournal);
+    fd = open(chemin, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    n = read(fd, &f, sizeof(f));
+    close(fd);
+
+    if (n != sizeof(f) || f.magie != REPRISE_MAGIE || f.version != REPRISE_VERSION
+        || f.taille != sizeof(struct etatReprise))
+        return -1;
+    *e = f.etat;
+    return 0;
+}
+
+/*******************************************************************************
+ * SECTION 2: RECONSTRUCTION DE L'ÉTAT
+ ******************************************************************************/
+
+int repriseRestaurer(const char *cheminJournal, struct etatReprise *e)
+{
+    struct lecteurJournal l;
+    struct enregistrement r;
+    struct action act;
+    struct evenement ev[MAX_EVENEMENTS];
+    struct joueurRepris *jr;
+    unsigned int graine;
+    int place, termine = 0;
+
+    if (journalOuvrir(&l, cheminJournal, 1) < 0)
+        return -1;
+
+    // Sans point de reprise valide, tout le journal est rejoué
+    if (chargerPointReprise(cheminJournal, e) < 0 || journalAller(&l, e->position, e->t) < 0)
+    {
+        memset(e, 0, sizeof(*e));
+        e->jeu.gagnant = -1;
+    }
+
+    while (journalSuivant(&l, &r))
+    {
+        switch (r.type)
+        {
+            case J_PARTIE:
+                graine = r.donnees[0] | (r.donnees[1] << 8) | (r.donnees[2] << 16)
+                         | ((unsigned int) r.donnees[3] << 24);
+                partieInit(&e->jeu, graine);
+                e->nbJoueurs = 0;
+                termine = 0;
+                break;
+
+            case J_JOUEUR:
+                place = r.donnees[0];
+                if (place >= NB_JOUEURS)
+                    break;
+                jr = &e->joueurs[place];
+                jr->robot = r.donnees[1];
+                jr->port = (int)(r.donnees[2] | (r.donnees[3] << 8) | (r.donnees[4] << 16)
+                                 | ((unsigned int) r.donnees[5] << 24));
+                snprintf(jr->nom, sizeof(jr->nom), "%s", (char *) r.donnees + 6);
+                snprintf(jr->ip, sizeof(jr->ip), "%s", (char *) r.donnees + 6 + strlen((char *) r.donnees + 6) + 1);
+                if (place + 1 > e->nbJoueurs)
+                    e->nbJoueurs = place + 1;
+                break;
+
+            // Seules les actions modifient l'état; les événements en découlent
+            case J_ACTION:
+                journalLireAction(&r, &act);
+                partieAppliquer(&e->jeu, &act, ev);
+                break;
+
+            case J_FIN:
+                termine = 1;
+                break;
+        }
+    }
+
+    e->position = l.pos;
+    e->t = l.t;
+    journalLiberer(&l);
+    return termine ? 0 : 1;
+}
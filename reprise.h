@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * REPRISE DES PARTIES APRÈS UN REDÉMARRAGE DU SERVEUR
+ * Un point de reprise (fichier "<journal>.etat", réécrit périodiquement)
+ * contient l'état complet de la partie et la position du journal qu'il
+ * couvre. Au redémarrage, seule la fin du journal après cette position est
+ * rejouée: le temps de reprise dépend du nombre de parties en cours, pas de
+ * la longueur de l'historique.
+ ******************************************************************************/
+#ifndef REPRISE_H
+#define REPRISE_H
+
+#include "partie.h"
+
+#define REPRISE_EXTENSION   ".etat"
+#define REPRISE_PERIODE     8       // Actions entre deux points de reprise
+#define REPRISE_DOSSIER     "encours"
+
+// Joueur assis à la table
+struct joueurRepris
+{
+    char ip[40];
+    int port;
+    char nom[40];
+    int robot;
+};
+
+// État complet d'une partie en cours
+struct etatReprise
+{
+    struct partie jeu;
+    int nbJoueurs;
+    struct joueurRepris joueurs[NB_JOUEURS];
+    long long position;                 // Octets du journal couverts par cet état
+    unsigned long long t;               // Horodatage du dernier enregistrement couvert
+};
+
+// Écrit le point de reprise de façon atomique (fichier temporaire puis rename)
+int repriseSauver(const char *cheminJournal, struct etatReprise *e);
+
+// Reconstruit l'état d'une partie: point de reprise puis fin du journal
+// Retourne 1 si la partie est en cours, 0 si elle est terminée, -1 si illisible
+int repriseRestaurer(const char *cheminJournal, struct etatReprise *e);
+
+#endif
@@ -8,678 +8,2948 @@
 #include <unistd.h>         // API POSIX (read, write, close, etc.)
 #include <sys/types.h>      // Types de données pour les appels système
 #include <sys/socket.h>     // Structures et fonctions pour les sockets
+#include <sys/un.h>         // Socket Unix de la console d'administration
 #include <netinet/in.h>     // Structures pour les adresses Internet
 #include <netdb.h>          // Définitions pour les opérations de base de données réseau
 #include <arpa/inet.h>      // Fonctions de manipulation d'adresses Internet
 
+#include <time.h>           // Graine du mélange
+#include <dirent.h>         // Parcours du dossier des parties en cours
+#include <sys/stat.h>       // Création du dossier des parties en cours
+#include <netinet/tcp.h>    // TCP_INFO: connexions en attente d'accept (métriques)
+#include <poll.h>           // Attente d'un message ou de la prochaine échéance
+#include <pthread.h>        // Fils des groupes de tables
+#include <fcntl.h>          // Réveils non bloquants entre fils
+#include <errno.h>          // Complétions io_uring (-ENOBUFS)
+#include <sys/resource.h>   // Descripteurs suivis par le backend io_uring
+
+#include "regles.h"         // Noms et symboles des cartes
+#include "partie.h"         // Règles: mélange, tours, réponses aux questions
+#include "journal.h"        // Journal binaire des parties
+#include "reprise.h"        // Points de reprise des parties en cours
+#include "bot.h"            // Stratégie des joueurs robots
+#include "session.h"        // Tables recyclées d'une partie à l'autre
+#include "logger.h"         // Journalisation asynchrone (LOG_INFO, LOG_DEBUG, ...)
+#include "metriques.h"      // Compteurs et histogrammes exposés à Prometheus
+#include "minuterie.h"      // Roue des délais de tour et d'inactivité
+#include "lobby.h"          // Files d'attente des joueurs, formation des tables
+#include "diffusion.h"      // Messages publics des tables pour les spectateurs
+#include "transport.h"      // Adresses locales: sockets Unix et anneaux partagés
+#include "uring.h"          // Backend io_uring (appels système directs)
+#include "classement.h"     // Cotes Elo et statistiques des joueurs sur disque
+#include "releve.h"         // Relève par un nouveau processus (descripteurs passés)
+#include "limiteur.h"       // Seaux à jetons par adresse et par place
+#include "sondes.h"         // Points de trace USDT (perf, bpftrace)
+
 /*******************************************************************************
  * SECTION 2: STRUCTURES ET VARIABLES GLOBALES
  ******************************************************************************/
 
-// Structure représentant un client connecté au serveur
-struct _client
-{
-    char ipAddress[40];     // Adresse IP du client 
-    int port;               // Port d'écoute du client
-    char name[40];          // Nom du joueur
-} tcpClients[4];            // Tableau de 4 clients (4 joueurs maximum)
-
-int nbClients;              // Nombre de clients actuellement connectés
-
-int fsmServer;              // Machine à états du serveur (0=attente joueurs, 1=partie en cours)
-
-// Deck de 13 cartes (indices 0 à 12 correspondant aux personnages)
-int deck[13]={0,1,2,3,4,5,6,7,8,9,10,11,12};
-
-// Tableau des statistiques de chaque joueur
-// tableCartes[i][j] = statistique j du joueur i
-// 8 colonnes: [0-6]=différentes catégories de symboles, [7]=points totaux
-int tableCartes[4][8];
-
-// Noms des 13 cartes/personnages du jeu Sherlock 13
-char *nomcartes[]=
-{
-    "Sebastian Moran",          // Carte 0
-    "irene Adler",              // Carte 1
-    "inspector Lestrade",       // Carte 2
-    "inspector Gregson",        // Carte 3
-    "inspector Baynes",         // Carte 4
-    "inspector Bradstreet",     // Carte 5
-    "inspector Hopkins",        // Carte 6
-    "Sherlock Holmes",          // Carte 7
-    "John Watson",              // Carte 8
-    "Mycroft Holmes",           // Carte 9
-    "Mrs. Hudson",              // Carte 10
-    "Mary Morstan",             // Carte 11
-    "James Moriarty"            // Carte 12
+// Tables du serveur: réserve de sessions allouée au démarrage
+// Une session contient les clients assis (tcpClients), son état (fsm) et le
+// point de reprise de son déroulement (co), la partie, les robots et le journal
+// jeu.tableCartes[i][j] = statistique j du joueur i
+// Le fil principal prend les sessions pour les tables formées par le lobby,
+// le groupe qui joue la table la rend à la fin de la partie
+struct reserveSessions reserve;
+pthread_mutex_t verrouReserve = PTHREAD_MUTEX_INITIALIZER;
+int nbTables = 64;              // Tables jouées en même temps (-n)
+
+// Lobby: joueurs en attente d'une table (fil principal) et noms des joueurs assis
+// Les groupes y oublient les joueurs d'une table terminée
+struct lobby lobby;
+pthread_mutex_t verrouLobby = PTHREAD_MUTEX_INITIALIZER;
+struct roue roueLobby;          // Inactivité des joueurs en attente
+int reveilLobby[2];             // Tube: une table s'est libérée
+#define LOBBY_ATTENTE_MAX 65536 // Joueurs en attente au plus (en plus des joueurs assis)
+
+// Groupe de tables (shard): un fil joue toutes les tables dont numero % nbGroupes
+// est le sien. Le fil principal lui passe les tables formées et les messages
+// de ses joueurs par lots, dans une file protégée par un verrou.
+#define COURRIER_MESSAGE 0      // Message d'un joueur assis
+#define COURRIER_TABLE   1      // Nouvelle table: joueurs à asseoir
+#define COURRIER_ARRET   2      // Dernier courrier: le fil du groupe s'arrête (relève)
+#define COURRIER_ADMIN   3      // Demande de la console d'administration
+#define COURRIER_FILE    1024   // Courriers en attente par groupe
+#define COURRIER_LOT     64     // Courriers pris d'un coup par le groupe
+
+struct courrier
+{
+    int type;
+    struct session *s;
+    char texte[256];                        // COURRIER_MESSAGE
+    int nbJoueurs;                          // COURRIER_TABLE
+    struct _client joueurs[NB_JOUEURS];
+    struct requeteAdmin *admin;             // COURRIER_ADMIN
 };
 
-int joueurCourant;          // Indice du joueur dont c'est le tour (0 à 3)
-int joueursPerdu[4];
+// Ce qui reprend le déroulement d'une table (deroulerTable)
+#define DECL_TABLE      0       // Table formée par le lobby (courrier)
+#define DECL_REPRISE    1       // Partie reprise d'un journal au démarrage
+#define DECL_ACTION     2       // Action reçue d'un joueur assis
+#define DECL_DELAI      3       // Délai de tour dépassé (action 'P')
 
-int joueurPerdu(int id)
+struct declencheur
 {
-    return joueursPerdu[id];
-}
-
-/*******************************************************************************
- * SECTION 3: FONCTION DE GESTION D'ERREUR
- ******************************************************************************/
+    int type;
+    struct action act;                      // DECL_ACTION, DECL_DELAI
+    struct courrier *c;                     // DECL_TABLE
+};
 
-// Affiche un message d'erreur et termine le programme
-void error(const char *msg)
+struct groupe
 {
-    perror(msg);            // Affiche le message d'erreur avec détails système
-    exit(1);                // Termine le programme avec code d'erreur 1
-}
+    int numero;
+    pthread_t fil;
+    pthread_mutex_t verrou;
+    pthread_cond_t place;                   // La file n'est plus pleine
+    struct courrier *file;                  // File circulaire de COURRIER_FILE courriers
+    int tete, nb;
+    int reveil[2];                          // Tube: la file n'est plus vide
+    struct roue roue;                       // Délais de tour des tables du groupe
+    unsigned int graine;                    // Graine de la prochaine donne du groupe
+    int draine;                             // Plus de nouvelle table ni de revanche (console)
+};
 
-/*******************************************************************************
- * SECTION 4: FONCTION DE MÉLANGE DU DECK
- ******************************************************************************/
+struct groupe *groupes;
+int nbGroupes = 1;              // Fils de tables (-S)
+// Chaque fil a un anneau de journal et une tranche de métriques: les groupes
+// et les fils fixes (principal, console, validation du classement, diffusion,
+// exposition des métriques, écriture du journal) doivent tous en avoir un
+#define FILS_FIXES 6
+#define GROUPES_MAX ((LOG_MAX_FILS < MET_MAX_FILS ? LOG_MAX_FILS : MET_MAX_FILS) - FILS_FIXES)
+#define GROUPE(s) (&groupes[(s)->numero % nbGroupes])
+
+// Protection du chemin du jeu (fil principal), avant toute lecture complète
+// d'un message: débit de chaque adresse IP (-d) et de chaque place (-p), et
+// admission des nouveaux joueurs refusée tant que la file d'un groupe compte
+// au moins seuilAdmission courriers (-Q, console: admission <n>)
+struct limiteur limiteAdresse = { 0, 0 };
+struct limiteur limitePlace = { 0, 0 };
+struct tableSeaux seauxAdresses;
+struct seau *seauxPlaces = NULL;        // NB_JOUEURS par session
+int seuilAdmission = 0;                 // 0 = toujours admis
+#define LIMITEUR_ADRESSES 65536         // Adresses suivies au plus
+
+int nbBots = 0;                 // Places tenues par des robots à chaque nouvelle table (-b)
+int revanche = 0;               // Redonne aux mêmes joueurs à la fin d'une partie (-r)
+int questionsPubliques = 0;     // Les spectateurs voient les réponses aux questions 'S' (-q)
+unsigned int graine;            // Graine de la première donne (-s), puis une suite par groupe
+int portServeur;                // Port d'écoute TCP (nom des journaux), 0 sans TCP
+int socketEcoute = -1;          // Socket d'écoute TCP (file d'attente lue par les métriques)
+
+// Adresses d'écoute: port TCP, unix:<chemin>, shm:<chemin> (joueurs de la machine)
+#define ECOUTES_MAX     4
+#define ANNEAU_SERVEUR  4096    // Messages de l'anneau partagé du serveur
+#define LOT_ANNEAU      64      // Messages lus d'un anneau avant de revenir aux autres écoutes
+
+// Backend réseau (-B): poll et un appel système par opération, ou io_uring:
+// réceptions multishot dans des tampons fournis, envois des groupes par lots
+int backendUring = 0;
+#define LOT_ENVOIS      256     // Messages d'un groupe envoyés par un io_uring_enter
+#define URING_TAMPONS   1024    // Tampons de réception de 256 octets
+
+// Message envoyé à un joueur, '\n' et zéro final compris (plus long: tronqué)
+#define ENVOI_MAX       256
+
+// Message en attente d'envoi par le lot de son groupe
+struct envoi
+{
+    struct sockaddr_in adresse;
+    int fente;                  // Descripteur direct du destinataire pendant le lot
+    int longueur;
+    char texte[ENVOI_MAX];
+};
 
-// Mélange aléatoirement le deck de cartes par la méthode de Fisher-Yates
-void melangerDeck()
+struct envois
 {
-    int i;                  // Compteur de boucle
-    int index1, index2;     // Indices des deux cartes à échanger
-    int tmp;                // Variable temporaire pour l'échange
+    struct uring u;
+    int nb;
+    struct envoi lot[LOT_ENVOIS];
+};
 
-    // Effectue 1000 échanges aléatoires pour bien mélanger le deck
-    for (i=0; i<1000; i++)
-    {
-        index1 = rand() % 13;       // Choix d'un premier indice aléatoire (0-12)
-        index2 = rand() % 13;       // Choix d'un deuxième indice aléatoire (0-12)
+__thread struct envois *envoisFil = NULL;   // Lot du fil (groupes, backend io_uring)
+
+// Journal binaire de la partie (NULL si désactivé)
+// Il reste dans <dossier>/encours tant que la partie n'est pas terminée
+char *dossierJournal = NULL;    // Dossier des journaux (-j)
+int numeroJournal = 0;          // Journaux ouverts par ce processus
+
+// Minuteries des tables: une table ne reste plus bloquée par un joueur absent
+int delaiTour = 60;             // Secondes pour jouer avant que le tour passe (-T, 0 = sans limite)
+int toursAvantForfait = 2;      // Délais dépassés d'affilée avant l'élimination (-F)
+int delaiInactivite = 300;      // Secondes sans nouvelles d'un joueur du lobby avant de l'oublier (-I, 0 = jamais)
+
+// Classement persistant des joueurs humains (NULL si désactivé)
+char *fichierClassement = NULL; // Index du classement (-R), journal à côté
+
+// Relève sans interruption (-U): un nouveau serveur lancé avec le même chemin
+// reprend les sockets d'écoute, les tables, le lobby et les spectateurs
+char *cheminReleve = NULL;      // Socket Unix de la relève (-U), NULL si désactivée
+int socketReleve = -1;          // Écoute du successeur
+int socketMetriques = -1;       // Écoute des métriques (passée au successeur)
+#define RELEVE_VERSION      1
+#define RELEVE_DELAI_MS     10000   // Attente de chaque message de l'autre processus
+#define RELEVE_ATTENTE_MS   500     // Messages en cours de réception attendus au plus (io_uring)
+
+// Console d'administration (-A): socket Unix, une commande par ligne
+// Le fil de la console ne touche pas aux tables: il demande à chaque groupe,
+// par courrier, d'écrire l'état de ses tables entre deux actions
+char *cheminAdmin = NULL;       // Socket Unix de la console (-A), NULL si désactivée
+#define PALMARES_ADMIN_DEFAUT   100     // Joueurs de "palmares" sans argument
+#define PALMARES_ADMIN_MAX      10000   // Joueurs d'une réponse au plus
+
+struct requeteAdmin
+{
+    char commande;                          // 'g': tables du groupe, 't': une table
+    int table;
+    FILE *sortie;
+    pthread_mutex_t verrou;
+    pthread_cond_t faite;
+    int terminee;
+};
 
-        // Échange les deux cartes en utilisant une variable temporaire
-        tmp = deck[index1];
-        deck[index1] = deck[index2];
-        deck[index2] = tmp;
-    }
-}
+// Sessions sorties de la réserve pour un groupe drainé (fil principal),
+// rendues quand le groupe est rouvert
+struct session *tablesDrainees = NULL;
+int nbTablesDrainees = 0;
 
 /*******************************************************************************
- * SECTION 5: FONCTION DE CRÉATION DU TABLEAU DE STATISTIQUES
+ * SECTION 3: FONCTION DE GESTION D'ERREUR
  ******************************************************************************/
 
-// Crée le tableau de statistiques basé sur les cartes distribuées
-// Chaque carte possède des caractéristiques (symboles) qui s'additionnent
-void createTable()
+// Affiche un message d'erreur et termine le programme
+void error(const char *msg)
 {
-    // DISTRIBUTION DES CARTES:
-    // Joueur 0: cartes d'indices 0, 1, 2 du deck mélangé
-    // Joueur 1: cartes d'indices 3, 4, 5 du deck mélangé
-    // Joueur 2: cartes d'indices 6, 7, 8 du deck mélangé
-    // Joueur 3: cartes d'indices 9, 10, 11 du deck mélangé
-    // Coupable: carte d'indice 12 (la carte à deviner)
-    
-    int i, j, c;            // Variables de boucle et carte courante
-
-    // Initialise toutes les statistiques à 0
-    for (i=0; i<4; i++)                 // Pour chaque joueur
-        for (j=0; j<8; j++)             // Pour chaque catégorie de symbole
-            tableCartes[i][j] = 0;      // Remise à zéro
-
-    // Pour chaque joueur (0 à 3)
-    for (i=0; i<4; i++)
-    {
-        // Pour chacune de ses 3 cartes
-        for (j=0; j<3; j++)
-        {
-            c = deck[i*3+j];        // Récupère l'indice de la carte du joueur i
-            
-            // Selon la carte, incrémente les statistiques correspondantes
-            // Chaque case représente un symbole ou caractéristique du personnage
-            switch (c)
-            {
-                case 0: // Sebastian Moran 
-                    tableCartes[i][7]++;    // Incrémente les points totaux (crâne)
-                    tableCartes[i][2]++;    // Incrémente le symbole 2 (poing)
-                    break;
-                    
-                case 1: // Irene Adler
-                    tableCartes[i][7]++;    // Incrémente les points totaux (crâne)
-                    tableCartes[i][1]++;    // Incrémente le symbole 1 (ampoule)
-                    tableCartes[i][5]++;    // Incrémente le symbole 5 (collier)
-                    break;
-                    
-                case 2: // Inspector Lestrade
-                    tableCartes[i][3]++;    // Incrémente le symbole 3 (couronne)
-                    tableCartes[i][6]++;    // Incrémente le symbole 6 (oeil)
-                    tableCartes[i][4]++;    // Incrémente le symbole 4 (carnet)
-                    break;
-                    
-                case 3: // Inspector Gregson 
-                    tableCartes[i][3]++;    // Incrémente le symbole 3 (couronne)
-                    tableCartes[i][2]++;    // Incrémente le symbole 2 (poing)
-                    tableCartes[i][4]++;    // Incrémente le symbole 4 (carnet)
-                    break;
-                    
-                case 4: // Inspector Baynes 
-                    tableCartes[i][3]++;    // Incrémente le symbole 3 (couronne)
-                    tableCartes[i][1]++;    // Incrémente le symbole 1 (ampoule)
-                    break;
-                    
-                case 5: // Inspector Bradstreet 
-                    tableCartes[i][3]++;    // Incrémente le symbole 3 (couronne)
-                    tableCartes[i][2]++;    // Incrémente le symbole 2 (poing)
-                    break;
-                    
-                case 6: // Inspector Hopkins 
-                    tableCartes[i][3]++;    // Incrémente le symbole 3 (couronne)
-                    tableCartes[i][0]++;    // Incrémente le symbole 0 (pipe)
-                    tableCartes[i][6]++;    // Incrémente le symbole 6 (oeil)
-                    break;
-                    
-                case 7: // Sherlock Holmes 
-                    tableCartes[i][0]++;    // Incrémente le symbole 0 (pipe)
-                    tableCartes[i][1]++;    // Incrémente le symbole 1 (ampoule)
-                    tableCartes[i][2]++;    // Incrémente le symbole 2 (poing)
-                    break;
-                    
-                case 8: // John Watson 
-                    tableCartes[i][0]++;    // Incrémente le symbole 0 (pipe)
-                    tableCartes[i][6]++;    // Incrémente le symbole 6 (oeil)
-                    tableCartes[i][2]++;    // Incrémente le symbole 2 (poing)
-                    break;
-                    
-                case 9: // Mycroft Holmes 
-                    tableCartes[i][0]++;    // Incrémente le symbole 0 (pipe)
-                    tableCartes[i][1]++;    // Incrémente le symbole 1 (ampoule)
-                    tableCartes[i][4]++;    // Incrémente le symbole 4 (carnet)
-                    break;
-                    
-                case 10: // Mrs. Hudson 
-                    tableCartes[i][0]++;    // Incrémente le symbole 0 (pipe)
-                    tableCartes[i][5]++;    // Incrémente le symbole 5 (collier)
-                    break;
-                    
-                case 11: // Mary Morstan 
-                    tableCartes[i][4]++;    // Incrémente le symbole 4 (carnet)
-                    tableCartes[i][5]++;    // Incrémente le symbole 5 (collier)
-                    break;
-                    
-                case 12: // James Moriarty 
-                    tableCartes[i][7]++;    // Incrémente les points totaux (crâne)
-                    tableCartes[i][1]++;    // Incrémente le symbole 1 (ampoule)
-                    break;
-            }
-        }
-    }
+    perror(msg);            // Affiche le message d'erreur avec détails système
+    exit(1);                // Termine le programme avec code d'erreur 1
 }
 
 /*******************************************************************************
- * SECTION 6: FONCTIONS D'AFFICHAGE (POUR LE DEBUG)
+ * SECTION 4: FONCTIONS D'AFFICHAGE (CONSOLE D'ADMINISTRATION)
  ******************************************************************************/
 
-// Affiche le deck et le tableau de statistiques dans le terminal du serveur
-// Utilisé pour le débogage et le suivi de la partie
-void printDeck()
+// Écrit le deck et le tableau de statistiques de la table dans f
+// Demandé par la console d'administration ("table <n>"), dans le fil du groupe
+void printDeck(FILE *f, struct session *s)
 {
     int i, j;               // Compteurs de boucle
 
     // Affiche toutes les cartes du deck avec leurs noms
-    printf("=== DECK DE CARTES ===\n");
+    fprintf(f, "=== DECK DE CARTES (table %d) ===\n", s->numero);
     for (i=0; i<13; i++)
-        printf("%d %s\n", deck[i], nomcartes[deck[i]]);
+        fprintf(f, "%d %s\n", s->jeu.deck[i], nomcartes[s->jeu.deck[i]]);
 
     // Affiche le tableau de statistiques de tous les joueurs
-    printf("\n=== TABLEAU DES CARACTÉRISTIQUES ===\n");
+    fprintf(f, "=== TABLEAU DES CARACTÉRISTIQUES ===\n");
     for (i=0; i<4; i++)
     {
-        printf("Joueur %d: ", i);
+        fprintf(f, "Joueur %d: ", i);
         for (j=0; j<8; j++)
-            printf("%2.2d ", tableCartes[i][j]);    // Format: 2 chiffres avec 0 initial si nécessaire
-        puts("");                                    // Retour à la ligne
+            fprintf(f, "%2.2d ", s->jeu.tableCartes[i][j]);  // Format: 2 chiffres avec 0 initial si nécessaire
+        fprintf(f, "\n");
     }
-    printf("\n");
 }
 
-// Affiche la liste des clients connectés (pour debug)
-void printClients()
+// Écrit la liste des clients assis à la table dans f
+void printClients(FILE *f, struct session *s)
 {
     int i;                  // Compteur de boucle
 
-    printf("=== CLIENTS CONNECTÉS ===\n");
+    fprintf(f, "=== CLIENTS CONNECTÉS (table %d) ===\n", s->numero);
     // Pour chaque client connecté, affiche ses informations
-    for (i=0; i<nbClients; i++)
-        printf("%d: %s %5.5d %s\n", i,              // Numéro du client
-               tcpClients[i].ipAddress,              // Adresse IP
-               tcpClients[i].port,                   // Port 
-               tcpClients[i].name);                  // Nom du joueur
-    printf("\n");
+    for (i=0; i<s->nbClients; i++)
+        fprintf(f, "%d: %s %5.5d %s%s\n", i,       // Numéro du client
+                s->tcpClients[i].ipAddress,         // Adresse IP
+                s->tcpClients[i].port,              // Port
+                s->tcpClients[i].name,              // Nom du joueur
+                s->tcpClients[i].robot ? " (robot)" : "");
 }
 
 /*******************************************************************************
- * SECTION 7: FONCTION DE RECHERCHE DE CLIENT
+ * SECTION 5: FONCTION DE RECHERCHE DE CLIENT
  ******************************************************************************/
 
-// Recherche un client par son nom dans le tableau tcpClients
+// Recherche un client par son nom dans le tableau tcpClients de la table
 // Retourne l'indice du client ou -1 si non trouvé
-int findClientByName(char *name)
+int findClientByName(struct session *s, char *name)
 {
     int i;                  // Compteur de boucle
 
     // Parcourt tous les clients connectés
-    for (i=0; i<nbClients; i++)
-        if (strcmp(tcpClients[i].name, name) == 0)  // Compare les noms 
+    for (i=0; i<s->nbClients; i++)
+        if (strcmp(s->tcpClients[i].name, name) == 0)  // Compare les noms 
             return i;                                 // Client trouvé, retourne son indice
     
     return -1;                                       // Client non trouvé
 }
 
 /*******************************************************************************
- * SECTION 8: FONCTIONS D'ENVOI DE MESSAGES
+ * SECTION 6: FONCTIONS D'ENVOI DE MESSAGES
  ******************************************************************************/
 
+void envoyerLot();
+
 // Envoie un message à un client spécifique via TCP
 // Crée une nouvelle connexion temporaire pour chaque message
 void sendMessageToClient(char *clientip, int clientport, char *mess)
 {
     int sockfd, portno, n;              // Descripteur de socket, numéro de port, résultat
     struct sockaddr_in serv_addr;       // Structure d'adresse du serveur
-    struct hostent *server;              // Informations sur l'hôte
-    char buffer[256];                    // Buffer pour le message à envoyer
-
-    // Crée un nouveau socket TCP pour la connexion
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    struct addrinfo indices, *server;    // Informations sur l'hôte
+    struct envoi *e;                     // Place du message dans le lot (io_uring)
+    char buffer[ENVOI_MAX];              // Buffer pour le message à envoyer
 
-    // Résout le nom d'hôte (ou IP) en adresse IP
-    server = gethostbyname(clientip);
-    if (server == NULL) {
-        fprintf(stderr, "ERROR, no such host\n");
-        exit(0);
+    // Client de la machine: socket Unix ou anneau partagé, sans pile TCP/IP
+    if (transportType(clientip) != TRANSPORT_TCP)
+    {
+        n = transportEnvoyer(clientip, mess);
+        if (n < 0)
+        {
+            LOG_AVERT("ERROR sending to %s", clientip);
+            metriquesCompte(MET_ECHECS_CONNEXION, 1);
+            return;
+        }
+        metriquesCompte(MET_MESSAGES_ENVOYES, 1);
+        metriquesCompte(MET_OCTETS_ENVOYES, strlen(mess) + 1);
+        if (transportType(clientip) == TRANSPORT_UNIX)
+            metriquesCompte(MET_APPELS_RESEAU, 4);
+        return;
     }
-    
+
     // Initialise la structure d'adresse
     bzero((char *) &serv_addr, sizeof(serv_addr));      // Remise à zéro de la structure
     serv_addr.sin_family = AF_INET;                      // Famille d'adresses IPv4
-    
-    // Copie l'adresse IP du serveur dans la structure
-    bcopy((char *)server->h_addr,
-         (char *)&serv_addr.sin_addr.s_addr,
-         server->h_length);
+
+    // Résout le nom d'hôte (ou IP) en adresse IP, sans état partagé entre les fils
+    // Un client injoignable ne doit pas arrêter le serveur (ni les autres parties):
+    // le message est perdu, le joueur pourra se reconnecter avec 'C'
+    if (inet_pton(AF_INET, clientip, &serv_addr.sin_addr) != 1)
+    {
+        bzero(&indices, sizeof(indices));
+        indices.ai_family = AF_INET;
+        if (getaddrinfo(clientip, NULL, &indices, &server) != 0) {
+            LOG_AVERT("ERROR, no such host %s", clientip);
+            metriquesCompte(MET_ECHECS_CONNEXION, 1);
+            return;
+        }
+        serv_addr.sin_addr = ((struct sockaddr_in *) server->ai_addr)->sin_addr;
+        freeaddrinfo(server);
+    }
     
     serv_addr.sin_port = htons(clientport);              // Convertit le port en format réseau 
-    
+
+    // Backend io_uring: le message part avec le lot du groupe
+    if (envoisFil != NULL)
+    {
+        if (envoisFil->nb == LOT_ENVOIS)
+            envoyerLot();
+        e = &envoisFil->lot[envoisFil->nb++];
+        e->adresse = serv_addr;
+        e->longueur = snprintf(e->texte, sizeof(e->texte), "%s\n", mess);
+        if (e->longueur >= (int) sizeof(e->texte))
+            e->longueur = sizeof(e->texte) - 1;
+        return;
+    }
+
+    // Crée un nouveau socket TCP pour la connexion
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    metriquesCompte(MET_APPELS_RESEAU, 4);
+
     // Établit la connexion avec le client
     if (connect(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0)
     {
-        printf("ERROR connecting\n");
-        exit(1);
+        LOG_AVERT("ERROR connecting %s:%d", clientip, clientport);
+        metriquesCompte(MET_ECHECS_CONNEXION, 1);
+        close(sockfd);
+        return;
     }
 
     // Prépare le message avec un retour à la ligne
-    sprintf(buffer, "%s\n", mess);
+    n = snprintf(buffer, sizeof(buffer), "%s\n", mess);
+    if (n >= (int) sizeof(buffer))
+        n = sizeof(buffer) - 1;
     
     // Envoie le message au client
-    n = write(sockfd, buffer, strlen(buffer));
+    n = write(sockfd, buffer, n);
+    if (n > 0)
+    {
+        metriquesCompte(MET_MESSAGES_ENVOYES, 1);
+        metriquesCompte(MET_OCTETS_ENVOYES, n);
+    }
 
     // Ferme la connexion (le message est envoyé)
     close(sockfd);
 }
 
+// Envoie un message au joueur assis à la place id
+// Un robot n'a pas de socket: le message est directement passé à sa stratégie
+void sendMessageToPlayer(struct session *s, int id, char *mess)
+{
+    if (s->tcpClients[id].robot)
+        botRecoit(&s->bots[id], mess);
+    else
+        sendMessageToClient(s->tcpClients[id].ipAddress,
+                            s->tcpClients[id].port,
+                            mess);
+}
+
 // Envoie un message à tous les clients connectés (broadcast)
 // Utilisé pour synchroniser l'état du jeu entre tous les joueurs
-void broadcastMessage(char *mess)
+// Un message à toute la table est public: il part aussi aux spectateurs
+void broadcastMessage(struct session *s, char *mess)
 {
     int i;                  // Compteur de boucle
 
+    SONDE2(diffusion_debut, s->numero, mess[0]);
     // Envoie le message à chaque client de la liste
-    for (i=0; i<nbClients; i++)
-        sendMessageToClient(tcpClients[i].ipAddress,
-                          tcpClients[i].port,
-                          mess);
+    for (i=0; i<s->nbClients; i++)
+        sendMessageToPlayer(s, i, mess);
+    diffusionPublier(s->numero, mess);
+    SONDE2(diffusion_fin, s->numero, s->nbClients);
+}
+
+// Envoie les événements produits par le moteur de partie et les journalise
+// Ceux d'une action numérotée (act->requete) portent " #<requete>" dans la
+// copie envoyée à son auteur seulement: ses réponses lui sont attribuables
+// même s'il a d'autres requêtes en cours (act NULL: début de partie)
+void envoyerEvenements(struct session *s, struct evenement *ev, int n, struct action *act)
+{
+    char reply[256], numerotee[ENVOI_MAX - 1];  // Place pour le '\n' de l'envoi
+    int i, j;
+
+    for (i=0; i<n; i++)
+    {
+        partieFormater(&ev[i], reply);
+        if (act == NULL || act->requete == 0)
+        {
+            if (ev[i].dest == A_TOUS)
+                broadcastMessage(s, reply);
+            else
+                sendMessageToPlayer(s, ev[i].dest, reply);
+        }
+        else
+        {
+            // Une réponse trop longue est tronquée, jamais son numéro (" #" et 11 chiffres au plus)
+            snprintf(numerotee, sizeof(numerotee), "%.*s #%d", (int) sizeof(numerotee) - 14, reply, act->requete);
+            if (ev[i].dest == A_TOUS)
+            {
+                for (j=0; j<s->nbClients; j++)
+                    sendMessageToPlayer(s, j, j == act->joueur ? numerotee : reply);
+                diffusionPublier(s->numero, reply);
+            }
+            else
+                sendMessageToPlayer(s, ev[i].dest, ev[i].dest == act->joueur ? numerotee : reply);
+        }
+        if (s->journal != NULL)
+            journalEvenement(s->journal, &ev[i]);
+    }
 }
 
 /*******************************************************************************
- * SECTION 9: FONCTION PRINCIPALE
+ * SECTION 7: DÉROULEMENT DE LA PARTIE
  ******************************************************************************/
 
-int main(int argc, char *argv[])
+void ouvrirJournal(struct session *s);
+void viderJournal(struct session *s);
+int deroulerTable(struct session *s, struct declencheur *d);
+
+// Tick courant de la roue des minuteries
+unsigned long horlogeTicks()
 {
-    /***************************************************************************
-     * SOUS-SECTION 9.1: DÉCLARATION DES VARIABLES
-     ***************************************************************************/
-    
-    // Variables pour le socket serveur
-    int sockfd, newsockfd, portno;              // Descripteurs de socket et numéro de port
-    socklen_t clilen;                            // Taille de la structure d'adresse client
-    char buffer[256];                            // Buffer pour la réception de messages
-    struct sockaddr_in serv_addr, cli_addr;     // Adresses serveur et client
-    int n;                                       // Résultat des opérations de lecture
-    int i, j;                                    // Compteurs de boucle
+    struct timespec t;
 
-    // Variables pour le traitement des messages de connexion
-    char com;                                    // Commande reçue (première lettre)
-    char clientIpAddress[256];                   // Adresse IP du client
-    char clientName[256];                        // Nom du joueur
-    int clientPort;                              // Port du client
-    int id;                                      // ID du joueur
-    char reply[256];                             // Message de réponse à envoyer
-    
-    // Variables pour la phase de jeu
-    int idJoueur;                                // ID du joueur qui fait l'action
-    int joueur;                                  // Numéro du joueur cible (pour commande S)
-    int objet;                                   // Numéro de l'objet/symbole demandé
-    int coupable;                                // Numéro de la carte accusée (pour commande G)
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * (1000 / MINUTERIE_TICK_MS) + t.tv_nsec / (MINUTERIE_TICK_MS * 1000000L);
+}
 
-    /***************************************************************************
-     * SOUS-SECTION 9.2: VÉRIFICATION DES ARGUMENTS
-     ***************************************************************************/
-    
-    // Vérifie qu'un numéro de port a été fourni en argument de ligne de commande
-    if (argc < 2) {
-        fprintf(stderr, "ERROR, no port provided\n");
-        fprintf(stderr, "Usage: %s <port>\n", argv[0]);
-        exit(1);
+// Laisse delaiTour secondes au joueur courant (les robots jouent aussitôt)
+// Repris par tourExpire, le déroulement de la table joue alors l'action 'P'
+void armerTour(struct session *s)
+{
+    if (s->fsm != SESSION_EN_JEU || s->jeu.gagnant != -1 || delaiTour <= 0
+        || s->tcpClients[s->jeu.joueurCourant].robot)
+    {
+        roueAnnuler(s->roue, &s->delaiTour);
+        return;
     }
+    rouePlanifier(s->roue, &s->delaiTour, horlogeTicks() + delaiTour * (1000 / MINUTERIE_TICK_MS));
+}
 
-    /***************************************************************************
-     * SOUS-SECTION 9.3: CRÉATION ET CONFIGURATION DU SOCKET SERVEUR
-     ***************************************************************************/
-    
-    // Crée un socket TCP (SOCK_STREAM)
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) 
-        error("ERROR opening socket");
-    
-    // Initialise la structure d'adresse du serveur
-    bzero((char *) &serv_addr, sizeof(serv_addr));      // Remise à zéro de la structure
-    portno = atoi(argv[1]);                              // Convertit l'argument en entier (numéro de port)
-    serv_addr.sin_family = AF_INET;                      // Famille IPv4
-    serv_addr.sin_addr.s_addr = INADDR_ANY;             // Accepte les connexions de n'importe quelle interface réseau
-    serv_addr.sin_port = htons(portno);                  // Convertit le port en format réseau 
-    
-    // Lie le socket à l'adresse et au port spécifiés
-    if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0) 
-        error("ERROR on binding");
-    
-    // Met le socket en mode écoute (max 5 connexions en attente dans la queue)
-    listen(sockfd, 5);
-    clilen = sizeof(cli_addr);                           // Taille de la structure d'adresse client
+// Distribue les cartes et annonce le premier joueur (4 joueurs assis)
+void demarrerPartie(struct session *s)
+{
+    struct evenement ev[MAX_EVENEMENTS];
+    int i, n;
+
+    LOG_INFO("=== DÉBUT DE LA PARTIE (table %d) ===", s->numero);
+    LOG_INFO("4 joueurs connectés, distribution des cartes...");
+
+    // ===== MESSAGE 'D' : DISTRIBUTION DES CARTES =====
+    // Format: "D <carte1> <carte2> <carte3>"
+    // Envoie à chaque joueur ses 3 cartes (indices du deck)
+    // Joueur i: cartes i*3, i*3+1, i*3+2 du deck mélangé
+    // ===== MESSAGE 'M' : INDICATION DU JOUEUR COURANT =====
+    // Format: "M <idJoueur>"
+    // Ce message active le bouton "GO" pour le joueur dont c'est le tour
+    n = partieDemarrer(&s->jeu, ev);
+    envoyerEvenements(s, ev, n, NULL);
+    for (i=0; i<NB_JOUEURS; i++)
+        s->toursJoues[i] = 0;
 
-    /***************************************************************************
-     * SOUS-SECTION 9.4: INITIALISATION DU JEU
-     ***************************************************************************/
-    
-    printf("=== INITIALISATION DU JEU SHERLOCK 13 ===\n\n");
-    
-    // Affiche le deck initial (ordre original)
-    printDeck();
-    
-    // Mélange le deck de manière aléatoire
-    melangerDeck();
-    
-    // Crée le tableau de statistiques basé sur les cartes distribuées
-    createTable();
-    
-    // Affiche le deck mélangé et les statistiques calculées
-    printDeck();
-    
-    // Initialise le joueur courant à 0 (le premier à se connecter commence)
-    joueurCourant = 0;
-    
-    // Initialise le nombre de clients à 0
-    nbClients = 0;
-    
-    // Initialise la machine à états à 0 (attente des joueurs)
-    fsmServer = 0;
+    for (i=0; i<4; i++)
+        LOG_DEBUG("Joueur %d (%s) reçoit: %s, %s, %s",
+               i, s->tcpClients[i].name,
+               nomcartes[s->jeu.deck[i*3]], nomcartes[s->jeu.deck[i*3+1]], nomcartes[s->jeu.deck[i*3+2]]);
+
+    // Affiche le personnage coupable (carte 12) pour le debug du serveur
+    LOG_DEBUG(">>> PERSONNAGE COUPABLE: %s (indice %d) <<<",
+           nomcartes[s->jeu.deck[12]], s->jeu.deck[12]);
+    LOG_INFO("C'est au tour du joueur %d (%s)",
+           s->jeu.joueurCourant, s->tcpClients[s->jeu.joueurCourant].name);
+
+    // Passe à l'état 1 (partie en cours)
+    s->fsm = SESSION_EN_JEU;
+}
+
+// Installe un joueur (humain ou robot) à la prochaine place libre
+void ajouterJoueur(struct session *s, char *clientIpAddress, int clientPort, char *clientName, int robot)
+{
+    char reply[256];
+    int id;
+
+    // Enregistre le nouveau client dans le tableau tcpClients
+    strcpy(s->tcpClients[s->nbClients].ipAddress, clientIpAddress);
+    s->tcpClients[s->nbClients].port = clientPort;
+    strcpy(s->tcpClients[s->nbClients].name, clientName);
+    s->tcpClients[s->nbClients].robot = robot;
+    if (robot)
+        botInit(&s->bots[s->nbClients], s->nbClients);
+    if (s->journal != NULL)
+        journalJoueur(s->journal, s->nbClients, robot, clientPort, clientName, clientIpAddress);
+    s->nbClients++;                        // Incrémente le compteur de clients
+
+    // Recherche l'ID du joueur qui vient de se connecter
+    id = findClientByName(s, clientName);
+    LOG_DEBUG("id=%d", id);
+
+    // ===== MESSAGE 'I' : ENVOI DE L'ID AU JOUEUR =====
+    // Format: "I <id> <table>"
+    // Envoie un message personnel au joueur pour lui communiquer son ID unique
+    // et sa table (à ajouter à la fin de ses actions)
+    sprintf(reply, "I %d %d", id, s->numero);
+    sendMessageToPlayer(s, id, reply);
+    LOG_INFO("Envoi de l'ID %d au joueur %s", id, clientName);
+
+    // ===== MESSAGE 'L' : BROADCAST DE LA LISTE DES JOUEURS =====
+    // Format: "L <nom1> <nom2> <nom3> <nom4>"
+    // Envoie à tous les joueurs la liste complète des noms (même ceux pas encore connectés)
+    sprintf(reply, "L %s %s %s %s",
+           s->tcpClients[0].name,
+           s->tcpClients[1].name,
+           s->tcpClients[2].name,
+           s->tcpClients[3].name);
+    broadcastMessage(s, reply);
+    LOG_DEBUG("Broadcast de la liste des joueurs: %s", reply);
+}
+
+// Un joueur déjà assis renvoie 'C' (client redémarré, ou serveur repris
+// après un arrêt): nouvelle adresse, puis tout ce qu'il faut pour reprendre
+void reconnecterJoueur(struct session *s, int id, char *clientIpAddress, int clientPort)
+{
+    char reply[256];
+
+    strcpy(s->tcpClients[id].ipAddress, clientIpAddress);
+    s->tcpClients[id].port = clientPort;
+    if (s->journal != NULL)
+        journalJoueur(s->journal, id, 0, clientPort, s->tcpClients[id].name, clientIpAddress);
+    LOG_INFO("Reconnexion du joueur %d (%s)", id, s->tcpClients[id].name);
+
+    sprintf(reply, "I %d %d", id, s->numero);
+    sendMessageToPlayer(s, id, reply);
+    sprintf(reply, "L %s %s %s %s",
+           s->tcpClients[0].name, s->tcpClients[1].name, s->tcpClients[2].name, s->tcpClients[3].name);
+    sendMessageToPlayer(s, id, reply);
+    sprintf(reply, "D %d %d %d", s->jeu.deck[id*3], s->jeu.deck[id*3+1], s->jeu.deck[id*3+2]);
+    sendMessageToPlayer(s, id, reply);
+    sprintf(reply, "M %d", s->jeu.joueurCourant);
+    sendMessageToPlayer(s, id, reply);
+}
+
+/*******************************************************************************
+ * SECTION 8: JOURNAL ET REPRISE APRÈS REDÉMARRAGE
+ ******************************************************************************/
+
+// Ouvre le journal d'une nouvelle partie dans <dossier>/encours
+void ouvrirJournal(struct session *s)
+{
+    sprintf(s->cheminJournal, "%s/" REPRISE_DOSSIER "/partie-%d-%ld-%d-%d" JOURNAL_EXTENSION,
+            dossierJournal, portServeur, (long) time(NULL), (int) getpid(),
+            __atomic_fetch_add(&numeroJournal, 1, __ATOMIC_RELAXED));
+    if (journalInit(&s->stockageJournal, s->cheminJournal) < 0)
+        error("ERROR creating journal");
+    s->journal = &s->stockageJournal;
+    journalPartie(s->journal, &s->jeu);
+    s->actionsSansReprise = 0;
+    LOG_INFO("Journal: %s", s->cheminJournal);
+}
+
+// Écrit le point de reprise de la partie (le journal doit être vidé)
+void sauverPointReprise(struct session *s)
+{
+    struct etatReprise e;
+    int i;
 
-    // Initialise le tableau des clients avec des valeurs par défaut
+    e.jeu = s->jeu;
+    e.nbJoueurs = s->nbClients;
     for (i=0; i<4; i++)
     {
-        strcpy(tcpClients[i].ipAddress, "localhost");   // IP par défaut
-        tcpClients[i].port = -1;                         // Port invalide (-1 indique non connecté)
-        strcpy(tcpClients[i].name, "-");                // Nom vide
+        strcpy(e.joueurs[i].ip, s->tcpClients[i].ipAddress);
+        e.joueurs[i].port = s->tcpClients[i].port;
+        strcpy(e.joueurs[i].nom, s->tcpClients[i].name);
+        e.joueurs[i].robot = s->tcpClients[i].robot;
     }
-    
-    printf("=== SERVEUR EN ATTENTE DE CONNEXIONS ===\n");
-    printf("Port d'écoute: %d\n\n", portno);
+    e.position = s->journal->position;
+    e.t = s->journal->dernier;
+    if (repriseSauver(s->cheminJournal, &e) < 0)
+        LOG_ERREUR("ERROR writing checkpoint %s", s->cheminJournal);
+    s->actionsSansReprise = 0;
+}
 
-    /***************************************************************************
-     * SOUS-SECTION 9.5: BOUCLE PRINCIPALE DU SERVEUR
-     ***************************************************************************/
-    
-    while (1)       // Boucle infinie - le serveur ne s'arrête jamais
-    {    
-        // Accepte une nouvelle connexion entrante
-        // Bloque jusqu'à ce qu'un client se connecte
-        newsockfd = accept(sockfd, 
-                          (struct sockaddr *) &cli_addr, 
-                          &clilen);
-        if (newsockfd < 0) 
-            error("ERROR on accept");
-
-        // Lit le message du client
-        bzero(buffer, 256);                             // Remise à zéro du buffer
-        n = read(newsockfd, buffer, 255);               // Lecture (max 255 caractères + '\0')
-        if (n < 0) 
-            error("ERROR reading from socket");
-
-        // Affiche les informations de la connexion pour le débogage
-        printf("Received packet from %s:%d\nData: [%s]\n\n",
-               inet_ntoa(cli_addr.sin_addr),            // Convertit l'IP en chaîne de caractères
-               ntohs(cli_addr.sin_port),                // Convertit le port en format hôte 
-               buffer);
-
-        /***********************************************************************
-         * SOUS-SECTION 9.6: MACHINE À ÉTATS - PHASE D'ATTENTE DES JOUEURS
-         * État fsmServer == 0: Le serveur attend que 4 joueurs se connectent
-         ***********************************************************************/
-        
-        if (fsmServer == 0)     // État 0: attente des connexions
-        {
-            switch (buffer[0])  // Analyse la première lettre de la commande
-            {
-                case 'C':       // Commande de Connexion
-                    printf(">>> TRAITEMENT CONNEXION <<<\n");
-                    
-                    // Parse le message: "C <IP> <port> <nom>"
-                    sscanf(buffer, "%c %s %d %s", &com, clientIpAddress, &clientPort, clientName);
-                    printf("COM=%c ipAddress=%s port=%d name=%s\n", com, clientIpAddress, clientPort, clientName);
-
-                    // Enregistre le nouveau client dans le tableau tcpClients
-                    strcpy(tcpClients[nbClients].ipAddress, clientIpAddress);
-                    tcpClients[nbClients].port = clientPort;
-                    strcpy(tcpClients[nbClients].name, clientName);
-                    nbClients++;                        // Incrémente le compteur de clients
-
-                    // Affiche la liste des clients connectés
-                    printClients();
-
-                    // Recherche l'ID du joueur qui vient de se connecter
-                    id = findClientByName(clientName);
-                    printf("id=%d\n", id);
-
-                    // ===== MESSAGE 'I' : ENVOI DE L'ID AU JOUEUR =====
-                    // Format: "I <id>"
-                    // Envoie un message personnel au joueur pour lui communiquer son ID unique
-                    sprintf(reply, "I %d", id);
-                    sendMessageToClient(tcpClients[id].ipAddress,
-                                      tcpClients[id].port,
-                                      reply);
-                    printf("Envoi de l'ID %d au joueur %s\n", id, clientName);
-
-                    // ===== MESSAGE 'L' : BROADCAST DE LA LISTE DES JOUEURS =====
-                    // Format: "L <nom1> <nom2> <nom3> <nom4>"
-                    // Envoie à tous les joueurs la liste complète des noms (même ceux pas encore connectés)
-                    sprintf(reply, "L %s %s %s %s", 
-                           tcpClients[0].name, 
-                           tcpClients[1].name, 
-                           tcpClients[2].name, 
-                           tcpClients[3].name);
-                    broadcastMessage(reply);
-                    printf("Broadcast de la liste des joueurs: %s\n", reply);
-
-                    // Si 4 joueurs sont connectés, lance la partie
-                    if (nbClients == 4)
-                    {
-                        printf("\n=== DÉBUT DE LA PARTIE ===\n");
-                        printf("4 joueurs connectés, distribution des cartes...\n\n");
-                        
-                        // ===== MESSAGE 'D' : DISTRIBUTION DES CARTES =====
-                        // Format: "D <carte1> <carte2> <carte3>"
-                        // Envoie à chaque joueur ses 3 cartes (indices du deck)
-                        // SYNCHRONISATION CLIENT: Le client attend le format "D %d %d %d"
-                        
-                        // Distribution au joueur 0 (cartes 0, 1, 2 du deck mélangé)
-                        sprintf(reply, "D %d %d %d", deck[0], deck[1], deck[2]);
-                        sendMessageToClient(tcpClients[0].ipAddress, tcpClients[0].port, reply);
-                        printf("Joueur 0 (%s) reçoit: %s => %s, %s, %s\n", 
-                               tcpClients[0].name, reply,
-                               nomcartes[deck[0]], nomcartes[deck[1]], nomcartes[deck[2]]);
-
-                        // Distribution au joueur 1 (cartes 3, 4, 5 du deck mélangé)
-                        sprintf(reply, "D %d %d %d", deck[3], deck[4], deck[5]);
-                        sendMessageToClient(tcpClients[1].ipAddress, tcpClients[1].port, reply);
-                        printf("Joueur 1 (%s) reçoit: %s => %s, %s, %s\n", 
-                               tcpClients[1].name, reply,
-                               nomcartes[deck[3]], nomcartes[deck[4]], nomcartes[deck[5]]);
-
-                        // Distribution au joueur 2 (cartes 6, 7, 8 du deck mélangé)
-                        sprintf(reply, "D %d %d %d", deck[6], deck[7], deck[8]);
-                        sendMessageToClient(tcpClients[2].ipAddress, tcpClients[2].port, reply);
-                        printf("Joueur 2 (%s) reçoit: %s => %s, %s, %s\n", 
-                               tcpClients[2].name, reply,
-                               nomcartes[deck[6]], nomcartes[deck[7]], nomcartes[deck[8]]);
-
-                        // Distribution au joueur 3 (cartes 9, 10, 11 du deck mélangé)
-                        sprintf(reply, "D %d %d %d", deck[9], deck[10], deck[11]);
-                        sendMessageToClient(tcpClients[3].ipAddress, tcpClients[3].port, reply);
-                        printf("Joueur 3 (%s) reçoit: %s => %s, %s, %s\n", 
-                               tcpClients[3].name, reply,
-                               nomcartes[deck[9]], nomcartes[deck[10]], nomcartes[deck[11]]);
-
-                        // Affiche le personnage coupable (carte 12) pour le debug du serveur
-                        printf("\n>>> PERSONNAGE COUPABLE: %s (indice %d) <<<\n\n", 
-                               nomcartes[deck[12]], deck[12]);
-
-                        // ===== MESSAGE 'M' : INDICATION DU JOUEUR COURANT =====
-                        // Format: "M <idJoueur>"
-                        // SYNCHRONISATION CLIENT: Le client attend 'M' (pas 'T' comme dans l'ancienne version)
-                        // Ce message active le bouton "GO" pour le joueur dont c'est le tour
-                        sprintf(reply, "M %d", joueurCourant);
-                        broadcastMessage(reply);
-                        printf("C'est au tour du joueur %d (%s)\n\n", 
-                               joueurCourant, tcpClients[joueurCourant].name);
-
-                        // Passe à l'état 1 (partie en cours)
-                        fsmServer = 1;
-                    }
-                    break;
-            }
+// Un seul appel système pour tous les enregistrements d'un message
+void viderJournal(struct session *s)
+{
+    if (s->journal == NULL)
+        return;
+    journalVider(s->journal);
+    if (s->actionsSansReprise >= REPRISE_PERIODE)
+        sauverPointReprise(s);
+}
+
+// Partie terminée: le journal quitte <dossier>/encours et le point de reprise disparaît
+void fermerJournal(struct session *s)
+{
+    char chemin[1100];
+    char *nom;
+
+    journalFin(s->journal, s->jeu.gagnant);
+    journalTerminer(s->journal);
+    s->journal = NULL;
+
+    sprintf(chemin, "%s" REPRISE_EXTENSION, s->cheminJournal);
+    unlink(chemin);
+    nom = strrchr(s->cheminJournal, '/') + 1;
+    sprintf(chemin, "%s/%s", dossierJournal, nom);
+    rename(s->cheminJournal, chemin);
+}
+
+// Reconstruit une partie restée en cours lors d'un arrêt du serveur
+// (point de reprise + fin du journal fichier). Une table incomplète n'est pas
+// reprise: ses joueurs retournent dans le lobby, son journal est effacé.
+// Retourne 1 si une partie a été reprise dans s
+int reprendrePartie(struct session *s, char *fichier)
+{
+    struct etatReprise e;
+    struct joueurLobby *j;
+    char reply[256], chemin[1100];
+    int i;
+
+    strcpy(s->cheminJournal, fichier);
+    switch (repriseRestaurer(s->cheminJournal, &e))
+    {
+        case 1:
+            break;
+        case 0:
+            // Terminée mais pas encore déplacée (arrêt pendant fermerJournal)
+            if (journalRouvrir(&s->stockageJournal, s->cheminJournal, e.position, e.t) == 0)
+                journalTerminer(&s->stockageJournal);
+            return 0;
+        default:
+            LOG_AVERT("Journal illisible: %s", s->cheminJournal);
+            return 0;
+    }
+
+    if (e.nbJoueurs < 4)
+    {
+        for (i=0; i<e.nbJoueurs; i++)
+            if (!e.joueurs[i].robot && lobbyChercher(&lobby, e.joueurs[i].nom) == NULL
+                && (j = lobbyAjouter(&lobby, e.joueurs[i].nom, e.joueurs[i].ip, e.joueurs[i].port, "")) != NULL
+                && delaiInactivite > 0)
+                rouePlanifier(&roueLobby, &j->inactivite, horlogeTicks() + delaiInactivite * (1000 / MINUTERIE_TICK_MS));
+        sprintf(chemin, "%s" REPRISE_EXTENSION, s->cheminJournal);
+        unlink(chemin);
+        unlink(s->cheminJournal);
+        LOG_INFO("Table incomplète abandonnée, joueurs remis en attente: %s", s->cheminJournal);
+        return 0;
+    }
+
+    // Restaure l'état du serveur; les joueurs restent assis à cette table
+    s->jeu = e.jeu;
+    s->nbClients = e.nbJoueurs;
+    for (i=0; i<s->nbClients; i++)
+    {
+        strcpy(s->tcpClients[i].ipAddress, e.joueurs[i].ip);
+        s->tcpClients[i].port = e.joueurs[i].port;
+        strcpy(s->tcpClients[i].name, e.joueurs[i].nom);
+        s->tcpClients[i].robot = e.joueurs[i].robot;
+        if (s->tcpClients[i].robot)
+            continue;
+
+        // Déjà connu (remis en attente par une table incomplète, ou déjà
+        // revenu): le même enregistrement est assis ici, il ne sort pas de la
+        // table d'une autre partie reprise
+        if ((j = lobbyChercher(&lobby, e.joueurs[i].nom)) == NULL)
+            j = lobbyAjouter(&lobby, e.joueurs[i].nom, e.joueurs[i].ip, e.joueurs[i].port, "");
+        else if (j->table != LOBBY_EN_ATTENTE)
+        {
+            LOG_AVERT("Joueur %s déjà assis à la table %d, sa place à la table %d ne lui est pas rendue",
+                      j->nom, j->table, s->numero);
+            continue;
         }
-    
-        /***********************************************************************
- * SOUS-SECTION 9.7: MACHINE À ÉTATS - PHASE DE JEU
- * État fsmServer == 1: La partie est en cours, traitement des actions
- ***********************************************************************/
+        else
+            roueAnnuler(&roueLobby, &j->inactivite);
+        if (j != NULL)
+            lobbyAsseoir(&lobby, j, s->numero);
+    }
+    s->fsm = SESSION_EN_JEU;
+    s->reprise = 1;
+
+    if (journalRouvrir(&s->stockageJournal, s->cheminJournal, e.position, e.t) < 0)
+        error("ERROR reopening journal");
+    s->journal = &s->stockageJournal;
+    sauverPointReprise(s);
+
+    LOG_INFO("=== PARTIE REPRISE (table %d): %s ===", s->numero, s->cheminJournal);
+
+    // Les robots ne retrouvent que leurs cartes (leurs déductions sont perdues)
+    for (i=0; i<s->nbClients; i++)
+        if (s->tcpClients[i].robot)
+        {
+            botInit(&s->bots[i], i);
+            sprintf(reply, "D %d %d %d", s->jeu.deck[i*3], s->jeu.deck[i*3+1], s->jeu.deck[i*3+2]);
+            botRecoit(&s->bots[i], reply);
+        }
+
+    // Les clients toujours en vie reprennent directement; les autres renverront 'C'
+    sprintf(reply, "L %s %s %s %s",
+           s->tcpClients[0].name, s->tcpClients[1].name, s->tcpClients[2].name, s->tcpClients[3].name);
+    broadcastMessage(s, reply);
+    sprintf(reply, "M %d", s->jeu.joueurCourant);
+    broadcastMessage(s, reply);
+    return 1;
+}
+
+// Reprend toutes les parties de ce port laissées en cours (avant le lancement des groupes)
+void reprendreParties(int portno)
+{
+    struct declencheur d;
+    struct dirent *entree;
+    struct session *s;
+    DIR *dossier;
+    char encours[600], chemin[1024], prefixe[64];
+
+    sprintf(encours, "%s/" REPRISE_DOSSIER, dossierJournal);
+    dossier = opendir(encours);
+    if (dossier == NULL)
+        return;
+
+    sprintf(prefixe, "partie-%d-", portno);
+    while ((entree = readdir(dossier)) != NULL)
+    {
+        if (strncmp(entree->d_name, prefixe, strlen(prefixe)) != 0
+            || strstr(entree->d_name, JOURNAL_EXTENSION REPRISE_EXTENSION) != NULL
+            || strcmp(entree->d_name + strlen(entree->d_name) - strlen(JOURNAL_EXTENSION),
+                      JOURNAL_EXTENSION) != 0)
+            continue;
+
+        s = sessionPrendre(&reserve);
+        if (s == NULL)
+        {
+            LOG_AVERT("Plus de table libre pour reprendre %s", entree->d_name);
+            break;
+        }
+        snprintf(chemin, sizeof(chemin), "%s/%s", encours, entree->d_name);
+        if (reprendrePartie(s, chemin))
+        {
+            // Le délai de tour repart de zéro, les robots jouent s'ils ont la main
+            d.type = DECL_REPRISE;
+            deroulerTable(s, &d);
+            viderJournal(s);
+        }
+        else
+            sessionRendre(&reserve, s);
+    }
+    closedir(dossier);
+}
+
+// Prépare une table vide: donne, journal et robots assis
+void installerTable(struct session *s)
+{
+    struct groupe *g = GROUPE(s);
+    char botName[40];
+    int i;
+
+    partieInit(&s->jeu, g->graine);
+    LOG_INFO("Graine: %u", g->graine);
+    g->graine = s->jeu.alea;
+
+    // Ouvre le journal de la partie: graine et donne en premier
+    if (dossierJournal != NULL)
+        ouvrirJournal(s);
+
+    // Installe les robots: ils occupent leur place sans se connecter
+    for (i=0; i<nbBots; i++)
+    {
+        sprintf(botName, "robot%d", i+1);
+        ajouterJoueur(s, "-", -1, botName, 1);
+    }
+}
+
+// Partie finie sans revanche: les joueurs humains quittent le lobby
+// avant de recevoir 'W', pour que leur 'C' suivant les remette en attente
+// au lieu de les reconnecter à cette table
+void oublierJoueurs(struct session *s)
+{
+    struct joueurLobby *j;
+    int i;
+
+    pthread_mutex_lock(&verrouLobby);
+    for (i=0; i<s->nbClients; i++)
+        if (!s->tcpClients[i].robot
+            && (j = lobbyChercher(&lobby, s->tcpClients[i].name)) != NULL && j->table == s->numero)
+            lobbyRetirer(&lobby, j);
+    pthread_mutex_unlock(&verrouLobby);
+}
+
+// Résultat de la partie pour le classement: seuls les humains sont classés,
+// le gagnant n'est compté que s'il est humain (au moins deux humains)
+void classerPartie(struct session *s)
+{
+    char noms[NB_JOUEURS][CLASSEMENT_NOM];
+    int i, nb = 0, gagnant = -1;
+
+    for (i=0; i<s->nbClients; i++)
+    {
+        if (s->tcpClients[i].robot)
+            continue;
+        if (i == s->jeu.gagnant)
+            gagnant = nb;
+        strncpy(noms[nb], s->tcpClients[i].name, CLASSEMENT_NOM - 1);
+        noms[nb++][CLASSEMENT_NOM - 1] = '\0';
+    }
+    if (nb >= 2)
+        classementPartie(noms, nb, gagnant, s->toursJoues[s->jeu.gagnant]);
+}
+
+// Fin de partie ('W' déjà envoyé): ferme le journal et classe la partie,
+// puis redonne aux mêmes joueurs (-r, sauf si le groupe est drainé)
+void terminerPartie(struct session *s)
+{
+    struct timespec t0, t1;
+    int i;
+
+    LOG_INFO(">>> FIN DE LA PARTIE (table %d, partie %d): joueur %d (%s) gagne <<<",
+           s->numero, s->parties + 1, s->jeu.gagnant, s->tcpClients[s->jeu.gagnant].name);
+    if (s->journal != NULL)
+        fermerJournal(s);
+    s->parties++;
+    metriquesCompte(MET_PARTIES, 1);
+    SONDE3(partie_fin, s->numero, s->jeu.gagnant, s->parties);
+    if (fichierClassement != NULL)
+        classerPartie(s);
+
+    if (!s->redonne)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    sessionNouvelleDonne(s, GROUPE(s)->graine);
+    GROUPE(s)->graine = s->jeu.alea;
+    if (dossierJournal != NULL)
+    {
+        ouvrirJournal(s);
+        for (i=0; i<s->nbClients; i++)
+            journalJoueur(s->journal, i, s->tcpClients[i].robot, s->tcpClients[i].port,
+                          s->tcpClients[i].name, s->tcpClients[i].ipAddress);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    LOG_INFO("Table %d redonnée en %.1f us", s->numero,
+           (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3);
+}
+
+// Table sans revanche: elle retourne dans la réserve (ses joueurs ont déjà
+// quitté le lobby) et le lobby est prévenu
+// Les clients humains renvoient 'C' pour retourner dans le lobby
+void rendreTable(struct session *s)
+{
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_mutex_lock(&verrouReserve);
+    sessionRendre(&reserve, s);
+    pthread_mutex_unlock(&verrouReserve);
+    if (write(reveilLobby[1], "t", 1) < 0)
+        LOG_DEBUG("Lobby déjà réveillé");
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    LOG_INFO("Table %d rendue en %.1f us", s->numero,
+           (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3);
+}
 
-else if (fsmServer == 1)
+// Applique l'action du joueur courant (reçue, d'un robot ou délai dépassé)
+// Retourne -1 si elle est refusée (hors tour ou invalide)
+int appliquerAction(struct session *s, struct action *act)
 {
-    switch (buffer[0])
+    struct evenement ev[MAX_EVENEMENTS];         // Messages produits par l'action
+    char reply[256];                             // Réponse publiée aux spectateurs
+    int n;                                       // Nombre d'événements produits
+
+    // Applique les règles; action refusée si ce n'est pas le tour du joueur
+    n = partieAppliquer(&s->jeu, act, ev);
+    if (n < 0)
+    {
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+        return -1;
+    }
+    if (s->journal != NULL)
+    {
+        journalAction(s->journal, act);
+        s->actionsSansReprise++;
+    }
+    if (act->code != 'P')
+        s->toursManques[act->joueur] = 0;
+    s->toursJoues[act->joueur]++;
+
+    switch (act->code)
     {
         /***************************************************************
          * COMMANDE 'G' : ACCUSATION DU COUPABLE
-         * Format: "G <idJoueur> <numCarte>"
+         * Réponse 'W' (victoire) ou 'F' (le joueur est éliminé) puis 'M'
          ***************************************************************/
         case 'G':
-            sscanf(buffer, "%c %d %d", &com, &idJoueur, &coupable);
-
-            // Ignore si ce n'est pas le tour du joueur
-            if (idJoueur != joueurCourant)
-                break;
-
-            printf(">>> ACCUSATION: Joueur %d (%s) accuse %s <<<\n",
-                   idJoueur,
-                   tcpClients[idJoueur].name,
-                   nomcartes[coupable]);
-
-            // Vérifie si l'accusation est correcte
-            if (coupable == deck[12])
-            {
-                // Victoire
-                sprintf(reply, "W %d %d", idJoueur, coupable);
-                broadcastMessage(reply);
-                printf(">>> VICTOIRE DU JOUEUR %d <<<\n", idJoueur);
-                exit(0);
-            }
+            LOG_INFO(">>> ACCUSATION: Joueur %d (%s) accuse %s <<<",
+                   act->joueur, s->tcpClients[act->joueur].name, nomcartes[act->a]);
+            if (s->jeu.gagnant != -1)
+                LOG_INFO(">>> VICTOIRE DU JOUEUR %d <<<", act->joueur);
             else
-            {
-                // Mauvaise accusation
-                joueursPerdu[idJoueur] = 1;
-                for (j = 0; j < 4; j++){
-                    if (j != idJoueur){
-                        sprintf(reply, "F %d %d", idJoueur, coupable);
-                        broadcastMessage(reply);
-                        printf("Mauvaise accusation du joueur %d\n", idJoueur);
-                    }
-                }
-            }
-
-            // Passe au joueur suivant
-            joueurCourant = (joueurCourant + 1) % 4;
-            sprintf(reply, "M %d", joueurCourant);
-            broadcastMessage(reply);
+                LOG_INFO("Mauvaise accusation du joueur %d", act->joueur);
             break;
 
         /***************************************************************
          * COMMANDE 'O' : QUESTION OUI / NON
-         * Format: "O <idJoueur> <joueurCible> <objet>"
+         * Réponse 'R <objet> <joueur> <0|1>' pour chaque joueur puis 'M'
          ***************************************************************/
         case 'O':
-            sscanf(buffer, "%c %d %d", &com, &idJoueur, &objet);
-
-            if (idJoueur != joueurCourant)
-                break;
-
-            printf(">>> QUESTION O/N: Joueur %d demande symbole %d<<<\n",
-                   idJoueur, objet);
-
-            // Réponse = 1 si le joueur ciblé possède le symbole
-            for (j = 0; j < 4; j++){
-                if (tableCartes[j][objet] > 0)
-                    sprintf(reply, "R %d %d %d", objet, j, 1);
-                else
-                    sprintf(reply, "R %d %d %d", objet, j, 0);
-                broadcastMessage(reply);
-            }
-
-            broadcastMessage(reply);
-
-            // Joueur suivant
-            joueurCourant = (joueurCourant + 1) % 4;
-            sprintf(reply, "M %d", joueurCourant);
-            broadcastMessage(reply);
+            LOG_DEBUG(">>> QUESTION O/N: Joueur %d demande symbole %d <<<",
+                   act->joueur, act->a);
             break;
 
         /***************************************************************
          * COMMANDE 'S' : QUESTION STATISTIQUE
-         * Format: "S <idJoueur> <joueur> <objet>"
+         * Réponse 'S <objet> <valeur>' au demandeur seulement puis 'M'
          ***************************************************************/
         case 'S':
-            sscanf(buffer, "%c %d %d %d", &com, &idJoueur, &joueur, &objet);
-
-            if (idJoueur != joueurCourant)
-                break;
-
-            printf(">>> QUESTION STAT: Joueur %d demande statistique %d au %d <<<\n",
-                   idJoueur, objet, joueur);
+            LOG_DEBUG(">>> QUESTION STAT: Joueur %d demande statistique %d au %d <<<",
+                   act->joueur, act->b, act->a);
+            // Table aux questions publiques: "S <objet> <valeur> <demandeur> <joueur>"
+            if (questionsPubliques)
+            {
+                sprintf(reply, "S %d %d %d %d", act->b, s->jeu.tableCartes[act->a][act->b],
+                        act->joueur, act->a);
+                diffusionPublier(s->numero, reply);
+            }
+            break;
 
-            // Réponse uniquement au joueur demandeur
-            sprintf(reply, "S %d %d", objet, tableCartes[joueur][objet]);
-            sendMessageToClient(tcpClients[idJoueur].ipAddress,
-                                tcpClients[idJoueur].port,
-                                reply);
+        /***************************************************************
+         * DÉLAI DE TOUR DÉPASSÉ (serveur)
+         * 'M' au joueur suivant, ou 'A' (forfait) puis 'M' ou 'W'
+         ***************************************************************/
+        case 'P':
+            LOG_INFO(">>> DÉLAI DÉPASSÉ: Joueur %d (%s) %s <<<", act->joueur,
+                   s->tcpClients[act->joueur].name, act->a ? "éliminé" : "passe son tour");
+            break;
+    }
+
+    // Fin de partie: on ne redonne pas dans un groupe drainé (-r)
+    if (s->jeu.gagnant != -1)
+    {
+        s->redonne = revanche && !__atomic_load_n(&GROUPE(s)->draine, __ATOMIC_ACQUIRE);
+        if (!s->redonne)
+            oublierJoueurs(s);
+    }
+    envoyerEvenements(s, ev, n, act);
+    SONDE3(tour_fin, s->numero, act->joueur, act->code);
+    return 0;
+}
+
+// Action du robot dont c'est le tour (même format que celles du réseau)
+void faireJouerBot(struct session *s, struct action *act)
+{
+    char action[256];
+
+    botJoue(&s->bots[s->jeu.joueurCourant], action);
+    LOG_DEBUG("Robot %d (%s) joue: %s", s->jeu.joueurCourant, s->tcpClients[s->jeu.joueurCourant].name, action);
+    partieLireAction(action, act);
+}
+
+/***************************************************************************
+ * DÉROULEMENT D'UNE TABLE (COROUTINE)
+ * Installation des joueurs, puis pour chaque partie: donne, tours jusqu'au
+ * gagnant, fin de partie; avec -r on redonne, sinon la table est rendue.
+ * La coroutine attend l'action du joueur humain courant (ou son délai) sans
+ * fil ni pile: son point de reprise est s->co, son état la session. Les
+ * robots jouent sans attendre. Le groupe la reprend à chaque déclencheur et
+ * envoie ensuite les messages du lot et le journal.
+ * Retourne CO_TERMINEE quand la table est rendue
+ ***************************************************************************/
+int deroulerTable(struct session *s, struct declencheur *d)
+{
+    struct action act;
+    int i;
+
+    CO_DEBUT(&s->co);
+
+    // Table formée par le lobby: donne, journal, robots, puis les joueurs
+    // (une table reprise d'un journal a déjà tout cela)
+    if (d->type == DECL_TABLE)
+    {
+        installerTable(s);
+        for (i=0; i<d->c->nbJoueurs; i++)
+            ajouterJoueur(s, d->c->joueurs[i].ipAddress, d->c->joueurs[i].port, d->c->joueurs[i].name, 0);
+    }
+
+    do
+    {
+        // Seule la première partie d'une table reprise est déjà donnée
+        if (!s->reprise)
+            demarrerPartie(s);
+        s->reprise = 0;
+
+        while (s->jeu.gagnant == -1)
+        {
+            SONDE3(tour_debut, s->numero, s->jeu.joueurCourant, s->tcpClients[s->jeu.joueurCourant].robot);
+            if (s->tcpClients[s->jeu.joueurCourant].robot)
+            {
+                faireJouerBot(s, &act);
+                appliquerAction(s, &act);
+                continue;
+            }
+
+            // Humain: son action ou son délai; une action refusée ne relance pas le délai
+            armerTour(s);
+            do
+            {
+                CO_ATTENDRE(&s->co, d->type == DECL_ACTION || d->type == DECL_DELAI);
+            } while (appliquerAction(s, &d->act) < 0);
+        }
+        roueAnnuler(s->roue, &s->delaiTour);
+        terminerPartie(s);
+    } while (s->redonne);
+
+    CO_FIN(&s->co);
+    rendreTable(s);
+    return CO_TERMINEE;
+}
+
+// Traite un message reçu d'un joueur assis
+void traiterMessage(struct session *s, char *buffer)
+{
+    char com;                                    // Commande reçue (première lettre)
+    char clientIpAddress[256];                   // Adresse IP du client
+    char clientName[256];                        // Nom du joueur
+    int clientPort;                              // Port du client
+    struct declencheur d;                        // Action du joueur ('G', 'O' ou 'S')
+    int n;                                       // Place du joueur
+
+    /***********************************************************************
+     * PARTIE EN COURS (fsm == SESSION_EN_JEU)
+     * Les actions reprennent le déroulement de la table, qui n'applique que
+     * celles du joueur courant (l'attente des joueurs se fait dans le lobby:
+     * une table arrive complète); les reconnexions sont traitées ici
+     ***********************************************************************/
+
+    if (s->fsm == SESSION_EN_JEU)
+    {
+        // Reconnexion d'un joueur de la partie: "C <IP> <port> <nom>"
+        if (buffer[0] == 'C')
+        {
+            if (sscanf(buffer, "%c %s %d %s", &com, clientIpAddress, &clientPort, clientName) == 4
+                && (n = findClientByName(s, clientName)) != -1 && !s->tcpClients[n].robot)
+                reconnecterJoueur(s, n, clientIpAddress, clientPort);
+            return;
+        }
+
+        // Formats: "G <idJoueur> <numCarte>", "O <idJoueur> <objet>",
+        //          "S <idJoueur> <joueur> <objet>" (suivis du numéro de table)
+        if (!partieLireAction(buffer, &d.act))
+        {
+            metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+            return;
+        }
+        SONDE3(message_lu, s->numero, d.act.code, d.act.joueur);
+        d.type = DECL_ACTION;
+        deroulerTable(s, &d);
+    }
+}
+
+// Délai de tour dépassé: le tour passe; après toursAvantForfait délais
+// d'affilée, le joueur est éliminé (la partie se termine s'il ne reste qu'un joueur)
+void tourExpire(struct minuterie *m)
+{
+    struct session *s = m->donnees;
+    struct declencheur d;
+
+    d.type = DECL_DELAI;
+    d.act.code = 'P';
+    d.act.joueur = s->jeu.joueurCourant;
+    d.act.a = ++s->toursManques[d.act.joueur] >= toursAvantForfait;
+    d.act.b = 0;
+    d.act.requete = 0;
+    deroulerTable(s, &d);
+    viderJournal(s);
+}
+
+/*******************************************************************************
+ * SECTION 9: LOBBY ET GROUPES DE TABLES
+ ******************************************************************************/
+
+void repondreAdmin(struct groupe *g, struct requeteAdmin *r);
+
+// Passe des courriers à un groupe; réveille son fil si sa file était vide
+// Attend s'il y a déjà COURRIER_FILE courriers en attente
+void posterCourriers(struct groupe *g, struct courrier *c, int n)
+{
+    int i, vide;
+
+    pthread_mutex_lock(&g->verrou);
+    vide = (g->nb == 0);
+    for (i=0; i<n; i++)
+    {
+        while (g->nb == COURRIER_FILE)
+        {
+            if (write(g->reveil[1], "c", 1) < 0)
+                LOG_DEBUG("Groupe %d déjà réveillé", g->numero);
+            pthread_cond_wait(&g->place, &g->verrou);
+        }
+        g->file[(g->tete + g->nb) % COURRIER_FILE] = c[i];
+        g->nb++;
+    }
+    pthread_mutex_unlock(&g->verrou);
+    if (vide && write(g->reveil[1], "c", 1) < 0)
+        LOG_DEBUG("Groupe %d déjà réveillé", g->numero);
+}
+
+// Traite un courrier dans le fil du groupe de sa table
+void traiterCourrier(struct courrier *c)
+{
+    struct session *s = c->s;
+    struct declencheur d;
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    SONDE2(courrier_debut, s->numero, c->type == COURRIER_TABLE ? 'T' : c->texte[0]);
+    if (c->type == COURRIER_TABLE)
+    {
+        // Nouvelle table: son déroulement commence (la partie démarre)
+        d.type = DECL_TABLE;
+        d.c = c;
+        deroulerTable(s, &d);
+    }
+    else
+        traiterMessage(s, c->texte);
+    viderJournal(s);
+    SONDE2(courrier_fin, s->numero, c->type == COURRIER_TABLE ? 'T' : c->texte[0]);
+
+    // Durée de traitement: règles, robots, envois et journal
+    if (c->type == COURRIER_MESSAGE)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        metriquesDuree(metriquesCommande(c->texte[0]),
+                       (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec));
+    }
+}
+
+// Fil d'un groupe: délais de tour de ses tables et courriers du fil principal
+void *filGroupe(void *arg)
+{
+    struct groupe *g = arg;
+    struct courrier lot[COURRIER_LOT];
+    struct pollfd attente;
+    char vidange[64];
+    int i, n, arret = 0;
+
+    // Backend io_uring: anneau propre au fil (seul à y soumettre), un
+    // descripteur direct par destinataire d'un lot
+    if (backendUring)
+    {
+        envoisFil = calloc(1, sizeof(struct envois));
+        if (envoisFil == NULL || uringInit(&envoisFil->u, 4 * LOT_ENVOIS) < 0
+            || uringFichiers(&envoisFil->u, LOT_ENVOIS) < 0)
+            error("ERROR initializing io_uring");
+    }
+
+    attente.fd = g->reveil[0];
+    attente.events = POLLIN;
+    while (!arret)
+    {
+        // Attend un courrier; tant que des délais courent, se réveille à chaque tick
+        if (poll(&attente, 1, g->roue.nb > 0 ? MINUTERIE_TICK_MS : -1) < 0)
+            continue;
+        if (attente.revents & POLLIN)
+            while (read(g->reveil[0], vidange, sizeof(vidange)) == sizeof(vidange))
+                ;
+
+        // Délais échus (tour passé, joueur éliminé): robots et journal suivent
+        if (roueAvancer(&g->roue, horlogeTicks()) > 0)
+            envoyerLot();
+
+        // Courriers par lots: le verrou n'est tenu que pour les copier
+        do
+        {
+            pthread_mutex_lock(&g->verrou);
+            n = (g->nb < COURRIER_LOT) ? g->nb : COURRIER_LOT;
+            for (i=0; i<n; i++)
+                lot[i] = g->file[(g->tete + i) % COURRIER_FILE];
+            g->tete = (g->tete + n) % COURRIER_FILE;
+            g->nb -= n;
+            if (n > 0)
+                pthread_cond_broadcast(&g->place);
+            pthread_mutex_unlock(&g->verrou);
+
+            for (i=0; i<n; i++)
+                if (lot[i].type == COURRIER_ARRET)
+                    arret = 1;
+                else if (lot[i].type == COURRIER_ADMIN)
+                    repondreAdmin(g, lot[i].admin);
+                else
+                    traiterCourrier(&lot[i]);
+            envoyerLot();
+        } while (n == COURRIER_LOT);
+    }
+
+    // Arrêté pour une relève: les minuteries restent dans la roue du groupe
+    if (envoisFil != NULL)
+    {
+        uringFermer(&envoisFil->u);
+        free(envoisFil);
+        envoisFil = NULL;
+    }
+    return NULL;
+}
+
+// Lance le fil de chaque groupe (au démarrage, ou après une relève manquée)
+void demarrerGroupes()
+{
+    int i;
+
+    for (i=0; i<nbGroupes; i++)
+        if (pthread_create(&groupes[i].fil, NULL, filGroupe, &groupes[i]) != 0)
+            error("ERROR creating group thread");
+}
+
+// Joueur en attente sans nouvelles depuis delaiInactivite: oublié par le lobby
+// (appelé par roueAvancer, lobby verrouillé)
+void attenteExpiree(struct minuterie *m)
+{
+    struct joueurLobby *j = m->donnees;
+
+    LOG_INFO("Joueur %s sans nouvelles, retiré du lobby", j->nom);
+    lobbyRetirer(&lobby, j);
+}
+
+// Sort de la réserve une session pour le lobby, NULL s'il n'y en a plus
+// Celles des groupes drainés sont mises de côté (fil principal)
+struct session *prendreTable()
+{
+    struct session *s;
+
+    pthread_mutex_lock(&verrouReserve);
+    while ((s = sessionPrendre(&reserve)) != NULL && __atomic_load_n(&GROUPE(s)->draine, __ATOMIC_ACQUIRE))
+    {
+        s->suivante = tablesDrainees;
+        tablesDrainees = s;
+        nbTablesDrainees++;
+    }
+    pthread_mutex_unlock(&verrouReserve);
+    return s;
+}
+
+// Remet dans la réserve les sessions mises de côté des groupes rouverts
+void rendreTablesDrainees()
+{
+    struct session **pp = &tablesDrainees, *s;
+
+    while ((s = *pp) != NULL)
+    {
+        if (__atomic_load_n(&GROUPE(s)->draine, __ATOMIC_ACQUIRE))
+        {
+            pp = &s->suivante;
+            continue;
+        }
+        *pp = s->suivante;
+        pthread_mutex_lock(&verrouReserve);
+        sessionRendre(&reserve, s);
+        pthread_mutex_unlock(&verrouReserve);
+        nbTablesDrainees--;
+    }
+}
+
+// Assoit les joueurs du lobby aux tables libres tant que des tables se forment
+// Les tables d'un même groupe lui sont passées en un seul lot, lobby déverrouillé
+// (un groupe qui termine une partie a besoin du lobby pour vider sa file)
+int formerTables()
+{
+    static struct courrier lots[NB_JOUEURS * GROUPES_MAX];
+    static int nbLot[GROUPES_MAX];
+    struct joueurLobby *joueurs[NB_JOUEURS];
+    struct courrier *c;
+    struct session *s;
+    int g, i, plein, formees = 0;
+    int taille = NB_JOUEURS - nbBots;
+    int parGroupe = sizeof(lots) / sizeof(lots[0]) / nbGroupes;
+
+    if (tablesDrainees != NULL)
+        rendreTablesDrainees();
+    do
+    {
+        plein = 0;
+        pthread_mutex_lock(&verrouLobby);
+        while (!plein && lobbyPrete(&lobby))
+        {
+            s = prendreTable();
+            if (s == NULL)
+                break;
+
+            lobbyFormer(&lobby, s->numero, joueurs);
+            g = s->numero % nbGroupes;
+            c = &lots[g * parGroupe + nbLot[g]];
+            c->type = COURRIER_TABLE;
+            c->s = s;
+            c->nbJoueurs = taille;
+            for (i=0; i<taille; i++)
+            {
+                roueAnnuler(&roueLobby, &joueurs[i]->inactivite);
+                strcpy(c->joueurs[i].ipAddress, joueurs[i]->ip);
+                c->joueurs[i].port = joueurs[i]->port;
+                strcpy(c->joueurs[i].name, joueurs[i]->nom);
+            }
+            formees++;
+            plein = (++nbLot[g] == parGroupe);
+        }
+        pthread_mutex_unlock(&verrouLobby);
+
+        for (g=0; g<nbGroupes; g++)
+            if (nbLot[g] > 0)
+            {
+                posterCourriers(&groupes[g], &lots[g * parGroupe], nbLot[g]);
+                nbLot[g] = 0;
+            }
+    } while (plein);
+
+    if (formees > 0)
+        LOG_INFO("%d table(s) formée(s), %d joueur(s) en attente", formees, lobby.enAttente);
+    return formees;
+}
+
+// Un groupe a au moins seuilAdmission courriers en attente (lecture sans verrou)
+int groupesSurcharges()
+{
+    int g, seuil = __atomic_load_n(&seuilAdmission, __ATOMIC_RELAXED);
+
+    if (seuil <= 0)
+        return 0;
+    for (g=0; g<nbGroupes; g++)
+        if (__atomic_load_n(&groupes[g].nb, __ATOMIC_RELAXED) >= seuil)
+            return 1;
+    return 0;
+}
+
+// Instant d'un message pour les limiteurs de débit (µs)
+unsigned long long microsecondes(struct timespec *t)
+{
+    return t->tv_sec * 1000000ULL + t->tv_nsec / 1000;
+}
+
+// Débit de l'adresse IP de l'expéditeur ("a.b.c.d:port"), retourne 0 si son
+// seau est vide. Les transports locaux (unix:, shm:) ne sont pas limités
+int adresseAdmise(const char *origine, unsigned long long maintenant)
+{
+    struct in_addr adresse;
+    char ip[16];
+
+    if (sscanf(origine, "%15[0-9.]", ip) != 1 || inet_pton(AF_INET, ip, &adresse) != 1)
+        return 1;
+    return seauPrendre(tableSeauxChercher(&seauxAdresses, adresse.s_addr), &limiteAdresse, maintenant);
+}
+
+// 'C' reçu par le fil principal: "C <IP> <port> <nom> [tag]"
+// Joueur assis: reconnexion transmise au groupe de sa table
+// Joueur en attente: nouvelle adresse, délai d'inactivité repoussé
+// Nouveau joueur: en queue de la file de son tag, sauf si un groupe est surchargé
+void accueillirJoueur(char *buffer)
+{
+    struct joueurLobby *j;
+    struct courrier c;
+    struct fiche f;
+    char com, ip[40], nom[40], tag[LOBBY_TAG] = "";
+    int port, table = -1, connu = 0, admis = 1;
+
+    if (sscanf(buffer, "%c %39s %d %39s %15s", &com, ip, &port, nom, tag) < 4)
+    {
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+        return;
+    }
+    SONDE3(message_lu, -1, 'C', nom);
+    // Fiche lue hors du verrou du lobby (une ou deux pages de l'index)
+    if (fichierClassement != NULL)
+        connu = classementChercher(nom, &f);
+
+    pthread_mutex_lock(&verrouLobby);
+    j = lobbyChercher(&lobby, nom);
+    if (j != NULL && j->table != LOBBY_EN_ATTENTE)
+        table = j->table;
+    else if (j != NULL)
+    {
+        strcpy(j->ip, ip);
+        j->port = port;
+    }
+    else if (groupesSurcharges())
+    {
+        admis = 0;
+        LOG_AVERT("Groupes surchargés, connexion de %s refusée", nom);
+    }
+    else
+    {
+        j = lobbyAjouter(&lobby, nom, ip, port, tag);
+        if (j == NULL)
+            LOG_AVERT("Lobby plein, connexion de %s refusée", nom);
+        else if (fichierClassement != NULL)
+        {
+            j->elo = f.elo;
+            LOG_INFO("Connexion: ipAddress=%s port=%d name=%s tag=%s elo=%.0f parties=%d%s", ip, port, nom, tag,
+                     f.elo, (int) f.parties, connu ? "" : " (nouveau)");
+        }
+        else
+            LOG_INFO("Connexion: ipAddress=%s port=%d name=%s tag=%s", ip, port, nom, tag);
+    }
+    if (j != NULL && table < 0 && delaiInactivite > 0)
+        rouePlanifier(&roueLobby, &j->inactivite, horlogeTicks() + delaiInactivite * (1000 / MINUTERIE_TICK_MS));
+    pthread_mutex_unlock(&verrouLobby);
+
+    if (table >= 0)
+    {
+        c.type = COURRIER_MESSAGE;
+        c.s = &reserve.sessions[table];
+        strcpy(c.texte, buffer);
+        posterCourriers(GROUPE(c.s), &c, 1);
+    }
+    else if (!admis)
+        metriquesCompte(MET_ADMISSIONS_REFUSEES, 1);
+    else if (j == NULL)
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+}
+
+// Action d'un joueur assis: transmise au groupe de la table (dernier champ,
+// table 0 si absent: clients d'un serveur à une seule table)
+// Refusée ici, sans réveiller le groupe, si elle vient d'une autre place que
+// celle du joueur courant (il ne change qu'avant l'envoi de son 'M': un
+// joueur ne peut pas jouer avant de l'avoir reçu) ou si sa place dépasse
+// son débit
+void routerAction(char *buffer, unsigned long long maintenant)
+{
+    struct courrier c;
+    struct session *s;
+    char com;
+    int x, y, z, table = 0, n;
+
+    n = sscanf(buffer, "%c %d %d %d %d", &com, &x, &y, &z, &table);
+    if (buffer[0] == 'G' || buffer[0] == 'O')
+        table = (n >= 4) ? z : 0;
+    else if (buffer[0] != 'S' || n < 4)
+        table = -1;
+    else if (n == 4)
+        table = 0;
+    if (table < 0 || table >= reserve.taille)
+    {
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+        return;
+    }
+    s = &reserve.sessions[table];
+    if (x < 0 || x >= NB_JOUEURS
+        || __atomic_load_n(&s->fsm, __ATOMIC_RELAXED) != SESSION_EN_JEU
+        || __atomic_load_n(&s->jeu.joueurCourant, __ATOMIC_RELAXED) != x)
+    {
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+        return;
+    }
+    if (seauxPlaces != NULL && !seauPrendre(&seauxPlaces[table * NB_JOUEURS + x], &limitePlace, maintenant))
+    {
+        metriquesCompte(MET_LIMITES_DEBIT, 1);
+        return;
+    }
+    c.type = COURRIER_MESSAGE;
+    c.s = s;
+    strcpy(c.texte, buffer);
+    posterCourriers(GROUPE(c.s), &c, 1);
+}
+
+// Spectateur: "E <IP> <port> <table>" (le serveur garde la connexion ouverte)
+void abonnerSpectateur(char *buffer)
+{
+    char com, ip[40];
+    int port, table;
+
+    if (sscanf(buffer, "%c %39s %d %d", &com, ip, &port, &table) != 4
+        || diffusionAbonner(ip, port, table) < 0)
+        metriquesCompte(MET_ACTIONS_REFUSEES, 1);
+}
+
+// Message reçu par le fil principal, quel que soit son transport
+void aiguillerMessage(char *buffer, int n, const char *origine)
+{
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    metriquesCompte(MET_MESSAGES_RECUS, 1);
+    metriquesCompte(MET_OCTETS_RECUS, n);
+    SONDE3(message_recu, buffer[0], n, origine);
+
+    // Débit de l'expéditeur, avant de lire ou de journaliser le message
+    if (limiteAdresse.debit > 0 && !adresseAdmise(origine, microsecondes(&t0)))
+    {
+        metriquesCompte(MET_LIMITES_DEBIT, 1);
+        return;
+    }
+
+    // Informations de la connexion (format lu par tracebench)
+    LOG_INFO("Received packet from %s\nData: [%s]", origine, buffer);
+
+    // Connexions: lobby (fil principal); spectateurs: fil de diffusion;
+    // actions: groupe de la table
+    if (buffer[0] == 'E')
+        abonnerSpectateur(buffer);
+    else if (buffer[0] == 'C')
+    {
+        accueillirJoueur(buffer);
+        formerTables();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        metriquesDuree(MET_CMD_C, (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec));
+    }
+    else
+        routerAction(buffer, microsecondes(&t0));
+}
+
+// Après chaque réveil du fil principal: joueurs en attente sans nouvelles,
+// et tables rendues par les groupes (le lobby peut en former de nouvelles)
+void servirLobby(int tablesRendues)
+{
+    char vidange[64];
+
+    pthread_mutex_lock(&verrouLobby);
+    roueAvancer(&roueLobby, horlogeTicks());
+    pthread_mutex_unlock(&verrouLobby);
+
+    if (tablesRendues)
+    {
+        while (read(reveilLobby[0], vidange, sizeof(vidange)) > 0)
+            ;
+        formerTables();
+    }
+}
+
+// Lot de messages d'un anneau partagé (les suivants attendent le tour suivant)
+void lireAnneau(struct ecoute *e)
+{
+    char buffer[256], origine[128];
+    int k, n;
+
+    for (k=0; k<LOT_ANNEAU; k++)
+    {
+        n = transportRecevoir(e, buffer, sizeof(buffer), origine, sizeof(origine));
+        if (n <= 0)
+            break;
+        aiguillerMessage(buffer, n, origine);
+    }
+}
+
+// Jauges lues par le fil des métriques à chaque exposition
+long jaugeSessions() { return reserve.utilisees - nbTablesDrainees; }
+long jaugeAttente() { return lobby.enAttente; }
+long jaugeFileLog() { return logEnAttente(); }
+long jaugePerdusLog() { return logPerdus(); }
+
+// Connexions établies en attente d'accept (tcpi_unacked d'une socket d'écoute)
+long jaugeFileAccept()
+{
+    struct tcp_info info;
+    socklen_t taille = sizeof(info);
+
+    if (getsockopt(socketEcoute, IPPROTO_TCP, TCP_INFO, &info, &taille) < 0)
+        return -1;
+    return info.tcpi_unacked;
+}
+
+/*******************************************************************************
+ * SECTION 10: CONSOLE D'ADMINISTRATION
+ ******************************************************************************/
+
+// Commandes de la console (-A), une par ligne:
+//   sessions          lobby et réserve, puis chaque groupe et ses tables en jeu
+//   table <n>         joueurs, deck et statistiques de la table n
+//   drainer <g>       le groupe g ne reçoit plus de table ni ne redonne (-r)
+//   rouvrir <g>       le groupe g reçoit de nouveau des tables
+//   log <niveau>      niveau de log: debug, info, avert ou erreur
+//   limite <n>        enregistrements par seconde et par ligne de log (0 = sans limite)
+//   admission <n>     nouveaux joueurs refusés dès qu'un groupe a n courriers en attente (0 = toujours admis)
+//   palmares [n] [r]  les n meilleures cotes (défaut 100) à partir du rang r (-R)
+//   rang <nom>        rang et fiche d'un joueur (-R)
+// Une table n'est lue que par le fil de son groupe, entre deux courriers:
+// l'état écrit est celui d'un instant entre deux actions, sans verrou de plus
+// sur le chemin du jeu. La réponse est écrite en mémoire puis envoyée par le
+// fil de la console (un client lent ne bloque pas le groupe).
+
+// Table jouée par son groupe, de l'installation de ses joueurs à son retour
+// dans la réserve (le fil principal la vide en la sortant de la réserve)
+int tableEnJeu(struct session *s)
+{
+    int enJeu;
+
+    pthread_mutex_lock(&verrouReserve);
+    enJeu = (s->fsm == SESSION_EN_JEU);
+    pthread_mutex_unlock(&verrouReserve);
+    return enJeu;
+}
+
+// Une ligne par table: partie, tour et joueurs
+void decrireTable(FILE *f, struct session *s)
+{
+    int i;
+
+    fprintf(f, "table %d: partie %d, ", s->numero, s->parties + 1);
+    if (s->jeu.gagnant != -1)
+        fprintf(f, "gagnée par %s", s->tcpClients[s->jeu.gagnant].name);
+    else
+        fprintf(f, "tour de %s", s->tcpClients[s->jeu.joueurCourant].name);
+    fprintf(f, ", joueurs");
+    for (i=0; i<s->nbClients; i++)
+        fprintf(f, " %s%s", s->tcpClients[i].name, s->jeu.joueursPerdu[i] ? "(x)" : "");
+    fprintf(f, "\n");
+}
+
+// Courrier COURRIER_ADMIN, dans le fil du groupe g
+void repondreAdmin(struct groupe *g, struct requeteAdmin *r)
+{
+    struct session *s;
+    int i, courriers, nb = 0;
+
+    if (r->commande == 't')
+    {
+        s = &reserve.sessions[r->table];
+        if (!tableEnJeu(s))
+            fprintf(r->sortie, "table %d: libre\n", r->table);
+        else
+        {
+            decrireTable(r->sortie, s);
+            fprintf(r->sortie, "groupe %d, %d action(s) depuis le point de reprise, délais manqués %d %d %d %d\n",
+                    g->numero, s->actionsSansReprise,
+                    s->toursManques[0], s->toursManques[1], s->toursManques[2], s->toursManques[3]);
+            printClients(r->sortie, s);
+            printDeck(r->sortie, s);
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&g->verrou);
+        courriers = g->nb;
+        pthread_mutex_unlock(&g->verrou);
+        for (i=g->numero; i<reserve.taille; i+=nbGroupes)
+            nb += tableEnJeu(&reserve.sessions[i]);
+        fprintf(r->sortie, "groupe %d: %s, %d table(s) en jeu, %ld délai(s) armé(s), %d courrier(s) en attente\n",
+                g->numero, __atomic_load_n(&g->draine, __ATOMIC_ACQUIRE) ? "drainé" : "ouvert",
+                nb, g->roue.nb, courriers);
+        for (i=g->numero; i<reserve.taille; i+=nbGroupes)
+            if (tableEnJeu(&reserve.sessions[i]))
+            {
+                fprintf(r->sortie, "  ");
+                decrireTable(r->sortie, &reserve.sessions[i]);
+            }
+    }
+
+    pthread_mutex_lock(&r->verrou);
+    r->terminee = 1;
+    pthread_cond_signal(&r->faite);
+    pthread_mutex_unlock(&r->verrou);
+}
+
+// Passe la demande au groupe g et attend sa réponse (écrite dans r->sortie)
+void demanderGroupe(int g, struct requeteAdmin *r)
+{
+    struct courrier c;
+
+    memset(&c, 0, sizeof(c));
+    c.type = COURRIER_ADMIN;
+    c.admin = r;
+    r->terminee = 0;
+    posterCourriers(&groupes[g], &c, 1);
+    pthread_mutex_lock(&r->verrou);
+    while (!r->terminee)
+        pthread_cond_wait(&r->faite, &r->verrou);
+    pthread_mutex_unlock(&r->verrou);
+}
+
+// Palmarès du classement: nb joueurs à partir du rang debut
+void ecrirePalmares(FILE *f, unsigned long debut, int nb)
+{
+    struct fiche *fiches;
+    int i;
+
+    if (nb < 1)
+        nb = 1;
+    if (nb > PALMARES_ADMIN_MAX)
+        nb = PALMARES_ADMIN_MAX;
+    fiches = malloc(nb * sizeof(struct fiche));
+    if (fiches == NULL)
+        return;
+    nb = classementPalmares(debut, nb, fiches);
+    fprintf(f, "palmarès: %d joueur(s) à partir du rang %lu sur %ld\n", nb, debut, classementJoueurs());
+    for (i=0; i<nb; i++)
+        fprintf(f, "%6lu %-20s %7.1f  %u partie(s), %u victoire(s)\n", debut + i,
+                fiches[i].nom, fiches[i].elo, fiches[i].parties, fiches[i].victoires);
+    free(fiches);
+}
+
+// Exécute une ligne de commande de la console, réponse écrite dans f
+void executerAdmin(char *ligne, FILE *f, struct requeteAdmin *r)
+{
+    char commande[32], argument[CLASSEMENT_NOM] = "";
+    struct fiche fiche;
+    unsigned long rang = 1;
+    int n, g, niveau;
+
+    if (sscanf(ligne, "%31s %39s %lu", commande, argument, &rang) < 1)
+        return;
+    n = (argument[0] >= '0' && argument[0] <= '9') ? atoi(argument) : -1;
+    r->sortie = f;
+
+    if (strcmp(commande, "sessions") == 0)
+    {
+        pthread_mutex_lock(&verrouLobby);
+        fprintf(f, "lobby: %d joueur(s) en attente, %d assis\n", lobby.enAttente, lobby.nb - lobby.enAttente);
+        pthread_mutex_unlock(&verrouLobby);
+        pthread_mutex_lock(&verrouReserve);
+        fprintf(f, "réserve: %d table(s) prise(s) sur %d, dont %d de côté (groupes drainés)\n",
+                reserve.utilisees, reserve.taille, nbTablesDrainees);
+        pthread_mutex_unlock(&verrouReserve);
+        fprintf(f, "admission: %d courrier(s) en attente au plus par groupe%s\n",
+                __atomic_load_n(&seuilAdmission, __ATOMIC_RELAXED), groupesSurcharges() ? " (dépassé)" : "");
+        r->commande = 'g';
+        for (g=0; g<nbGroupes; g++)
+            demanderGroupe(g, r);
+    }
+    else if (strcmp(commande, "table") == 0 && n >= 0 && n < reserve.taille)
+    {
+        r->commande = 't';
+        r->table = n;
+        demanderGroupe(n % nbGroupes, r);
+    }
+    else if ((strcmp(commande, "drainer") == 0 || strcmp(commande, "rouvrir") == 0)
+             && n >= 0 && n < nbGroupes)
+    {
+        // Les tables mises de côté retournent dans la réserve au réveil du lobby
+        __atomic_store_n(&groupes[n].draine, commande[0] == 'd', __ATOMIC_RELEASE);
+        if (commande[0] == 'r' && write(reveilLobby[1], "t", 1) < 0)
+            LOG_DEBUG("Lobby déjà réveillé");
+        LOG_INFO("Console: groupe %d %s", n, commande[0] == 'd' ? "drainé" : "rouvert");
+        fprintf(f, "groupe %d %s\n", n, commande[0] == 'd' ? "drainé" : "rouvert");
+    }
+    else if (strcmp(commande, "log") == 0 && (niveau = logNiveauDepuis(argument)) >= 0)
+    {
+        __atomic_store_n(&logNiveau, niveau, __ATOMIC_RELAXED);
+        fprintf(f, "niveau de log %s\n", argument);
+    }
+    else if (strcmp(commande, "limite") == 0 && n >= 0)
+    {
+        __atomic_store_n(&logLimite, (unsigned int) n, __ATOMIC_RELAXED);
+        fprintf(f, "limite de log %d par seconde et par ligne\n", n);
+    }
+    else if (strcmp(commande, "admission") == 0 && n >= 0)
+    {
+        __atomic_store_n(&seuilAdmission, n, __ATOMIC_RELAXED);
+        LOG_INFO("Console: seuil d'admission %d", n);
+        fprintf(f, "seuil d'admission %d courrier(s) par groupe\n", n);
+    }
+    else if ((strcmp(commande, "palmares") == 0 || strcmp(commande, "rang") == 0) && fichierClassement == NULL)
+        fprintf(f, "erreur: pas de classement (-R)\n");
+    else if (strcmp(commande, "palmares") == 0)
+        ecrirePalmares(f, rang > 0 ? rang : 1, argument[0] != '\0' ? n : PALMARES_ADMIN_DEFAUT);
+    else if (strcmp(commande, "rang") == 0 && argument[0] != '\0')
+    {
+        if ((rang = classementRang(argument, &fiche)) == 0)
+            fprintf(f, "%s: pas classé\n", argument);
+        else
+            fprintf(f, "%s: rang %lu sur %ld, cote %.1f, %u partie(s), %u victoire(s)\n",
+                    fiche.nom, rang, classementJoueurs(), fiche.elo, fiche.parties, fiche.victoires);
+    }
+    else
+        fprintf(f, "erreur: commandes sessions, table <n>, drainer <g>, rouvrir <g>, log <niveau>, limite <n>, "
+                "admission <n>, palmares [n] [rang], rang <nom>\n");
+}
+
+// Fil de la console: une connexion à la fois, une réponse par ligne reçue
+void *filAdmin(void *arg)
+{
+    int ecoute = (int)(long) arg;
+    struct requeteAdmin r;
+    char ligne[256];
+    char *reponse;
+    size_t taille;
+    FILE *entree, *f;
+    int fd, envoye;
+
+    pthread_mutex_init(&r.verrou, NULL);
+    pthread_cond_init(&r.faite, NULL);
+    while (1)
+    {
+        fd = accept(ecoute, NULL, NULL);
+        if (fd < 0)
+            continue;
+        entree = fdopen(fd, "r");
+        if (entree == NULL)
+        {
+            close(fd);
+            continue;
+        }
+        while (fgets(ligne, sizeof(ligne), entree) != NULL)
+        {
+            reponse = NULL;
+            taille = 0;
+            f = open_memstream(&reponse, &taille);
+            if (f == NULL)
+                break;
+            executerAdmin(ligne, f, &r);
+            fclose(f);
+            envoye = (taille > 0) ? send(fd, reponse, taille, MSG_NOSIGNAL) : 0;
+            free(reponse);
+            if (envoye < 0)
+                break;
+        }
+        fclose(entree);
+    }
+    return NULL;
+}
+
+// Ouvre la socket de la console (remplace une socket existante, accès
+// réservé au propriétaire) et lance son fil
+int servirAdmin(const char *chemin)
+{
+    struct sockaddr_un un;
+    pthread_t fil;
+    int fd;
+
+    if (strlen(chemin) >= sizeof(un.sun_path) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        return -1;
+    memset(&un, 0, sizeof(un));
+    un.sun_family = AF_UNIX;
+    strcpy(un.sun_path, chemin);
+    unlink(chemin);
+    if (bind(fd, (struct sockaddr *) &un, sizeof(un)) < 0 || chmod(chemin, 0600) < 0
+        || listen(fd, 4) < 0 || pthread_create(&fil, NULL, filAdmin, (void *)(long) fd) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    pthread_detach(fil);
+    return fd;
+}
+
+/*******************************************************************************
+ * SECTION 11: RELÈVE PAR UN NOUVEAU PROCESSUS
+ ******************************************************************************/
+
+// Le nouveau serveur se connecte à la socket de relève de l'ancien (-U), qui
+// s'arrête de lire, arrête ses groupes une fois leurs courriers traités et
+// vide le classement, puis lui passe, un message par élément: ses sockets
+// d'écoute (les connexions en attente restent dans la file du noyau, les
+// anneaux partagés gardent leurs messages), les tables en cours, le lobby et
+// les connexions des spectateurs. Les clients ne voient rien: leurs messages
+// suivants arrivent au nouveau processus. L'ancien s'arrête dès l'accord du
+// nouveau; sans accord, il relance ses groupes et continue.
+enum { REL_VERSION, REL_ECOUTE, REL_METRIQUES, REL_TABLE, REL_JOUEUR, REL_SPECTATEURS, REL_FIN, REL_ACCORD };
+
+// Les deux processus doivent s'entendre sur la forme des messages
+struct versionReleve
+{
+    int version;
+    int tailleTable;
+    int tailleJoueur;
+    int nbTables;
+};
+
+struct ecouteRelevee
+{
+    int type;
+    char adresse[108];
+};
+
+// Table en cours: tout l'état de la session (les robots gardent leurs déductions)
+struct tableRelevee
+{
+    int numero;
+    int parties;
+    int nbClients;
+    struct _client clients[NB_JOUEURS];
+    struct partie jeu;
+    struct bot bots[NB_JOUEURS];
+    int toursManques[NB_JOUEURS];
+    int toursJoues[NB_JOUEURS];
+    char cheminJournal[1024];               // "" sans journal
+    long long position;
+    unsigned long long dernier;
+};
+
+struct joueurReleve
+{
+    char nom[LOBBY_NOM];
+    char ip[40];
+    int port;
+    char tag[LOBBY_TAG];
+    int table;                              // LOBBY_EN_ATTENTE: en file, dans l'ordre d'arrivée
+    float elo;
+};
+
+// Ce que le nouveau processus a reçu, repris en deux temps (écoutes, puis le jeu)
+struct releve
+{
+    int fd;                                 // Connexion à l'ancien processus, -1 sans relève
+    struct ecouteRelevee ecoutes[ECOUTES_MAX];
+    int fdsEcoutes[ECOUTES_MAX];
+    int nbEcoutes;
+    int metriques;
+    struct tableRelevee *tables;
+    int nbTables;
+    struct joueurReleve *joueurs;
+    int nbJoueurs;
+    int *spectateurs;                       // Connexions et tables des spectateurs
+    int *tablesSpectateurs;
+    int nbSpectateurs;
+};
+
+int envoyerJoueurReleve(int fd, struct joueurLobby *j)
+{
+    struct joueurReleve r;
+
+    memset(&r, 0, sizeof(r));
+    strcpy(r.nom, j->nom);
+    strcpy(r.ip, j->ip);
+    r.port = j->port;
+    strcpy(r.tag, lobby.files[j->file].tag);
+    r.table = j->table;
+    r.elo = j->elo;
+    return releveEnvoyer(fd, REL_JOUEUR, &r, sizeof(r), NULL, 0);
+}
+
+// Ancien processus (fil principal, plus aucune réception en cours): passe
+// tout au successeur connecté sur fd. Retourne 0 s'il a tout repris (ce
+// processus doit s'arrêter sans rien fermer), -1 s'il faut continuer
+int cederServeur(int fd, struct ecoute *ecoutes, int nbEcoutes)
+{
+    struct versionReleve v;
+    struct ecouteRelevee e;
+    struct tableRelevee t;
+    struct courrier c;
+    struct session *s;
+    struct joueurLobby *j;
+    struct timespec t0, t1;
+    int *fds, *tables, recus[RELEVE_FDS];
+    int i, k, n, ok, type, nbRecus, nbSpectateurs, nbTablesCedees = 0;
+    unsigned int h;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    LOG_INFO("=== RELÈVE PAR UN NOUVEAU PROCESSUS ===");
+
+    // Plus rien ne bouge: chaque groupe traite ses derniers courriers et
+    // s'arrête, les fins de partie en file sont validées dans le classement
+    memset(&c, 0, sizeof(c));
+    c.type = COURRIER_ARRET;
+    for (i=0; i<nbGroupes; i++)
+        posterCourriers(&groupes[i], &c, 1);
+    for (i=0; i<nbGroupes; i++)
+        pthread_join(groupes[i].fil, NULL);
+    if (fichierClassement != NULL)
+        classementVider();
+
+    v.version = RELEVE_VERSION;
+    v.tailleTable = sizeof(struct tableRelevee);
+    v.tailleJoueur = sizeof(struct joueurReleve);
+    v.nbTables = reserve.taille;
+    ok = releveEnvoyer(fd, REL_VERSION, &v, sizeof(v), NULL, 0) == 0;
+
+    // Sockets d'écoute (un anneau partagé se reprend par son chemin)
+    for (i=0; ok && i<nbEcoutes; i++)
+    {
+        memset(&e, 0, sizeof(e));
+        e.type = ecoutes[i].type;
+        strcpy(e.adresse, ecoutes[i].adresse);
+        ok = releveEnvoyer(fd, REL_ECOUTE, &e, sizeof(e), &ecoutes[i].fd, ecoutes[i].type != TRANSPORT_SHM) == 0;
+    }
+    if (ok && socketMetriques >= 0)
+        ok = releveEnvoyer(fd, REL_METRIQUES, NULL, 0, &socketMetriques, 1) == 0;
+
+    // Tables en cours: chacune attend l'action d'un humain (les robots ont joué)
+    for (i=0; ok && i<reserve.taille; i++)
+    {
+        s = &reserve.sessions[i];
+        if (s->fsm != SESSION_EN_JEU)
+            continue;
+        memset(&t, 0, sizeof(t));
+        t.numero = s->numero;
+        t.parties = s->parties;
+        t.nbClients = s->nbClients;
+        memcpy(t.clients, s->tcpClients, sizeof(t.clients));
+        t.jeu = s->jeu;
+        memcpy(t.bots, s->bots, sizeof(t.bots));
+        memcpy(t.toursManques, s->toursManques, sizeof(t.toursManques));
+        memcpy(t.toursJoues, s->toursJoues, sizeof(t.toursJoues));
+        if (s->journal != NULL)
+        {
+            strcpy(t.cheminJournal, s->cheminJournal);
+            t.position = s->journal->position;
+            t.dernier = s->journal->dernier;
+        }
+        ok = releveEnvoyer(fd, REL_TABLE, &t, sizeof(t), NULL, 0) == 0;
+        nbTablesCedees++;
+    }
+
+    // Lobby: joueurs en attente dans l'ordre de leur file, puis joueurs assis
+    for (k=0; ok && k<lobby.nbFiles; k++)
+        for (j = lobby.files[k].tete; ok && j != NULL; j = j->suivant)
+            ok = envoyerJoueurReleve(fd, j) == 0;
+    for (h=0; ok && h<=lobby.masque; h++)
+        if ((j = lobby.index[h]) != NULL && j->table != LOBBY_EN_ATTENTE)
+            ok = envoyerJoueurReleve(fd, j) == 0;
+
+    // Spectateurs: RELEVE_FDS connexions par message
+    n = diffusionSpectateurs() + 1;
+    fds = malloc(n * sizeof(int));
+    tables = malloc(n * sizeof(int));
+    nbSpectateurs = (fds != NULL && tables != NULL) ? diffusionCeder(fds, tables, n) : 0;
+    for (k=0; ok && k<nbSpectateurs; k+=RELEVE_FDS)
+    {
+        n = (nbSpectateurs - k < RELEVE_FDS) ? nbSpectateurs - k : RELEVE_FDS;
+        ok = releveEnvoyer(fd, REL_SPECTATEURS, tables + k, n * sizeof(int), fds + k, n) == 0;
+    }
+    free(fds);
+    free(tables);
+
+    if (ok)
+        ok = releveEnvoyer(fd, REL_FIN, NULL, 0, NULL, 0) == 0;
+    if (ok && releveRecevoir(fd, &type, &v, sizeof(v), recus, &nbRecus, RELEVE_DELAI_MS) >= 0
+        && type == REL_ACCORD)
+    {
+        close(fd);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        LOG_INFO("Relève acceptée: %d table(s), %d joueur(s), %d spectateur(s) cédés en %.1f ms",
+                 nbTablesCedees, lobby.nb, nbSpectateurs,
+                 (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+        return 0;
+    }
+
+    // Successeur parti ou incompatible: ce processus reprend là où il s'était arrêté
+    close(fd);
+    LOG_ERREUR("Relève interrompue, le serveur continue");
+    diffusionReprendre();
+    demarrerGroupes();
+    return -1;
+}
+
+// Nouveau processus: reçoit tout ce que l'ancien lui passe
+// Retourne -1 si l'ancien processus est incompatible ou disparaît en route
+int recevoirReleve(struct releve *r)
+{
+    struct versionReleve v;
+    char donnees[RELEVE_MESSAGE];
+    int fds[RELEVE_FDS];
+    int type, n, nbFds, i, capaciteJoueurs = 0, capaciteSpectateurs = 0;
+    void *p;
+
+    n = releveRecevoir(r->fd, &type, &v, sizeof(v), fds, &nbFds, RELEVE_DELAI_MS);
+    if (n != sizeof(v) || type != REL_VERSION || v.version != RELEVE_VERSION
+        || v.tailleTable != sizeof(struct tableRelevee) || v.tailleJoueur != sizeof(struct joueurReleve))
+    {
+        LOG_ERREUR("Relève impossible: serveur en place incompatible");
+        return -1;
+    }
+    r->tables = calloc(v.nbTables, sizeof(struct tableRelevee));
+    if (r->tables == NULL)
+        return -1;
+
+    while ((n = releveRecevoir(r->fd, &type, donnees, sizeof(donnees), fds, &nbFds, RELEVE_DELAI_MS)) >= 0)
+    {
+        switch (type)
+        {
+            case REL_ECOUTE:
+                if (r->nbEcoutes == ECOUTES_MAX)
+                    break;
+                memcpy(&r->ecoutes[r->nbEcoutes], donnees, sizeof(struct ecouteRelevee));
+                r->fdsEcoutes[r->nbEcoutes++] = (nbFds > 0) ? fds[0] : -1;
+                nbFds = 0;
+                break;
+
+            case REL_METRIQUES:
+                r->metriques = (nbFds > 0) ? fds[0] : -1;
+                nbFds = 0;
+                break;
+
+            case REL_TABLE:
+                if (r->nbTables < v.nbTables)
+                    memcpy(&r->tables[r->nbTables++], donnees, sizeof(struct tableRelevee));
+                break;
+
+            case REL_JOUEUR:
+                if (r->nbJoueurs == capaciteJoueurs)
+                {
+                    capaciteJoueurs = capaciteJoueurs ? 2 * capaciteJoueurs : 1024;
+                    p = realloc(r->joueurs, capaciteJoueurs * sizeof(struct joueurReleve));
+                    if (p == NULL)
+                        return -1;
+                    r->joueurs = p;
+                }
+                memcpy(&r->joueurs[r->nbJoueurs++], donnees, sizeof(struct joueurReleve));
+                break;
+
+            case REL_SPECTATEURS:
+                if (r->nbSpectateurs + nbFds > capaciteSpectateurs)
+                {
+                    capaciteSpectateurs = 2 * capaciteSpectateurs + RELEVE_FDS;
+                    r->spectateurs = realloc(r->spectateurs, capaciteSpectateurs * sizeof(int));
+                    r->tablesSpectateurs = realloc(r->tablesSpectateurs, capaciteSpectateurs * sizeof(int));
+                    if (r->spectateurs == NULL || r->tablesSpectateurs == NULL)
+                        return -1;
+                }
+                for (i=0; i<nbFds && i < n / (int) sizeof(int); i++)
+                {
+                    r->spectateurs[r->nbSpectateurs] = fds[i];
+                    r->tablesSpectateurs[r->nbSpectateurs++] = ((int *) donnees)[i];
+                }
+                nbFds = 0;
+                break;
+
+            case REL_FIN:
+                return 0;
+        }
+        // Descripteurs d'un message inattendu
+        while (nbFds > 0)
+            close(fds[--nbFds]);
+    }
+    LOG_ERREUR("Relève impossible: le serveur en place ne répond plus");
+    return -1;
+}
+
+// Nouveau processus: sort de la relève l'écoute de cette adresse, -1 si
+// l'ancien processus n'y écoutait pas
+int reprendreEcoute(struct releve *r, struct ecoute *e, const char *adresse, int file)
+{
+    int i, fd;
+
+    for (i=0; i<r->nbEcoutes; i++)
+        if (r->ecoutes[i].adresse[0] != '\0' && strcmp(r->ecoutes[i].adresse, adresse) == 0)
+        {
+            fd = r->fdsEcoutes[i];
+            r->ecoutes[i].adresse[0] = '\0';
+            return transportReprendre(e, adresse, fd, file);
+        }
+    return -1;
+}
+
+// Nouveau processus (avant le lancement des groupes): reprend les tables aux
+// mêmes numéros, le lobby et les spectateurs. Chaque table repart du coup
+// attendu (le délai de tour repart de zéro)
+void reprendreReleve(struct releve *r)
+{
+    struct tableRelevee *t;
+    struct joueurReleve *jr;
+    struct joueurLobby *j;
+    struct declencheur d;
+    struct session *s;
+    char reply[256];
+    int i, reprises = 0;
+
+    // Écoutes de l'ancien processus que celui-ci ne reprend pas
+    for (i=0; i<r->nbEcoutes; i++)
+        if (r->ecoutes[i].adresse[0] != '\0')
+        {
+            LOG_AVERT("Adresse %s abandonnée (absente de la ligne de commande)", r->ecoutes[i].adresse);
+            if (r->fdsEcoutes[i] >= 0)
+                close(r->fdsEcoutes[i]);
+        }
+
+    for (i=0; i<r->nbTables; i++)
+    {
+        t = &r->tables[i];
+        s = sessionPrendreNumero(&reserve, t->numero);
+        if (s == NULL)
+        {
+            LOG_ERREUR("Table %d hors de la réserve (-n %d), partie perdue", t->numero, nbTables);
+            continue;
+        }
+        s->parties = t->parties;
+        s->nbClients = t->nbClients;
+        memcpy(s->tcpClients, t->clients, sizeof(t->clients));
+        s->jeu = t->jeu;
+        memcpy(s->bots, t->bots, sizeof(t->bots));
+        memcpy(s->toursManques, t->toursManques, sizeof(t->toursManques));
+        memcpy(s->toursJoues, t->toursJoues, sizeof(t->toursJoues));
+        s->fsm = SESSION_EN_JEU;
+        s->reprise = 1;
+
+        // Journal repris à la fin de ce que l'ancien processus y a écrit
+        if (t->cheminJournal[0] != '\0' && dossierJournal != NULL)
+        {
+            strcpy(s->cheminJournal, t->cheminJournal);
+            if (journalRouvrir(&s->stockageJournal, s->cheminJournal, t->position, t->dernier) < 0)
+                error("ERROR reopening journal");
+            s->journal = &s->stockageJournal;
+            sauverPointReprise(s);
+        }
+
+        // Instantané des spectateurs avant l'arrivée de leurs connexions
+        sprintf(reply, "L %s %s %s %s",
+               s->tcpClients[0].name, s->tcpClients[1].name, s->tcpClients[2].name, s->tcpClients[3].name);
+        diffusionPublier(s->numero, reply);
+        sprintf(reply, "M %d", s->jeu.joueurCourant);
+        diffusionPublier(s->numero, reply);
+
+        d.type = DECL_REPRISE;
+        deroulerTable(s, &d);
+        viderJournal(s);
+        reprises++;
+    }
+
+    // Lobby: les files gardent leur ordre, les joueurs assis leur table
+    for (i=0; i<r->nbJoueurs; i++)
+    {
+        jr = &r->joueurs[i];
+        j = lobbyAjouter(&lobby, jr->nom, jr->ip, jr->port, jr->tag);
+        if (j == NULL)
+        {
+            LOG_AVERT("Lobby plein, joueur %s perdu", jr->nom);
+            continue;
+        }
+        j->elo = jr->elo;
+        if (jr->table != LOBBY_EN_ATTENTE && jr->table < reserve.taille
+            && reserve.sessions[jr->table].fsm == SESSION_EN_JEU)
+            lobbyAsseoir(&lobby, j, jr->table);
+        else if (delaiInactivite > 0)
+            rouePlanifier(&roueLobby, &j->inactivite, horlogeTicks() + delaiInactivite * (1000 / MINUTERIE_TICK_MS));
+    }
+
+    for (i=0; i<r->nbSpectateurs; i++)
+        if (diffusionAdopter(r->spectateurs[i], r->tablesSpectateurs[i]) < 0)
+            close(r->spectateurs[i]);
+
+    LOG_INFO("Relève: %d table(s), %d joueur(s), %d spectateur(s) repris", reprises, r->nbJoueurs,
+             r->nbSpectateurs);
+    free(r->tables);
+    free(r->joueurs);
+    free(r->spectateurs);
+    free(r->tablesSpectateurs);
+}
+
+// Nouveau processus, tout est repris: l'ancien s'arrête (fin de la connexion),
+// puis celui-ci attend à son tour un successeur
+void terminerReleve(struct releve *r)
+{
+    int fds[RELEVE_FDS], type, nbFds;
+    char rien[16];
+
+    if (r->fd >= 0)
+    {
+        if (releveEnvoyer(r->fd, REL_ACCORD, NULL, 0, NULL, 0) < 0)
+            error("ERROR on takeover");
+        while (releveRecevoir(r->fd, &type, rien, sizeof(rien), fds, &nbFds, RELEVE_DELAI_MS) >= 0)
+            ;
+        close(r->fd);
+        r->fd = -1;
+    }
+    if (cheminReleve != NULL && (socketReleve = releveEcouter(cheminReleve)) < 0)
+        error("ERROR on binding takeover socket");
+}
+
+// Un successeur s'est connecté à la socket de relève: s'il reprend tout, ce
+// processus s'arrête (le logger écrit ce qui reste)
+void accueillirSuccesseur(int fd, struct ecoute *ecoutes, int nbEcoutes)
+{
+    if (cederServeur(fd, ecoutes, nbEcoutes) == 0)
+        exit(0);
+}
+
+/*******************************************************************************
+ * SECTION 12: BACKEND IO_URING
+ ******************************************************************************/
+
+enum { EV_ACCEPT, EV_RECEPTION, EV_FERMETURE, EV_ANNEAU, EV_REVEIL, EV_RELEVE, EV_ANNULATION };
+#define EVENEMENT(type, n)  (((unsigned long long)(type) << 32) | (unsigned int)(n))
+
+// Envoie le lot du fil en un io_uring_enter et attend qu'il soit parti
+// Chaque message est une chaîne socket -> connect -> send -> close sur un
+// descripteur direct; les messages d'un même destinataire se suivent dans une
+// seule chaîne (liens durs: une erreur ne rompt pas la chaîne, le descripteur
+// est toujours refermé), les destinataires différents partent en parallèle
+void envoyerLot()
+{
+    struct envois *e = envoisFil;
+    struct io_uring_sqe *sqe = NULL;
+    struct io_uring_cqe *cqe;
+    long appels;
+    int i, j, fentes = 0, total = 0, vus = 0, op;
+
+    if (e == NULL || e->nb == 0)
+        return;
+    SONDE1(lot_debut, e->nb);
+    for (i=0; i<e->nb; i++)
+        e->lot[i].fente = -1;
+
+    for (i=0; i<e->nb; i++)
+    {
+        if (e->lot[i].fente >= 0)
+            continue;
+        for (j=i; j<e->nb; j++)
+        {
+            if (e->lot[j].fente >= 0
+                || memcmp(&e->lot[j].adresse, &e->lot[i].adresse, sizeof(struct sockaddr_in)) != 0)
+                continue;
+            e->lot[j].fente = fentes;
+
+            sqe = uringSqe(&e->u);
+            sqe->opcode = IORING_OP_SOCKET;
+            sqe->fd = AF_INET;
+            sqe->off = SOCK_STREAM;
+            sqe->file_index = fentes + 1;
+            sqe->flags = IOSQE_IO_HARDLINK;
+            sqe->user_data = j * 4 + 0;
+
+            sqe = uringSqe(&e->u);
+            sqe->opcode = IORING_OP_CONNECT;
+            sqe->fd = fentes;
+            sqe->addr = (unsigned long) &e->lot[j].adresse;
+            sqe->off = sizeof(struct sockaddr_in);
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->user_data = j * 4 + 1;
+
+            sqe = uringSqe(&e->u);
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fentes;
+            sqe->addr = (unsigned long) e->lot[j].texte;
+            sqe->len = e->lot[j].longueur;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->user_data = j * 4 + 2;
+
+            sqe = uringSqe(&e->u);
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->file_index = fentes + 1;
+            sqe->flags = IOSQE_IO_HARDLINK;
+            sqe->user_data = j * 4 + 3;
+            total += 4;
+        }
+        // Fin de la chaîne du destinataire
+        sqe->flags &= ~IOSQE_IO_HARDLINK;
+        fentes++;
+    }
+
+    appels = e->u.appels;
+    while (vus < total)
+    {
+        if (uringSoumettre(&e->u, total - vus, -1) < 0)
+            error("ERROR on io_uring_enter");
+        while ((cqe = uringCqe(&e->u)) != NULL)
+        {
+            j = cqe->user_data / 4;
+            op = cqe->user_data % 4;
+            if (op == 1 && cqe->res < 0)
+            {
+                LOG_AVERT("ERROR connecting %s:%d", inet_ntoa(e->lot[j].adresse.sin_addr),
+                          ntohs(e->lot[j].adresse.sin_port));
+                metriquesCompte(MET_ECHECS_CONNEXION, 1);
+            }
+            else if (op == 2 && cqe->res > 0)
+            {
+                metriquesCompte(MET_MESSAGES_ENVOYES, 1);
+                metriquesCompte(MET_OCTETS_ENVOYES, cqe->res);
+            }
+            uringVu(&e->u);
+            vus++;
+        }
+    }
+    metriquesCompte(MET_APPELS_RESEAU, e->u.appels - appels);
+    SONDE2(lot_fin, e->nb, e->u.appels - appels);
+    e->nb = 0;
+}
+
+static void armerAccept(struct uring *u, int fd, int i)
+{
+    struct io_uring_sqe *sqe = uringSqe(u);
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = EVENEMENT(EV_ACCEPT, i);
+}
+
+static void armerReception(struct uring *u, int fd)
+{
+    struct io_uring_sqe *sqe = uringSqe(u);
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = EVENEMENT(EV_RECEPTION, fd);
+}
+
+static void armerPoll(struct uring *u, int fd, int type, int i)
+{
+    struct io_uring_sqe *sqe = uringSqe(u);
 
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = EVENEMENT(type, i);
+}
+
+// Relève: plus d'accept multishot (ceux en cours sont annulés)
+static void annulerAccepts(struct uring *u, struct ecoute *ecoutes, int nbEcoutes)
+{
+    struct io_uring_sqe *sqe;
+    int i;
+
+    for (i=0; i<nbEcoutes; i++)
+        if (ecoutes[i].type != TRANSPORT_SHM)
+        {
+            sqe = uringSqe(u);
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = EVENEMENT(EV_ACCEPT, i);
+            sqe->user_data = EVENEMENT(EV_ANNULATION, i);
         }
-        // Joueur suivant
-        joueurCourant = (joueurCourant + 1) % 4;
-        if (joueurPerdu(joueurCourant))
-            joueurCourant = (joueurCourant + 1) % 4;
-        sprintf(reply, "M %d", joueurCourant);
-        broadcastMessage(reply);
-        /* break; */
 }
+
+// Boucle du fil principal avec io_uring: accept multishot sur chaque socket
+// d'écoute, réception multishot de chaque connexion dans les tampons fournis,
+// fermeture par l'anneau. Un io_uring_enter par tour de boucle soumet tout ce
+// que le tour précédent a préparé et attend les complétions suivantes
+// Relève: les connexions déjà acceptées sont lues avant de céder les écoutes
+// (les suivantes attendent le successeur dans la file du noyau)
+void servirUring(struct ecoute *ecoutes, int nbEcoutes)
+{
+    struct uring u;
+    struct uringTampons tampons;
+    struct io_uring_cqe *cqe;
+    struct io_uring_sqe *sqe;
+    struct rlimit limite;
+    unsigned char *attendu;             // Connexion dont le message reste à lire: écoute + 1
+    char buffer[256], origine[128];
+    struct sockaddr_in pair;
+    socklen_t lg;
+    unsigned int nbFd, id, drapeaux;
+    int i, type, n, res, delai, reveil;
+    int accepts = 0, enCours = 0;       // Accept multishot armés, connexions à lire
+    int successeur = -1;                // Relève demandée: connexion du successeur
+    unsigned long echeance = 0;         // Tick où la relève n'attend plus les messages en cours
+    long appels;
+
+    if (uringInit(&u, 1024) < 0 || uringTamponsInit(&u, &tampons, 0, URING_TAMPONS, 256) < 0)
+        error("ERROR initializing io_uring");
+    getrlimit(RLIMIT_NOFILE, &limite);
+    nbFd = (limite.rlim_cur < (1u << 20)) ? limite.rlim_cur : (1u << 20);
+    attendu = calloc(nbFd, 1);
+    if (attendu == NULL)
+        error("ERROR allocating io_uring state");
+
+    for (i=0; i<nbEcoutes; i++)
+        if (ecoutes[i].type == TRANSPORT_SHM)
+            armerPoll(&u, ecoutes[i].fd, EV_ANNEAU, i);
+        else
+        {
+            armerAccept(&u, ecoutes[i].fd, i);
+            accepts++;
+        }
+    armerPoll(&u, reveilLobby[0], EV_REVEIL, 0);
+    if (socketReleve >= 0)
+        armerPoll(&u, socketReleve, EV_RELEVE, 0);
+
+    while (1)
+    {
+        delai = (roueLobby.nb > 0 || successeur >= 0) ? MINUTERIE_TICK_MS : -1;
+        for (i=0; i<nbEcoutes; i++)
+            if (transportPret(&ecoutes[i]))
+                delai = 0;
+        appels = u.appels;
+        if (uringSoumettre(&u, delai == 0 ? 0 : 1, delai) < 0)
+            error("ERROR on io_uring_enter");
+
+        reveil = 0;
+        while ((cqe = uringCqe(&u)) != NULL)
+        {
+            type = cqe->user_data >> 32;
+            n = (int)(cqe->user_data & 0xffffffffu);
+            res = cqe->res;
+            drapeaux = cqe->flags;
+            uringVu(&u);
+
+            switch (type)
+            {
+                // Nouvelle connexion: un message à lire
+                case EV_ACCEPT:
+                    if (res >= 0)
+                        SONDE2(connexion_acceptee, res, ecoutes[n].fd);
+                    if (res >= 0 && (unsigned int) res < nbFd)
+                    {
+                        attendu[res] = n + 1;
+                        enCours++;
+                        armerReception(&u, res);
+                    }
+                    else if (res >= 0)
+                        close(res);
+                    if (!(drapeaux & IORING_CQE_F_MORE))
+                    {
+                        if (successeur < 0)
+                            armerAccept(&u, ecoutes[n].fd, n);
+                        else
+                            accepts--;
+                    }
+                    break;
+
+                // Le premier segment est le message (comme le read du backend poll)
+                case EV_RECEPTION:
+                    if (res > 0 && (drapeaux & IORING_CQE_F_BUFFER))
+                    {
+                        id = drapeaux >> IORING_CQE_BUFFER_SHIFT;
+                        if (attendu[n])
+                        {
+                            i = attendu[n] - 1;
+                            attendu[n] = 0;
+                            enCours--;
+                            res = (res < 255) ? res : 255;
+                            memcpy(buffer, uringTampon(&tampons, id), res);
+                            buffer[res] = '\0';
+                            // Adresse de l'expéditeur pour le limiteur (-d): un
+                            // appel de plus, seulement s'il est actif
+                            lg = sizeof(pair);
+                            if (limiteAdresse.debit > 0 && ecoutes[i].type == TRANSPORT_TCP
+                                && getpeername(n, (struct sockaddr *) &pair, &lg) == 0)
+                                snprintf(origine, sizeof(origine), "%s:%d", inet_ntoa(pair.sin_addr), ntohs(pair.sin_port));
+                            else
+                                snprintf(origine, sizeof(origine), "%s", ecoutes[i].adresse);
+                            aiguillerMessage(buffer, res, origine);
+                        }
+                        uringRendre(&tampons, id);
+                    }
+                    if (!(drapeaux & IORING_CQE_F_MORE))
+                    {
+                        if (res == -ENOBUFS && attendu[n])
+                            armerReception(&u, n);
+                        else
+                        {
+                            if (attendu[n])
+                            {
+                                attendu[n] = 0;
+                                enCours--;
+                            }
+                            SONDE1(connexion_fermee, n);
+                            sqe = uringSqe(&u);
+                            sqe->opcode = IORING_OP_CLOSE;
+                            sqe->fd = n;
+                            sqe->user_data = EVENEMENT(EV_FERMETURE, n);
+                        }
+                    }
+                    break;
+
+                case EV_ANNEAU:
+                    if (!(drapeaux & IORING_CQE_F_MORE))
+                        armerPoll(&u, ecoutes[n].fd, EV_ANNEAU, n);
+                    break;
+
+                case EV_REVEIL:
+                    reveil = 1;
+                    if (!(drapeaux & IORING_CQE_F_MORE))
+                        armerPoll(&u, reveilLobby[0], EV_REVEIL, 0);
+                    break;
+
+                // Un successeur se présente: plus de nouvelles connexions
+                case EV_RELEVE:
+                    if (!(drapeaux & IORING_CQE_F_MORE))
+                        armerPoll(&u, socketReleve, EV_RELEVE, 0);
+                    if (successeur < 0 && (successeur = accept(socketReleve, NULL, NULL)) >= 0)
+                    {
+                        annulerAccepts(&u, ecoutes, nbEcoutes);
+                        echeance = horlogeTicks() + RELEVE_ATTENTE_MS / MINUTERIE_TICK_MS;
+                    }
+                    break;
+            }
+        }
+
+        servirLobby(reveil);
+        for (i=0; i<nbEcoutes; i++)
+            if (ecoutes[i].type == TRANSPORT_SHM)
+                lireAnneau(&ecoutes[i]);
+        metriquesCompte(MET_APPELS_RESEAU, u.appels - appels + reveil);
+
+        // Accepts annulés et messages reçus (ou attendus assez longtemps):
+        // relève; si elle échoue, les accepts sont réarmés
+        if (successeur >= 0 && accepts == 0 && (enCours == 0 || horlogeTicks() > echeance))
+        {
+            accueillirSuccesseur(successeur, ecoutes, nbEcoutes);
+            successeur = -1;
+            for (i=0; i<nbEcoutes; i++)
+                if (ecoutes[i].type != TRANSPORT_SHM)
+                {
+                    armerAccept(&u, ecoutes[i].fd, i);
+                    accepts++;
+                }
+        }
+    }
 }
+
+/*******************************************************************************
+ * SECTION 13: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    /***************************************************************************
+     * SOUS-SECTION 13.1: DÉCLARATION DES VARIABLES
+     ***************************************************************************/
+
+    // Variables pour les adresses d'écoute
+    struct ecoute ecoutes[ECOUTES_MAX];          // Port TCP, socket Unix, anneau partagé
+    int nbEcoutes = 0;
+    int portno = 0;                              // Port TCP (nom des journaux)
+    char buffer[256];                            // Buffer pour la réception de messages
+    char origine[128];                           // Émetteur du message (ip:port ou adresse locale)
+    int n;                                       // Résultat des opérations de lecture
+    int opt;                                     // Option de la ligne de commande
+    int delai;                                   // Attente maximale de poll (ms)
+    char chemin[600];                            // Dossier des parties en cours
+    int niveauLog = LOG_NIV_INFO;                // Niveau de log (-l)
+    unsigned int limiteLog = 1000;               // Messages par seconde et par ligne de log (-L)
+    char *adresseMetriques = NULL;               // Exposition des métriques (-m)
+    struct pollfd attente[ECOUTES_MAX + 2];      // Adresses d'écoute, réveil du lobby et relève
+    struct releve releve;                        // Ce que passe le serveur relevé (-U)
+    int i;
+
+    /***************************************************************************
+     * SOUS-SECTION 13.2: VÉRIFICATION DES ARGUMENTS
+     ***************************************************************************/
+
+    // Option -A <chemin>: console d'administration sur une socket Unix
+    // Option -b <n>: n places (0 à 3) sont tenues par des robots du serveur
+    // Option -B <poll|io_uring>: backend réseau (défaut: poll)
+    // Option -d <n>[:rafale]: au plus n messages par seconde par adresse IP (défaut: sans limite)
+    // Option -p <n>[:rafale]: au plus n actions par seconde par place d'une table (défaut: sans limite)
+    // Option -Q <n>: nouveaux joueurs refusés dès qu'un groupe a n courriers en attente (défaut: 0, toujours admis)
+    // Option -j <dossier>: journal binaire de la partie dans ce dossier
+    // Option -l <niveau>: debug, info, avert ou erreur (défaut: info)
+    // Option -L <n>: au plus n messages par seconde et par ligne de log (0 = sans limite)
+    // Option -m <port|unix:chemin>: métriques Prometheus sur 127.0.0.1:port ou une socket Unix
+    // Option -T <s>: délai pour jouer avant que le tour passe (défaut: 60, 0 = sans limite)
+    // Option -U <chemin>: relève sans interruption par socket Unix (reprend le serveur qui y écoute)
+    // Option -F <n>: délais dépassés d'affilée avant l'élimination du joueur (défaut: 2)
+    // Option -I <s>: joueur oublié par le lobby après s secondes sans nouvelles en attente (défaut: 300, 0 = jamais)
+    // Option -n <n>: n tables jouées en même temps (défaut: 64)
+    // Option -S <n>: n fils se partagent les tables (défaut: 1)
+    // Option -q: les spectateurs reçoivent les réponses aux questions statistiques
+    // Option -r: à la fin d'une partie, nouvelle donne pour les mêmes joueurs
+    // Option -s <graine>: graine du mélange (par défaut: heure et pid)
+    graine = time(NULL) ^ (getpid() << 16);
+    while ((opt = getopt(argc, argv, "A:b:B:d:F:I:j:l:L:m:n:p:qQ:rR:s:S:T:U:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'A':
+                cheminAdmin = optarg;
+                break;
+            case 'b':
+                nbBots = atoi(optarg);
+                break;
+            case 'B':
+                if (strcmp(optarg, "io_uring") == 0)
+                    backendUring = 1;
+                else if (strcmp(optarg, "poll") != 0)
+                {
+                    fprintf(stderr, "ERROR, backend must be poll or io_uring\n");
+                    exit(1);
+                }
+                break;
+            case 'd':
+            case 'p':
+                if (limiteurLire(opt == 'd' ? &limiteAdresse : &limitePlace, optarg) < 0)
+                {
+                    fprintf(stderr, "ERROR, rate must be <n>[:<burst>] with a positive burst\n");
+                    exit(1);
+                }
+                break;
+            case 'F':
+                toursAvantForfait = atoi(optarg);
+                break;
+            case 'I':
+                delaiInactivite = atoi(optarg);
+                break;
+            case 'j':
+                dossierJournal = optarg;
+                break;
+            case 'l':
+                niveauLog = logNiveauDepuis(optarg);
+                if (niveauLog < 0)
+                {
+                    fprintf(stderr, "ERROR, log level must be debug, info, avert or erreur\n");
+                    exit(1);
+                }
+                break;
+            case 'L':
+                limiteLog = strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                adresseMetriques = optarg;
+                break;
+            case 'n':
+                nbTables = atoi(optarg);
+                break;
+            case 'q':
+                questionsPubliques = 1;
+                break;
+            case 'Q':
+                seuilAdmission = atoi(optarg);
+                break;
+            case 'r':
+                revanche = 1;
+                break;
+            case 'R':
+                fichierClassement = optarg;
+                break;
+            case 's':
+                graine = strtoul(optarg, NULL, 0);
+                break;
+            case 'S':
+                nbGroupes = atoi(optarg);
+                break;
+            case 'T':
+                delaiTour = atoi(optarg);
+                break;
+            case 'U':
+                cheminReleve = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-A admin] [-b nbRobots] [-B backend] [-d debitAdresse] [-F forfait] [-I inactivite] [-j dossierJournal] [-l niveau] [-L limite] [-m metriques] [-n tables] [-p debitPlace] [-q] [-Q admission] [-r] [-R classement] [-s graine] [-S groupes] [-T delaiTour] [-U releve] <port|unix:chemin|shm:chemin>...\n", argv[0]);
+                exit(1);
+        }
+    }
+
+    // Vérifie qu'un numéro de port a été fourni en argument de ligne de commande
+    if (optind >= argc) {
+        fprintf(stderr, "ERROR, no port provided\n");
+        fprintf(stderr, "Usage: %s [-A admin] [-b nbRobots] [-B backend] [-d debitAdresse] [-F forfait] [-I inactivite] [-j dossierJournal] [-l niveau] [-L limite] [-m metriques] [-n tables] [-p debitPlace] [-q] [-Q admission] [-r] [-R classement] [-s graine] [-S groupes] [-T delaiTour] [-U releve] <port|unix:chemin|shm:chemin>...\n", argv[0]);
+        exit(1);
+    }
+
+    // Au moins un humain doit se connecter pour que la partie ait un intérêt
+    if (nbBots < 0 || nbBots > 3) {
+        fprintf(stderr, "ERROR, nbRobots must be between 0 and 3\n");
+        exit(1);
+    }
+    if (nbTables < 1 || nbGroupes < 1 || nbGroupes > GROUPES_MAX) {
+        fprintf(stderr, "ERROR, tables must be positive and groups between 1 and %d\n", GROUPES_MAX);
+        exit(1);
+    }
+
+    /***************************************************************************
+     * SOUS-SECTION 13.3: INITIALISATION DU JEU
+     ***************************************************************************/
+    
+    logInit(stdout, niveauLog, limiteLog);
+    LOG_INFO("=== INITIALISATION DU JEU SHERLOCK 13 ===");
+
+    // Alloue les tables et le lobby une fois pour toutes
+    // Chaque groupe a sa roue, sa graine et sa file de courriers
+    if (reserveInit(&reserve, nbTables, NULL) < 0
+        || lobbyInit(&lobby, NB_JOUEURS * nbTables + LOBBY_ATTENTE_MAX, NB_JOUEURS - nbBots, attenteExpiree) < 0)
+        error("ERROR allocating sessions");
+    if (diffusionInit(nbTables) < 0)
+        error("ERROR allocating spectator rings");
+    if (limitePlace.debit > 0 && (seauxPlaces = calloc(nbTables * NB_JOUEURS, sizeof(struct seau))) == NULL)
+        error("ERROR allocating rate limiters");
+    if (limiteAdresse.debit > 0 && tableSeauxInit(&seauxAdresses, LIMITEUR_ADRESSES) < 0)
+        error("ERROR allocating rate limiters");
+    roueInit(&roueLobby, horlogeTicks());
+    if (pipe(reveilLobby) < 0)
+        error("ERROR creating pipe");
+    fcntl(reveilLobby[0], F_SETFL, O_NONBLOCK);
+    fcntl(reveilLobby[1], F_SETFL, O_NONBLOCK);
+    groupes = calloc(nbGroupes, sizeof(struct groupe));
+    if (groupes == NULL)
+        error("ERROR allocating groups");
+    for (i=0; i<nbGroupes; i++)
+    {
+        groupes[i].numero = i;
+        groupes[i].graine = graine + i;
+        groupes[i].file = calloc(COURRIER_FILE, sizeof(struct courrier));
+        if (groupes[i].file == NULL || pipe(groupes[i].reveil) < 0)
+            error("ERROR allocating groups");
+        fcntl(groupes[i].reveil[0], F_SETFL, O_NONBLOCK);
+        fcntl(groupes[i].reveil[1], F_SETFL, O_NONBLOCK);
+        pthread_mutex_init(&groupes[i].verrou, NULL);
+        pthread_cond_init(&groupes[i].place, NULL);
+        roueInit(&groupes[i].roue, horlogeTicks());
+    }
+    for (i=0; i<reserve.taille; i++)
+    {
+        reserve.sessions[i].roue = &GROUPE(&reserve.sessions[i])->roue;
+        minuterieInit(&reserve.sessions[i].delaiTour, tourExpire, &reserve.sessions[i], 0);
+    }
+    LOG_INFO("%d tables, %d groupe(s), graine %u, backend %s", nbTables, nbGroupes, graine,
+             backendUring ? "io_uring" : "poll");
+
+    /***************************************************************************
+     * SOUS-SECTION 13.4: ADRESSES D'ÉCOUTE ET REPRISE DES PARTIES
+     ***************************************************************************/
+
+    // Relève (-U): si un serveur écoute déjà sur ce chemin, il s'arrête de
+    // lire et passe tout à celui-ci, sockets d'écoute comprises (une fois
+    // tout alloué: la pause des joueurs ne dure que le temps de la reprise)
+    memset(&releve, 0, sizeof(releve));
+    releve.fd = (cheminReleve != NULL) ? releveConnecter(cheminReleve) : -1;
+    releve.metriques = -1;
+    if (releve.fd >= 0 && recevoirReleve(&releve) < 0)
+        exit(1);
+
+    // Chaque argument est une adresse: un port TCP (toutes les interfaces),
+    // unix:<chemin> ou shm:<chemin> pour les joueurs et robots de la machine.
+    // La file d'attente TCP absorbe les rafales de 'C' (une connexion refusée
+    // coûte au client une seconde de retransmission)
+    for (; optind < argc && nbEcoutes < ECOUTES_MAX; optind++)
+    {
+        if (transportType(argv[optind]) == TRANSPORT_TCP && portno == 0)
+            portno = atoi(argv[optind]);
+        n = transportType(argv[optind]) == TRANSPORT_SHM ? ANNEAU_SERVEUR : SOMAXCONN;
+        if (reprendreEcoute(&releve, &ecoutes[nbEcoutes], argv[optind], n) < 0
+            && transportEcouter(&ecoutes[nbEcoutes], argv[optind], atoi(argv[optind]), n) < 0)
+            error("ERROR on binding");
+        if (ecoutes[nbEcoutes].type == TRANSPORT_TCP && socketEcoute < 0)
+            socketEcoute = ecoutes[nbEcoutes].fd;
+        nbEcoutes++;
+    }
+    portServeur = portno;
+
+    // Classement: rejoue son journal avant la première fin de partie
+    if (fichierClassement != NULL && classementOuvrir(fichierClassement) < 0)
+        error("ERROR opening ratings store");
+
+    // Reprend les parties du serveur relevé, ou celles laissées en cours par
+    // un arrêt du serveur sur ce port
+    if (dossierJournal != NULL)
+    {
+        sprintf(chemin, "%s/" REPRISE_DOSSIER, dossierJournal);
+        mkdir(chemin, 0755);
+    }
+    if (releve.fd >= 0)
+        reprendreReleve(&releve);
+    else if (dossierJournal != NULL)
+        reprendreParties(portno);
+
+    // Le serveur relevé s'arrête; celui-ci attend à son tour un successeur
+    terminerReleve(&releve);
+
+    // Les groupes ne démarrent qu'après la reprise (seul le fil principal a touché aux tables)
+    demarrerGroupes();
+    
+    // Métriques: compteurs du fil principal et jauges lues à la demande
+    if (adresseMetriques != NULL)
+    {
+        metriquesJauge("sh13_active_sessions", "gauge", "Sessions prises dans la réserve", jaugeSessions);
+        metriquesJauge("sh13_spectators", "gauge", "Spectateurs connectés", diffusionSpectateurs);
+        metriquesJauge("sh13_lobby_waiting", "gauge", "Joueurs en attente d'une table dans le lobby", jaugeAttente);
+        if (fichierClassement != NULL)
+            metriquesJauge("sh13_rated_players", "gauge", "Joueurs du classement sur disque", classementJoueurs);
+        if (socketEcoute >= 0)
+            metriquesJauge("sh13_accept_queue", "gauge", "Connexions en attente d'accept", jaugeFileAccept);
+        metriquesJauge("sh13_log_queue_bytes", "gauge", "Octets en attente dans les anneaux du logger", jaugeFileLog);
+        metriquesJauge("sh13_log_dropped_total", "counter", "Enregistrements perdus (anneau du logger plein)", jaugePerdusLog);
+        socketMetriques = (releve.metriques >= 0) ? metriquesReprendre(releve.metriques)
+                                                  : metriquesServir(adresseMetriques);
+        if (socketMetriques < 0)
+            error("ERROR serving metrics");
+        LOG_INFO("Métriques: %s", adresseMetriques);
+    }
+    else if (releve.metriques >= 0)
+        close(releve.metriques);
+
+    // Console d'administration (après une relève, elle remplace celle de l'ancien processus)
+    if (cheminAdmin != NULL)
+    {
+        if (servirAdmin(cheminAdmin) < 0)
+            error("ERROR opening admin socket");
+        LOG_INFO("Console d'administration: %s", cheminAdmin);
+    }
+
+
+    LOG_INFO("=== SERVEUR EN ATTENTE DE CONNEXIONS ===");
+    for (i=0; i<nbEcoutes; i++)
+        LOG_INFO("Adresse d'écoute: %s", ecoutes[i].adresse);
+    if (cheminReleve != NULL)
+        LOG_INFO("Relève: %s", cheminReleve);
+
+    /***************************************************************************
+     * SOUS-SECTION 13.5: BOUCLE PRINCIPALE DU SERVEUR
+     ***************************************************************************/
+    
+    formerTables();
+    if (backendUring)
+        servirUring(ecoutes, nbEcoutes);
+
+    for (i=0; i<nbEcoutes; i++)
+    {
+        attente[i].fd = ecoutes[i].fd;
+        attente[i].events = POLLIN;
+    }
+    attente[nbEcoutes].fd = reveilLobby[0];
+    attente[nbEcoutes].events = POLLIN;
+    attente[nbEcoutes + 1].fd = socketReleve;   // Ignorée par poll sans -U (-1)
+    attente[nbEcoutes + 1].events = POLLIN;
+    while (1)       // Boucle infinie - les parties s'enchaînent sans redémarrer le serveur
+    {    
+        // Attend un message ou une table libérée; tant que des joueurs attendent
+        // avec un délai d'inactivité, se réveille à chaque tick. Un anneau partagé
+        // qui contient déjà des messages ne laisse pas dormir
+        delai = roueLobby.nb > 0 ? MINUTERIE_TICK_MS : -1;
+        for (i=0; i<nbEcoutes; i++)
+            if (transportPret(&ecoutes[i]))
+                delai = 0;
+        if (poll(attente, nbEcoutes + 2, delai) < 0)
+            error("ERROR on poll");
+        metriquesCompte(MET_APPELS_RESEAU, 1);
+
+        // Joueurs en attente sans nouvelles, tables rendues par les groupes
+        servirLobby(attente[nbEcoutes].revents & POLLIN);
+
+        // Une connexion par message (accept, read, close), ou un lot de
+        // messages de l'anneau
+        for (i=0; i<nbEcoutes; i++)
+        {
+            if (ecoutes[i].type == TRANSPORT_SHM)
+            {
+                lireAnneau(&ecoutes[i]);
+                continue;
+            }
+            if (!(attente[i].revents & POLLIN))
+                continue;
+            n = transportRecevoir(&ecoutes[i], buffer, sizeof(buffer), origine, sizeof(origine));
+            if (n < 0)
+                error("ERROR on accept");
+            metriquesCompte(MET_APPELS_RESEAU, 3);
+            if (n > 0)
+                aiguillerMessage(buffer, n, origine);
+        }
+
+        // Un successeur se présente (-U): les connexions suivantes l'attendent
+        // dans la file des sockets d'écoute
+        if ((attente[nbEcoutes + 1].revents & POLLIN) && (n = accept(socketReleve, NULL, NULL)) >= 0)
+            accueillirSuccesseur(n, ecoutes, nbEcoutes);
+    }
 }
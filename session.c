@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * SESSIONS DE JEU
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "session.h"
+
+int reserveInit(struct reserveSessions *r, int taille, struct roue *roue)
+{
+    int i;
+
+    r->sessions = calloc(taille, sizeof(struct session));
+    if (r->sessions == NULL)
+        return -1;
+    r->taille = taille;
+    r->utilisees = 0;
+    r->libres = NULL;
+
+    // Chaînées dans l'ordre: la session 0 sort en premier
+    for (i=taille-1; i>=0; i--)
+    {
+        r->sessions[i].numero = i;
+        r->sessions[i].fsm = SESSION_LIBRE;
+        r->sessions[i].roue = roue;
+        r->sessions[i].suivante = r->libres;
+        r->libres = &r->sessions[i];
+    }
+    return 0;
+}
+
+struct session *sessionPrendre(struct reserveSessions *r)
+{
+    struct session *s = r->libres;
+
+    if (s == NULL)
+        return NULL;
+    r->libres = s->suivante;
+    r->utilisees++;
+    s->suivante = NULL;
+    s->parties = 0;
+    s->reprise = 0;
+    sessionVider(s);
+    return s;
+}
+
+struct session *sessionPrendreNumero(struct reserveSessions *r, int numero)
+{
+    struct session **pp;
+
+    for (pp = &r->libres; *pp != NULL && (*pp)->numero != numero; pp = &(*pp)->suivante)
+        ;
+    if (*pp == NULL)
+        return NULL;
+    *pp = (*pp)->suivante;
+    r->utilisees++;
+    r->sessions[numero].suivante = NULL;
+    r->sessions[numero].parties = 0;
+    r->sessions[numero].reprise = 0;
+    sessionVider(&r->sessions[numero]);
+    return &r->sessions[numero];
+}
+
+void sessionRendre(struct reserveSessions *r, struct session *s)
+{
+    sessionAnnulerMinuteries(s);
+    s->fsm = SESSION_LIBRE;
+    s->journal = NULL;
+    s->suivante = r->libres;
+    r->libres = s;
+    r->utilisees--;
+}
+
+void sessionVider(struct session *s)
+{
+    int i;
+
+    for (i=0; i<NB_JOUEURS; i++)
+    {
+        strcpy(s->tcpClients[i].ipAddress, "localhost");   // IP par défaut
+        s->tcpClients[i].port = -1;                         // Port invalide (-1 indique non connecté)
+        strcpy(s->tcpClients[i].name, "-");                // Nom vide
+        s->tcpClients[i].robot = 0;
+    }
+    s->nbClients = 0;
+    sessionAnnulerMinuteries(s);
+    s->fsm = SESSION_ATTENTE;
+    s->co = 0;
+    s->journal = NULL;
+    s->actionsSansReprise = 0;
+}
+
+void sessionNouvelleDonne(struct session *s, unsigned int graine)
+{
+    int i;
+
+    partieInit(&s->jeu, graine);
+    for (i=0; i<s->nbClients; i++)
+        if (s->tcpClients[i].robot)
+            botInit(&s->bots[i], i);
+    sessionAnnulerMinuteries(s);
+    s->journal = NULL;
+    s->actionsSansReprise = 0;
+    s->fsm = SESSION_ATTENTE;
+}
+
+void sessionAnnulerMinuteries(struct session *s)
+{
+    int i;
+
+    roueAnnuler(s->roue, &s->delaiTour);
+    for (i=0; i<NB_JOUEURS; i++)
+        s->toursManques[i] = 0;
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * SESSIONS DE JEU
+ * Une session est une table: joueurs assis, partie, robots et journal.
+ * Les sessions viennent d'une réserve allouée au démarrage du serveur et
+ * sont recyclées à la fin des parties: aucune allocation par partie.
+ ******************************************************************************/
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "partie.h"
+#include "journal.h"
+#include "bot.h"
+#include "minuterie.h"
+#include "coroutine.h"
+
+// États d'une session (vus de l'extérieur; le déroulement de la partie est
+// la coroutine de la session)
+#define SESSION_LIBRE   -1      // Dans la réserve
+#define SESSION_ATTENTE  0      // Attente des joueurs
+#define SESSION_EN_JEU   1      // Partie en cours
+
+// Client assis à la table
+struct _client
+{
+    char ipAddress[40];     // Adresse IP du client
+    int port;               // Port d'écoute du client
+    char name[40];          // Nom du joueur
+    int robot;              // 1 si la place est tenue par un robot du serveur (pas de socket)
+};
+
+struct session
+{
+    int numero;                         // Indice dans la réserve
+    int fsm;                            // SESSION_LIBRE, SESSION_ATTENTE ou SESSION_EN_JEU
+    coroutine co;                       // Point de reprise du déroulement de la table
+    struct _client tcpClients[NB_JOUEURS];
+    int nbClients;
+    struct partie jeu;
+    struct bot bots[NB_JOUEURS];        // Connaissances des robots, indexées par place
+    struct journal *journal;            // &stockageJournal, NULL si pas de journal
+    struct journal stockageJournal;
+    char cheminJournal[1024];
+    int actionsSansReprise;             // Actions jouées depuis le dernier point de reprise
+    int parties;                        // Parties terminées à cette table
+    int redonne;                        // La partie finie sera redonnée aux mêmes joueurs
+    int reprise;                        // Partie en cours reprise (journal, relève): déjà donnée
+    struct roue *roue;                  // Roue des minuteries du fil qui joue la table
+    struct minuterie delaiTour;         // Échéance du joueur courant
+    int toursManques[NB_JOUEURS];       // Délais de tour dépassés d'affilée
+    int toursJoues[NB_JOUEURS];         // Actions jouées dans la partie (classement)
+    struct session *suivante;           // Chaînage des sessions libres
+};
+
+struct reserveSessions
+{
+    struct session *sessions;
+    int taille;
+    int utilisees;
+    struct session *libres;
+};
+
+// Alloue toutes les sessions d'un coup, retourne -1 si la mémoire manque
+// Les minuteries des sessions sont inactives; leur rappel (et leur roue,
+// si les tables ne partagent pas roue) est à choisir par le serveur
+int reserveInit(struct reserveSessions *r, int taille, struct roue *roue);
+
+// Sort une session vide de la réserve, NULL si toutes sont utilisées
+struct session *sessionPrendre(struct reserveSessions *r);
+
+// Sort de la réserve la session numero (les clients d'une table reprise
+// connaissent son numéro), NULL si elle n'est pas libre
+struct session *sessionPrendreNumero(struct reserveSessions *r, int numero);
+
+// Remet une session dans la réserve (son journal doit être fermé)
+void sessionRendre(struct reserveSessions *r, struct session *s);
+
+// Libère toutes les places de la table (minuteries annulées)
+void sessionVider(struct session *s);
+
+// Annule le délai de tour, remet à zéro les tours manqués
+void sessionAnnulerMinuteries(struct session *s);
+
+// Nouvelle donne pour les mêmes joueurs: partie remise à zéro, robots aussi
+void sessionNouvelleDonne(struct session *s, unsigned int graine);
+
+#endif
@@ -1,6 +1,6 @@
-#include <SDL2/SDL.h>        
+#include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
-#include <SDL2/SDL_ttf.h>        
+#include <SDL2/SDL_ttf.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -11,27 +11,92 @@
 #include <netinet/in.h>
 #include <netdb.h>
 
-pthread_t thread_serveur_tcp_id;
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-char gbuffer[256];
+#include "transport.h"      // Adresses locales: unix:<chemin>, shm:<chemin>
+#include "regles.h"         // lireRequete: numero "#<n>" des reponses
+
 char gServerIpAddress[256];
 int gServerPort;
-char gClientIpAddress[256];
-int gClientPort;
-char gName[256];
-char gNames[4][256];
-int gId;
-int joueurSel;
-int objetSel;
-int guiltSel;
-int guiltGuess[13];
-int tableCartes[4][8];
-int b[3];
-int goEnabled;
-int connectEnabled;
-
-int gameOver = 0;           // 1 si la partie est terminée
-int winner = 0;             // 1 si ce joueur a gagné, 0 sinon
+
+#define SIGNE_DE_VIE_MS 30000  // Intervalle des 'C' renvoyes au lobby en attendant une table
+
+// Requetes 'G', 'O', 'S' envoyees et pas encore acquittees: le serveur renvoie
+// leur numero ("#<n>") dans ses reponses, qui sont attribuees a la bonne
+// question meme si la selection a change ou si plusieurs sont en cours
+#define REQUETES_MAX 16
+struct requete
+{
+        int numero;             // 0 = case libre
+        char code;
+        int joueur;
+        int objet;
+};
+
+// Un processus peut tenir plusieurs places (sieges): chacune a son adresse
+// de reception, son fil qui l'ecoute et son plateau, dessine dans sa case de
+// l'unique fenetre. Images, textures et police sont chargees une fois pour
+// tous les sieges
+#define SIEGES_MAX 4
+#define LARGEUR 1024        // Plateau d'un siege (coordonnees des clics et du dessin)
+#define HAUTEUR 768
+
+struct siege
+{
+	pthread_t thread_serveur_tcp_id;
+	char buffer[256];
+	volatile int synchro;       // 1: buffer contient un message a consommer
+	char clientIpAddress[256];
+	int clientPort;
+	char name[256];
+	char names[4][256];
+	int id;
+	int table;                  // Table attribuee par le lobby du serveur (avec 'I')
+	int joueurSel;
+	int objetSel;
+	int guiltSel;
+	int guiltGuess[13];
+	int tableCartes[4][8];
+	int b[3];
+	int goEnabled;
+	int connectEnabled;
+	int gameOver;               // 1 si la partie est terminée
+	int winner;                 // 1 si ce joueur a gagné, 0 sinon
+	struct requete requetes[REQUETES_MAX];
+	int prochaineRequete;
+	Uint32 dernierSigne;
+};
+
+struct siege sieges[SIEGES_MAX];
+int nbSieges;
+int colonnes;               // Disposition des sieges dans la fenetre
+float echelle;              // Taille d'une case / taille d'un plateau
+
+// Ressources partagees par les sieges (un seul renderer)
+SDL_Renderer *renderer;
+TTF_Font *Sans;
+SDL_Texture *texture_deck[13], *texture_objet[8], *texture_gobutton, *texture_connectbutton;
+SDL_Texture *texture_winner = NULL, *texture_loser = NULL;
+
+// Enregistre une requete, retourne son numero (a ajouter au message)
+int nouvelleRequete(struct siege *s, char code, int joueur, int objet)
+{
+        struct requete *r = &s->requetes[s->prochaineRequete % REQUETES_MAX];
+
+        r->numero = s->prochaineRequete++;
+        r->code = code;
+        r->joueur = joueur;
+        r->objet = objet;
+        return r->numero;
+}
+
+// Requete en cours de ce numero, NULL si inconnue ou deja acquittee
+struct requete *trouverRequete(struct siege *s, int numero)
+{
+        struct requete *r = &s->requetes[numero % REQUETES_MAX];
+
+        if (numero <= 0 || r->numero != numero)
+                return NULL;
+        return r;
+}
 
 char *nbobjets[]={"5","5","5","5","4","3","3","3"};
 char *nbnoms[]={"Sebastian Moran", "irene Adler", "inspector Lestrade",
@@ -39,56 +104,36 @@ char *nbnoms[]={"Sebastian Moran", "irene Adler", "inspector Lestrade",
   "inspector Hopkins", "Sherlock Holmes", "John Watson", "Mycroft Holmes",
   "Mrs. Hudson", "Mary Morstan", "James Moriarty"};
 
-volatile int synchro;
-
+// Reception des messages du serveur pour un siege: port TCP, socket Unix ou
+// anneau partage selon son adresse
 void *fn_serveur_tcp(void *arg)
 {
-        int sockfd, newsockfd, portno;
-        socklen_t clilen;
-        struct sockaddr_in serv_addr, cli_addr;
+        struct siege *s = arg;
+        struct ecoute ecoute;
         int n;
 
-        sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd<0)
-        {
-                printf("sockfd error\n");
-                exit(1);
-        }
-
-        bzero((char *) &serv_addr, sizeof(serv_addr));
-        portno = gClientPort;
-        serv_addr.sin_family = AF_INET;
-        serv_addr.sin_addr.s_addr = INADDR_ANY;
-        serv_addr.sin_port = htons(portno);
-       if (bind(sockfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) < 0)
+        if (transportEcouter(&ecoute, s->clientIpAddress, s->clientPort, 64) < 0)
         {
-                printf("bind error\n");
+                printf("bind error (%s %d)\n", s->clientIpAddress, s->clientPort);
                 exit(1);
         }
 
-        listen(sockfd,5);
-        clilen = sizeof(cli_addr);
         while (1)
         {
-                newsockfd = accept(sockfd, (struct sockaddr *) &cli_addr, &clilen);
-                if (newsockfd < 0)
-                {
-                        printf("accept error\n");
-                        exit(1);
-                }
-
-                bzero(gbuffer,256);
-                n = read(newsockfd,gbuffer,255);
+                bzero(s->buffer,256);
+                n = transportAttendre(&ecoute, s->buffer, 256);
                 if (n < 0)
                 {
-                        printf("read error\n");
+                        printf("accept error\n");
                         exit(1);
                 }
-                //printf("%s",gbuffer);
+                if (n == 0)
+                        continue;
+                //printf("%s",s->buffer);
 
-                synchro=1;
+                s->synchro=1;
 
-                while (synchro);
+                while (s->synchro);
 
      }
 }
@@ -100,6 +145,17 @@ void sendMessageToServer(char *ipAddress, int portno, char *mess)
     struct hostent *server;
     char sendbuffer[256];
 
+    // Serveur sur la meme machine: sans pile TCP/IP
+    if (transportType(ipAddress) != TRANSPORT_TCP)
+    {
+        if (transportEnvoyer(ipAddress, mess) < 0)
+        {
+                printf("ERROR connecting\n");
+                exit(1);
+        }
+        return;
+    }
+
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
 
     server = gethostbyname(ipAddress);
@@ -125,199 +181,224 @@ void sendMessageToServer(char *ipAddress, int portno, char *mess)
     close(sockfd);
 }
 
-int main(int argc, char ** argv)
+/*******************************************************************************
+ * RESSOURCES PARTAGEES
+ ******************************************************************************/
+
+// Texture d'une image, la surface decodee est liberee aussitot
+SDL_Texture *chargerTexture(const char *fichier)
 {
-	int ret;
-	int i,j;
+	SDL_Surface *surface = IMG_Load(fichier);
+	SDL_Texture *texture;
+
+	if (surface == NULL)
+		return NULL;
+	texture = SDL_CreateTextureFromSurface(renderer, surface);
+	SDL_FreeSurface(surface);
+	return texture;
+}
 
-    int quit = 0;
-    SDL_Event event;
-	int mx,my;
-	char sendBuffer[256];
-	char lname[256];
-	int id;
+void chargerRessources()
+{
+	char fichier[64];
+	int i;
 
-        if (argc<6)
-        {
-                printf("<app> <Main server ip address> <Main server port> <Client ip address> <Client port> <player name>\n");
-                exit(1);
-        }
+	for (i=0;i<13;i++)
+	{
+		sprintf(fichier,"SH13_%d.png",i);
+		texture_deck[i] = chargerTexture(fichier);
+	}
 
-        strcpy(gServerIpAddress,argv[1]);
-        gServerPort=atoi(argv[2]);
-        strcpy(gClientIpAddress,argv[3]);
-        gClientPort=atoi(argv[4]);
-        strcpy(gName,argv[5]);
+	texture_objet[0] = chargerTexture("SH13_pipe_120x120.png");
+	texture_objet[1] = chargerTexture("SH13_ampoule_120x120.png");
+	texture_objet[2] = chargerTexture("SH13_poing_120x120.png");
+	texture_objet[3] = chargerTexture("SH13_couronne_120x120.png");
+	texture_objet[4] = chargerTexture("SH13_carnet_120x120.png");
+	texture_objet[5] = chargerTexture("SH13_collier_120x120.png");
+	texture_objet[6] = chargerTexture("SH13_oeil_120x120.png");
+	texture_objet[7] = chargerTexture("SH13_crane_120x120.png");
 
-    SDL_Init(SDL_INIT_VIDEO);
-	TTF_Init();
- 
-    SDL_Window * window = SDL_CreateWindow("SDL2 SH13",
-        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1024, 768, 0);
- 
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, 0);
-
-    SDL_Surface *deck[13],*objet[8],*gobutton,*connectbutton;
-
-	SDL_Surface *winner_image, *loser_image;
-
-	deck[0] = IMG_Load("SH13_0.png");
-	deck[1] = IMG_Load("SH13_1.png");
-	deck[2] = IMG_Load("SH13_2.png");
-	deck[3] = IMG_Load("SH13_3.png");
-	deck[4] = IMG_Load("SH13_4.png");
-	deck[5] = IMG_Load("SH13_5.png");
-	deck[6] = IMG_Load("SH13_6.png");
-	deck[7] = IMG_Load("SH13_7.png");
-	deck[8] = IMG_Load("SH13_8.png");
-	deck[9] = IMG_Load("SH13_9.png");
-	deck[10] = IMG_Load("SH13_10.png");
-	deck[11] = IMG_Load("SH13_11.png");
-	deck[12] = IMG_Load("SH13_12.png");
-
-	objet[0] = IMG_Load("SH13_pipe_120x120.png");
-	objet[1] = IMG_Load("SH13_ampoule_120x120.png");
-	objet[2] = IMG_Load("SH13_poing_120x120.png");
-	objet[3] = IMG_Load("SH13_couronne_120x120.png");
-	objet[4] = IMG_Load("SH13_carnet_120x120.png");
-	objet[5] = IMG_Load("SH13_collier_120x120.png");
-	objet[6] = IMG_Load("SH13_oeil_120x120.png");
-	objet[7] = IMG_Load("SH13_crane_120x120.png");
-
-	gobutton = IMG_Load("gobutton.png");
-	connectbutton = IMG_Load("connectbutton.png");
-
-	winner_image = IMG_Load("winner_image.png");
-	loser_image = IMG_Load("loser_image.png");
-
-    SDL_Texture *texture_winner = NULL;
-    SDL_Texture *texture_loser = NULL;
-
-    if (winner_image != NULL) {
-        texture_winner = SDL_CreateTextureFromSurface(renderer, winner_image);
-        SDL_FreeSurface(winner_image);
-    }
-    if (loser_image != NULL) {
-        texture_loser = SDL_CreateTextureFromSurface(renderer, loser_image);
-        SDL_FreeSurface(loser_image);
-    }
-	strcpy(gNames[0],"-");
-	strcpy(gNames[1],"-");
-	strcpy(gNames[2],"-");
-	strcpy(gNames[3],"-");
+	texture_gobutton = chargerTexture("gobutton.png");
+	texture_connectbutton = chargerTexture("connectbutton.png");
 
-	joueurSel=-1;
-	objetSel=-1;
-	guiltSel=-1;
+	texture_winner = chargerTexture("winner_image.png");
+	texture_loser = chargerTexture("loser_image.png");
 
-	b[0]=-1;
-	b[1]=-1;
-	b[2]=-1;
+	Sans = TTF_OpenFont("sans.ttf", 15);
+	printf("Sans=%p\n",Sans);
+}
 
-	for (i=0;i<13;i++)
-		guiltGuess[i]=0;
+// Textes rendus une fois et gardes en textures: noms des suspects et des
+// joueurs, nombres du plateau (le meme cache sert a tous les sieges)
+#define TEXTES_MAX 256
+struct texteRendu
+{
+	char texte[64];
+	SDL_Texture *texture;
+	int w, h;
+} textes[TEXTES_MAX];
+int nbTextes = 0;
 
-	for (i=0;i<4;i++)
-		for (j=0;j<8;j++)
-			tableCartes[i][j]=-1;
+void viderTextes()
+{
+	int i;
 
-	goEnabled=0;
-	connectEnabled=1;
+	for (i=0;i<nbTextes;i++)
+		SDL_DestroyTexture(textes[i].texture);
+	nbTextes=0;
+}
 
-    SDL_Texture *texture_deck[13],*texture_gobutton,*texture_connectbutton,*texture_objet[8];
+void afficherTexte(const char *texte, int x, int y)
+{
+	SDL_Color col = {0, 0, 0};
+	SDL_Surface *surfaceMessage;
+	SDL_Rect Message_rect;
+	struct texteRendu *t = NULL;
+	int i;
 
-	for (i=0;i<13;i++)
-		texture_deck[i] = SDL_CreateTextureFromSurface(renderer, deck[i]);
-	for (i=0;i<8;i++)
-		texture_objet[i] = SDL_CreateTextureFromSurface(renderer, objet[i]);
+	for (i=0;i<nbTextes;i++)
+		if (strcmp(textes[i].texte, texte) == 0)
+		{
+			t = &textes[i];
+			break;
+		}
 
-    texture_gobutton = SDL_CreateTextureFromSurface(renderer, gobutton);
-    texture_connectbutton = SDL_CreateTextureFromSurface(renderer, connectbutton);
+	if (t == NULL)
+	{
+		if (strlen(texte) >= sizeof(textes[0].texte))
+			return;
+		if (nbTextes == TEXTES_MAX)
+			viderTextes();
+		surfaceMessage = TTF_RenderText_Solid(Sans, texte, col);
+		if (surfaceMessage == NULL)
+			return;
+		t = &textes[nbTextes++];
+		strcpy(t->texte, texte);
+		t->texture = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
+		t->w = surfaceMessage->w;
+		t->h = surfaceMessage->h;
+		SDL_FreeSurface(surfaceMessage);
+	}
+
+	Message_rect.x = x;
+	Message_rect.y = y;
+	Message_rect.w = t->w;
+	Message_rect.h = t->h;
+	SDL_RenderCopy(renderer, t->texture, NULL, &Message_rect);
+}
 
-    TTF_Font* Sans = TTF_OpenFont("sans.ttf", 15); 
-    printf("Sans=%p\n",Sans);
+/*******************************************************************************
+ * SIEGES
+ ******************************************************************************/
 
-   /* Creation du thread serveur tcp. */
-   printf ("Creation du thread serveur tcp !\n");
-   synchro=0;
-   ret = pthread_create ( & thread_serveur_tcp_id, NULL, fn_serveur_tcp, NULL);
+void initialiserSiege(struct siege *s)
+{
+	int i,j;
 
-    while (!quit)
-    {
-	if (SDL_PollEvent(&event))
-	{
-        	switch (event.type)
-        	{
-            		case SDL_QUIT:
-                		quit = 1;
-                		break;
-			case  SDL_MOUSEBUTTONDOWN:
-                printf("SDL_MOUSEBUTTONDOWN\n");
-				SDL_GetMouseState( &mx, &my );
-				printf("mx=%d my=%d\n",mx,my);
-				if ((mx<200) && (my<50) && (connectEnabled==1))
+	strcpy(s->names[0],"-");
+	strcpy(s->names[1],"-");
+	strcpy(s->names[2],"-");
+	strcpy(s->names[3],"-");
+
+	s->joueurSel=-1;
+	s->objetSel=-1;
+	s->guiltSel=-1;
+
+	s->b[0]=-1;
+	s->b[1]=-1;
+	s->b[2]=-1;
+
+	for (i=0;i<13;i++)
+		s->guiltGuess[i]=0;
+
+	for (i=0;i<4;i++)
+		for (j=0;j<8;j++)
+			s->tableCartes[i][j]=-1;
+
+	s->goEnabled=0;
+	s->connectEnabled=1;
+	s->id=-1;
+	s->table=0;
+	s->gameOver=0;
+	s->winner=0;
+	s->prochaineRequete=1;
+	s->synchro=0;
+}
+
+// Clic en (mx, my), coordonnees du plateau du siege
+void cliquer(struct siege *s, int mx, int my)
+{
+	char sendBuffer[256];
+
+				printf("[%s] mx=%d my=%d\n",s->name,mx,my);
+				if ((mx<200) && (my<50) && (s->connectEnabled==1))
 				{
-					sprintf(sendBuffer,"C %s %d %s",gClientIpAddress,gClientPort,gName);
-					/* printf("C %s %d %s\n",gClientIpAddress,gClientPort,gName); */
+					sprintf(sendBuffer,"C %s %d %s",s->clientIpAddress,s->clientPort,s->name);
+					/* printf("C %s %d %s\n",s->clientIpAddress,s->clientPort,s->name); */
                     sendMessageToServer(gServerIpAddress, gServerPort, sendBuffer);
 
 					// RAJOUTER DU CODE ICI
 
-					connectEnabled=0;
+					s->connectEnabled=0;
+                    s->id=-1;
+                    s->dernierSigne=SDL_GetTicks();
 				}
 				else if ((mx>=0) && (mx<200) && (my>=90) && (my<330))
 				{
                     printf("Case 1\n");
-                    if (joueurSel==((my-90)/60))
-                        joueurSel=-1;
+                    if (s->joueurSel==((my-90)/60))
+                        s->joueurSel=-1;
                     else
-					    joueurSel=(my-90)/60;
-					guiltSel=-1;
+					    s->joueurSel=(my-90)/60;
+					s->guiltSel=-1;
 				}
 				else if ((mx>=200) && (mx<680) && (my>=0) && (my<90))
 				{
                     printf("Case 2\n"); // top row with objects
-                    if (objetSel == ((mx-200)/60))
-                        objetSel=-1;
+                    if (s->objetSel == ((mx-200)/60))
+                        s->objetSel=-1;
                     else
-					    objetSel=(mx-200)/60;
-					guiltSel=-1;
+					    s->objetSel=(mx-200)/60;
+					s->guiltSel=-1;
 				}
 				else if ((mx>=100) && (mx<250) && (my>=350) && (my<740))
 				{
                     printf("Case 3\n");
-					joueurSel=-1;
-					objetSel=-1;
-					guiltSel=(my-350)/30;
+					s->joueurSel=-1;
+					s->objetSel=-1;
+					s->guiltSel=(my-350)/30;
 				}
 				else if ((mx>=250) && (mx<300) && (my>=350) && (my<740))
 				{
                     printf("Case 4\n"); // vertical row on the left
 					int ind=(my-350)/30;
-					guiltGuess[ind]=1-guiltGuess[ind];
+					s->guiltGuess[ind]=1-s->guiltGuess[ind];
 				}
-				else if ((mx>=500) && (mx<700) && (my>=350) && (my<450) && (goEnabled==1))
+				else if ((mx>=500) && (mx<700) && (my>=350) && (my<450) && (s->goEnabled==1))
 				{
-					printf("go! joueur=%d objet=%d guilt=%d\n",joueurSel, objetSel, guiltSel);
-					if (guiltSel!=-1)
+					printf("go! joueur=%d objet=%d guilt=%d\n",s->joueurSel, s->objetSel, s->guiltSel);
+					if (s->guiltSel!=-1)
 					{
-						sprintf(sendBuffer,"G %d %d",gId, guiltSel);
+						sprintf(sendBuffer,"G %d %d %d #%d",s->id, s->guiltSel, s->table,
+                                nouvelleRequete(s, 'G', -1, s->guiltSel));
                         sendMessageToServer(gServerIpAddress, gServerPort, sendBuffer);
 
 					// RAJOUTER DU CODE ICI
 
 					}
-					else if ((objetSel!=-1) && (joueurSel==-1))
+					else if ((s->objetSel!=-1) && (s->joueurSel==-1))
 					{
-						sprintf(sendBuffer,"O %d %d",gId, objetSel);
+						sprintf(sendBuffer,"O %d %d %d #%d",s->id, s->objetSel, s->table,
+                                nouvelleRequete(s, 'O', -1, s->objetSel));
                         sendMessageToServer(gServerIpAddress, gServerPort, sendBuffer);
 
 					// RAJOUTER DU CODE ICI
 
 					}
-					else if ((objetSel!=-1) && (joueurSel!=-1))
+					else if ((s->objetSel!=-1) && (s->joueurSel!=-1))
 					{
-						sprintf(sendBuffer,"S %d %d %d",gId, joueurSel,objetSel);
+						sprintf(sendBuffer,"S %d %d %d %d #%d",s->id, s->joueurSel,s->objetSel, s->table,
+                                nouvelleRequete(s, 'S', s->joueurSel, s->objetSel));
                         sendMessageToServer(gServerIpAddress, gServerPort, sendBuffer);
 
 					// RAJOUTER DU CODE ICI
@@ -326,50 +407,69 @@ int main(int argc, char ** argv)
 				}
 				else
 				{
-					joueurSel=-1;
-					objetSel=-1;
-					guiltSel=-1;
+					s->joueurSel=-1;
+					s->objetSel=-1;
+					s->guiltSel=-1;
 				}
-				break;
-			case  SDL_MOUSEMOTION:
-				SDL_GetMouseState( &mx, &my );
-				break;
-        	}
-	}
+}
 
-        if (synchro==1)
-        {
-                printf("consomme |%s|\n",gbuffer);
-		switch (gbuffer[0])
+// Consomme le message recu par le fil du siege
+void traiterMessage(struct siege *s)
+{
+	int i,j;
+	int id;
+
+                printf("[%s] consomme |%s|\n",s->name,s->buffer);
+		switch (s->buffer[0])
 		{
 			// Message 'I' : le joueur recoit son Id
 			case 'I':
-                sscanf(gbuffer,"I %d",&id);
-                gId=id;
+                sscanf(s->buffer,"I %d %d",&id,&s->table);
+                s->id=id;
 				// RAJOUTER DU CODE ICI
 
 				break;
 			// Message 'L' : le joueur recoit la liste des joueurs
 			case 'L':
-                sscanf(gbuffer,"L %s %s %s %s",gNames[0],gNames[1],gNames[2],gNames[3]);
+                sscanf(s->buffer,"L %s %s %s %s",s->names[0],s->names[1],s->names[2],s->names[3]);
 				// RAJOUTER DU CODE ICI
 
 				break;
 			// Message 'D' : le joueur recoit ses trois cartes
 			case 'D':
 				// RAJOUTER DU CODE ICI
-                sscanf(gbuffer,"D %d %d %d",&b[0],&b[1],&b[2]);
+                sscanf(s->buffer,"D %d %d %d",&s->b[0],&s->b[1],&s->b[2]);
+                // Nouvelle donne (le serveur enchaine les parties): plateau remis a zero
+                s->gameOver=0;
+                s->winner=0;
+                s->joueurSel=-1;
+                s->objetSel=-1;
+                s->guiltSel=-1;
+                for (i=0;i<13;i++)
+                    s->guiltGuess[i]=0;
+                for (i=0;i<4;i++)
+                    for (j=0;j<8;j++)
+                        s->tableCartes[i][j]=-1;
+                for (i=0;i<REQUETES_MAX;i++)
+                    s->requetes[i].numero=0;
+                s->connectEnabled=0;
 
 				break;
 			// Message 'M' : le joueur recoit le n° du joueur courant
 			// Cela permet d'affecter goEnabled pour autoriser l'affichage du bouton go
 			case 'M':
 				// RAJOUTER DU CODE ICI
-                sscanf(gbuffer,"M %d",&id);
-                if (id==gId)
-                    goEnabled=1;
+                sscanf(s->buffer,"M %d",&id);
+                if (id==s->id)
+                    s->goEnabled=1;
                 else
-                    goEnabled=0;
+                    s->goEnabled=0;
+                // Dernier message d'une action: la requete est acquittee
+                {
+                    struct requete *r = trouverRequete(s, lireRequete(s->buffer));
+                    if (r != NULL)
+                        r->numero=0;
+                }
 
 				break;
 			// Message 'V' : le joueur recoit une valeur de tableCartes
@@ -377,26 +477,37 @@ int main(int argc, char ** argv)
 				// RAJOUTER DU CODE ICI
                 {
                     int j1,o,v;
-                    sscanf(gbuffer,"V %d %d %d",&j1,&o,&v);
-                    tableCartes[j1][o]=v;
+                    sscanf(s->buffer,"V %d %d %d",&j1,&o,&v);
+                    s->tableCartes[j1][o]=v;
                 }
 
 				break;
             case 'R':
                 {
                     int o,j,r;
-                    sscanf(gbuffer,"R %d %d %d",&o, &j,&r);
+                    sscanf(s->buffer,"R %d %d %d",&o, &j,&r);
                     printf("Réponse à la question O/N: objet=%d réponse=%d\n",o,r);
-                    tableCartes[j][o]=r?100:-1;
+                    s->tableCartes[j][o]=r?100:-1;
                     // RAJOUTER DU CODE ICI
                 }
                 break;
             case 'S':
                 {
-                    int j1,o,t;
-                    sscanf(gbuffer,"S %d %d",&j1,&t);
-                    printf("Réponse à la question Statistique: joueur=%d total=%d \n",j1,t);
-                    tableCartes[joueurSel][objetSel]=t;
+                    int o,t;
+                    struct requete *r = trouverRequete(s, lireRequete(s->buffer));
+                    sscanf(s->buffer,"S %d %d",&o,&t);
+                    // Case de la question a laquelle le serveur repond (serveur
+                    // sans numeros de requete: la selection courante)
+                    if (r != NULL && r->code == 'S')
+                    {
+                        printf("Réponse à la question Statistique #%d: joueur=%d objet=%d total=%d \n",r->numero,r->joueur,o,t);
+                        s->tableCartes[r->joueur][o]=t;
+                    }
+                    else if (s->joueurSel!=-1)
+                    {
+                        printf("Réponse à la question Statistique: objet=%d total=%d \n",o,t);
+                        s->tableCartes[s->joueurSel][o]=t;
+                    }
                     // RAJOUTER DU CODE ICI
                 }
                 break;
@@ -404,104 +515,83 @@ int main(int argc, char ** argv)
                 {
                     int j1;
                     int j2;
-                    sscanf(gbuffer,"F %d %d",&j1,&j2);
+                    sscanf(s->buffer,"F %d %d",&j1,&j2);
                     printf("Mauvaise accusation du joueur %d pour %d\n",j1,j2);
-                    if (j1==gId)
-                        gameOver = 1;
-                    guiltGuess[j2]=1;
+                    if (j1==s->id)
+                        s->gameOver = 1;
+                    s->guiltGuess[j2]=1;
                 }
                 break;
             case 'W':
                 {
                     int j1;
                     int j2;
-                    sscanf(gbuffer,"W %d %d",&j1,&j2);
-                    if (j1==gId) {
+                    sscanf(s->buffer,"W %d %d",&j1,&j2);
+                    if (j1==s->id) {
                         printf(">>> VICTOIRE !!! Vous aviez raison, le coupable est %d <<<\n",j2);
-                        winner = 1;
-                        gameOver = 1;
+                        s->winner = 1;
+                        s->gameOver = 1;
                         }
                     else {
-                        gameOver = 1;
+                        s->gameOver = 1;
                         printf(">>> DEFAITE !!! Le joueur %d avait raison, le coupable est %d <<<\n",j1,j2);
                         }
-                    guiltGuess[j2]=1;
+                    s->guiltGuess[j2]=1;
+                    // Sans revanche du serveur, le joueur se reconnecte pour la partie suivante
+                    s->connectEnabled=1;
+                }
+                break;
+            // Message 'A' : joueur elimine apres plusieurs delais de tour depasses
+            case 'A':
+                {
+                    int j1;
+                    sscanf(s->buffer,"A %d",&j1);
+                    printf("Le joueur %d est elimine (trop lent)\n",j1);
+                    if (j1==s->id)
+                        s->gameOver = 1;
                 }
                 break;
-
-
-			/* case 'W': */
-   /*              { */
-   /*                  int idWinner; */
-   /*                  char coupableName[256]; */
-   /*                  sscanf(gbuffer,"W %d %s",&idWinner, coupableName); */
-   /*                  printf(">>> VICTOIRE du joueur %d (%s) - Coupable: %s <<<\n",  */
-   /*                         idWinner, gNames[idWinner], coupableName); */
-   /*                   */
-   /*                  gameOver = 1; */
-   /*                  if (idWinner == gId) { */
-   /*                      winner = 1;  // Ce joueur a gagné */
-   /*                      printf("VOUS AVEZ GAGNÉ!\n"); */
-   /*                  } else { */
-   /*                      winner = 0;  // Ce joueur a perdu */
-   /*                      printf("Vous avez perdu...\n"); */
-   /*                  } */
-   /*              } */
-                /* break; */
-                
-            /* case 'F': */
-            /*     { */
-            /*         int idLoser; */
-            /*         char accusedName[256]; */
-            /*         sscanf(gbuffer,"F %d %s",&idLoser, accusedName); */
-            /*         printf(">>> ÉCHEC du joueur %d (%s) - A accusé: %s <<<\n",  */
-            /*                idLoser, gNames[idLoser], accusedName); */
-            /*     } */
-            /*     break; */
-		/* } */
-		/* synchro=0; */
-  /*       } */
 		}
-		synchro=0;
-        }
+}
 
-        SDL_Rect dstrect_grille = { 512-250, 10, 500, 350 };
-        SDL_Rect dstrect_image = { 0, 0, 500, 330 };
-        SDL_Rect dstrect_image1 = { 0, 340, 250, 330/2 };
+// Dessine le plateau du siege (la vue du renderer est deja sa case)
+void dessinerSiege(struct siege *s)
+{
+	int i,j;
 
 	SDL_SetRenderDrawColor(renderer, 255, 230, 230, 230);
-	SDL_Rect rect = {0, 0, 1024, 768}; 
+	SDL_Rect rect = {0, 0, LARGEUR, HAUTEUR};
 	SDL_RenderFillRect(renderer, &rect);
 
-	if (gameOver) {
-        if (winner && texture_winner != NULL) {
+	if (s->gameOver) {
+        if (s->winner && texture_winner != NULL) {
             SDL_Rect dstrect = { 256, 184, 512, 400 };
             SDL_RenderCopy(renderer, texture_winner, NULL, &dstrect);
-        } else if (!winner && texture_loser != NULL) {
+        } else if (!s->winner && texture_loser != NULL) {
             SDL_Rect dstrect = { 256, 184, 512, 400 };
             SDL_RenderCopy(renderer, texture_loser, NULL, &dstrect);
         }
     }
-	if (joueurSel!=-1)
+	if (s->joueurSel!=-1)
 	{
 		SDL_SetRenderDrawColor(renderer, 255, 180, 180, 255);
-		SDL_Rect rect1 = {0, 90+joueurSel*60, 200 , 60}; 
+		SDL_Rect rect1 = {0, 90+s->joueurSel*60, 200 , 60};
 		SDL_RenderFillRect(renderer, &rect1);
-	}	
+	}
 
-	if (objetSel!=-1)
+	if (s->objetSel!=-1)
 	{
 		SDL_SetRenderDrawColor(renderer, 180, 255, 180, 255);
-		SDL_Rect rect1 = {200+objetSel*60, 0, 60 , 90}; 
+		SDL_Rect rect1 = {200+s->objetSel*60, 0, 60 , 90};
 		SDL_RenderFillRect(renderer, &rect1);
-	}	
+	}
 
-	if (guiltSel!=-1)
+	if (s->guiltSel!=-1)
 	{
 		SDL_SetRenderDrawColor(renderer, 180, 180, 255, 255);
-		SDL_Rect rect1 = {100, 350+guiltSel*30, 150 , 30}; 
+		SDL_Rect rect1 = {100, 350+s->guiltSel*30, 150 , 30};
 		SDL_RenderFillRect(renderer, &rect1);
-	}	
+	}
 
 	{
         SDL_Rect dstrect_pipe = { 210, 10, 40, 40 };
@@ -522,61 +612,23 @@ int main(int argc, char ** argv)
         SDL_RenderCopy(renderer, texture_objet[7], NULL, &dstrect_crane);
 	}
 
-        SDL_Color col1 = {0, 0, 0};
         for (i=0;i<8;i++)
-        {
-                SDL_Surface* surfaceMessage = TTF_RenderText_Solid(Sans, nbobjets[i], col1);
-                SDL_Texture* Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-
-                SDL_Rect Message_rect; //create a rect
-                Message_rect.x = 230+i*60;  //controls the rect's x coordinate 
-                Message_rect.y = 50; // controls the rect's y coordinte
-                Message_rect.w = surfaceMessage->w; // controls the width of the rect
-                Message_rect.h = surfaceMessage->h; // controls the height of the rect
-
-                SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
-                SDL_DestroyTexture(Message);
-                SDL_FreeSurface(surfaceMessage);
-        }
+                afficherTexte(nbobjets[i], 230+i*60, 50);
 
         for (i=0;i<13;i++)
-        {
-                SDL_Surface* surfaceMessage = TTF_RenderText_Solid(Sans, nbnoms[i], col1);
-                SDL_Texture* Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-
-                SDL_Rect Message_rect;
-                Message_rect.x = 105;
-                Message_rect.y = 350+i*30;
-                Message_rect.w = surfaceMessage->w;
-                Message_rect.h = surfaceMessage->h;
-
-                SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
-                SDL_DestroyTexture(Message);
-                SDL_FreeSurface(surfaceMessage);
-        }
+                afficherTexte(nbnoms[i], 105, 350+i*30);
 
 	for (i=0;i<4;i++)
         	for (j=0;j<8;j++)
         	{
-			if (tableCartes[i][j]!=-1)
+			if (s->tableCartes[i][j]!=-1)
 			{
 				char mess[10];
-				if (tableCartes[i][j]==100)
+				if (s->tableCartes[i][j]==100)
 					sprintf(mess,"*");
 				else
-					sprintf(mess,"%d",tableCartes[i][j]);
-                		SDL_Surface* surfaceMessage = TTF_RenderText_Solid(Sans, mess, col1);
-                		SDL_Texture* Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-
-                		SDL_Rect Message_rect;
-                		Message_rect.x = 230+j*60;
-                		Message_rect.y = 110+i*60;
-                		Message_rect.w = surfaceMessage->w;
-                		Message_rect.h = surfaceMessage->h;
-
-                		SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
-                		SDL_DestroyTexture(Message);
-                		SDL_FreeSurface(surfaceMessage);
+					sprintf(mess,"%d",s->tableCartes[i][j]);
+                		afficherTexte(mess, 230+j*60, 110+i*60);
 			}
         	}
 
@@ -731,7 +783,7 @@ int main(int argc, char ** argv)
 
 	// Afficher les suppositions
 	for (i=0;i<13;i++)
-		if (guiltGuess[i] == 1)
+		if (s->guiltGuess[i] == 1)
 		{
 			SDL_RenderDrawLine(renderer, 250,350+i*30,300,380+i*30);
 			SDL_RenderDrawLine(renderer, 250,380+i*30,300,350+i*30);
@@ -761,68 +813,177 @@ int main(int argc, char ** argv)
 	SDL_RenderDrawLine(renderer, 250,350,250,740);
 	SDL_RenderDrawLine(renderer, 300,350,300,740);
 
-        //SDL_RenderCopy(renderer, texture_grille, NULL, &dstrect_grille);
-	if (b[0]!=-1)
+	if (s->b[0]!=-1)
 	{
         	SDL_Rect dstrect = { 750, 0, 1000/4, 660/4 };
-        	SDL_RenderCopy(renderer, texture_deck[b[0]], NULL, &dstrect);
+        	SDL_RenderCopy(renderer, texture_deck[s->b[0]], NULL, &dstrect);
 	}
-	if (b[1]!=-1)
+	if (s->b[1]!=-1)
 	{
         	SDL_Rect dstrect = { 750, 200, 1000/4, 660/4 };
-        	SDL_RenderCopy(renderer, texture_deck[b[1]], NULL, &dstrect);
+        	SDL_RenderCopy(renderer, texture_deck[s->b[1]], NULL, &dstrect);
 	}
-	if (b[2]!=-1)
+	if (s->b[2]!=-1)
 	{
         	SDL_Rect dstrect = { 750, 400, 1000/4, 660/4 };
-        	SDL_RenderCopy(renderer, texture_deck[b[2]], NULL, &dstrect);
+        	SDL_RenderCopy(renderer, texture_deck[s->b[2]], NULL, &dstrect);
 	}
 
 	// Le bouton go
-	if (goEnabled==1)
+	if (s->goEnabled==1)
 	{
         	SDL_Rect dstrect = { 500, 350, 200, 150 };
         	SDL_RenderCopy(renderer, texture_gobutton, NULL, &dstrect);
 	}
 	// Le bouton connect
-	if (connectEnabled==1)
+	if (s->connectEnabled==1)
 	{
         	SDL_Rect dstrect = { 0, 0, 200, 50 };
         	SDL_RenderCopy(renderer, texture_connectbutton, NULL, &dstrect);
 	}
 
-        //SDL_SetRenderDrawColor(renderer, 255, 0, 0, SDL_ALPHA_OPAQUE);
-        //SDL_RenderDrawLine(renderer, 0, 0, 200, 200);
-
-	SDL_Color col = {0, 0, 0};
 	for (i=0;i<4;i++)
-		if (strlen(gNames[i])>0)
-		{
-		SDL_Surface* surfaceMessage = TTF_RenderText_Solid(Sans, gNames[i], col);
-		SDL_Texture* Message = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
-
-		SDL_Rect Message_rect; //create a rect
-		Message_rect.x = 10;  //controls the rect's x coordinate 
-		Message_rect.y = 110+i*60; // controls the rect's y coordinte
-		Message_rect.w = surfaceMessage->w; // controls the width of the rect
-		Message_rect.h = surfaceMessage->h; // controls the height of the rect
-
-		SDL_RenderCopy(renderer, Message, NULL, &Message_rect);
-    		SDL_DestroyTexture(Message);
-    		SDL_FreeSurface(surfaceMessage);
-		}
+		if (strlen(s->names[i])>0)
+			afficherTexte(s->names[i], 10, 110+i*60);
+
+	// Nom du siege (plusieurs places dans la fenetre)
+	if (nbSieges > 1)
+		afficherTexte(s->name, 750, 740);
+}
+
+int main(int argc, char ** argv)
+{
+	int ret;
+	int i;
+
+    int quit = 0;
+    SDL_Event event;
+	int mx,my;
+	char sendBuffer[256];
+	SDL_Rect ecran;
+	int lignes, largeurCase, hauteurCase;
+
+        if (argc<6 || (argc-6)%2 != 0 || (argc-4)/2 > SIEGES_MAX)
+        {
+                printf("<app> <Main server ip address> <Main server port> <Client ip address> <Client port> <player name> [<Client port> <player name>]...\n");
+                exit(1);
+        }
+
+        strcpy(gServerIpAddress,argv[1]);
+        gServerPort=atoi(argv[2]);
+
+        // Une place par couple <port> <nom>. Plusieurs places sur une adresse
+        // unix: ou shm: ont chacune leur chemin: <chemin>-<port>
+        nbSieges=(argc-4)/2;
+        for (i=0;i<nbSieges;i++)
+        {
+                struct siege *s = &sieges[i];
+
+                s->clientPort=atoi(argv[4+2*i]);
+                if (nbSieges>1 && transportType(argv[3])!=TRANSPORT_TCP)
+                        snprintf(s->clientIpAddress,sizeof(s->clientIpAddress),"%.200s-%d",argv[3],s->clientPort);
+                else
+                        snprintf(s->clientIpAddress,sizeof(s->clientIpAddress),"%s",argv[3]);
+                snprintf(s->name,sizeof(s->name),"%s",argv[5+2*i]);
+                initialiserSiege(s);
+        }
+
+    SDL_Init(SDL_INIT_VIDEO);
+	TTF_Init();
+
+    // Places en grille de deux colonnes, reduites pour tenir sur l'ecran
+    colonnes = (nbSieges>1) ? 2 : 1;
+    lignes = (nbSieges+colonnes-1)/colonnes;
+    echelle = 1;
+    if (SDL_GetDisplayUsableBounds(0, &ecran) == 0)
+    {
+        if (echelle*colonnes*LARGEUR > ecran.w)
+            echelle = (float) ecran.w/(colonnes*LARGEUR);
+        if (echelle*lignes*HAUTEUR > ecran.h)
+            echelle = (float) ecran.h/(lignes*HAUTEUR);
+    }
+    largeurCase = LARGEUR*echelle;
+    hauteurCase = HAUTEUR*echelle;
+
+    SDL_Window * window = SDL_CreateWindow("SDL2 SH13",
+        SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, colonnes*largeurCase, lignes*hauteurCase, 0);
+
+    renderer = SDL_CreateRenderer(window, -1, 0);
+
+    chargerRessources();
+
+   /* Creation des threads serveur tcp, un par siege. */
+   printf ("Creation du thread serveur tcp !\n");
+   for (i=0;i<nbSieges;i++)
+       ret = pthread_create ( & sieges[i].thread_serveur_tcp_id, NULL, fn_serveur_tcp, &sieges[i]);
+
+    while (!quit)
+    {
+	if (SDL_PollEvent(&event))
+	{
+        	switch (event.type)
+        	{
+            		case SDL_QUIT:
+                		quit = 1;
+                		break;
+			case  SDL_MOUSEBUTTONDOWN:
+                printf("SDL_MOUSEBUTTONDOWN\n");
+				SDL_GetMouseState( &mx, &my );
+				// Case cliquee, puis coordonnees dans son plateau
+				i = (my/hauteurCase)*colonnes + mx/largeurCase;
+				if (mx/largeurCase < colonnes && i < nbSieges)
+					cliquer(&sieges[i], (mx%largeurCase)/echelle, (my%hauteurCase)/echelle);
+				break;
+			case  SDL_MOUSEMOTION:
+				SDL_GetMouseState( &mx, &my );
+				break;
+        	}
+	}
+
+        for (i=0;i<nbSieges;i++)
+        {
+            struct siege *s = &sieges[i];
+
+            // Signe de vie en attendant une table: le lobby oublie les joueurs sans nouvelles
+            if (s->id<0 && s->connectEnabled==0 && SDL_GetTicks()-s->dernierSigne>SIGNE_DE_VIE_MS)
+            {
+                sprintf(sendBuffer,"C %s %d %s",s->clientIpAddress,s->clientPort,s->name);
+                sendMessageToServer(gServerIpAddress, gServerPort, sendBuffer);
+                s->dernierSigne=SDL_GetTicks();
+            }
+
+            if (s->synchro==1)
+            {
+                traiterMessage(s);
+                s->synchro=0;
+            }
+        }
+
+	SDL_RenderSetScale(renderer, echelle, echelle);
+	for (i=0;i<nbSieges;i++)
+	{
+		// Vue en coordonnees du plateau (multipliees par l'echelle)
+		SDL_Rect vue = { (i%colonnes)*LARGEUR, (i/colonnes)*HAUTEUR, LARGEUR, HAUTEUR };
+		SDL_RenderSetViewport(renderer, &vue);
+		dessinerSiege(&sieges[i]);
+	}
 
         SDL_RenderPresent(renderer);
     }
- 
-    SDL_DestroyTexture(texture_deck[0]);
-    SDL_DestroyTexture(texture_deck[1]);
-    SDL_FreeSurface(deck[0]);
-    SDL_FreeSurface(deck[1]);
+
+    viderTextes();
+    for (i=0;i<13;i++)
+        SDL_DestroyTexture(texture_deck[i]);
+    for (i=0;i<8;i++)
+        SDL_DestroyTexture(texture_objet[i]);
+    SDL_DestroyTexture(texture_gobutton);
+    SDL_DestroyTexture(texture_connectbutton);
+    if (Sans != NULL)
+        TTF_CloseFont(Sans);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
- 
+
     SDL_Quit();
- 
+
     return 0;
 }
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * SONDES STATIQUES (USDT)
+ * Points de trace du serveur pour perf et bpftrace, sans recompiler: chaque
+ * SONDEn(nom, ...) pose un nop dans le code et décrit son adresse et ses
+ * arguments dans une note ELF .note.stapsdt (format SystemTap/DTrace v3,
+ * celui de <sys/sdt.h>, dont on se passe). Désactivée, une sonde ne coûte
+ * que ce nop; perf ou bpftrace le remplacent par un point d'arrêt quand ils
+ * s'y attachent. Les arguments sont passés en entiers de 64 bits signés
+ * (une chaîne: son adresse, à lire avec str(argN)).
+ *
+ *   bpftrace -l 'usdt:./server:sh13:*'
+ *   perf buildid-cache --add ./server && perf list sdt_sh13:*
+ *
+ * Compiler avec -DSANS_SONDES retire les sondes.
+ ******************************************************************************/
+#ifndef SONDES_H
+#define SONDES_H
+
+#define SONDES_FOURNISSEUR "sh13"
+
+#if defined(SANS_SONDES) || !defined(__x86_64__)
+
+#define SONDE0(nom)                 do { } while (0)
+#define SONDE1(nom, a)              do { (void) (a); } while (0)
+#define SONDE2(nom, a, b)           do { (void) (a); (void) (b); } while (0)
+#define SONDE3(nom, a, b, c)        do { (void) (a); (void) (b); (void) (c); } while (0)
+
+#else
+
+// Note: nop, puis dans .note.stapsdt: adresse du nop, base de la section
+// .stapsdt.base (les outils corrigent l'adresse si le binaire est déplacé),
+// sémaphore (aucun), fournisseur, nom et arguments ("-8@<opérande>")
+#define _SONDE(nom, args, ...)                                              \
+    __asm__ __volatile__ (                                                  \
+        "990: nop\n"                                                        \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                       \
+        ".balign 4\n"                                                       \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                  \
+        "991: .asciz \"stapsdt\"\n"                                         \
+        "992: .balign 4\n"                                                  \
+        "993: .8byte 990b\n"                                                \
+        ".8byte _.stapsdt.base\n"                                           \
+        ".8byte 0\n"                                                        \
+        ".asciz \"" SONDES_FOURNISSEUR "\"\n"                               \
+        ".asciz \"" #nom "\"\n"                                             \
+        ".asciz \"" args "\"\n"                                             \
+        "994: .balign 4\n"                                                  \
+        ".popsection\n"                                                     \
+        ".ifndef _.stapsdt.base\n"                                          \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n"                                            \
+        ".hidden _.stapsdt.base\n"                                          \
+        "_.stapsdt.base: .space 1\n"                                        \
+        ".size _.stapsdt.base, 1\n"                                         \
+        ".popsection\n"                                                     \
+        ".endif\n"                                                          \
+        :: __VA_ARGS__)
+
+#define SONDE0(nom)             _SONDE(nom, "")
+#define SONDE1(nom, a)          _SONDE(nom, "-8@%0", "nor" ((long) (a)))
+#define SONDE2(nom, a, b)       _SONDE(nom, "-8@%0 -8@%1", "nor" ((long) (a)), "nor" ((long) (b)))
+#define SONDE3(nom, a, b, c)    _SONDE(nom, "-8@%0 -8@%1 -8@%2", "nor" ((long) (a)), "nor" ((long) (b)), \
+                                       "nor" ((long) (c)))
+
+#endif
+
+#endif
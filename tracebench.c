@@ -0,0 +1,738 @@
+/*******************************************************************************
+ * REJEU DE TRAFIC ENREGISTRÉ CONTRE UN SERVEUR SHERLOCK 13
+ * Rejoue les messages des clients humains d'une partie enregistrée contre un
+ * serveur local, en plusieurs copies en parallèle, et mesure la latence de
+ * chaque message jusqu'à son acquittement par le serveur.
+ *
+ * Traces acceptées:
+ *   - journal binaire de partie (.sh13j): messages 'C' et actions des
+ *     joueurs humains, horodatés à la microseconde;
+ *   - sortie standard du serveur ("Received packet from ...\nData: [...]"),
+ *     horodatée si chaque ligne commence par des secondes ("12.345 Received...").
+ *
+ * Usage: ./tracebench [options] <IP serveur> <port serveur> <trace>...
+ ******************************************************************************/
+
+/*******************************************************************************
+ * SECTION 1: INCLUSION DES BIBLIOTHÈQUES
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#include "partie.h"
+#include "journal.h"
+#include "histogramme.h"
+
+/*******************************************************************************
+ * SECTION 2: STRUCTURES ET VARIABLES GLOBALES
+ ******************************************************************************/
+
+// Un message client à rejouer
+struct etape
+{
+    double t;               // Secondes depuis le début de la trace
+    int joueur;             // Indice du joueur dans la trace
+    struct action act;      // code 'C' pour une connexion, sinon 'G', 'O' ou 'S'
+};
+
+// Une partie enregistrée: joueurs humains et leurs messages dans l'ordre
+struct trace
+{
+    char fichier[256];
+    char noms[NB_JOUEURS][40];
+    int places[NB_JOUEURS];     // Place attribuée à chaque joueur à l'enregistrement
+    int nbJoueurs;
+    struct etape *etapes;
+    int nbEtapes;
+    int horodatee;              // 0 si la trace ne contient pas d'horodatage
+};
+
+// Un joueur rejoué: port d'écoute propre à la copie
+struct joueurRejoue
+{
+    char nom[40];
+    int port;
+    int fd;
+    int id;                     // Place reçue avec 'I' (-1 tant que non connue)
+    int table;                  // Table reçue avec 'I', ajoutée à chaque action
+    int siege;                  // Place attendue (celle de l'enregistrement)
+    double envoiC;              // Instant d'envoi du 'C' pas encore acquitté, 0 sinon
+    struct copie *c;
+};
+
+// Une copie de la trace, jouée contre un port serveur
+struct copie
+{
+    struct trace *tr;
+    struct joueurRejoue joueurs[NB_JOUEURS];
+    char tag[16];               // File du lobby propre à la copie (les copies ne se mêlent pas)
+    int serveurPort;
+    int etape;                  // Prochaine étape à envoyer
+    double debut;               // Instant de départ de la copie
+    double envoi;               // Instant d'envoi de l'étape en attente, 0 si aucune
+    double derniere;            // Instant où la dernière étape a été jouée (attente du 'W')
+    int finie;
+};
+
+// Indices des histogrammes par type de message
+#define H_C 0
+#define H_G 1
+#define H_O 2
+#define H_S 3
+
+struct fil
+{
+    pthread_t tid;
+    struct copie *copies;
+    int nbCopies;
+    struct histogramme histo[4];
+    struct histogramme retard;  // Retard d'envoi sur le calendrier de la trace
+    long envoyes;
+    long acquittes;
+    long delais;                // Messages sans acquittement dans le délai
+    long erreurs;               // Échecs de connexion / envoi
+    long sieges;                // Place reçue différente de l'enregistrement
+    long ignores;               // Étapes non jouées car la partie s'est terminée avant
+    long parties;               // Parties terminées ('W' reçu)
+};
+
+char gServerIpAddress[256];
+int gServerPort;
+struct sockaddr_in gServerAddr;
+
+int nbFils = 1;             // -t: nombre de fils d'exécution
+int nbCopies = 1;           // -n: copies de chaque trace jouées en parallèle
+int portBase = 34000;       // -p: premier port d'écoute des joueurs rejoués
+int nbPortsServeur = 1;     // -P: copies réparties sur ce nombre de ports serveur consécutifs
+double vitesse = 1;         // -x: 1 = temps d'origine, 2 = deux fois plus vite, 0 = au plus vite
+double delai = 2;           // -a: secondes d'attente d'un acquittement
+int duree = 0;              // -d: durée maximale en secondes (0 = jusqu'à la fin des traces)
+
+struct trace *traces;
+int nbTraces;
+
+volatile int arret = 0;
+volatile int filsTermines = 0;
+
+/*******************************************************************************
+ * SECTION 3: HORLOGE
+ ******************************************************************************/
+
+double maintenant()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*******************************************************************************
+ * SECTION 4: LECTURE DES TRACES
+ ******************************************************************************/
+
+void ajouterEtape(struct trace *tr, double t, int joueur, struct action *act)
+{
+    if (tr->nbEtapes % 256 == 0)
+        tr->etapes = realloc(tr->etapes, (tr->nbEtapes + 256) * sizeof(struct etape));
+    tr->etapes[tr->nbEtapes].t = t;
+    tr->etapes[tr->nbEtapes].joueur = joueur;
+    tr->etapes[tr->nbEtapes].act = *act;
+    tr->nbEtapes++;
+}
+
+int joueurParPlace(struct trace *tr, int place)
+{
+    int i;
+
+    for (i=0; i<tr->nbJoueurs; i++)
+        if (tr->places[i] == place)
+            return i;
+    return -1;
+}
+
+int joueurParNom(struct trace *tr, char *nom)
+{
+    int i;
+
+    for (i=0; i<tr->nbJoueurs; i++)
+        if (strcmp(tr->noms[i], nom) == 0)
+            return i;
+    return -1;
+}
+
+// Journal binaire: première partie du fichier, joueurs humains seulement
+// (les actions des robots sont rejouées par les robots du serveur)
+int lireJournal(struct trace *tr)
+{
+    struct lecteurJournal l;
+    struct enregistrement e;
+    struct action act;
+    unsigned long long debut = 0;
+    unsigned int graine = 0;
+    int robots = 0, parties = 0, j;
+
+    if (journalOuvrir(&l, tr->fichier, 0) < 0)
+        return -1;
+    while (journalSuivant(&l, &e))
+    {
+        if (debut == 0)
+            debut = e.t;
+        if (e.type == J_PARTIE && ++parties > 1)
+            break;
+        switch (e.type)
+        {
+            case J_PARTIE:
+                graine = e.donnees[0] | (e.donnees[1] << 8) | (e.donnees[2] << 16)
+                         | ((unsigned int) e.donnees[3] << 24);
+                break;
+
+            case J_JOUEUR:
+                if (e.donnees[1])
+                {
+                    robots++;
+                    break;
+                }
+                j = joueurParPlace(tr, e.donnees[0]);
+                if (j < 0 && tr->nbJoueurs < NB_JOUEURS)
+                {
+                    j = tr->nbJoueurs++;
+                    tr->places[j] = e.donnees[0];
+                    snprintf(tr->noms[j], sizeof(tr->noms[j]), "%s", (char *) e.donnees + 6);
+                }
+                act.code = 'C';
+                act.joueur = e.donnees[0];
+                if (j >= 0)
+                    ajouterEtape(tr, (e.t - debut) / 1e6, j, &act);
+                break;
+
+            case J_ACTION:
+                journalLireAction(&e, &act);
+                j = joueurParPlace(tr, act.joueur);
+                if (j >= 0)
+                    ajouterEtape(tr, (e.t - debut) / 1e6, j, &act);
+                break;
+        }
+    }
+    journalLiberer(&l);
+    tr->horodatee = 1;
+    printf("%s: journal, graine %u (serveur à lancer avec -s %u -b %d)\n",
+           tr->fichier, graine, graine, robots);
+    return 0;
+}
+
+// Sortie standard du serveur: les places sont déduites de l'ordre des 'C'
+// (les robots, assis au démarrage, occupent les premières places)
+int lireSortieServeur(struct trace *tr)
+{
+    FILE *f;
+    char ligne[512], nom[40], *p;
+    struct action act;
+    struct { double t; char message[256]; } *messages = NULL;
+    int nb = 0, paquet = 0, j, k, port;
+    double t = 0, t0 = -1;
+
+    f = fopen(tr->fichier, "r");
+    if (f == NULL)
+        return -1;
+    tr->horodatee = 1;
+    while (fgets(ligne, sizeof(ligne), f) != NULL)
+    {
+        if ((p = strstr(ligne, "Received packet from")) != NULL)
+        {
+            paquet = 1;
+            if (p == ligne || sscanf(ligne, "%lf", &t) != 1)
+            {
+                tr->horodatee = 0;
+                t = 0;
+            }
+            if (t0 < 0)
+                t0 = t;
+            continue;
+        }
+        if (!paquet || strncmp(ligne, "Data: [", 7) != 0)
+            continue;
+        paquet = 0;
+        if (nb % 256 == 0)
+            messages = realloc(messages, (nb + 256) * sizeof(*messages));
+        messages[nb].t = t - t0;
+        snprintf(messages[nb].message, sizeof(messages[nb].message), "%.200s", ligne + 7);
+        messages[nb].message[strcspn(messages[nb].message, "]\n")] = '\0';
+        nb++;
+    }
+    fclose(f);
+
+    // Premier passage: joueurs connectés
+    for (k=0; k<nb; k++)
+        if (messages[k].message[0] == 'C'
+            && sscanf(messages[k].message, "C %*s %d %39s", &port, nom) == 2
+            && joueurParNom(tr, nom) < 0 && tr->nbJoueurs < NB_JOUEURS)
+            snprintf(tr->noms[tr->nbJoueurs++], sizeof(nom), "%s", nom);
+    for (j=0; j<tr->nbJoueurs; j++)
+        tr->places[j] = NB_JOUEURS - tr->nbJoueurs + j;
+
+    // Second passage: étapes
+    for (k=0; k<nb; k++)
+    {
+        if (messages[k].message[0] == 'C')
+        {
+            if (sscanf(messages[k].message, "C %*s %d %39s", &port, nom) != 2
+                || (j = joueurParNom(tr, nom)) < 0)
+                continue;
+            act.code = 'C';
+            act.joueur = tr->places[j];
+        }
+        else if (!partieLireAction(messages[k].message, &act)
+                 || (j = joueurParPlace(tr, act.joueur)) < 0)
+            continue;
+        ajouterEtape(tr, messages[k].t, j, &act);
+    }
+    free(messages);
+    printf("%s: sortie serveur, %s\n", tr->fichier,
+           tr->horodatee ? "horodatée" : "sans horodatage (rejouée au plus vite)");
+    return 0;
+}
+
+int lireTrace(struct trace *tr, char *fichier)
+{
+    int n = strlen(fichier), e = strlen(JOURNAL_EXTENSION);
+
+    memset(tr, 0, sizeof(*tr));
+    snprintf(tr->fichier, sizeof(tr->fichier), "%s", fichier);
+    if (n > e && strcmp(fichier + n - e, JOURNAL_EXTENSION) == 0)
+        return lireJournal(tr);
+    return lireSortieServeur(tr);
+}
+
+/*******************************************************************************
+ * SECTION 5: ENVOI DES MESSAGES
+ ******************************************************************************/
+
+// Même protocole que sh13.c: une connexion TCP par message
+int sendMessageToServer(int portno, char *mess)
+{
+    struct sockaddr_in addr = gServerAddr;
+    char sendbuffer[256];
+    int sockfd, n, len;
+
+    addr.sin_port = htons(portno);
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0)
+        return -1;
+    if (connect(sockfd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        close(sockfd);
+        return -1;
+    }
+
+    len = sprintf(sendbuffer, "%s\n", mess);
+    n = write(sockfd, sendbuffer, len);
+    close(sockfd);
+    return n == len ? 0 : -1;
+}
+
+int indiceHisto(char code)
+{
+    switch (code)
+    {
+        case 'C': return H_C;
+        case 'G': return H_G;
+        case 'O': return H_O;
+        default:  return H_S;
+    }
+}
+
+// Envoie l'étape courante de la copie; le nom et le port sont ceux de la copie
+// Un 'C' n'attend pas son 'I': le lobby ne répond qu'une fois la table formée
+void envoyerEtape(struct fil *f, struct copie *c, double t)
+{
+    struct etape *et = &c->tr->etapes[c->etape];
+    struct joueurRejoue *jr = &c->joueurs[et->joueur];
+    char mess[256];
+
+    if (et->act.code == 'C')
+        sprintf(mess, "C 127.0.0.1 %d %s %s", jr->port, jr->nom, c->tag);
+    else
+    {
+        partieFormaterAction(&et->act, mess);
+        sprintf(mess + strlen(mess), " %d", jr->table);
+    }
+
+    if (c->tr->horodatee && vitesse > 0)
+        histoAjoute(&f->retard, (t - (c->debut + et->t / vitesse)) * 1e6);
+    f->envoyes++;
+    if (et->act.code == 'C')
+    {
+        jr->siege = et->act.joueur;
+        jr->envoiC = t;
+        c->etape++;
+    }
+    else
+        c->envoi = t;
+    if (sendMessageToServer(c->serveurPort, mess) < 0)
+    {
+        f->erreurs++;
+        if (et->act.code == 'C')
+            jr->envoiC = 0;
+        else
+        {
+            c->envoi = 0;
+            c->etape++;
+        }
+    }
+}
+
+void acquitter(struct fil *f, struct copie *c)
+{
+    struct etape *et = &c->tr->etapes[c->etape];
+
+    histoAjoute(&f->histo[indiceHisto(et->act.code)], (maintenant() - c->envoi) * 1e6);
+    f->acquittes++;
+    c->envoi = 0;
+    c->etape++;
+}
+
+/*******************************************************************************
+ * SECTION 6: TRAITEMENT DES MESSAGES REÇUS
+ ******************************************************************************/
+
+void recevoir(struct fil *f, struct joueurRejoue *jr, char *mess)
+{
+    struct copie *c = jr->c;
+    struct etape *et = c->envoi != 0 ? &c->tr->etapes[c->etape] : NULL;
+    int attendu = et != NULL && &c->joueurs[et->joueur] == jr;
+    int x;
+
+    switch (mess[0])
+    {
+        // 'I': acquitte la connexion du joueur (table formée)
+        case 'I':
+            jr->table = 0;
+            sscanf(mess, "I %d %d", &jr->id, &jr->table);
+            if (jr->envoiC != 0)
+            {
+                if (jr->id != jr->siege)
+                    f->sieges++;
+                histoAjoute(&f->histo[H_C], (maintenant() - jr->envoiC) * 1e6);
+                f->acquittes++;
+                jr->envoiC = 0;
+            }
+            break;
+
+        // 'M': acquitte l'action du joueur (le tour passe à un autre)
+        case 'M':
+            sscanf(mess, "M %d", &x);
+            if (attendu && et->act.code != 'C' && x != jr->id)
+                acquitter(f, c);
+            break;
+
+        // 'W': fin de partie, les étapes restantes ne sont pas jouées
+        case 'W':
+            if (c->finie)
+                break;
+            if (attendu)
+                acquitter(f, c);
+            f->parties++;
+            f->ignores += c->tr->nbEtapes - c->etape;
+            c->etape = c->tr->nbEtapes;
+            c->finie = 1;
+            break;
+    }
+}
+
+// Accepte toutes les connexions en attente sur le port d'un joueur
+void accepterMessages(struct fil *f, struct joueurRejoue *jr)
+{
+    char buffer[256];
+    int fd, n, total;
+
+    while ((fd = accept(jr->fd, NULL, NULL)) >= 0)
+    {
+        total = 0;
+        while (total < 255 && (n = read(fd, buffer + total, 255 - total)) > 0)
+            total += n;
+        close(fd);
+        buffer[total] = '\0';
+        if (total > 0)
+            recevoir(f, jr, buffer);
+    }
+}
+
+/*******************************************************************************
+ * SECTION 7: BOUCLE D'UN FIL D'EXÉCUTION
+ ******************************************************************************/
+
+// Instant d'envoi de la prochaine étape d'une copie, 0 si elle attend un acquittement
+// (ou la table du joueur qui doit jouer)
+double echeance(struct copie *c)
+{
+    if (c->finie || c->envoi != 0 || c->etape >= c->tr->nbEtapes
+        || c->joueurs[c->tr->etapes[c->etape].joueur].envoiC != 0)
+        return 0;
+    if (!c->tr->horodatee || vitesse <= 0)
+        return c->debut;
+    return c->debut + c->tr->etapes[c->etape].t / vitesse;
+}
+
+void *fn_fil(void *arg)
+{
+    struct fil *f = arg;
+    struct epoll_event ev, evs[256];
+    struct copie *c;
+    double t, prochaine, e;
+    int ep, i, j, n, attente, actives;
+
+    ep = epoll_create1(0);
+    for (i=0; i<f->nbCopies; i++)
+        for (j=0; j<f->copies[i].tr->nbJoueurs; j++)
+        {
+            ev.events = EPOLLIN;
+            ev.data.ptr = &f->copies[i].joueurs[j];
+            epoll_ctl(ep, EPOLL_CTL_ADD, f->copies[i].joueurs[j].fd, &ev);
+        }
+
+    t = maintenant();
+    for (i=0; i<f->nbCopies; i++)
+        f->copies[i].debut = t;
+
+    while (!arret)
+    {
+        // Envoie les étapes dues, abandonne celles qui ne sont pas acquittées
+        t = maintenant();
+        prochaine = t + 0.1;
+        actives = 0;
+        for (i=0; i<f->nbCopies; i++)
+        {
+            c = &f->copies[i];
+            if (c->envoi != 0 && t - c->envoi > delai)
+            {
+                f->delais++;
+                c->envoi = 0;
+                c->etape++;
+            }
+            for (j=0; j<c->tr->nbJoueurs; j++)
+                if (c->joueurs[j].envoiC != 0 && t - c->joueurs[j].envoiC > delai)
+                {
+                    f->delais++;
+                    c->joueurs[j].envoiC = 0;
+                }
+            // Après la dernière étape, les robots peuvent encore finir la partie
+            if (!c->finie && c->etape >= c->tr->nbEtapes)
+            {
+                if (c->derniere == 0)
+                    c->derniere = t;
+                else if (t - c->derniere > delai)
+                    c->finie = 1;
+            }
+            if (c->finie)
+                continue;
+            actives++;
+            e = echeance(c);
+            if (e != 0 && e <= t)
+                envoyerEtape(f, c, t);
+            else if (e != 0 && e < prochaine)
+                prochaine = e;
+        }
+        if (actives == 0)
+            break;
+
+        attente = (int)((prochaine - maintenant()) * 1000);
+        if (attente < 0)
+            attente = 0;
+        n = epoll_wait(ep, evs, 256, attente);
+        for (i=0; i<n; i++)
+            accepterMessages(f, evs[i].data.ptr);
+    }
+
+    close(ep);
+    __sync_fetch_and_add(&filsTermines, 1);
+    return NULL;
+}
+
+/*******************************************************************************
+ * SECTION 8: FONCTION PRINCIPALE
+ ******************************************************************************/
+
+void usage(char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t fils] [-n copies] [-p portBase] [-P nbPortsServeur]\n"
+                    "          [-x vitesse] [-a delaiAcquittement] [-d secondes]\n"
+                    "          <IP serveur> <port serveur> <trace>...\n", prog);
+    exit(1);
+}
+
+void afficherLatences(char *titre, struct histogramme *h)
+{
+    if (h->nb == 0)
+        return;
+    printf("%-12s n=%-7ld p50=%.0f p90=%.0f p99=%.0f p99.9=%.0f max=%.0f\n", titre, h->nb,
+           histoPercentile(h, 50), histoPercentile(h, 90),
+           histoPercentile(h, 99), histoPercentile(h, 99.9), h->max);
+}
+
+int main(int argc, char *argv[])
+{
+    struct copie *copies;
+    struct fil *fils, total;
+    struct sockaddr_in addr;
+    struct hostent *server;
+    struct histogramme toutes;
+    double debut, t;
+    int nb, opt, i, j, k, port, un = 1;
+
+    while ((opt = getopt(argc, argv, "t:n:p:P:x:a:d:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': nbFils = atoi(optarg); break;
+            case 'n': nbCopies = atoi(optarg); break;
+            case 'p': portBase = atoi(optarg); break;
+            case 'P': nbPortsServeur = atoi(optarg); break;
+            case 'x': vitesse = atof(optarg); break;
+            case 'a': delai = atof(optarg); break;
+            case 'd': duree = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind + 3 > argc || nbFils < 1 || nbCopies < 1 || nbPortsServeur < 1)
+        usage(argv[0]);
+
+    strcpy(gServerIpAddress, argv[optind]);
+    gServerPort = atoi(argv[optind+1]);
+
+    server = gethostbyname(gServerIpAddress);
+    if (server == NULL) {
+        fprintf(stderr, "ERROR, no such host\n");
+        exit(1);
+    }
+    bzero((char *) &gServerAddr, sizeof(gServerAddr));
+    gServerAddr.sin_family = AF_INET;
+    bcopy((char *)server->h_addr, (char *)&gServerAddr.sin_addr.s_addr, server->h_length);
+
+    printf("=== REJEU DE TRACES SH13 ===\n");
+    nbTraces = argc - optind - 2;
+    traces = calloc(nbTraces, sizeof(struct trace));
+    for (i=0; i<nbTraces; i++)
+        if (lireTrace(&traces[i], argv[optind + 2 + i]) < 0 || traces[i].nbEtapes == 0)
+        {
+            fprintf(stderr, "%s: trace illisible ou vide\n", argv[optind + 2 + i]);
+            exit(1);
+        }
+
+    // Chaque copie a ses propres noms et ports d'écoute
+    nb = nbCopies * nbTraces;
+    copies = calloc(nb, sizeof(struct copie));
+    port = portBase;
+    for (i=0; i<nb; i++)
+    {
+        struct copie *c = &copies[i];
+
+        c->tr = &traces[i % nbTraces];
+        c->serveurPort = gServerPort + i % nbPortsServeur;
+        sprintf(c->tag, "tb%d", i % 1000000);
+        for (j=0; j<c->tr->nbJoueurs; j++)
+        {
+            struct joueurRejoue *jr = &c->joueurs[j];
+
+            snprintf(jr->nom, sizeof(jr->nom), "%.30s_%d", c->tr->noms[j], i % 1000000);
+            jr->port = port++;
+            jr->id = -1;
+            jr->c = c;
+
+            jr->fd = socket(AF_INET, SOCK_STREAM, 0);
+            setsockopt(jr->fd, SOL_SOCKET, SO_REUSEADDR, &un, sizeof(un));
+            bzero((char *) &addr, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = INADDR_ANY;
+            addr.sin_port = htons(jr->port);
+            if (bind(jr->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+            {
+                fprintf(stderr, "ERROR on binding port %d\n", jr->port);
+                exit(1);
+            }
+            listen(jr->fd, 64);
+            fcntl(jr->fd, F_SETFL, O_NONBLOCK);
+        }
+    }
+
+    fils = calloc(nbFils, sizeof(struct fil));
+    for (k=0; k<nbFils; k++)
+    {
+        fils[k].copies = copies + nb * k / nbFils;
+        fils[k].nbCopies = nb * (k+1) / nbFils - nb * k / nbFils;
+    }
+
+    if (vitesse > 0)
+        printf("%d copies, %d fils, vitesse x%g, serveur %s:%d (%d ports)\n\n",
+               nb, nbFils, vitesse, gServerIpAddress, gServerPort, nbPortsServeur);
+    else
+        printf("%d copies, %d fils, au plus vite, serveur %s:%d (%d ports)\n\n",
+               nb, nbFils, gServerIpAddress, gServerPort, nbPortsServeur);
+
+    debut = maintenant();
+    for (k=0; k<nbFils; k++)
+        pthread_create(&fils[k].tid, NULL, fn_fil, &fils[k]);
+    if (duree > 0)
+    {
+        for (i=0; i<duree * 10 && filsTermines < nbFils; i++)
+            usleep(100000);
+        arret = 1;
+    }
+    for (k=0; k<nbFils; k++)
+        pthread_join(fils[k].tid, NULL);
+    t = maintenant() - debut;
+
+    // Agrège les résultats de tous les fils
+    memset(&total, 0, sizeof(total));
+    memset(&toutes, 0, sizeof(toutes));
+    for (k=0; k<nbFils; k++)
+    {
+        for (j=0; j<4; j++)
+        {
+            histoFusionne(&total.histo[j], &fils[k].histo[j]);
+            histoFusionne(&toutes, &fils[k].histo[j]);
+        }
+        histoFusionne(&total.retard, &fils[k].retard);
+        total.envoyes += fils[k].envoyes;
+        total.acquittes += fils[k].acquittes;
+        total.delais += fils[k].delais;
+        total.erreurs += fils[k].erreurs;
+        total.sieges += fils[k].sieges;
+        total.ignores += fils[k].ignores;
+        total.parties += fils[k].parties;
+    }
+
+    printf("\n=== RÉSULTATS (%.2f s) ===\n", t);
+    printf("messages envoyés: %ld (%.1f/s), acquittés: %ld\n",
+           total.envoyes, total.envoyes / t, total.acquittes);
+    printf("parties terminées: %ld / %d\n", total.parties, nb);
+    printf("erreurs: envoi=%ld sans acquittement=%ld places différentes=%ld étapes ignorées=%ld\n",
+           total.erreurs, total.delais, total.sieges, total.ignores);
+    printf("latence message -> acquittement (us):\n");
+    afficherLatences("  C -> I", &total.histo[H_C]);
+    afficherLatences("  G -> M/W", &total.histo[H_G]);
+    afficherLatences("  O -> M", &total.histo[H_O]);
+    afficherLatences("  S -> M", &total.histo[H_S]);
+    afficherLatences("  toutes", &toutes);
+    afficherLatences("retard envoi", &total.retard);
+
+    for (i=0; i<nb; i++)
+        for (j=0; j<copies[i].tr->nbJoueurs; j++)
+            close(copies[i].joueurs[j].fd);
+    for (i=0; i<nbTraces; i++)
+        free(traces[i].etapes);
+    free(traces);
+    free(copies);
+    free(fils);
+    return total.delais + total.erreurs == 0 ? 0 : 2;
+}
@@ -0,0 +1,487 @@
+/*******************************************************************************
+ * TRANSPORTS: TCP, SOCKET UNIX, MÉMOIRE PARTAGÉE
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "transport.h"
+#include "hachage.h"
+#include "sondes.h"         // Points de trace USDT (accept, close)
+
+#define SHM_MAGIQUE         0x53483133u     // "SH13": anneau initialisé
+#define DESTINATIONS_MAX    8192            // Anneaux projetés par un écrivain (puissance de 2)
+
+// Un message: sequence = position + 1 quand il est publié, position + capacité
+// quand le lecteur a libéré l'emplacement pour le tour suivant
+struct emplacementShm
+{
+    unsigned long sequence;
+    int longueur;
+    char texte[TRANSPORT_MESSAGE];
+};
+
+// Les compteurs des écrivains et du lecteur sont sur des lignes de cache distinctes
+struct anneauShm
+{
+    unsigned int magique;
+    unsigned int masque;                                    // Capacité - 1
+    unsigned long ecriture __attribute__((aligned(64)));   // Emplacements réservés
+    int dort __attribute__((aligned(64)));                 // Lecteur en attente sur le tube
+    unsigned long lecture __attribute__((aligned(64)));    // Lecteur seulement
+    struct emplacementShm emplacements[] __attribute__((aligned(64)));
+};
+
+// Anneau d'un destinataire, projeté au premier envoi
+struct destination
+{
+    char chemin[108];
+    struct anneauShm *anneau;
+    size_t taille;
+    unsigned int masque;
+    int reveil;                     // Écriture du tube nommé
+};
+
+static struct destination *destinations = NULL;
+static pthread_rwlock_t verrouDestinations = PTHREAD_RWLOCK_INITIALIZER;
+
+static size_t tailleAnneau(unsigned int capacite)
+{
+    return sizeof(struct anneauShm) + capacite * sizeof(struct emplacementShm);
+}
+
+int transportType(const char *adresse)
+{
+    if (strncmp(adresse, "unix:", 5) == 0)
+        return TRANSPORT_UNIX;
+    if (strncmp(adresse, "shm:", 4) == 0)
+        return TRANSPORT_SHM;
+    return TRANSPORT_TCP;
+}
+
+static int adresseUnix(struct sockaddr_un *un, const char *adresse)
+{
+    if (strlen(adresse + 5) >= sizeof(un->sun_path))
+        return -1;
+    memset(un, 0, sizeof(*un));
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, adresse + 5);
+    return 0;
+}
+
+/*******************************************************************************
+ * ANNEAU PARTAGÉ
+ ******************************************************************************/
+
+static int anneauNonVide(struct anneauShm *a)
+{
+    return __atomic_load_n(&a->emplacements[a->lecture & a->masque].sequence, __ATOMIC_ACQUIRE)
+           == a->lecture + 1;
+}
+
+static int anneauLire(struct anneauShm *a, char *buffer, int taille)
+{
+    struct emplacementShm *p = &a->emplacements[a->lecture & a->masque];
+    int n;
+
+    if (__atomic_load_n(&p->sequence, __ATOMIC_ACQUIRE) != a->lecture + 1)
+        return 0;
+    n = (p->longueur < taille - 1) ? p->longueur : taille - 1;
+    memcpy(buffer, p->texte, n);
+    buffer[n] = '\0';
+    __atomic_store_n(&p->sequence, a->lecture + a->masque + 1, __ATOMIC_RELEASE);
+    a->lecture++;
+    return n;
+}
+
+// Retourne -1 si l'anneau est plein (lecteur arrêté ou débordé)
+static int anneauEcrire(struct anneauShm *a, int reveil, const char *mess)
+{
+    struct emplacementShm *p;
+    unsigned long pos, seq;
+    long ecart;
+    int n;
+
+    pos = __atomic_load_n(&a->ecriture, __ATOMIC_RELAXED);
+    while (1)
+    {
+        p = &a->emplacements[pos & a->masque];
+        seq = __atomic_load_n(&p->sequence, __ATOMIC_ACQUIRE);
+        ecart = (long)(seq - pos);
+        if (ecart == 0)
+        {
+            if (__atomic_compare_exchange_n(&a->ecriture, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (ecart < 0)
+            return -1;
+        else
+            pos = __atomic_load_n(&a->ecriture, __ATOMIC_RELAXED);
+    }
+
+    n = snprintf(p->texte, sizeof(p->texte), "%s\n", mess);
+    p->longueur = (n < (int) sizeof(p->texte)) ? n : (int) sizeof(p->texte) - 1;
+    __atomic_store_n(&p->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    // Pendant de la barrière de transportPret: soit le lecteur voit le message,
+    // soit l'écrivain le voit endormi
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&a->dort, __ATOMIC_RELAXED))
+        if (write(reveil, "", 1) < 0 && errno != EAGAIN)
+            return -1;
+    return 0;
+}
+
+static int ecouterShm(struct ecoute *e, const char *chemin, int capacite, int perimes)
+{
+    char tube[128];
+    struct stat st;
+    struct anneauShm *a;
+    size_t taille;
+    int fd, i, nouveau;
+
+    if (capacite < 2 || (capacite & (capacite - 1)) != 0
+        || snprintf(tube, sizeof(tube), "%s.reveil", chemin) >= (int) sizeof(tube))
+        return -1;
+    taille = tailleAnneau(capacite);
+    fd = open(chemin, O_RDWR | O_CREAT, 0660);
+    if (fd < 0)
+        return -1;
+    nouveau = fstat(fd, &st) < 0 || (size_t) st.st_size != taille;
+    if (nouveau && (ftruncate(fd, 0) < 0 || ftruncate(fd, taille) < 0))
+    {
+        close(fd);
+        return -1;
+    }
+    a = mmap(NULL, taille, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (a == MAP_FAILED)
+        return -1;
+
+    // Anneau repris tel quel si sa forme convient: les écrivains qui l'ont
+    // projeté continuent d'y écrire sans le savoir
+    if (nouveau || a->magique != SHM_MAGIQUE || a->masque != (unsigned int)(capacite - 1))
+    {
+        __atomic_store_n(&a->magique, 0, __ATOMIC_RELEASE);
+        a->masque = capacite - 1;
+        a->ecriture = a->lecture = 0;
+        a->dort = 0;
+        for (i=0; i<capacite; i++)
+            a->emplacements[i].sequence = i;
+        __atomic_store_n(&a->magique, SHM_MAGIQUE, __ATOMIC_RELEASE);
+    }
+
+    // Lecture et écriture: le tube ne voit jamais la fin de fichier
+    if ((mkfifo(tube, 0660) < 0 && errno != EEXIST)
+        || (e->fd = open(tube, O_RDWR | O_NONBLOCK)) < 0)
+    {
+        munmap(a, taille);
+        return -1;
+    }
+    e->anneau = a;
+
+    // Messages d'une exécution précédente: périmés (sauf relève)
+    while (perimes && anneauLire(a, tube, sizeof(tube)) > 0)
+        ;
+    return 0;
+}
+
+// Projette l'anneau d'un destinataire (verrou d'écriture tenu)
+static struct destination *projeter(const char *chemin)
+{
+    struct destination *d;
+    struct stat st;
+    struct anneauShm *a;
+    struct sigaction action;
+    char tube[128];
+    unsigned int i, k;
+    int fd;
+
+    if (destinations == NULL)
+    {
+        destinations = calloc(DESTINATIONS_MAX, sizeof(struct destination));
+        if (destinations == NULL)
+            return NULL;
+        // Tube d'un lecteur arrêté: EPIPE plutôt que la fin du processus
+        // (sauf si le programme a déjà choisi quoi faire de SIGPIPE)
+        if (sigaction(SIGPIPE, NULL, &action) == 0 && action.sa_handler == SIG_DFL)
+            signal(SIGPIPE, SIG_IGN);
+    }
+    // Case du chemin, ou première case vide (les cases ne sont jamais libérées)
+    i = hacherNom(chemin) & (DESTINATIONS_MAX - 1);
+    for (k=0; destinations[i].chemin[0] != '\0' && strcmp(destinations[i].chemin, chemin) != 0; k++)
+    {
+        if (k == DESTINATIONS_MAX - 1)
+            return NULL;
+        i = (i + 1) & (DESTINATIONS_MAX - 1);
+    }
+    d = &destinations[i];
+
+    // Anneau recréé par son lecteur (autre capacité): projeté à nouveau
+    if (d->anneau != NULL)
+    {
+        munmap(d->anneau, d->taille);
+        close(d->reveil);
+        d->anneau = NULL;
+    }
+    if (strlen(chemin) >= sizeof(d->chemin)
+        || snprintf(tube, sizeof(tube), "%s.reveil", chemin) >= (int) sizeof(tube))
+        return NULL;
+    strcpy(d->chemin, chemin);
+
+    fd = open(chemin, O_RDWR);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(struct anneauShm))
+    {
+        close(fd);
+        return NULL;
+    }
+    a = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (a == MAP_FAILED)
+        return NULL;
+    if (__atomic_load_n(&a->magique, __ATOMIC_ACQUIRE) != SHM_MAGIQUE
+        || tailleAnneau(a->masque + 1) != (size_t) st.st_size
+        || (d->reveil = open(tube, O_WRONLY | O_NONBLOCK)) < 0)
+    {
+        munmap(a, st.st_size);
+        return NULL;
+    }
+    d->taille = st.st_size;
+    d->masque = a->masque;
+    d->anneau = a;
+    return d;
+}
+
+static struct destination *chercherDestination(const char *chemin)
+{
+    unsigned int i;
+
+    if (destinations == NULL)
+        return NULL;
+    for (i = hacherNom(chemin) & (DESTINATIONS_MAX - 1); destinations[i].chemin[0] != '\0';
+         i = (i + 1) & (DESTINATIONS_MAX - 1))
+        if (strcmp(destinations[i].chemin, chemin) == 0)
+            return destinations[i].anneau != NULL ? &destinations[i] : NULL;
+    return NULL;
+}
+
+static int destinationValide(struct destination *d)
+{
+    return __atomic_load_n(&d->anneau->magique, __ATOMIC_ACQUIRE) == SHM_MAGIQUE
+           && d->anneau->masque == d->masque;
+}
+
+static int envoyerShm(const char *chemin, const char *mess)
+{
+    struct destination *d;
+    int r;
+
+    // Chemin courant: anneau déjà projeté, écrivains en parallèle
+    pthread_rwlock_rdlock(&verrouDestinations);
+    d = chercherDestination(chemin);
+    if (d != NULL && destinationValide(d))
+    {
+        r = anneauEcrire(d->anneau, d->reveil, mess);
+        pthread_rwlock_unlock(&verrouDestinations);
+        return r;
+    }
+    pthread_rwlock_unlock(&verrouDestinations);
+
+    pthread_rwlock_wrlock(&verrouDestinations);
+    d = chercherDestination(chemin);
+    if (d == NULL || !destinationValide(d))
+        d = projeter(chemin);
+    r = (d != NULL) ? anneauEcrire(d->anneau, d->reveil, mess) : -1;
+    pthread_rwlock_unlock(&verrouDestinations);
+    return r;
+}
+
+/*******************************************************************************
+ * RÉCEPTION
+ ******************************************************************************/
+
+int transportEcouter(struct ecoute *e, const char *adresse, int port, int file)
+{
+    struct sockaddr_in in;
+    struct sockaddr_un un;
+    int oui = 1;
+
+    memset(e, 0, sizeof(*e));
+    e->type = transportType(adresse);
+    e->fd = -1;
+    snprintf(e->adresse, sizeof(e->adresse), "%s", adresse);
+
+    if (e->type == TRANSPORT_SHM)
+        return ecouterShm(e, adresse + 4, file, 1);
+
+    if (e->type == TRANSPORT_UNIX)
+    {
+        if (adresseUnix(&un, adresse) < 0 || (e->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+            return -1;
+        unlink(un.sun_path);
+        if (bind(e->fd, (struct sockaddr *) &un, sizeof(un)) < 0)
+            return -1;
+    }
+    else
+    {
+        if ((e->fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+            return -1;
+        setsockopt(e->fd, SOL_SOCKET, SO_REUSEADDR, &oui, sizeof(oui));
+        memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_addr.s_addr = INADDR_ANY;
+        in.sin_port = htons(port);
+        if (bind(e->fd, (struct sockaddr *) &in, sizeof(in)) < 0)
+            return -1;
+    }
+    return listen(e->fd, file);
+}
+
+int transportReprendre(struct ecoute *e, const char *adresse, int fd, int file)
+{
+    memset(e, 0, sizeof(*e));
+    e->type = transportType(adresse);
+    e->fd = fd;
+    snprintf(e->adresse, sizeof(e->adresse), "%s", adresse);
+    if (e->type == TRANSPORT_SHM)
+    {
+        if (fd >= 0)
+            close(fd);
+        return ecouterShm(e, adresse + 4, file, 0);
+    }
+    return fd >= 0 ? 0 : -1;
+}
+
+int transportPret(struct ecoute *e)
+{
+    struct anneauShm *a = e->anneau;
+
+    if (e->type != TRANSPORT_SHM)
+        return 0;
+    if (anneauNonVide(a))
+        return 1;
+    __atomic_store_n(&a->dort, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!anneauNonVide(a))
+        return 0;
+    __atomic_store_n(&a->dort, 0, __ATOMIC_RELAXED);
+    return 1;
+}
+
+int transportRecevoir(struct ecoute *e, char *buffer, int taille, char *origine, int tailleOrigine)
+{
+    struct sockaddr_in client;
+    socklen_t lg = sizeof(client);
+    char vide[64];
+    int fd, n;
+
+    if (e->type == TRANSPORT_SHM)
+    {
+        // Réveillé (ou servi sans dormir): les écrivains cessent de sonner
+        if (__atomic_load_n(&e->anneau->dort, __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&e->anneau->dort, 0, __ATOMIC_RELAXED);
+            while (read(e->fd, vide, sizeof(vide)) > 0)
+                ;
+        }
+        n = anneauLire(e->anneau, buffer, taille);
+        if (n > 0 && origine != NULL)
+            snprintf(origine, tailleOrigine, "%s", e->adresse);
+        return n;
+    }
+
+    fd = accept(e->fd, (struct sockaddr *) &client, &lg);
+    if (fd < 0)
+        return -1;
+    SONDE2(connexion_acceptee, fd, e->fd);
+    memset(buffer, 0, taille);
+    n = read(fd, buffer, taille - 1);
+    SONDE1(connexion_fermee, fd);
+    close(fd);
+    if (origine != NULL)
+    {
+        if (e->type == TRANSPORT_TCP)
+            snprintf(origine, tailleOrigine, "%s:%d", inet_ntoa(client.sin_addr), ntohs(client.sin_port));
+        else
+            snprintf(origine, tailleOrigine, "%s", e->adresse);
+    }
+    return n;
+}
+
+int transportAttendre(struct ecoute *e, char *buffer, int taille)
+{
+    struct pollfd attente;
+    int n;
+
+    while (1)
+    {
+        n = transportRecevoir(e, buffer, taille, NULL, 0);
+        if (n != 0)
+            return n;
+        if (transportPret(e))
+            continue;
+        attente.fd = e->fd;
+        attente.events = POLLIN;
+        if (poll(&attente, 1, -1) < 0 && errno != EINTR)
+            return -1;
+    }
+}
+
+void transportFermer(struct ecoute *e)
+{
+    if (e->anneau != NULL)
+        munmap(e->anneau, tailleAnneau(e->anneau->masque + 1));
+    if (e->fd >= 0)
+        close(e->fd);
+    if (e->type == TRANSPORT_UNIX)
+        unlink(e->adresse + 5);
+    e->anneau = NULL;
+    e->fd = -1;
+}
+
+/*******************************************************************************
+ * ENVOI
+ ******************************************************************************/
+
+int transportEnvoyer(const char *adresse, const char *mess)
+{
+    struct sockaddr_un un;
+    char buffer[256];
+    int fd, n, lg;
+
+    if (transportType(adresse) == TRANSPORT_SHM)
+        return envoyerShm(adresse + 4, mess);
+    if (transportType(adresse) != TRANSPORT_UNIX || adresseUnix(&un, adresse) < 0)
+        return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *) &un, sizeof(un)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    lg = snprintf(buffer, sizeof(buffer), "%s\n", mess);
+    if (lg >= (int) sizeof(buffer))
+        lg = sizeof(buffer) - 1;
+    n = send(fd, buffer, lg, MSG_NOSIGNAL);
+    close(fd);
+    return n == lg ? n : -1;
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * TRANSPORTS: TCP, SOCKET UNIX, MÉMOIRE PARTAGÉE
+ * L'adresse d'un serveur ou d'un client choisit son transport:
+ *   <hôte> <port>       TCP, une connexion par message (protocole d'origine)
+ *   unix:<chemin>       socket Unix, une connexion par message, sans pile TCP/IP
+ *   shm:<chemin>        anneau projeté en mémoire (fichier <chemin>, de préférence
+ *                       sous /dev/shm) et tube nommé <chemin>.reveil
+ * Les deux transports locaux ne servent qu'entre processus d'une même machine;
+ * le port est ignoré. Un anneau appartient à celui qui le lit (le serveur pour
+ * les messages qu'il reçoit, chaque client pour les siens) et n'importe quel
+ * processus y écrit sans appel système: chaque écrivain réserve un emplacement
+ * par compare-and-swap (file bornée à plusieurs écrivains et un lecteur), et
+ * n'écrit un octet dans le tube que si le lecteur s'est déclaré endormi.
+ ******************************************************************************/
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#define TRANSPORT_TCP   0
+#define TRANSPORT_UNIX  1
+#define TRANSPORT_SHM   2
+
+#define TRANSPORT_MESSAGE   244     // Plus long message d'un anneau, '\0' compris
+
+struct anneauShm;
+
+// Point de réception: socket d'écoute, ou anneau et lecture de son tube
+struct ecoute
+{
+    int type;
+    int fd;                         // À surveiller avec poll/epoll (POLLIN)
+    struct anneauShm *anneau;       // TRANSPORT_SHM seulement
+    char adresse[108];
+};
+
+// Transport désigné par une adresse
+int transportType(const char *adresse);
+
+// Écoute à l'adresse (TCP: toutes les interfaces, sur port). file: connexions
+// en attente (TCP, unix) ou emplacements de l'anneau (shm, puissance de 2).
+// Un anneau existant est repris (ses écrivains le gardent projeté) et vidé
+// des messages d'une exécution précédente. Retourne -1 en cas d'échec
+int transportEcouter(struct ecoute *e, const char *adresse, int port, int file);
+
+// Reprend l'écoute d'un autre processus (relève): socket d'écoute héritée fd
+// (TCP, unix: les connexions en attente sont gardées), ou anneau repris avec
+// les messages qu'il contient (shm: fd ignoré). Retourne -1 en cas d'échec
+int transportReprendre(struct ecoute *e, const char *adresse, int fd, int file);
+
+// À appeler avant d'attendre sur e->fd: retourne 1 si des messages sont déjà
+// là (ne pas dormir), sinon déclare le lecteur endormi et retourne 0
+int transportPret(struct ecoute *e);
+
+// Reçoit un message après le réveil de e->fd (accept bloquant pour TCP et
+// unix). origine: "ip:port" de l'émetteur, ou l'adresse locale
+// Retourne la longueur, 0 si l'anneau est vide, -1 en cas d'erreur
+int transportRecevoir(struct ecoute *e, char *buffer, int taille, char *origine, int tailleOrigine);
+
+// Attend et reçoit le prochain message (fil dédié à la réception)
+int transportAttendre(struct ecoute *e, char *buffer, int taille);
+
+// Envoie un message ('\n' ajouté) à une adresse locale (unix ou shm; les
+// anneaux restent projetés pour les envois suivants). Utilisable par
+// plusieurs fils. Retourne -1 si le destinataire est injoignable ou son
+// anneau plein
+int transportEnvoyer(const char *adresse, const char *mess);
+
+void transportFermer(struct ecoute *e);
+
+#endif
@@ -0,0 +1,190 @@
+/*******************************************************************************
+ * IO_URING SANS BIBLIOTHÈQUE
+ ******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+static int uringSetup(unsigned entrees, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entrees, p);
+}
+
+static int uringEnter(int fd, unsigned soumettre, unsigned attendre, unsigned drapeaux, void *arg, size_t lg)
+{
+    return syscall(__NR_io_uring_enter, fd, soumettre, attendre, drapeaux, arg, lg);
+}
+
+static int uringRegister(int fd, unsigned op, void *arg, unsigned nb)
+{
+    return syscall(__NR_io_uring_register, fd, op, arg, nb);
+}
+
+int uringInit(struct uring *u, unsigned entrees)
+{
+    struct io_uring_params p;
+
+    memset(u, 0, sizeof(*u));
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    p.cq_entries = 4 * entrees;
+    u->fd = uringSetup(entrees, &p);
+    if (u->fd < 0 && errno == EINVAL)
+    {
+        // Noyau plus ancien: sans les options de confort
+        p.flags = IORING_SETUP_CQSIZE;
+        u->fd = uringSetup(entrees, &p);
+    }
+    if (u->fd < 0)
+        return -1;
+    if (!(p.features & IORING_FEAT_EXT_ARG))
+    {
+        close(u->fd);
+        return -1;
+    }
+
+    u->lgSq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->lgCq = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    u->lgSqes = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sq = mmap(NULL, u->lgSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    u->cq = mmap(NULL, u->lgCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->lgSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->sq == MAP_FAILED || u->cq == MAP_FAILED || u->sqes == MAP_FAILED)
+    {
+        close(u->fd);
+        return -1;
+    }
+
+    u->sqTete = (unsigned *)((char *) u->sq + p.sq_off.head);
+    u->sqQueue = (unsigned *)((char *) u->sq + p.sq_off.tail);
+    u->sqMasque = (unsigned *)((char *) u->sq + p.sq_off.ring_mask);
+    u->sqTableau = (unsigned *)((char *) u->sq + p.sq_off.array);
+    u->sqEntrees = p.sq_entries;
+    u->cqTete = (unsigned *)((char *) u->cq + p.cq_off.head);
+    u->cqQueue = (unsigned *)((char *) u->cq + p.cq_off.tail);
+    u->cqMasque = (unsigned *)((char *) u->cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)((char *) u->cq + p.cq_off.cqes);
+    return 0;
+}
+
+void uringFermer(struct uring *u)
+{
+    munmap(u->sqes, u->lgSqes);
+    munmap(u->cq, u->lgCq);
+    munmap(u->sq, u->lgSq);
+    close(u->fd);
+}
+
+struct io_uring_sqe *uringSqe(struct uring *u)
+{
+    struct io_uring_sqe *sqe;
+    unsigned queue = *u->sqQueue;
+
+    if (queue - __atomic_load_n(u->sqTete, __ATOMIC_ACQUIRE) >= u->sqEntrees)
+    {
+        uringSoumettre(u, 0, 0);
+        queue = *u->sqQueue;
+    }
+    sqe = &u->sqes[queue & *u->sqMasque];
+    memset(sqe, 0, sizeof(*sqe));
+    u->sqTableau[queue & *u->sqMasque] = queue & *u->sqMasque;
+    __atomic_store_n(u->sqQueue, queue + 1, __ATOMIC_RELEASE);
+    u->aSoumettre++;
+    return sqe;
+}
+
+int uringSoumettre(struct uring *u, unsigned attendre, int delaiMs)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned drapeaux = IORING_ENTER_EXT_ARG;
+    int n;
+
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (attendre > 0)
+        drapeaux |= IORING_ENTER_GETEVENTS;
+    if (attendre > 0 && delaiMs >= 0)
+    {
+        ts.tv_sec = delaiMs / 1000;
+        ts.tv_nsec = (delaiMs % 1000) * 1000000L;
+        arg.ts = (unsigned long) &ts;
+    }
+    while (1)
+    {
+        u->appels++;
+        n = uringEnter(u->fd, u->aSoumettre, attendre, drapeaux, &arg, sizeof(arg));
+        if (n >= 0)
+        {
+            u->aSoumettre -= (n < (int) u->aSoumettre) ? n : u->aSoumettre;
+            return 0;
+        }
+        if (errno == ETIME)
+        {
+            u->aSoumettre = 0;
+            return 0;
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return -1;
+    }
+}
+
+int uringFichiers(struct uring *u, unsigned n)
+{
+    int *fds = malloc(n * sizeof(int));
+    unsigned i;
+    int r;
+
+    if (fds == NULL)
+        return -1;
+    for (i=0; i<n; i++)
+        fds[i] = -1;
+    r = uringRegister(u->fd, IORING_REGISTER_FILES, fds, n);
+    free(fds);
+    return r;
+}
+
+int uringTamponsInit(struct uring *u, struct uringTampons *t, unsigned short groupe, unsigned nb, unsigned taille)
+{
+    struct io_uring_buf_reg reg;
+    unsigned i;
+
+    t->nb = nb;
+    t->taille = taille;
+    t->groupe = groupe;
+    t->anneau = mmap(NULL, nb * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    t->memoire = malloc((size_t) nb * taille);
+    if (t->anneau == MAP_FAILED || t->memoire == NULL)
+        return -1;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long) t->anneau;
+    reg.ring_entries = nb;
+    reg.bgid = groupe;
+    if (uringRegister(u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        return -1;
+
+    t->anneau->tail = 0;
+    for (i=0; i<nb; i++)
+        uringRendre(t, i);
+    return 0;
+}
+
+void uringRendre(struct uringTampons *t, unsigned id)
+{
+    unsigned short queue = t->anneau->tail;
+    struct io_uring_buf *b = &t->anneau->bufs[queue & (t->nb - 1)];
+
+    b->addr = (unsigned long) uringTampon(t, id);
+    b->len = t->taille;
+    b->bid = id;
+    __atomic_store_n(&t->anneau->tail, (unsigned short)(queue + 1), __ATOMIC_RELEASE);
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * IO_URING SANS BIBLIOTHÈQUE
+ * Anneaux de soumission et de complétion projetés depuis le noyau, appels
+ * système directs (io_uring_setup, io_uring_enter, io_uring_register).
+ * Les SQE préparées s'accumulent et partent toutes au prochain uringSoumettre:
+ * un seul io_uring_enter soumet un lot et attend ses complétions.
+ * Un anneau n'est utilisé que par un fil.
+ ******************************************************************************/
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+
+struct uring
+{
+    int fd;
+    unsigned *sqTete, *sqQueue, *sqMasque, *sqTableau;
+    unsigned sqEntrees;
+    unsigned aSoumettre;                // SQE préparées depuis le dernier io_uring_enter
+    struct io_uring_sqe *sqes;
+    unsigned *cqTete, *cqQueue, *cqMasque;
+    struct io_uring_cqe *cqes;
+    void *sq, *cq;
+    size_t lgSq, lgCq, lgSqes;
+    long appels;                        // io_uring_enter effectués
+};
+
+// Tampons de réception fournis au noyau (IORING_REGISTER_PBUF_RING):
+// une réception choisit elle-même un tampon libre du groupe
+struct uringTampons
+{
+    struct io_uring_buf_ring *anneau;
+    char *memoire;
+    unsigned nb, taille;
+    unsigned short groupe;
+};
+
+// entrees: SQE (puissance de 2); l'anneau de complétion en a 4 fois plus
+// Retourne -1 si io_uring est indisponible
+int uringInit(struct uring *u, unsigned entrees);
+
+void uringFermer(struct uring *u);
+
+// Prochaine SQE, remise à zéro (soumet le lot en cours si l'anneau est plein)
+struct io_uring_sqe *uringSqe(struct uring *u);
+
+// Soumet les SQE préparées et attend au moins attendre complétions,
+// au plus delaiMs (-1: sans limite). Retourne -1 en cas d'erreur
+int uringSoumettre(struct uring *u, unsigned attendre, int delaiMs);
+
+// Prochaine complétion, NULL s'il n'y en a plus; uringVu la libère
+static inline struct io_uring_cqe *uringCqe(struct uring *u)
+{
+    unsigned tete = *u->cqTete;
+
+    if (tete == __atomic_load_n(u->cqQueue, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &u->cqes[tete & *u->cqMasque];
+}
+
+static inline void uringVu(struct uring *u)
+{
+    __atomic_store_n(u->cqTete, *u->cqTete + 1, __ATOMIC_RELEASE);
+}
+
+// Table de n descripteurs directs vides (IOSQE_FIXED_FILE)
+int uringFichiers(struct uring *u, unsigned n);
+
+// nb tampons de taille octets dans le groupe (nb puissance de 2)
+int uringTamponsInit(struct uring *u, struct uringTampons *t, unsigned short groupe, unsigned nb, unsigned taille);
+
+static inline char *uringTampon(struct uringTampons *t, unsigned id)
+{
+    return t->memoire + (size_t) id * t->taille;
+}
+
+// Rend le tampon id au noyau
+void uringRendre(struct uringTampons *t, unsigned id);
+
+#endif
@@ -0,0 +1,39 @@
+#!/bin/bash
+# Serveur au nombre maximal de fils de tables (-S): chaque fil doit garder son
+# anneau de journal et sa tranche de métriques. Refuse aussi -S max+1.
+#
+# Usage: ./verif_groupes.sh [secondes]
+# Code de retour 1 si un enregistrement ou une métrique est perdu.
+
+DUREE=${1:-4}
+PORT=27100
+METRIQUES=9470
+PORT_JOUEURS=28100
+JOURNAL=$(mktemp)
+
+MAX=$(./server -S 0 "$PORT" 2>&1 | sed -n 's/.*groups between 1 and \([0-9]*\).*/\1/p')
+if [ -z "$MAX" ] || ./server -S $((MAX + 1)) "$PORT" > /dev/null 2>&1; then
+    echo "ECHEC: -S $((MAX + 1)) accepté"
+    exit 1
+fi
+
+./server -S "$MAX" -n "$MAX" -l info -m "$METRIQUES" "$PORT" > "$JOURNAL" 2>&1 &
+SERVEUR=$!
+sleep 0.5
+RAPPORT=$(./loadgen -t 1 -n "$MAX" -w 0 -d "$DUREE" -r -p "$PORT_JOUEURS" 127.0.0.1 "$PORT")
+PAGE=$(curl -s "localhost:$METRIQUES/metrics")
+kill "$SERVEUR"
+wait "$SERVEUR" 2>/dev/null
+
+PARTIES=$(echo "$PAGE" | awk '/^sh13_games_total/ { print $2 }')
+REFUSES=$(echo "$PAGE" | awk '/^sh13_metrics_threads_refused_total/ { print $2 }')
+PERDUS=$(grep -c "enregistrements perdus (plus de" "$JOURNAL")
+rm -f "$JOURNAL"
+
+echo "-S $MAX: parties=$PARTIES fils sans métriques=$REFUSES pertes du journal=$PERDUS"
+echo "$RAPPORT" | grep "^erreurs"
+if [ "${PARTIES:-0}" -eq 0 ] || [ "$REFUSES" != "0" ] || [ "$PERDUS" != "0" ]; then
+    echo "ECHEC"
+    exit 1
+fi
+echo "OK"
@@ -0,0 +1,61 @@
+#!/bin/bash
+# Partie reprise d'un journal que les robots finissent seuls, avec -r: la
+# donne suivante doit avoir lieu (la table ne reste pas bloquée).
+# Une partie à un humain est interrompue (kill -9), son point de reprise est
+# modifié pour éliminer l'humain, puis le serveur la reprend.
+#
+# Usage: ./verif_reprise.sh
+# Code de retour 1 si la table ne rejoue pas après la partie reprise.
+
+PORT=27200
+PORT_JOUEURS=28200
+TEMP=$(mktemp -d)
+trap 'rm -rf "$TEMP"' EXIT
+
+cat > "$TEMP/eliminer.c" <<'FIN'
+#include "reprise.h"
+int main(int argc, char **argv)
+{
+    struct etatReprise e;
+    int i;
+
+    if (argc < 2 || repriseRestaurer(argv[1], &e) != 1)
+        return 1;
+    for (i=0; i<e.nbJoueurs; i++)
+        e.jeu.joueursPerdu[i] = !e.joueurs[i].robot;
+    while (!e.joueurs[e.jeu.joueurCourant].robot)
+        e.jeu.joueurCourant = (e.jeu.joueurCourant + 1) % NB_JOUEURS;
+    return repriseSauver(argv[1], &e) < 0;
+}
+FIN
+gcc -I. -o "$TEMP/eliminer" "$TEMP/eliminer.c" reprise.c journal.c partie.c regles.c || exit 1
+
+# Une partie à un humain, arrêtée après son premier point de reprise
+mkdir "$TEMP/journaux"
+./server -n 1 -b 3 -j "$TEMP/journaux" "$PORT" > /dev/null 2>&1 &
+SERVEUR=$!
+sleep 0.5
+./loadgen -t 1 -n 1 -j 1 -w 300 -d 5 -p "$PORT_JOUEURS" 127.0.0.1 "$PORT" > /dev/null &
+CHARGE=$!
+sleep 1.3
+{ kill -9 "$SERVEUR" "$CHARGE"; wait "$SERVEUR" "$CHARGE"; } 2> /dev/null
+JOURNAL=$(ls "$TEMP"/journaux/encours/*.sh13j 2> /dev/null | head -1)
+if [ -z "$JOURNAL" ] || [ ! -f "$JOURNAL.etat" ] || ! "$TEMP/eliminer" "$JOURNAL"; then
+    echo "ECHEC: pas de partie en cours à reprendre"
+    exit 1
+fi
+
+# Reprise avec -r: l'humain absent perd ses tours, les robots finissent
+./server -n 1 -b 3 -r -T 1 -j "$TEMP/journaux" "$PORT" > "$TEMP/serveur.log" 2>&1 &
+SERVEUR=$!
+sleep 4
+kill "$SERVEUR"
+wait "$SERVEUR" 2> /dev/null
+
+PARTIES=$(grep -c "FIN DE LA PARTIE" "$TEMP/serveur.log")
+echo "parties finies après la reprise: $PARTIES"
+if ! grep -q "PARTIE REPRISE" "$TEMP/serveur.log" || [ "$PARTIES" -lt 2 ]; then
+    echo "ECHEC"
+    exit 1
+fi
+echo "OK"